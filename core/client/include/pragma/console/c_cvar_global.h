@@ -42,6 +42,10 @@ REGISTER_CONCOMMAND_CL(debug_font_glyph_map,Console::commands::debug_font_glyph_
 REGISTER_CONCOMMAND_CL(debug_dump_font_glyph_map,Console::commands::debug_dump_font_glyph_map,ConVarFlags::None,"Dumps the glyph map for the specified font to an image file.");
 REGISTER_CONCOMMAND_CL(debug_render_depth_buffer,Console::commands::debug_render_depth_buffer,ConVarFlags::None,"Draws the scene depth buffer to screen.");
 REGISTER_CONCOMMAND_CL(debug_render_validation_error_enabled,Console::commands::debug_render_validation_error_enabled,ConVarFlags::None,"Enables or disables the specified validation error.");
+REGISTER_CONCOMMAND_CL(debug_render_queue_benchmark,Console::commands::debug_render_queue_benchmark,ConVarFlags::None,"Builds and sorts a render queue from synthetic items on multiple threads and prints the timings. Does not require a loaded map. Usage: debug_render_queue_benchmark <itemCount> <threadCount> <iterationCount>");
+REGISTER_CONCOMMAND_CL(debug_frustum_culling_benchmark,Console::commands::debug_frustum_culling_benchmark,ConVarFlags::None,"Culls synthetic bounding boxes against a set of planes, both with the per-box test and the batched render bounds test, and prints the timings. Does not require a loaded map. Usage: debug_frustum_culling_benchmark <boxCount> <iterationCount>");
+REGISTER_CONCOMMAND_CL(debug_occlusion_tree_benchmark,Console::commands::debug_occlusion_tree_benchmark,ConVarFlags::None,"Moves synthetic objects every frame, updates and queries both the occlusion octree and the dynamic AABB tree and prints the timings. Does not require a loaded map. Usage: debug_occlusion_tree_benchmark <objectCount> <frameCount>");
+REGISTER_CONCOMMAND_CL(debug_particle_simulation_benchmark,Console::commands::debug_particle_simulation_benchmark,ConVarFlags::None,"Simulates synthetic particles, both with the per-particle operator path and the batched SoA kernels, and prints the timings. Does not require a loaded map. Usage: debug_particle_simulation_benchmark <particleCount> <iterationCount>");
 
 REGISTER_CONCOMMAND_CL(debug_render_info,Console::commands::debug_render_info,ConVarFlags::None,"Prints some timing information to the console.");
 
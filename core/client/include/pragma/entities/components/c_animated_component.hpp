@@ -59,6 +59,7 @@ namespace pragma
 
 		uint32_t OnSkeletonUpdated();
 		bool MaintainAnimations(double dt) override;
+		virtual void FinalizeAnimationUpdate() override;
 
 		void SetSkeletonUpdateCallbacksEnabled(bool enabled);
 		bool AreSkeletonUpdateCallbacksEnabled() const;
@@ -27,6 +27,7 @@ class ModelSubMesh;
 class ModelMesh;
 namespace prosper {class IUniformResizableBuffer; class IDescriptorSet; class SwapDescriptorSet; class SwapBuffer;};
 namespace Intersection {struct LineMeshResult;};
+namespace pragma::rendering {class RenderBoundsStorage;};
 namespace pragma
 {
 	class CModelComponent;
@@ -78,6 +79,8 @@ namespace pragma
 		prosper::SwapDescriptorSet *GetSwapRenderDescriptorSet() const;
 
 		static const std::vector<CRenderComponent*> &GetEntitiesExemptFromOcclusionCulling();
+		// Absolute render bounds of all render components, used for batched frustum culling
+		static rendering::RenderBoundsStorage &GetRenderBoundsStorage();
 		static const std::shared_ptr<prosper::IUniformResizableBuffer> &GetInstanceBuffer();
 		static void InitializeBuffers();
 		static void ClearBuffers();
@@ -170,6 +173,8 @@ namespace pragma
 
 		void SetRenderBufferDirty();
 		void SetRenderBoundsDirty();
+		// Index of this component's bounds in the render bounds storage
+		uint32_t GetRenderBoundsSlot() const;
 		std::optional<Intersection::LineMeshResult> CalcRayIntersection(const Vector3 &start,const Vector3 &dir,bool precise=false) const;
 
 		bool IsInstantiable() const;
@@ -227,6 +232,7 @@ namespace pragma
 		std::mutex m_renderDataMutex;
 		std::unordered_map<unsigned int,RenderInstance*> m_renderInstances;
 		std::unique_ptr<SortedRenderMeshContainer> m_renderMeshContainer = nullptr;
+		uint32_t m_renderBoundsSlot = std::numeric_limits<uint32_t>::max();
 		static std::vector<CRenderComponent*> s_ocExemptEntities;
 	private:
 		void UpdateAbsoluteRenderBounds();
@@ -14,6 +14,7 @@
 #include "pragma/rendering/c_rendermode.h"
 #include "pragma/rendering/c_renderflags.h"
 #include "pragma/rendering/render_mesh_collection_handler.hpp"
+#include "pragma/rendering/render_bounds_storage.hpp"
 #include <pragma/util/util_bsp_tree.hpp>
 #include <pragma/entities/components/base_entity_component.hpp>
 #include <shader/prosper_descriptor_array_manager.hpp>
@@ -51,7 +52,8 @@ public:
 		CHCPP,
 		BSP,
 		Octree,
-		Inert
+		Inert,
+		AabbTree
 	};
 	enum class RenderQueueId : uint8_t
 	{
@@ -74,7 +76,8 @@ public:
 		const std::function<pragma::rendering::RenderQueue*(pragma::rendering::SceneRenderPass,bool)> &getRenderQueue,
 		const pragma::CSceneComponent &scene,const pragma::CCameraComponent &cam,const Mat4 &vp,const std::function<bool(const Vector3&,const Vector3&)> &fShouldCull,
 		int32_t lodBias=0,const std::function<void(pragma::rendering::RenderQueue&,const pragma::rendering::RenderQueueItem&)> &fOptInsertItemToQueue=nullptr,
-		pragma::GameShaderSpecializationConstantFlag baseSpecializationFlags=static_cast<pragma::GameShaderSpecializationConstantFlag>(0)
+		pragma::GameShaderSpecializationConstantFlag baseSpecializationFlags=static_cast<pragma::GameShaderSpecializationConstantFlag>(0),
+		const pragma::rendering::VisibilityBitset *renderBoundsVisibility=nullptr
 	);
 	// Note: All arguments have to be thread safe for the duration of the render (except vp)
 	static void CollectRenderMeshesFromOctree(
@@ -84,7 +87,8 @@ public:
 		const std::function<bool(const Vector3&,const Vector3&)> &fShouldCull,const std::vector<util::BSPTree*> *bspTrees=nullptr,const std::vector<util::BSPTree::Node*> *bspLeafNodes=nullptr,
 		int32_t lodBias=0,
 		const std::function<bool(CBaseEntity&,const pragma::CSceneComponent&,RenderFlags)> &shouldConsiderEntity=nullptr,
-		pragma::GameShaderSpecializationConstantFlag baseSpecializationFlags=static_cast<pragma::GameShaderSpecializationConstantFlag>(0)
+		pragma::GameShaderSpecializationConstantFlag baseSpecializationFlags=static_cast<pragma::GameShaderSpecializationConstantFlag>(0),
+		const pragma::rendering::VisibilityBitset *renderBoundsVisibility=nullptr
 	);
 	static bool ShouldConsiderEntity(CBaseEntity &ent,const pragma::CSceneComponent &scene,RenderFlags renderFlags,pragma::rendering::RenderMask renderMask);
 	static bool ShouldCull(CBaseEntity &ent,const std::function<bool(const Vector3&,const Vector3&)> &fShouldCull);
@@ -119,7 +123,7 @@ public:
 private:
 	void AddRenderMeshesToRenderQueue(
 		pragma::CRasterizationRendererComponent *optRasterizationRenderer,RenderFlags renderFlags,pragma::CRenderComponent &renderC,const pragma::CSceneComponent &scene,const pragma::CCameraComponent &cam,const Mat4 &vp,
-		const std::function<bool(const Vector3&,const Vector3&)> &fShouldCull,
+		const std::function<bool(const Vector3&,const Vector3&)> &fShouldCull,const pragma::rendering::VisibilityBitset *renderBoundsVisibility=nullptr,
 		pragma::GameShaderSpecializationConstantFlag baseSpecializationFlags=static_cast<pragma::GameShaderSpecializationConstantFlag>(0)
 	);
 	void CollectRenderMeshesFromOctree(
@@ -132,6 +136,9 @@ private:
 	std::shared_ptr<pragma::OcclusionCullingHandler> m_occlusionCullingHandler = nullptr;
 
 	std::vector<WorldMeshVisibility> m_worldMeshVisibility;
+	// Frustum culling result for the absolute render bounds of all render components (see CRenderComponent::GetRenderBoundsStorage).
+	// Only valid for the render pass that is currently being built.
+	pragma::rendering::VisibilityBitset m_renderBoundsVisibility;
 	std::array<std::shared_ptr<pragma::rendering::RenderQueue>,umath::to_integral(RenderQueueId::Count)> m_renderQueues;
 	std::vector<std::shared_ptr<const pragma::rendering::RenderQueue>> m_worldRenderQueues;
 	std::atomic<bool> m_worldRenderQueuesReady = false;
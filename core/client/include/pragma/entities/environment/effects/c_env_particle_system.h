@@ -14,6 +14,7 @@
 #include "pragma/particlesystem/c_particle.h"
 #include "pragma/rendering/c_alpha_mode.hpp"
 #include "pragma/particlesystem/c_particlemodifier.h"
+#include "pragma/particlesystem/c_particle_storage.hpp"
 #include <mathutil/transform.hpp>
 #include <fsys/vfileptr.h>
 #include <optional>
@@ -36,6 +37,8 @@ namespace pragma
 		DepthOnly = Bloom<<1u
 	};
 	class CParticleSystemComponent;
+	class JobSystem;
+	class JobCounter;
 	class CSceneComponent;
 	class DLLCLIENT CParticleSystemComponent final
 		: public BaseEnvParticleSystemComponent,
@@ -247,6 +250,10 @@ namespace pragma
 		void SetColorFactor(const Vector4 &colorFactor);
 		
 		void Simulate(double tDelta);
+		// Simulates the specified particle systems and their children. The particles of systems whose operators all support batch simulation
+		// are simulated in parallel on the engine's job system. Emission, callbacks and operators which don't support batch simulation
+		// (e.g. Lua operators) are always executed on the calling thread.
+		static void Simulate(const std::vector<CParticleSystemComponent*> &particleSystems,double tDelta);
 		void RecordRender(prosper::ICommandBuffer &drawCmd,CSceneComponent &scene,const pragma::CRasterizationRendererComponent &renderer,ParticleRenderFlags renderFlags);
 		void RecordRenderShadow(prosper::ICommandBuffer &drawCmd,CSceneComponent &scene,const pragma::CRasterizationRendererComponent &renderer,pragma::CLightComponent *light,uint32_t layerId=0);
 		uint32_t GetParticleCount() const;
@@ -348,6 +355,25 @@ namespace pragma
 		std::vector<std::size_t> m_sortedParticleIndices;
 		std::vector<std::size_t> m_particleIndicesToBufferIndices;
 		std::vector<std::size_t> m_bufferIndicesToParticleIndices;
+		// Only used if all operators support batch simulation
+		ParticleStorage m_particleStorage;
+		// State of the current simulation step, shared between the simulation stages
+		struct SimulationState
+		{
+			double tDelta = 0.0;
+			// Delta time before the time scale has been applied
+			double tDeltaUnscaled = 0.0;
+			Vector3 cameraPosition {};
+			std::optional<Quat> velocityRotation {};
+			bool batched = false;
+			bool updateInstanceData = false;
+			// Whether the child systems should be simulated after the emission of this system has been updated
+			bool simulateChildren = false;
+			// Particles whose lifetime has run out during this step. The destruction callbacks are always run on the main thread.
+			std::vector<uint32_t> expiredParticles;
+			// Whether any of the particles of a batch have moved
+			std::vector<uint8_t> batchMovement;
+		} m_simulationState {};
 		bool FindFreeParticle(uint32_t *idx);
 
 		pragma::rendering::SceneRenderPass m_renderPass = pragma::rendering::SceneRenderPass::World;
@@ -404,7 +430,29 @@ namespace pragma
 		// Only with OrientationType::World
 		float m_worldScale = 1.f;
 
+		// Number of particles that are simulated by a single job, if all operators support batch simulation
+		static constexpr uint32_t PARTICLE_BATCH_SIZE = 4'096;
+
 		void SortParticles();
+		// Simulation stages; BeginSimulation, UpdateEmission, InvokeRenderCallbacks and EndSimulation have to be called from the main thread,
+		// SimulateParticleBatches and UpdateInstanceData can be executed on any thread.
+		// Returns false if the particle system isn't being simulated.
+		bool BeginSimulation(double tDelta);
+		// Runs the operators on all live particles and moves them by their velocities
+		void SimulateParticles(double tDelta,const Vector3 &posCam);
+		// Same as SimulateParticles, but the particles are simulated in batches. If a job system is specified, all batches except for the first
+		// are scheduled as jobs with the specified counter.
+		void SimulateParticleBatches(JobSystem *jobSystem,JobCounter *counter);
+		bool SimulateParticleBatch(uint32_t offset,uint32_t count);
+		// Returns false if the instance data doesn't need to be updated
+		bool UpdateEmission();
+		void InvokeRenderCallbacks();
+		void UpdateInstanceData();
+		void EndSimulation();
+		void UpdateParticleLifetimes(float tDelta);
+		void DestroyExpiredParticles();
+		// Returns true if the world rotation of the particle has changed
+		bool IntegrateAngularVelocity(CParticle &p,double tDelta);
 		CParticle &CreateParticle(uint32_t idx,float timeCreated,float timeAlive);
 		uint32_t CreateParticles(uint32_t count,double tSimDelta,float tStart,float tDtPerParticle);
 		void OnParticleDestroyed(CParticle &particle);
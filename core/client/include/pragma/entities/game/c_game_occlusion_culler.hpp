@@ -12,6 +12,7 @@
 #include "pragma/entities/c_baseentity.h"
 #include "pragma/entities/components/c_entity_component.hpp"
 #include "pragma/rendering/occlusion_culling/c_occlusion_octree.hpp"
+#include "pragma/rendering/occlusion_culling/dynamic_aabb_tree.hpp"
 #include <pragma/entities/components/base_entity_component.hpp>
 
 namespace pragma
@@ -29,9 +30,19 @@ namespace pragma
 		OcclusionOctree<CBaseEntity*> &GetOcclusionOctree();
 		const OcclusionOctree<CBaseEntity*> &GetOcclusionOctree() const;
 
+		// Contains the same entities as the occlusion octree, the user data of each proxy is the local index of the entity
+		DynamicAabbTree &GetAabbTree();
+		const DynamicAabbTree &GetAabbTree() const;
+
 		void AddEntity(CBaseEntity &ent);
 	private:
+		void InsertAabbTreeProxy(CBaseEntity &ent);
+		// Only updates the bounds of an existing proxy; Entities that have been taken out of the tree (e.g. because of their render mode) stay out
+		void UpdateAabbTreeProxy(CBaseEntity &ent);
+		void RemoveAabbTreeProxy(CBaseEntity &ent);
 		std::shared_ptr<OcclusionOctree<CBaseEntity*>> m_occlusionOctree = nullptr;
+		DynamicAabbTree m_aabbTree {};
+		std::unordered_map<CBaseEntity*,DynamicAabbTree::ProxyId> m_aabbTreeProxies {};
 		std::unordered_map<CBaseEntity*,std::vector<CallbackHandle>> m_callbacks {};
 	};
 };
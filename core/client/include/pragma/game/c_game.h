@@ -484,10 +484,14 @@ private:
 		MessagePacketTracker();
 		uint8_t lastInMessageId;
 		uint8_t outMessageId;
+		bool hasReceivedMessage = false;
+		// Bit i is set if the message with the id 'lastInMessageId -i -1' has been received as well
+		uint32_t receivedMessageMask = 0;
 		// Looks for lost packets and updates 'lastInMessageId'
 		void CheckMessages(uint8_t messageId,std::vector<double> &lostPacketTimestamps,const double &tCur);
 		void CheckMessages(uint8_t messageId,std::vector<double> &lostPacketTimestamps);
 		bool IsMessageInOrder(uint8_t messageId) const;
+		void UpdateReceivedMessageMask(uint8_t messageId);
 		std::array<double,std::numeric_limits<decltype(lastInMessageId)>::max() +1> messageTimestamps;
 	};
 	MessagePacketTracker m_snapshotTracker;
@@ -0,0 +1,88 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright (c) 2021 Silverlan
+ */
+
+#ifndef __C_PARTICLE_STORAGE_HPP__
+#define __C_PARTICLE_STORAGE_HPP__
+
+#include "pragma/clientdefinitions.h"
+#include <mathutil/umath.h>
+#include <mathutil/uvec.h>
+#include <vector>
+#include <array>
+
+class CParticle;
+namespace pragma
+{
+	// View of a contiguous range of particles in a ParticleStorage. Operators which support batch simulation
+	// receive spans instead of individual particles, which allows them to process the fields of all particles at once.
+	struct DLLCLIENT ParticleSpan
+	{
+		// The components of vector fields must be consecutive
+		enum class Field : uint8_t
+		{
+			PositionX = 0,
+			PositionY,
+			PositionZ,
+			VelocityX,
+			VelocityY,
+			VelocityZ,
+			ColorR,
+			ColorG,
+			ColorB,
+			ColorA,
+			Radius,
+			Life,
+			TimeAlive,
+			CameraDistance,
+
+			Count
+		};
+		float *GetField(Field field) const {return fields[umath::to_integral(field)];}
+		ParticleSpan GetSubSpan(uint32_t offset,uint32_t count) const;
+
+		// Batched kernels for the built-in operators
+		void AddVelocity(const Vector3 &v);
+		void ScaleVelocity(float factor);
+		// Scales the velocity of every particle by max(0,1 -drag *|velocity|)
+		void ApplyQuadraticDrag(float drag);
+		// Moves all particles by their velocity and updates their camera distances. The velocities are rotated
+		// by the specified rotation before they are applied, if there is one.
+		// Returns true if at least one particle has moved.
+		bool IntegrateVelocity(float tDelta,const Quat *velocityRotation,const Vector3 &camPos);
+
+		std::array<float*,umath::to_integral(Field::Count)> fields {};
+		// Index of each particle in CParticleSystemComponent::GetParticles()
+		const uint32_t *particleIndices = nullptr;
+		uint32_t size = 0;
+	};
+
+	// Structure of arrays of the particle fields that are modified during the simulation.
+	// The particle objects remain the authoritative copy; Particles are copied into the storage
+	// before the batched operators are run and copied back afterwards.
+	class DLLCLIENT ParticleStorage
+	{
+	public:
+		ParticleStorage()=default;
+		ParticleStorage(const ParticleStorage&)=delete;
+		ParticleStorage &operator=(const ParticleStorage&)=delete;
+
+		// Keeps the allocated memory, if the count is smaller than the current capacity
+		void Resize(uint32_t count);
+		uint32_t GetSize() const {return m_size;}
+		ParticleSpan GetSpan();
+
+		void Gather(uint32_t idx,const CParticle &particle,uint32_t particleIndex);
+		// Only copies back the fields that can be modified by the batched operators
+		void Scatter(uint32_t idx,CParticle &particle) const;
+	private:
+		std::array<std::vector<float>,umath::to_integral(ParticleSpan::Field::Count)> m_fields;
+		std::vector<uint32_t> m_particleIndices;
+		uint32_t m_size = 0;
+	};
+};
+
+#endif
@@ -12,7 +12,7 @@
 #include <unordered_map>
 #include <cmaterial.h>
 
-namespace pragma {class CParticleSystemComponent;};
+namespace pragma {class CParticleSystemComponent; struct ParticleSpan;};
 #define REGISTER_PARTICLE_MODIFIER(localname,classname,basetype) \
 	static std::unique_ptr<basetype,void(*)(basetype*)> CreateParticle##classname##Modifier(pragma::CParticleSystemComponent &pSystem,const std::unordered_map<std::string,std::string> &values) \
 	{ \
@@ -88,6 +88,14 @@ public:
 	virtual void Simulate(CParticle &particle,double tDelta,float strength);
 	virtual void Initialize(pragma::CParticleSystemComponent &pSystem,const std::unordered_map<std::string,std::string> &values) override;
 	float CalcStrength(float curTime) const;
+
+	// If all operators of a particle system support batch simulation, the particles are simulated in batches
+	// with the span overloads below, instead of calling the per-particle overloads for every particle.
+	// Operators which return true have to implement both and the results have to be the same.
+	virtual bool SupportsBatchSimulation() const;
+	virtual void PreSimulate(pragma::ParticleSpan &span,double tDelta);
+	virtual void Simulate(pragma::ParticleSpan &span,double tDelta);
+	virtual void PostSimulate(pragma::ParticleSpan &span,double tDelta);
 private:
 	float m_opStartFadein = 0.f;
 	float m_opEndFadein = 0.f;
@@ -102,6 +110,7 @@ class DLLCLIENT CParticleOperatorLifespanDecay
 public:
 	CParticleOperatorLifespanDecay()=default;
 	virtual void Simulate(CParticle &particle,double tDelta,float strength) override;
+	virtual bool SupportsBatchSimulation() const override {return true;}
 };
 
 ///////////////////////
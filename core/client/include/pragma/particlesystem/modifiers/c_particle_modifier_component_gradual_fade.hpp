@@ -17,6 +17,13 @@ class DLLCLIENT CParticleModifierComponentGradualFade
 	public CParticleModifierComponentTime
 {
 protected:
+	// Unprocessed fade start and end values of a particle. These are constant for the particle's entire lifetime,
+	// so they can be cached to evaluate the fade without the particle object.
+	struct DLLCLIENT FadeTimes
+	{
+		float start = 0.f;
+		float end = 0.f;
+	};
 	CParticleModifierComponentGradualFade()=default;
 	void Initialize(const std::unordered_map<std::string,std::string> &values);
 
@@ -29,6 +36,10 @@ protected:
 	// Returns the eased fade fraction
 	float GetEasedFadeFraction(CParticle &p) const;
 	bool GetEasedFadeFraction(CParticle &p,float &outFraction) const;
+
+	FadeTimes GetFadeTimes(CParticle &p) const;
+	bool GetFadeFraction(const FadeTimes &fadeTimes,float timeAlive,float lifeSpan,float &outFraction) const;
+	bool GetEasedFadeFraction(const FadeTimes &fadeTimes,float timeAlive,float lifeSpan,float &outFraction) const;
 private:
 	CParticleModifierComponentRandomVariable<std::uniform_real_distribution<float>,float> m_fStart;
 	CParticleModifierComponentRandomVariable<std::uniform_real_distribution<float>,float> m_fEnd;
@@ -21,6 +21,7 @@ protected:
 	CParticleModifierComponentTime()=default;
 	void Initialize(const std::string &prefix,const std::unordered_map<std::string,std::string> &values);
 	float GetTime(float t,CParticle &p) const;
+	float GetTime(float t,float lifeSpan) const;
 private:
 	bool m_bLifetimeFraction = false;
 };
@@ -22,10 +22,22 @@ public:
 	virtual void Simulate(CParticle &particle,double,float strength) override;
 	virtual void Initialize(pragma::CParticleSystemComponent &pSystem,const std::unordered_map<std::string,std::string> &values) override;
 	virtual void OnParticleCreated(CParticle &particle) override;
+	virtual bool SupportsBatchSimulation() const override {return true;}
+	virtual void Simulate(pragma::ParticleSpan &span,double tDelta) override;
 private:
+	Color CalcColor(const Color &colorStart,CParticleModifierComponentRandomColor::ComponentFlags componentFlags,const Color &colorEnd,float tFade) const;
 	CParticleModifierComponentRandomColor m_colorStart;
 	CParticleModifierComponentRandomColor m_colorEnd;
 	std::unique_ptr<std::vector<Color>> m_particleStartColors = nullptr;
+
+	// Random values of each particle, cached when the particle is created, for the batch simulation
+	struct ParticleFadeData
+	{
+		FadeTimes fadeTimes {};
+		Color colorStart {};
+		Color colorEnd {};
+	};
+	std::vector<ParticleFadeData> m_particleFadeData;
 };
 
 #endif
@@ -11,6 +11,8 @@
 #include "pragma/clientdefinitions.h"
 #include "pragma/particlesystem/c_particlemodifier.h"
 #include "pragma/particlesystem/modifiers/c_particle_modifier_component_gradual_fade.hpp"
+#include "pragma/particlesystem/c_particle_storage.hpp"
+#include <optional>
 
 class DLLCLIENT CParticleOperatorRadiusFadeBase
 	: public CParticleOperator,
@@ -20,14 +22,26 @@ public:
 	virtual void Initialize(pragma::CParticleSystemComponent &pSystem,const std::unordered_map<std::string,std::string> &values) override;
 	virtual void Simulate(CParticle &particle,double,float strength) override;
 	virtual void OnParticleCreated(CParticle &particle) override;
+	virtual void Simulate(pragma::ParticleSpan &span,double tDelta) override;
 protected:
 	CParticleOperatorRadiusFadeBase(const std::string &identifier);
 	virtual void ApplyRadius(CParticle &particle,float radius) const=0;
+	// Only used for batch simulation; Returns the field the radius is applied to
+	virtual std::optional<pragma::ParticleSpan::Field> GetRadiusField() const {return {};}
 private:
 	CParticleModifierComponentRandomVariable<std::uniform_real_distribution<float>,float> m_fRadiusStart;
 	CParticleModifierComponentRandomVariable<std::uniform_real_distribution<float>,float> m_fRadiusEnd;
 	std::unique_ptr<std::vector<float>> m_particleStartRadiuses = nullptr;
 	std::string m_identifier;
+
+	// Random values of each particle, cached when the particle is created, for the batch simulation
+	struct ParticleFadeData
+	{
+		FadeTimes fadeTimes {};
+		float radiusStart = 0.f;
+		float radiusEnd = 0.f;
+	};
+	std::vector<ParticleFadeData> m_particleFadeData;
 };
 
 ////////////////////////////
@@ -37,8 +51,10 @@ class DLLCLIENT CParticleOperatorRadiusFade
 {
 public:
 	CParticleOperatorRadiusFade();
+	virtual bool SupportsBatchSimulation() const override {return true;}
 protected:
 	virtual void ApplyRadius(CParticle &particle,float radius) const override;
+	virtual std::optional<pragma::ParticleSpan::Field> GetRadiusField() const override {return pragma::ParticleSpan::Field::Radius;}
 };
 
 ////////////////////////////
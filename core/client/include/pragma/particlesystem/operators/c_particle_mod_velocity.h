@@ -20,6 +20,8 @@ public:
 	CParticleOperatorVelocity()=default;
 	virtual void Initialize(pragma::CParticleSystemComponent &pSystem,const std::unordered_map<std::string,std::string> &values) override;
 	virtual void Simulate(CParticle &particle,double tDelta,float strength) override;
+	virtual bool SupportsBatchSimulation() const override {return true;}
+	virtual void Simulate(pragma::ParticleSpan &span,double tDelta) override;
 	float GetSpeed() const;
 };
 
@@ -17,6 +17,7 @@ public:
 	CParticleOperatorJitter()=default;
 	virtual void Initialize(pragma::CParticleSystemComponent &pSystem,const std::unordered_map<std::string,std::string> &values) override;
 	virtual void Simulate(CParticle &particle,double tDelta,float strength) override;
+	virtual void Simulate(pragma::ParticleSpan &span,double tDelta) override;
 };
 
 #endif
@@ -19,6 +19,8 @@ public:
 	virtual void Initialize(pragma::CParticleSystemComponent &pSystem,const std::unordered_map<std::string,std::string> &values) override;
 	virtual void Simulate(CParticle &particle,double tDelta,float strength) override;
 	virtual void Simulate(double tDelta) override;
+	virtual bool SupportsBatchSimulation() const override {return true;}
+	virtual void Simulate(pragma::ParticleSpan &span,double tDelta) override;
 private:
 	float m_fAmount = 1.f;
 	float m_fTickDrag = 1.f;
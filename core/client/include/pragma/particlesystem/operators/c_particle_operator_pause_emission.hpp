@@ -18,6 +18,7 @@ class DLLCLIENT CParticleOperatorPauseEmissionBase
 public:
 	virtual void Simulate(double tDelta) override;
 	virtual void OnParticleSystemStarted() override;
+	virtual bool SupportsBatchSimulation() const override {return true;}
 protected:
 	CParticleOperatorPauseEmissionBase()=default;
 	virtual void Initialize(pragma::CParticleSystemComponent &pSystem,const std::unordered_map<std::string,std::string> &values) override;
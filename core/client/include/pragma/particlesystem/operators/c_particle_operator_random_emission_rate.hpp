@@ -19,6 +19,7 @@ public:
 	virtual void Initialize(pragma::CParticleSystemComponent &pSystem,const std::unordered_map<std::string,std::string> &values) override;
 	virtual void Simulate(double tDelta) override;
 	virtual void OnParticleSystemStarted() override;
+	virtual bool SupportsBatchSimulation() const override {return true;}
 private:
 	float GetInterval() const;
 	void Reset();
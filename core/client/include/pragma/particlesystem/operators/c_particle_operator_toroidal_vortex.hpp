@@ -18,6 +18,8 @@ public:
 	virtual void Initialize(pragma::CParticleSystemComponent &pSystem,const std::unordered_map<std::string,std::string> &values) override;
 	virtual void Simulate(CParticle &particle,double tDelta,float strength) override;
 	virtual void Simulate(double tDelta) override;
+	virtual bool SupportsBatchSimulation() const override {return true;}
+	virtual void Simulate(pragma::ParticleSpan &span,double tDelta) override;
 private:
 	Vector3 m_vAxis = {0.f,1.f,0.f};
 	float m_fHeight = 1.f;
@@ -18,6 +18,8 @@ public:
 	virtual void Initialize(pragma::CParticleSystemComponent &pSystem,const std::unordered_map<std::string,std::string> &values) override;
 	virtual void Simulate(CParticle &particle,double tDelta,float strength) override;
 	virtual void Simulate(double tDelta) override;
+	virtual bool SupportsBatchSimulation() const override {return true;}
+	virtual void Simulate(pragma::ParticleSpan &span,double tDelta) override;
 	virtual void OnParticleCreated(CParticle &particle) override;
 protected:
 	std::vector<int32_t> m_hashCodes;
@@ -0,0 +1,83 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright (c) 2021 Silverlan
+ */
+
+#ifndef __DYNAMIC_AABB_TREE_HPP__
+#define __DYNAMIC_AABB_TREE_HPP__
+
+#include "pragma/clientdefinitions.h"
+#include <mathutil/uvec.h>
+#include <mathutil/plane.hpp>
+#include <vector>
+#include <array>
+#include <limits>
+
+namespace pragma
+{
+	// Bounding volume hierarchy for moving objects. All nodes are stored in a single flat array and reference each other by index.
+	// Leaves store enlarged ("fat") bounds, so objects can move by a small distance without the tree having to be changed. If an object
+	// leaves its fat bounds, its leaf is re-inserted and the tree is re-balanced with tree rotations along the path to the root.
+	class DLLCLIENT DynamicAabbTree
+	{
+	public:
+		using ProxyId = uint32_t;
+		static constexpr ProxyId INVALID_PROXY = std::numeric_limits<ProxyId>::max();
+		// Default amount by which the bounds of a leaf are enlarged on every side
+		static constexpr float DEFAULT_MARGIN = 16.f;
+
+		DynamicAabbTree(float margin=DEFAULT_MARGIN);
+		// The user data is returned by the queries
+		ProxyId CreateProxy(const Vector3 &min,const Vector3 &max,uint32_t userData);
+		void DestroyProxy(ProxyId proxyId);
+		// Returns true if the proxy had to be re-inserted into the tree
+		bool MoveProxy(ProxyId proxyId,const Vector3 &min,const Vector3 &max);
+		uint32_t GetUserData(ProxyId proxyId) const;
+		// Returns the enlarged bounds of the proxy
+		std::pair<Vector3,Vector3> GetFatBounds(ProxyId proxyId) const;
+		void Clear();
+
+		uint32_t GetProxyCount() const;
+		uint32_t GetHeight() const;
+		float GetMargin() const;
+
+		// The query results are appended to outUserData
+		void QueryAll(std::vector<uint32_t> &outUserData) const;
+		void QueryFrustum(const std::vector<umath::Plane> &planes,std::vector<uint32_t> &outUserData) const;
+		void QuerySphere(const Vector3 &origin,float radius,std::vector<uint32_t> &outUserData) const;
+		void QueryAabb(const Vector3 &min,const Vector3 &max,std::vector<uint32_t> &outUserData) const;
+	private:
+		static constexpr uint32_t INVALID_NODE = std::numeric_limits<uint32_t>::max();
+		struct Node
+		{
+			Vector3 min;
+			Vector3 max;
+			// Index of the next free node if this node is unused
+			uint32_t parent = INVALID_NODE;
+			std::array<uint32_t,2> children {INVALID_NODE,INVALID_NODE};
+			// 0 for leaves, -1 for unused nodes
+			int32_t height = -1;
+			uint32_t userData = 0;
+			bool IsLeaf() const {return children[0] == INVALID_NODE;}
+		};
+		uint32_t AllocateNode();
+		void FreeNode(uint32_t nodeIdx);
+		void InsertLeaf(uint32_t leafIdx);
+		void RemoveLeaf(uint32_t leafIdx);
+		// Re-fits the bounds and heights of all ancestors of the node
+		void RefitAncestors(uint32_t nodeIdx);
+		// Performs a tree rotation at the node if it is imbalanced and returns the index of the new subtree root
+		uint32_t Balance(uint32_t nodeIdx);
+		void CollectLeaves(uint32_t nodeIdx,std::vector<uint32_t> &outUserData,std::vector<uint32_t> &stack) const;
+
+		std::vector<Node> m_nodes;
+		uint32_t m_root = INVALID_NODE;
+		uint32_t m_freeList = INVALID_NODE;
+		uint32_t m_proxyCount = 0;
+		float m_margin = DEFAULT_MARGIN;
+	};
+};
+
+#endif
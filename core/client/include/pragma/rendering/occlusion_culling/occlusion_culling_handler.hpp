@@ -9,6 +9,7 @@
 #define __OCCLUSION_CULLING_HANDLER_HPP__
 
 #include "pragma/clientdefinitions.h"
+#include "pragma/rendering/render_bounds_storage.hpp"
 #include <pragma/entities/baseentity_handle.h>
 #include <pragma/util/util_bsp_tree.hpp>
 #include <mathutil/plane.hpp>
@@ -56,6 +57,14 @@ namespace pragma
 		OcclusionCullingHandler()=default;
 		virtual bool ShouldExamine(CModelMesh &mesh,const Vector3 &pos,bool bViewModel,std::size_t numMeshes,const std::vector<umath::Plane> *optPlanes=nullptr) const;
 		virtual bool ShouldExamine(CSceneComponent &scene,const CRasterizationRendererComponent &renderer,CBaseEntity &cent,bool &outViewModel,std::vector<umath::Plane> **outPlanes) const;
+
+		// Culls the render bounds of all entities against the frustum planes of the renderer in batches.
+		// Until ClearFrustumVisibility is called, ShouldExamine will use the result instead of testing every entity individually.
+		void UpdateFrustumVisibility(const CRasterizationRendererComponent &renderer);
+		void ClearFrustumVisibility();
+		rendering::VisibilityBitset m_frustumVisibility;
+		rendering::VisibilityBitset m_clippedFrustumVisibility;
+		bool m_frustumVisibilityValid = false;
 	};
 };
 
@@ -0,0 +1,31 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright (c) 2021 Silverlan
+ */
+
+#ifndef __OCCLUSION_CULLING_HANDLER_AABB_TREE_HPP__
+#define __OCCLUSION_CULLING_HANDLER_AABB_TREE_HPP__
+
+#include "pragma/clientdefinitions.h"
+#include "pragma/rendering/occlusion_culling/occlusion_culling_handler.hpp"
+
+namespace pragma
+{
+	// Same as the octree handler, but dynamic entities are looked up in the dynamic AABB tree of the occlusion culler
+	class DLLCLIENT OcclusionCullingHandlerAabbTree
+		: public OcclusionCullingHandler
+	{
+	public:
+		OcclusionCullingHandlerAabbTree()=default;
+		virtual void PerformCulling(
+			CSceneComponent &scene,const CRasterizationRendererComponent &renderer,const Vector3 &camPos,
+			std::vector<pragma::OcclusionMeshInfo> &culledMeshesOut,bool cullByViewFrustum=true
+		) override;
+	private:
+		std::vector<uint32_t> m_queryResults;
+	};
+};
+
+#endif
@@ -0,0 +1,80 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright (c) 2021 Silverlan
+ */
+
+#ifndef __RENDER_BOUNDS_STORAGE_HPP__
+#define __RENDER_BOUNDS_STORAGE_HPP__
+
+#include "pragma/clientdefinitions.h"
+#include <mathutil/uvec.h>
+#include <mathutil/plane.hpp>
+#include <vector>
+#include <array>
+#include <mutex>
+#include <limits>
+
+namespace pragma {class CRenderComponent;};
+namespace pragma::rendering
+{
+	// One visibility bit per render bounds slot
+	class DLLCLIENT VisibilityBitset
+	{
+	public:
+		// Resizes the bitset and marks all slots as not visible
+		void Reset(uint32_t count);
+		uint32_t GetCount() const {return m_count;}
+		// Slots outside of the range of the bitset (e.g. components that were created after the culling pass) are considered visible
+		bool IsVisible(uint32_t slot) const {return (slot >= m_count) || (m_bits[slot /64] &(1ull<<(slot %64))) != 0;}
+		uint64_t *GetData() {return m_bits.data();}
+		const uint64_t *GetData() const {return m_bits.data();}
+	private:
+		std::vector<uint64_t> m_bits;
+		uint32_t m_count = 0;
+	};
+
+	// Absolute render bounds of all render components, stored as a structure of arrays so they can be tested against
+	// the frustum planes in batches. Every render component occupies one slot for its entire lifetime, the bounds
+	// of a slot are only re-read from the component if it has been marked as dirty.
+	class DLLCLIENT RenderBoundsStorage
+	{
+	public:
+		static constexpr uint32_t INVALID_SLOT = std::numeric_limits<uint32_t>::max();
+		// Number of bounding boxes that are tested against a plane at once
+		static constexpr uint32_t BATCH_SIZE = 4;
+
+		RenderBoundsStorage()=default;
+		RenderBoundsStorage(const RenderBoundsStorage&)=delete;
+		RenderBoundsStorage &operator=(const RenderBoundsStorage&)=delete;
+
+		// If no component is specified, the bounds of the slot have to be assigned with SetBounds
+		uint32_t AllocateSlot(CRenderComponent *renderC=nullptr);
+		void FreeSlot(uint32_t slot);
+		void MarkDirty(uint32_t slot);
+		void SetBounds(uint32_t slot,const Vector3 &min,const Vector3 &max);
+		// Re-reads the absolute render bounds of all components that have been marked as dirty since the last call
+		void UpdateDirtyBounds();
+		// Number of slots, including free ones
+		uint32_t GetSlotCount() const;
+		CRenderComponent *GetComponent(uint32_t slot) const;
+
+		// Tests the bounds of all slots against the planes. A slot is visible unless its bounds are entirely on the outer side of at least one plane,
+		// which matches the result of umath::intersection::aabb_in_plane_mesh. Free slots are never visible.
+		void CullByPlanes(const std::vector<umath::Plane> &planes,VisibilityBitset &outVisibility) const;
+	private:
+		void MarkDirtyUnlocked(uint32_t slot);
+		void SetBoundsUnlocked(uint32_t slot,const Vector3 &min,const Vector3 &max);
+		// Padded to a multiple of BATCH_SIZE
+		std::array<std::vector<float>,3> m_min;
+		std::array<std::vector<float>,3> m_max;
+		std::vector<CRenderComponent*> m_components;
+		std::vector<uint32_t> m_freeSlots;
+		std::vector<uint32_t> m_dirtySlots;
+		std::vector<uint8_t> m_dirtyFlags;
+		mutable std::mutex m_mutex;
+	};
+};
+
+#endif
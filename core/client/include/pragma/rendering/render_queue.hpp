@@ -77,6 +77,12 @@ namespace pragma::rendering
 			uint32_t startSkipIndex;
 			uint32_t GetSkipCount() const {return instanceCount *meshCount;}
 		};
+		// Append buffer 0 is shared by all threads that haven't been assigned a buffer of their own
+		static constexpr uint32_t APPEND_BUFFER_COUNT = 16;
+		static constexpr uint32_t SHARED_APPEND_BUFFER_INDEX = 0;
+		// Assigns an append buffer to the calling thread. Only one thread may use a given index at a time.
+		static void SetThreadAppendBufferIndex(uint32_t index);
+		static uint32_t GetThreadAppendBufferIndex();
 		static std::shared_ptr<RenderQueue> Create(std::string name);
 		~RenderQueue();
 		void Clear();
@@ -84,6 +90,12 @@ namespace pragma::rendering
 		void Add(const std::vector<RenderQueueItem> &items);
 		void Add(const RenderQueueItem &item);
 		void Add(CBaseEntity &ent,RenderMeshIndex meshIdx,CMaterial &mat,prosper::PipelineID pipelineId,const CCameraComponent *optCam=nullptr);
+		// Adds the item to the append buffer of the calling thread, which does not require a lock unless
+		// the thread doesn't have its own buffer. The items only become part of the queue after MergeAppendBuffers.
+		void Append(const RenderQueueItem &item);
+		// Moves the contents of all append buffers into the queue. Must not be called while other threads are still appending.
+		void MergeAppendBuffers();
+		// Merges the append buffers and sorts the items by their sorting keys
 		void Sort();
 		void Merge(const RenderQueue &other);
 		const std::string &GetName() const {return m_name;}
@@ -98,6 +110,11 @@ namespace pragma::rendering
 	private:
 		RenderQueue(std::string name);
 
+		std::array<std::vector<RenderQueueItem>,APPEND_BUFFER_COUNT> m_appendBuffers {};
+		std::mutex m_sharedAppendBufferMutex {};
+		// Scratch buffer for the radix sort, kept around to avoid re-allocations every frame
+		RenderQueueSortList m_sortScratch {};
+
 		std::atomic<bool> m_locked = false;
 		mutable std::condition_variable m_threadWaitCondition {};
 		mutable std::mutex m_threadWaitMutex {};
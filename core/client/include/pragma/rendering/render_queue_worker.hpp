@@ -9,22 +9,23 @@
 #define __RENDER_QUEUE_WORKER_HPP__
 
 #include "pragma/clientdefinitions.h"
-#include <queue>
+#include <pragma/util/job_system.hpp>
+#include <functional>
 #include <vector>
-#include <mutex>
-#include <atomic>
-#include <thread>
+#include <memory>
 
 struct RenderQueueWorkerStats;
 namespace pragma::rendering
 {
 	class RenderQueueWorker;
+	// Render queue jobs are executed by a dedicated job system, so that every worker can be assigned its own render queue append buffer
 	class RenderQueueWorkerManager
 	{
 	public:
 		using Job = std::function<void(void)>;
 		RenderQueueWorkerManager(uint32_t numWorkers);
 		~RenderQueueWorkerManager();
+		// Waits until all jobs have been completed. The calling thread will help with the execution of the remaining jobs.
 		void WaitForCompletion();
 		void FlushPendingJobs();
 		void AddJob(const Job &job);
@@ -36,37 +37,24 @@ namespace pragma::rendering
 
 		RenderQueueWorker &GetWorker(uint32_t i);
 		const RenderQueueWorker &GetWorker(uint32_t i) const;
+		JobSystem &GetJobSystem();
 	private:
-		friend RenderQueueWorker;
-		std::vector<std::shared_ptr<RenderQueueWorker>> m_workers;
-		std::queue<Job> m_pendingJobs;
-
-		std::queue<Job> m_readyJobs;
-		std::condition_variable m_readyJobCondition;
-		std::atomic<bool> m_workAvailable = false;
-		std::atomic<uint32_t> m_numThreadsWorking = 0;
-		std::mutex m_readyJobMutex;
-
-		std::condition_variable m_workCompleteCondition;
-		std::mutex m_workCompleteMutex;
+		void ExecuteBatch(const std::vector<Job> &jobs);
+		std::unique_ptr<JobSystem> m_jobSystem;
+		JobCounter m_jobCounter;
+		std::vector<std::unique_ptr<RenderQueueWorker>> m_workers;
+		std::vector<Job> m_pendingJobs;
 		uint32_t m_numJobsPerBatch = 2;
 	};
 
 	class RenderQueueWorker
 	{
 	public:
-		RenderQueueWorker(RenderQueueWorkerManager &manager);
-		~RenderQueueWorker();
-
+		RenderQueueWorker()=default;
 		void SetStats(RenderQueueWorkerStats *stats);
-		void Stop();
+		RenderQueueWorkerStats *GetStats() const;
 	private:
-		void StartThread();
-		std::thread m_thread;
-		RenderQueueWorkerManager &m_manager;
-		std::atomic<bool> m_running = true;
 		RenderQueueWorkerStats *m_stats = nullptr;
-
 	};
 };
 
@@ -228,6 +228,7 @@ struct DLLCLIENT RenderQueueBuilderStats
 	enum class Timer : uint32_t
 	{
 		TotalExecution = 0,
+		FrustumCulling,
 		WorldQueueUpdate,
 		OctreeProcessing,
 		WorkerWait,
@@ -33,7 +33,7 @@ class DLLCLIENT CResourceWatcherManager
 	: public ResourceWatcherManager
 {
 protected:
-	virtual void OnMaterialReloaded(const std::string &path,const std::unordered_set<Model*> &modelMap) override;
+	virtual void OnMaterialsReloaded(const std::vector<std::string> &paths,const std::unordered_set<Model*> &models) override;
 	virtual void OnResourceChanged(const util::Path &rootPath,const util::Path &path,const std::string &ext) override;
 	virtual void ReloadTexture(const std::string &path) override;
 	virtual void GetWatchPaths(std::vector<std::string> &paths) override;
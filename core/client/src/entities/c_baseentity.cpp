@@ -228,11 +228,11 @@ void CBaseEntity::ReceiveData(NetPacket &packet)
 	auto &componentManager = static_cast<pragma::CEntityComponentManager&>(c_game->GetEntityComponentManager());
 	auto &componentTypes = componentManager.GetRegisteredComponentTypes();
 	auto &svComponentToClComponentTable = componentManager.GetServerComponentIdToClientComponentIdTable();
-	auto numComponents = packet->Read<uint8_t>();
+	auto numComponents = nwm::read_varint(packet);
 	for(auto i=decltype(numComponents){0u};i<numComponents;++i)
 	{
 		auto svId = packet->Read<pragma::ComponentId>();
-		auto componentSize = packet->Read<uint8_t>();
+		auto componentSize = nwm::read_varint(packet);
 		auto offset = packet->GetOffset();
 		if(svId < svComponentToClComponentTable.size() && svComponentToClComponentTable.at(svId) != pragma::CEntityComponentManager::INVALID_COMPONENT)
 		{
@@ -139,15 +139,14 @@ void CWaterSurfaceComponent::InitializeSurface()
 	subMesh->SetIndexType(pragma::model::IndexType::UInt16);
 	subMesh->SetIndices(simTriangles);
 
-	sim.LockParticleHeights();
+	PhysWaterSurfaceSimulator::HeightView heights {sim};
 	auto numParticles = sim.GetParticleCount();
 	verts.reserve(numParticles);
 	for(auto i=decltype(numParticles){0};i<numParticles;++i)
 	{
-		auto pos = sim.CalcParticlePosition(i);
+		auto pos = sim.CalcParticlePosition(heights,i);
 		verts.push_back(umath::Vertex(pos,{pos.x /(10.f *sim.GetWidth()),pos.z /(10.f *sim.GetLength())},{0.f,1.f,0.f})); // TODO
 	}
-	sim.UnlockParticleHeights();
 
 	auto *matWater = GetWaterMaterial();
 	if(matWater != nullptr)
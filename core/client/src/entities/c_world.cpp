@@ -248,6 +248,16 @@ void CWorldComponent::BuildOfflineRenderQueues(bool rebuild)
 				clusterMeshes.reserve(clusterMeshes.size() *1.1 +100);
 			clusterMeshes.push_back(meshIdx);
 		};
+		// Clusters from which each cluster is visible, gathered once from the compressed visibility rows
+		// so we don't have to test every cluster pair for every mesh
+		std::vector<std::vector<util::BSPTree::ClusterIndex>> visibleFromClusters;
+		visibleFromClusters.resize(numClusters);
+		for(auto clusterIdx=decltype(numClusters){0u};clusterIdx<numClusters;++clusterIdx)
+		{
+			m_bspTree->IterateVisibleClusters(static_cast<util::BSPTree::ClusterIndex>(clusterIdx),[&visibleFromClusters,clusterIdx](util::BSPTree::ClusterIndex clusterDst) {
+				visibleFromClusters[clusterDst].push_back(static_cast<util::BSPTree::ClusterIndex>(clusterIdx));
+			});
+		}
 		for(auto meshIdx=decltype(renderMeshes.size()){0u};meshIdx<renderMeshes.size();++meshIdx)
 		{
 			auto &subMesh = renderMeshes.at(meshIdx);
@@ -267,12 +277,10 @@ void CWorldComponent::BuildOfflineRenderQueues(bool rebuild)
 				for(auto *node : leafNodes)
 				{
 					auto meshClusterIdx = node->cluster;
-					if(meshClusterIdx == std::numeric_limits<util::BSPTree::ClusterIndex>::max())
+					if(meshClusterIdx >= numClusters)
 						continue;
-					for(auto clusterIdx=decltype(numClusters){0u};clusterIdx<numClusters;++clusterIdx)
+					for(auto clusterIdx : visibleFromClusters[meshClusterIdx])
 					{
-						if(m_bspTree->IsClusterVisible(clusterIdx,meshClusterIdx) == false)
-							continue;
 						auto it = clusters.find(clusterIdx);
 						if(it != clusters.end())
 							continue;
@@ -282,12 +290,10 @@ void CWorldComponent::BuildOfflineRenderQueues(bool rebuild)
 				}
 				continue;
 			}
-			for(auto clusterIdx=decltype(numClusters){0u};clusterIdx<numClusters;++clusterIdx)
-			{
-				if(m_bspTree->IsClusterVisible(clusterIdx,meshClusterIdx) == false)
-					continue;
+			if(meshClusterIdx >= numClusters)
+				continue;
+			for(auto clusterIdx : visibleFromClusters[meshClusterIdx])
 				fAddClusterMesh(clusterIdx,meshIdx);
-			}
 		}
 	}
 
@@ -245,6 +245,11 @@ bool CAnimatedComponent::MaintainAnimations(double dt)
 	SetBoneBufferDirty(); // TODO: Only if anything has actually changed
 	return true;
 }
+void CAnimatedComponent::FinalizeAnimationUpdate()
+{
+	BaseAnimatedComponent::FinalizeAnimationUpdate();
+	SetBoneBufferDirty(); // TODO: Only if anything has actually changed
+}
 
 void CAnimatedComponent::UpdateBoneMatricesMT()
 {
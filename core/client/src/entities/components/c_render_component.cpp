@@ -9,6 +9,7 @@
 #include "pragma/entities/components/c_render_component.hpp"
 #include "pragma/rendering/shaders/world/c_shader_scene.hpp"
 #include "pragma/rendering/shaders/world/c_shader_textured.hpp"
+#include "pragma/rendering/render_bounds_storage.hpp"
 #include "pragma/entities/components/c_vertex_animated_component.hpp"
 #include "pragma/entities/components/c_softbody_component.hpp"
 #include "pragma/entities/components/c_animated_component.hpp"
@@ -78,7 +79,9 @@ void CRenderComponent::RegisterEvents(pragma::EntityComponentManager &componentM
 CRenderComponent::CRenderComponent(BaseEntity &ent)
 	: BaseRenderComponent(ent),m_renderGroups{util::TEnumProperty<pragma::rendering::RenderGroup>::Create(pragma::rendering::RenderGroup::None)},
 	m_renderPass{util::TEnumProperty<pragma::rendering::SceneRenderPass>::Create(rendering::SceneRenderPass::World)}
-{}
+{
+	m_renderBoundsSlot = GetRenderBoundsStorage().AllocateSlot(this);
+}
 void CRenderComponent::InitializeLuaObject(lua_State *l) {return BaseEntityComponent::InitializeLuaObject<std::remove_reference_t<decltype(*this)>>(l);}
 void CRenderComponent::InitializeBuffers()
 {
@@ -178,6 +181,7 @@ void CRenderComponent::Initialize()
 		m_absoluteRenderBounds = {};
 		m_localRenderSphere = {};
 		m_absoluteRenderSphere = {};
+		SetRenderBoundsDirty();
 
 		auto &ent = GetEntity();
 		auto *mdlComponent = GetModelComponent();
@@ -208,6 +212,7 @@ CRenderComponent::~CRenderComponent()
 	auto it = std::find(s_ocExemptEntities.begin(),s_ocExemptEntities.end(),this);
 	if(it != s_ocExemptEntities.end())
 		s_ocExemptEntities.erase(it);
+	GetRenderBoundsStorage().FreeSlot(m_renderBoundsSlot);
 
 	if(m_renderBuffer != nullptr)
 		c_engine->GetRenderContext().KeepResourceAliveUntilPresentationComplete(m_renderBuffer);
@@ -298,7 +303,7 @@ void CRenderComponent::SetLocalRenderBounds(Vector3 min,Vector3 max)
 
 	if(min == m_localRenderBounds.min && max == m_localRenderBounds.max)
 		return;
-	umath::set_flag(m_stateFlags,StateFlags::RenderBoundsDirty);
+	SetRenderBoundsDirty();
 	GetEntity().SetStateFlag(BaseEntity::StateFlags::RenderBoundsChanged);
 
 	if(uvec::distance_sqr(min,max) > 0.001f)
@@ -595,7 +600,12 @@ void CRenderComponent::SetExemptFromOcclusionCulling(bool exempt)
 }
 bool CRenderComponent::IsExemptFromOcclusionCulling() const {return umath::is_flag_set(m_stateFlags,StateFlags::ExemptFromOcclusionCulling);}
 void CRenderComponent::SetRenderBufferDirty() {umath::set_flag(m_stateFlags,StateFlags::RenderBufferDirty);}
-void CRenderComponent::SetRenderBoundsDirty() {umath::set_flag(m_stateFlags,StateFlags::RenderBoundsDirty);}
+void CRenderComponent::SetRenderBoundsDirty()
+{
+	umath::set_flag(m_stateFlags,StateFlags::RenderBoundsDirty);
+	GetRenderBoundsStorage().MarkDirty(m_renderBoundsSlot);
+}
+uint32_t CRenderComponent::GetRenderBoundsSlot() const {return m_renderBoundsSlot;}
 void CRenderComponent::UpdateRenderBuffers(const std::shared_ptr<prosper::IPrimaryCommandBuffer> &drawCmd,bool bForceBufferUpdate)
 {
 	// Commented because render buffers must not be initialized on a non-main thread
@@ -844,6 +854,11 @@ bool CRenderComponent::RenderCallback(RenderObject*,pragma::CCameraComponent *ca
 	return ShouldDraw();
 }
 const std::vector<CRenderComponent*> &CRenderComponent::GetEntitiesExemptFromOcclusionCulling() {return s_ocExemptEntities;}
+pragma::rendering::RenderBoundsStorage &CRenderComponent::GetRenderBoundsStorage()
+{
+	static pragma::rendering::RenderBoundsStorage storage {};
+	return storage;
+}
 const std::shared_ptr<prosper::IUniformResizableBuffer> &CRenderComponent::GetInstanceBuffer() {return s_instanceBuffer;}
 void CRenderComponent::ClearBuffers()
 {
@@ -17,6 +17,7 @@
 #include "pragma/entities/components/c_time_scale_component.hpp"
 #include "pragma/entities/components/c_attachable_component.hpp"
 #include "pragma/entities/environment/c_env_camera.h"
+#include "pragma/console/c_cvar.h"
 #include <pragma/asset/util_asset.hpp>
 #include <sprite_sheet_animation.hpp>
 #include <buffers/prosper_dynamic_resizable_buffer.hpp>
@@ -29,6 +30,7 @@
 #include <pragma/entities/entity_component_system_t.hpp>
 #include <pragma/entities/environment/effects/particlesystemdata.h>
 #include <pragma/util/util_game.hpp>
+#include <pragma/util/job_system.hpp>
 #include <datasystem_vector.h>
 #include <udm.hpp>
 
@@ -1619,59 +1621,60 @@ void CParticleSystemComponent::OnComplete()
 SpriteSheetAnimation *CParticleSystemComponent::GetSpriteSheetAnimation() {return m_spriteSheetAnimationData.get();}
 const SpriteSheetAnimation *CParticleSystemComponent::GetSpriteSheetAnimation() const {return const_cast<CParticleSystemComponent*>(this)->GetSpriteSheetAnimation();}
 
-void CParticleSystemComponent::Simulate(double tDelta)
+bool CParticleSystemComponent::IntegrateAngularVelocity(CParticle &p,double tDelta)
 {
-	auto *cam = c_game->GetPrimaryCamera();
-	if(!IsActiveOrPaused() || cam == nullptr)
-		return;
-	util::ScopeGuard sg {[this,tDelta]() {m_simulationTime += tDelta;}}; // Increment simulation time once this tick is complete
+	auto velAng = p.GetAngularVelocity() *static_cast<float>(tDelta);
+	if(uvec::length_sqr(velAng) == 0.f)
+		return false;
+	// Update world rotation
+	auto rotOld = p.GetWorldRotation();
+	auto rotNew = glm::quat_cast(glm::eulerAngleYXZ(velAng.y,velAng.x,velAng.z)) *rotOld;
+	p.SetWorldRotation(rotNew);
 
-	auto pTsComponent = GetEntity().GetTimeScaleComponent();
-	if(pTsComponent.valid())
-		tDelta *= pTsComponent->GetTimeScale();
-	m_tLifeTime += tDelta;
+	// Update sprite rotation
+	auto rot = p.GetRotation();
+	rot += umath::rad_to_deg(velAng.y);
+	p.SetRotation(rot);
+	return rotOld.w != rotNew.w || rotOld.x != rotNew.x || rotOld.y != rotNew.y || rotOld.z != rotNew.z;
+}
 
+void CParticleSystemComponent::UpdateParticleLifetimes(float tDelta)
+{
 	m_numParticles = 0;
-	m_numRenderParticles = 0;
+	m_simulationState.expiredParticles.clear();
 	for(auto i=decltype(m_maxParticlesCur){0};i<m_maxParticlesCur;++i)
 	{
 		auto &p = m_particles[i];
 		auto life = p.GetLife();
 		if(life > 0.f)
 		{
-			life -= static_cast<float>(tDelta);
+			life -= tDelta;
 			p.SetLife(life);
-			p.SetTimeAlive(p.GetTimeAlive() +static_cast<float>(tDelta));
+			p.SetTimeAlive(p.GetTimeAlive() +tDelta);
 			if(life > 0)
 				m_numParticles++;
 			else
 				p.SetCameraDistance(-1);
 		}
 		if(life <= 0.f && p.IsAlive())
-		{
-			OnParticleDestroyed(p);
-			p.SetAlive(false);
-		}
+			m_simulationState.expiredParticles.push_back(i);
 	}
+}
 
-	// Simulate particle operators
-	// This has to be before particles are created, otherwise operators like
-	// "emission_rate_random" will not work properly!
-	for(auto &op : m_operators)
-		op->Simulate(tDelta);
-	//unsigned int numRender = 0;
-	if(umath::is_flag_set(m_flags,Flags::MoveWithEmitter) || umath::is_flag_set(m_flags,Flags::RotateWithEmitter))
+void CParticleSystemComponent::DestroyExpiredParticles()
+{
+	for(auto idx : m_simulationState.expiredParticles)
 	{
-		auto pAttComponent = GetEntity().GetComponent<pragma::CAttachableComponent>();
-		if(pAttComponent.valid())
-			pAttComponent->UpdateAttachmentOffset();
+		auto &p = m_particles[idx];
+		OnParticleDestroyed(p);
+		p.SetAlive(false);
 	}
+	m_simulationState.expiredParticles.clear();
+}
 
-	auto bMoving = (umath::is_flag_set(m_flags,Flags::MoveWithEmitter) && GetEntity().HasStateFlag(BaseEntity::StateFlags::PositionChanged))
-		|| (umath::is_flag_set(m_flags,Flags::RotateWithEmitter) && GetEntity().HasStateFlag(BaseEntity::StateFlags::RotationChanged));
-	umath::set_flag(m_flags,Flags::HasMovingParticles,bMoving);
+void CParticleSystemComponent::SimulateParticles(double tDelta,const Vector3 &posCam)
+{
 	auto &pose = GetEntity().GetPose();
-	auto &posCam = cam->GetEntity().GetPosition();
 	for(auto i=decltype(m_maxParticlesCur){0};i<m_maxParticlesCur;++i)
 	{
 		auto &p = m_particles[i];
@@ -1683,21 +1686,8 @@ void CParticleSystemComponent::Simulate(double tDelta)
 			for(auto &op : m_operators)
 				op->Simulate(p,tDelta);
 
-			auto velAng = p.GetAngularVelocity() *static_cast<float>(tDelta);
-			if(uvec::length_sqr(velAng) > 0.f)
-			{
-				// Update world rotation
-				auto rotOld = p.GetWorldRotation();
-				auto rotNew = glm::quat_cast(glm::eulerAngleYXZ(velAng.y,velAng.x,velAng.z)) *rotOld;
-				p.SetWorldRotation(rotNew);
-				if(rotOld.w != rotNew.w || rotOld.x != rotNew.x || rotOld.y != rotNew.y || rotOld.z != rotNew.z)
-					umath::set_flag(m_flags,Flags::HasMovingParticles,true);
-
-				// Update sprite rotation
-				auto rot = p.GetRotation();
-				rot += umath::rad_to_deg(velAng.y);
-				p.SetRotation(rot);
-			}
+			if(IntegrateAngularVelocity(p,tDelta))
+				umath::set_flag(m_flags,Flags::HasMovingParticles,true);
 
 			auto pos = p.GetPosition();
 			auto &vel = p.GetVelocity();
@@ -1714,10 +1704,235 @@ void CParticleSystemComponent::Simulate(double tDelta)
 			p.SetCameraDistance(glm::length2(pos -posCam));
 			for(auto &op : m_operators)
 				op->PostSimulate(p,tDelta);
-			//numRender++;
 		}
 	}
-	//
+}
+
+void CParticleSystemComponent::SimulateParticleBatches(JobSystem *jobSystem,JobCounter *counter)
+{
+	auto &state = m_simulationState;
+	UpdateParticleLifetimes(static_cast<float>(state.tDelta));
+
+	// Copy the live particles into the SoA storage, so each operator only has to be called once per batch
+	m_particleStorage.Resize(m_maxParticlesCur);
+	uint32_t numLive = 0;
+	for(auto i=decltype(m_maxParticlesCur){0};i<m_maxParticlesCur;++i)
+	{
+		auto &p = m_particles[i];
+		if(p.GetLife() > 0.f)
+			m_particleStorage.Gather(numLive++,p,i);
+	}
+	m_particleStorage.Resize(numLive);
+
+	auto numBatches = (numLive +PARTICLE_BATCH_SIZE -1) /PARTICLE_BATCH_SIZE;
+	state.batchMovement.clear();
+	state.batchMovement.resize(numBatches,0);
+	for(auto i=decltype(numBatches){1};i<numBatches;++i)
+	{
+		auto offset = i *PARTICLE_BATCH_SIZE;
+		auto count = umath::min(PARTICLE_BATCH_SIZE,numLive -offset);
+		if(jobSystem == nullptr)
+		{
+			state.batchMovement[i] = SimulateParticleBatch(offset,count);
+			continue;
+		}
+		jobSystem->Schedule([this,i,offset,count]() {
+			m_simulationState.batchMovement[i] = SimulateParticleBatch(offset,count);
+		},counter);
+	}
+	// The first batch is simulated by the current thread
+	if(numBatches > 0)
+		state.batchMovement.front() = SimulateParticleBatch(0,umath::min(PARTICLE_BATCH_SIZE,numLive));
+}
+
+bool CParticleSystemComponent::SimulateParticleBatch(uint32_t offset,uint32_t count)
+{
+	auto &state = m_simulationState;
+	auto span = m_particleStorage.GetSpan().GetSubSpan(offset,count);
+	for(auto &op : m_operators)
+		op->PreSimulate(span,state.tDelta);
+	for(auto &op : m_operators)
+		op->Simulate(span,state.tDelta);
+
+	auto moving = span.IntegrateVelocity(static_cast<float>(state.tDelta),state.velocityRotation ? &*state.velocityRotation : nullptr,state.cameraPosition);
+	for(auto &op : m_operators)
+		op->PostSimulate(span,state.tDelta);
+
+	// Batched operators don't modify the angular velocity or rotation, so it doesn't matter that the
+	// angular velocity is applied after the post-simulation step here
+	for(auto i=decltype(count){0};i<count;++i)
+	{
+		auto &p = m_particles[span.particleIndices[i]];
+		m_particleStorage.Scatter(offset +i,p);
+		if(IntegrateAngularVelocity(p,state.tDelta))
+			moving = true;
+	}
+	return moving;
+}
+
+static CVar cvMultithreadedSimulation = GetClientConVar("cl_particle_simulation_multithreaded");
+void CParticleSystemComponent::Simulate(const std::vector<CParticleSystemComponent*> &particleSystems,double tDelta)
+{
+	auto *jobSystem = cvMultithreadedSimulation->GetBool() ? &c_engine->GetJobSystem() : nullptr;
+	JobCounter counter {};
+
+	// Child systems are simulated once the emission of their parent has been updated, so the systems are
+	// simulated one hierarchy level at a time. All systems of the same level are simulated together.
+	std::vector<::util::WeakHandle<CParticleSystemComponent>> systems;
+	std::vector<::util::WeakHandle<CParticleSystemComponent>> levelSystems;
+	std::vector<std::pair<CParticleSystemComponent*,double>> level;
+	std::vector<std::pair<CParticleSystemComponent*,double>> nextLevel;
+	level.reserve(particleSystems.size());
+	for(auto *ps : particleSystems)
+		level.push_back({ps,tDelta});
+	while(level.empty() == false)
+	{
+		levelSystems.clear();
+		for(auto &pair : level)
+		{
+			if(pair.first->BeginSimulation(pair.second))
+				levelSystems.push_back(::util::WeakHandle<CParticleSystemComponent>{std::static_pointer_cast<CParticleSystemComponent>(pair.first->shared_from_this())});
+		}
+
+		// Operators may have removed particle systems during BeginSimulation
+		for(auto &hSystem : levelSystems)
+		{
+			if(hSystem.expired() || hSystem->m_simulationState.batched == false)
+				continue;
+			auto *ps = hSystem.get();
+			if(jobSystem == nullptr)
+			{
+				ps->SimulateParticleBatches(nullptr,nullptr);
+				continue;
+			}
+			jobSystem->Schedule([ps,jobSystem,&counter]() {ps->SimulateParticleBatches(jobSystem,&counter);},&counter);
+		}
+		if(jobSystem)
+			jobSystem->Wait(counter);
+
+		// Operators which don't support batch simulation may call into Lua, so these systems are simulated after
+		// all jobs have been completed
+		for(auto &hSystem : levelSystems)
+		{
+			if(hSystem.expired())
+				continue;
+			auto &state = hSystem->m_simulationState;
+			if(state.batched == false)
+				hSystem->SimulateParticles(state.tDelta,state.cameraPosition);
+		}
+
+		nextLevel.clear();
+		for(auto &hSystem : levelSystems)
+		{
+			if(hSystem.expired())
+				continue;
+			auto &state = hSystem->m_simulationState;
+			state.updateInstanceData = hSystem->UpdateEmission();
+			if(state.simulateChildren == false)
+				continue;
+			for(auto &hChild : hSystem->m_childSystems)
+			{
+				if(hChild.child.valid() && hChild.child->IsActiveOrPaused())
+					nextLevel.push_back({hChild.child.get(),state.tDelta});
+			}
+		}
+		systems.insert(systems.end(),levelSystems.begin(),levelSystems.end());
+		level.swap(nextLevel);
+	}
+	if(systems.empty())
+		return;
+
+	// Render callbacks of a parent are called after its children have been simulated
+	for(auto it=systems.rbegin();it!=systems.rend();++it)
+	{
+		auto &hSystem = *it;
+		if(hSystem.expired() || hSystem->m_simulationState.updateInstanceData == false)
+			continue;
+		hSystem->InvokeRenderCallbacks();
+	}
+	for(auto &hSystem : systems)
+	{
+		if(hSystem.expired() || hSystem->m_simulationState.updateInstanceData == false)
+			continue;
+		auto *ps = hSystem.get();
+		if(jobSystem == nullptr)
+		{
+			ps->UpdateInstanceData();
+			continue;
+		}
+		jobSystem->Schedule([ps]() {ps->UpdateInstanceData();},&counter);
+	}
+	if(jobSystem)
+		jobSystem->Wait(counter);
+
+	for(auto &hSystem : systems)
+	{
+		if(hSystem.expired())
+			continue;
+		hSystem->EndSimulation();
+	}
+}
+
+void CParticleSystemComponent::Simulate(double tDelta) {Simulate(std::vector<CParticleSystemComponent*>{this},tDelta);}
+
+bool CParticleSystemComponent::BeginSimulation(double tDelta)
+{
+	auto *cam = c_game->GetPrimaryCamera();
+	if(!IsActiveOrPaused() || cam == nullptr)
+		return false;
+	auto &state = m_simulationState;
+	state.tDeltaUnscaled = tDelta; // Simulation time is incremented once this tick is complete
+	state.updateInstanceData = false;
+	state.simulateChildren = false;
+
+	auto pTsComponent = GetEntity().GetTimeScaleComponent();
+	if(pTsComponent.valid())
+		tDelta *= pTsComponent->GetTimeScale();
+	state.tDelta = tDelta;
+	m_tLifeTime += tDelta;
+
+	m_numRenderParticles = 0;
+	state.batched = std::all_of(m_operators.begin(),m_operators.end(),[](const std::unique_ptr<CParticleOperator,void(*)(CParticleOperator*)> &op) {
+		return op->SupportsBatchSimulation();
+	});
+	// The lifetimes of batched systems are updated together with the particle simulation
+	if(state.batched == false)
+	{
+		UpdateParticleLifetimes(static_cast<float>(tDelta));
+		DestroyExpiredParticles();
+	}
+
+	// Simulate particle operators
+	// This has to be before particles are created, otherwise operators like
+	// "emission_rate_random" will not work properly!
+	for(auto &op : m_operators)
+		op->Simulate(tDelta);
+	//unsigned int numRender = 0;
+	if(umath::is_flag_set(m_flags,Flags::MoveWithEmitter) || umath::is_flag_set(m_flags,Flags::RotateWithEmitter))
+	{
+		auto pAttComponent = GetEntity().GetComponent<pragma::CAttachableComponent>();
+		if(pAttComponent.valid())
+			pAttComponent->UpdateAttachmentOffset();
+	}
+
+	auto bMoving = (umath::is_flag_set(m_flags,Flags::MoveWithEmitter) && GetEntity().HasStateFlag(BaseEntity::StateFlags::PositionChanged))
+		|| (umath::is_flag_set(m_flags,Flags::RotateWithEmitter) && GetEntity().HasStateFlag(BaseEntity::StateFlags::RotationChanged));
+	umath::set_flag(m_flags,Flags::HasMovingParticles,bMoving);
+	state.cameraPosition = cam->GetEntity().GetPosition();
+	state.velocityRotation = umath::is_flag_set(m_flags,Flags::RotateWithEmitter) ? GetEntity().GetPose().GetRotation() : std::optional<Quat>{};
+	return true;
+}
+
+bool CParticleSystemComponent::UpdateEmission()
+{
+	auto &state = m_simulationState;
+	auto tDelta = state.tDelta;
+	if(state.batched)
+	{
+		DestroyExpiredParticles();
+		if(std::find(state.batchMovement.begin(),state.batchMovement.end(),1) != state.batchMovement.end())
+			umath::set_flag(m_flags,Flags::HasMovingParticles,true);
+	}
 
 	auto numFill = m_maxParticlesCur -m_numParticles;
 	auto bEmissionPaused = IsEmissionPaused();
@@ -1768,18 +1983,6 @@ void CParticleSystemComponent::Simulate(double tDelta)
 		m_numParticles += numCreate;
 	}
 
-	auto bChildrenSimulated = false;
-	const auto fSimulateChildren = [this,tDelta,&bChildrenSimulated]() {
-		if(bChildrenSimulated)
-			return;
-		bChildrenSimulated = true;
-		for(auto &hChild : m_childSystems)
-		{
-			if(hChild.child.valid() && hChild.child->IsActiveOrPaused())
-				hChild.child->Simulate(tDelta);
-		}
-	};
-
 	if(
 		m_numParticles == 0 && IsContinuous() == false && m_tLastEmission != 0.0 && bEmissionPaused == false && 
 		(m_currentParticleLimit == 0u || m_currentParticleLimit == std::numeric_limits<uint32_t>::max())
@@ -1801,15 +2004,38 @@ void CParticleSystemComponent::Simulate(double tDelta)
 			// This can happen if no particles are being emitted for some time. Find a better way to handle this!
 			m_state = State::Complete;
 			OnComplete();
-			return;
+			return false;
 		}
-		fSimulateChildren();
+		state.simulateChildren = true;
 		if(umath::is_flag_set(m_flags,Flags::AlwaysSimulate) == false)
-			return;
+			return false;
 	}
+	state.simulateChildren = true;
+	return true;
+}
+
+void CParticleSystemComponent::InvokeRenderCallbacks()
+{
+	if(m_maxParticlesCur == 0)
+		return;
+	// Last chance to update particle transforms and such
+	for(auto it=m_renderCallbacks.begin();it!=m_renderCallbacks.end();)
+	{
+		auto &hCb = *it;
+		if(hCb.IsValid() == false)
+		{
+			it = m_renderCallbacks.erase(it);
+			continue;
+		}
+		hCb();
+		++it;
+	}
+}
+
+void CParticleSystemComponent::UpdateInstanceData()
+{
 	if(umath::is_flag_set(m_flags,Flags::SortParticles))
 		SortParticles(); // TODO Sort every frame?
-	fSimulateChildren();
 
 	auto constexpr enableDynamicBounds = false;
 	auto bStatic = IsStatic();
@@ -1819,21 +2045,6 @@ void CParticleSystemComponent::Simulate(double tDelta)
 		m_renderBounds.first = uvec::MAX;
 		m_renderBounds.second = uvec::MIN;
 	}
-	if(m_maxParticlesCur > 0)
-	{
-		// Call render callbacks; Last chance to update particle transforms and such
-		for(auto it=m_renderCallbacks.begin();it!=m_renderCallbacks.end();)
-		{
-			auto &hCb = *it;
-			if(hCb.IsValid() == false)
-			{
-				it = m_renderCallbacks.erase(it);
-				continue;
-			}
-			hCb();
-			++it;
-		}
-	}
 	auto pTrComponent = GetEntity().GetTransformComponent();
 	auto psPos = pTrComponent != nullptr ? pTrComponent->GetPosition() : Vector3{};
 	auto alphaMode = GetEffectiveAlphaMode();
@@ -1909,6 +2120,19 @@ void CParticleSystemComponent::Simulate(double tDelta)
 	{
 		if(m_numRenderParticles == 0)
 			m_renderBounds = {{},{}};
+	}
+}
+
+void CParticleSystemComponent::EndSimulation()
+{
+	auto &state = m_simulationState;
+	util::ScopeGuard sg {[this,&state]() {m_simulationTime += state.tDeltaUnscaled;}};
+	if(state.updateInstanceData == false)
+		return;
+	auto constexpr enableDynamicBounds = false;
+	if constexpr(enableDynamicBounds)
+	{
+		// Renderers may be implemented in Lua, so their bounds can't be queried from UpdateInstanceData
 		for(auto &r : m_renderers)
 		{
 			auto rendererBounds = r->GetRenderBounds();
@@ -1916,7 +2140,7 @@ void CParticleSystemComponent::Simulate(double tDelta)
 		}
 	}
 	auto &bufParticles = GetParticleBuffer();
-	auto bUpdateBuffers = (bStatic == false || m_numRenderParticles != m_numPrevRenderParticles) ? true : false;
+	auto bUpdateBuffers = (IsStatic() == false || m_numRenderParticles != m_numPrevRenderParticles) ? true : false;
 	m_numPrevRenderParticles = m_numRenderParticles;
 	if(bufParticles != nullptr && bUpdateBuffers == true && m_numRenderParticles > 0u)
 	{
@@ -1930,7 +2154,7 @@ void CParticleSystemComponent::Simulate(double tDelta)
 			c_engine->GetRenderContext().ScheduleRecordUpdateBuffer(particleAnimBuffer,0ull,m_numRenderParticles *sizeof(ParticleAnimationData),m_particleAnimData.data());
 	}
 	for(auto &r : m_renderers)
-		r->PostSimulate(tDelta);
+		r->PostSimulate(state.tDelta);
 }
 
 const std::vector<CParticleSystemComponent::ChildData> &CParticleSystemComponent::GetChildren() const {return const_cast<CParticleSystemComponent*>(this)->GetChildren();}
@@ -66,6 +66,7 @@ void COcclusionCullerComponent::AddEntity(CBaseEntity &ent)
 			return;
 		SceneRenderDesc::AssertRenderQueueThreadInactive();
 		m_occlusionOctree->InsertObject(ent);
+		InsertAabbTreeProxy(*ent);
 		auto pTrComponent = ent->GetTransformComponent();
 		if(pTrComponent != nullptr)
 		{
@@ -79,7 +80,10 @@ void COcclusionCullerComponent::AddEntity(CBaseEntity &ent)
 				// In those cases we still mustn't update the entity in the octree though, so we
 				// check for it here. TODO: This is a messy solution, find a better way!
 				if(SceneRenderDesc::GetActiveRenderQueueThreadCount() == 0)
+				{
 					m_occlusionOctree->UpdateObject(ent);
+					UpdateAabbTreeProxy(*ent);
+				}
 				return util::EventReply::Unhandled;
 			}));
 		}
@@ -90,11 +94,13 @@ void COcclusionCullerComponent::AddEntity(CBaseEntity &ent)
 				SceneRenderDesc::AssertRenderQueueThreadInactive();
 				auto *ent = static_cast<CBaseEntity*>(&pGenericComponent->GetEntity());
 				m_occlusionOctree->UpdateObject(ent);
+				UpdateAabbTreeProxy(*ent);
 			}));
 			it->second.push_back(pGenericComponent->BindEventUnhandled(pragma::CRenderComponent::EVENT_ON_RENDER_BOUNDS_CHANGED,[this,pGenericComponent](std::reference_wrapper<pragma::ComponentEvent> evData) mutable {
 				SceneRenderDesc::AssertRenderQueueThreadInactive();
 				auto *ent = static_cast<CBaseEntity*>(&pGenericComponent->GetEntity());
 				m_occlusionOctree->UpdateObject(ent);
+				UpdateAabbTreeProxy(*ent);
 			}));
 			it->second.push_back(pGenericComponent->BindEventUnhandled(BaseEntity::EVENT_ON_REMOVE,[this,pGenericComponent](std::reference_wrapper<pragma::ComponentEvent> evData) mutable {
 				auto *ent = static_cast<CBaseEntity*>(&pGenericComponent->GetEntity());
@@ -111,6 +117,7 @@ void COcclusionCullerComponent::AddEntity(CBaseEntity &ent)
 				}
 				SceneRenderDesc::AssertRenderQueueThreadInactive();
 				m_occlusionOctree->RemoveObject(ent);
+				RemoveAabbTreeProxy(*ent);
 			}));
 		}
 	};
@@ -134,7 +141,10 @@ void COcclusionCullerComponent::AddEntity(CBaseEntity &ent)
 				fInsertOctreeObject(&ent);
 		}
 		else
+		{
 			occlusionTree.RemoveObject(&ent);
+			RemoveAabbTreeProxy(ent);
+		}
 		return util::EventReply::Unhandled;
 	});
 	pRenderComponent->AddEventCallback(CRenderComponent::EVENT_ON_RENDER_MODE_CHANGED,cbRenderMode);
@@ -146,6 +156,35 @@ void COcclusionCullerComponent::AddEntity(CBaseEntity &ent)
 
 const OcclusionOctree<CBaseEntity*> &COcclusionCullerComponent::GetOcclusionOctree() const {return const_cast<COcclusionCullerComponent*>(this)->GetOcclusionOctree();}
 OcclusionOctree<CBaseEntity*> &COcclusionCullerComponent::GetOcclusionOctree() {return *m_occlusionOctree;}
+const DynamicAabbTree &COcclusionCullerComponent::GetAabbTree() const {return const_cast<COcclusionCullerComponent*>(this)->GetAabbTree();}
+DynamicAabbTree &COcclusionCullerComponent::GetAabbTree() {return m_aabbTree;}
+
+void COcclusionCullerComponent::InsertAabbTreeProxy(CBaseEntity &ent)
+{
+	if(m_aabbTreeProxies.find(&ent) != m_aabbTreeProxies.end())
+	{
+		UpdateAabbTreeProxy(ent);
+		return;
+	}
+	auto &renderBounds = ent.GetAbsoluteRenderBounds();
+	m_aabbTreeProxies[&ent] = m_aabbTree.CreateProxy(renderBounds.min,renderBounds.max,ent.GetLocalIndex());
+}
+void COcclusionCullerComponent::UpdateAabbTreeProxy(CBaseEntity &ent)
+{
+	auto it = m_aabbTreeProxies.find(&ent);
+	if(it == m_aabbTreeProxies.end())
+		return;
+	auto &renderBounds = ent.GetAbsoluteRenderBounds();
+	m_aabbTree.MoveProxy(it->second,renderBounds.min,renderBounds.max);
+}
+void COcclusionCullerComponent::RemoveAabbTreeProxy(CBaseEntity &ent)
+{
+	auto it = m_aabbTreeProxies.find(&ent);
+	if(it == m_aabbTreeProxies.end())
+		return;
+	m_aabbTree.DestroyProxy(it->second);
+	m_aabbTreeProxies.erase(it);
+}
 
 void COcclusionCullerComponent::OnRemove()
 {
@@ -159,6 +198,9 @@ void COcclusionCullerComponent::OnRemove()
 			hCb.Remove();
 		}
 	}
+	m_callbacks.clear();
+	m_aabbTreeProxies.clear();
+	m_aabbTree.Clear();
 }
 
 void COcclusionCullerComponent::OnEntitySpawn()
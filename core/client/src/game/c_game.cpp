@@ -132,18 +132,33 @@ bool CGame::MessagePacketTracker::IsMessageInOrder(uint8_t messageId) const
 	return (messageTimestamps[messageId] > messageTimestamps[lastInMessageId]) ? true : false;
 }
 
+void CGame::MessagePacketTracker::UpdateReceivedMessageMask(uint8_t messageId)
+{
+	if(hasReceivedMessage == false)
+	{
+		receivedMessageMask = 0;
+		return;
+	}
+	// The previous message moves to bit 'shift -1', everything older is shifted along with it
+	auto shift = static_cast<uint8_t>(messageId -lastInMessageId);
+	receivedMessageMask = (shift > 0 && shift <= 32) ? static_cast<uint32_t>(((static_cast<uint64_t>(receivedMessageMask)<<1u) | 1u)<<(shift -1u)) : 0u;
+}
+
 void CGame::MessagePacketTracker::CheckMessages(uint8_t messageId,std::vector<double> &lostPacketTimestamps,const double &tCur)
 {
+	UpdateReceivedMessageMask(messageId);
 	if(messageId != static_cast<decltype(messageId)>(lastInMessageId +1)) // We've lost at least 1 packet
 	{
 		for(auto id=static_cast<decltype(messageId)>(lastInMessageId +1);id!=messageId;++id) // Assume all messages inbetween are lost packets
 			lostPacketTimestamps.push_back(tCur);
 	}
 	lastInMessageId = messageId;
+	hasReceivedMessage = true;
 }
 
 void CGame::MessagePacketTracker::CheckMessages(uint8_t messageId,std::vector<double> &lostPacketTimestamps)
 {
+	UpdateReceivedMessageMask(messageId);
 	if(messageId != static_cast<decltype(messageId)>(lastInMessageId +1)) // We've lost at least 1 packet
 	{
 		for(auto id=static_cast<decltype(messageId)>(lastInMessageId +1);id!=messageId;++id) // Check which packets we've lost
@@ -154,6 +169,7 @@ void CGame::MessagePacketTracker::CheckMessages(uint8_t messageId,std::vector<do
 		}
 	}
 	lastInMessageId = messageId;
+	hasReceivedMessage = true;
 }
 
 //////////////////////////
@@ -1513,6 +1529,14 @@ void CGame::SendUserInput()
 		for(auto v : actionValues)
 			p->Write<float>(pl->GetActionInputAxisMagnitude(static_cast<Action>(v)));
 	}
+	// Acknowledge the last snapshots we've received, so the server can use them as baseline for delta compression.
+	// Input packets are unreliable, so the previous snapshots are acknowledged again as well.
+	p->Write<bool>(m_snapshotTracker.hasReceivedMessage);
+	if(m_snapshotTracker.hasReceivedMessage)
+	{
+		p->Write<uint8_t>(m_snapshotTracker.lastInMessageId);
+		p->Write<uint32_t>(m_snapshotTracker.receivedMessageMask);
+	}
 	client->SendPacket("userinput",p,pragma::networking::Protocol::FastUnreliable);
 }
 
@@ -1559,21 +1583,26 @@ void CGame::ReceiveSnapshot(NetPacket &packet)
 	for(unsigned int i=0;i<numEnts;i++)
 	{
 		CBaseEntity *ent = static_cast<CBaseEntity*>(nwm::read_entity(packet));
-		Vector3 pos = nwm::read_vector(packet);
-		Vector3 vel = nwm::read_vector(packet);
-		Vector3 angVel = nwm::read_vector(packet);
-		auto orientation = nwm::read_quat(packet);
-		auto entDataSize = packet->Read<UInt8>();
+		// Fields that haven't changed since the last acknowledged snapshot are omitted by the server
+		auto fields = packet->Read<pragma::SnapshotEntityFieldFlags>();
+		auto hasField = [fields](pragma::SnapshotEntityFieldFlags field) {return (fields &field) != pragma::SnapshotEntityFieldFlags::None;};
+		auto pTrComponent = (ent != nullptr) ? ent->GetTransformComponent() : nullptr;
+		auto pVelComponent = (ent != nullptr) ? ent->GetComponent<pragma::VelocityComponent>() : pragma::ComponentHandle<pragma::VelocityComponent>{};
+		auto posEnt = pTrComponent != nullptr ? pTrComponent->GetPosition() : Vector3{};
+		Vector3 pos = hasField(pragma::SnapshotEntityFieldFlags::Position) ? nwm::read_vector(packet) : posEnt;
+		Vector3 vel = hasField(pragma::SnapshotEntityFieldFlags::Velocity) ? nwm::read_vector(packet) : (pVelComponent.valid() ? pVelComponent->GetVelocity() : Vector3{});
+		Vector3 angVel = hasField(pragma::SnapshotEntityFieldFlags::AngularVelocity) ? nwm::read_vector(packet) : (pVelComponent.valid() ? pVelComponent->GetAngularVelocity() : Vector3{});
+		auto orientation = hasField(pragma::SnapshotEntityFieldFlags::Rotation) ? nwm::read_quat(packet) : (pTrComponent != nullptr ? pTrComponent->GetRotation() : uquat::identity());
+		auto entDataSize = nwm::read_varint(packet);
 		if(ent != NULL)
 		{
-			pos += vel *tDelta;
-			if(uvec::length_sqr(angVel) > 0.0)
+			if(hasField(pragma::SnapshotEntityFieldFlags::Position))
+				pos += vel *tDelta;
+			if(hasField(pragma::SnapshotEntityFieldFlags::Rotation) && uvec::length_sqr(angVel) > 0.0)
 				orientation = uquat::create(EulerAngles(umath::rad_to_deg(angVel.x),umath::rad_to_deg(angVel.y),umath::rad_to_deg(angVel.z)) *tDelta) *orientation; // TODO: Check if this is correct
 
 			// Move the entity to the correct position without teleporting it.
 			// Teleporting can lead to odd physics glitches.
-			auto pTrComponent = ent->GetTransformComponent();
-			auto posEnt = pTrComponent != nullptr ? pTrComponent->GetPosition() : Vector3{};
 			auto correctionVel = pos -posEnt;
 			auto l = uvec::length_sqr(correctionVel);
 #ifdef ENABLE_DEPRECATED_PHYSICS
@@ -1581,7 +1610,7 @@ void CGame::ReceiveSnapshot(NetPacket &packet)
 			if(l > maxCorrectionDistance)
 #endif
 			{
-				if(pTrComponent != nullptr)
+				if(pTrComponent != nullptr && hasField(pragma::SnapshotEntityFieldFlags::Position))
 					pTrComponent->SetPosition(pos); // Too far away, just snap into position
 			}
 #ifdef ENABLE_DEPRECATED_PHYSICS
@@ -1594,13 +1623,14 @@ void CGame::ReceiveSnapshot(NetPacket &packet)
 			}
 #endif
 			//
-			auto pVelComponent = ent->GetComponent<pragma::VelocityComponent>();
 			if(pVelComponent.valid())
 			{
-				pVelComponent->SetVelocity(vel);
-				pVelComponent->SetAngularVelocity(angVel);
+				if(hasField(pragma::SnapshotEntityFieldFlags::Velocity))
+					pVelComponent->SetVelocity(vel);
+				if(hasField(pragma::SnapshotEntityFieldFlags::AngularVelocity))
+					pVelComponent->SetAngularVelocity(angVel);
 			}
-			if(pTrComponent != nullptr)
+			if(pTrComponent != nullptr && hasField(pragma::SnapshotEntityFieldFlags::Rotation))
 				pTrComponent->SetRotation(orientation);
 			ent->ReceiveSnapshotData(packet);
 		}
@@ -1676,11 +1706,11 @@ void CGame::ReceiveSnapshot(NetPacket &packet)
 			auto &componentManager = static_cast<pragma::CEntityComponentManager&>(GetEntityComponentManager());
 			auto &svComponentToClComponentTable = componentManager.GetServerComponentIdToClientComponentIdTable();
 			auto &componentTypes = componentManager.GetRegisteredComponentTypes();
-			auto numComponents = packet->Read<uint8_t>();
+			auto numComponents = nwm::read_varint(packet);
 			for(auto i=decltype(numComponents){0};i<numComponents;++i)
 			{
 				auto svId = packet->Read<pragma::ComponentId>();
-				auto componentSize = packet->Read<uint8_t>();
+				auto componentSize = nwm::read_varint(packet);
 				auto componentEndOffset = packet->GetOffset() +componentSize;
 				if(ent != nullptr && svId < svComponentToClComponentTable.size() && svComponentToClComponentTable.at(svId) != pragma::CEntityComponentManager::INVALID_COMPONENT)
 				{
@@ -0,0 +1,346 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright (c) 2021 Silverlan
+ */
+
+#include "stdafx_client.h"
+#include "pragma/particlesystem/c_particle_storage.hpp"
+#include "pragma/particlesystem/c_particle.h"
+#include "pragma/console/c_cvar_global_functions.h"
+#include <random>
+#include <chrono>
+#include <memory>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+	#define PRAGMA_PARTICLE_SSE
+	#include <xmmintrin.h>
+#endif
+
+using namespace pragma;
+
+ParticleSpan ParticleSpan::GetSubSpan(uint32_t offset,uint32_t count) const
+{
+	ParticleSpan span {};
+	for(auto i=decltype(fields.size()){0u};i<fields.size();++i)
+		span.fields[i] = fields[i] +offset;
+	span.particleIndices = particleIndices +offset;
+	span.size = count;
+	return span;
+}
+
+void ParticleSpan::AddVelocity(const Vector3 &v)
+{
+	auto *vx = GetField(Field::VelocityX);
+	auto *vy = GetField(Field::VelocityY);
+	auto *vz = GetField(Field::VelocityZ);
+	uint32_t i = 0;
+#ifdef PRAGMA_PARTICLE_SSE
+	auto dx = _mm_set1_ps(v.x);
+	auto dy = _mm_set1_ps(v.y);
+	auto dz = _mm_set1_ps(v.z);
+	for(;i +4 <= size;i+=4)
+	{
+		_mm_storeu_ps(vx +i,_mm_add_ps(_mm_loadu_ps(vx +i),dx));
+		_mm_storeu_ps(vy +i,_mm_add_ps(_mm_loadu_ps(vy +i),dy));
+		_mm_storeu_ps(vz +i,_mm_add_ps(_mm_loadu_ps(vz +i),dz));
+	}
+#endif
+	for(;i<size;++i)
+	{
+		vx[i] += v.x;
+		vy[i] += v.y;
+		vz[i] += v.z;
+	}
+}
+
+void ParticleSpan::ScaleVelocity(float factor)
+{
+	auto *vx = GetField(Field::VelocityX);
+	auto *vy = GetField(Field::VelocityY);
+	auto *vz = GetField(Field::VelocityZ);
+	uint32_t i = 0;
+#ifdef PRAGMA_PARTICLE_SSE
+	auto f = _mm_set1_ps(factor);
+	for(;i +4 <= size;i+=4)
+	{
+		_mm_storeu_ps(vx +i,_mm_mul_ps(_mm_loadu_ps(vx +i),f));
+		_mm_storeu_ps(vy +i,_mm_mul_ps(_mm_loadu_ps(vy +i),f));
+		_mm_storeu_ps(vz +i,_mm_mul_ps(_mm_loadu_ps(vz +i),f));
+	}
+#endif
+	for(;i<size;++i)
+	{
+		vx[i] *= factor;
+		vy[i] *= factor;
+		vz[i] *= factor;
+	}
+}
+
+void ParticleSpan::ApplyQuadraticDrag(float drag)
+{
+	auto *vx = GetField(Field::VelocityX);
+	auto *vy = GetField(Field::VelocityY);
+	auto *vz = GetField(Field::VelocityZ);
+	uint32_t i = 0;
+#ifdef PRAGMA_PARTICLE_SSE
+	auto d = _mm_set1_ps(drag);
+	auto one = _mm_set1_ps(1.f);
+	auto zero = _mm_setzero_ps();
+	for(;i +4 <= size;i+=4)
+	{
+		auto x = _mm_loadu_ps(vx +i);
+		auto y = _mm_loadu_ps(vy +i);
+		auto z = _mm_loadu_ps(vz +i);
+		auto l = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x,x),_mm_mul_ps(y,y)),_mm_mul_ps(z,z)));
+		auto f = _mm_max_ps(zero,_mm_sub_ps(one,_mm_mul_ps(d,l)));
+		_mm_storeu_ps(vx +i,_mm_mul_ps(x,f));
+		_mm_storeu_ps(vy +i,_mm_mul_ps(y,f));
+		_mm_storeu_ps(vz +i,_mm_mul_ps(z,f));
+	}
+#endif
+	for(;i<size;++i)
+	{
+		auto l = umath::sqrt(vx[i] *vx[i] +vy[i] *vy[i] +vz[i] *vz[i]);
+		auto f = umath::max(0.f,1.f -drag *l);
+		vx[i] *= f;
+		vy[i] *= f;
+		vz[i] *= f;
+	}
+}
+
+bool ParticleSpan::IntegrateVelocity(float tDelta,const Quat *velocityRotation,const Vector3 &camPos)
+{
+	// The rotation is the same for all particles, so we can apply it as a matrix
+	auto m = (velocityRotation != nullptr) ? glm::mat3_cast(*velocityRotation) : glm::mat3{1.f};
+	std::array<float,9> r {};
+	for(auto col=0u;col<3u;++col)
+	{
+		for(auto row=0u;row<3u;++row)
+			r[row *3 +col] = m[col][row] *tDelta;
+	}
+	auto *px = GetField(Field::PositionX);
+	auto *py = GetField(Field::PositionY);
+	auto *pz = GetField(Field::PositionZ);
+	auto *vx = GetField(Field::VelocityX);
+	auto *vy = GetField(Field::VelocityY);
+	auto *vz = GetField(Field::VelocityZ);
+	auto *camDist = GetField(Field::CameraDistance);
+	auto moved = false;
+	uint32_t i = 0;
+#ifdef PRAGMA_PARTICLE_SSE
+	__m128 rs[9];
+	for(auto j=0u;j<r.size();++j)
+		rs[j] = _mm_set1_ps(r[j]);
+	auto cx = _mm_set1_ps(camPos.x);
+	auto cy = _mm_set1_ps(camPos.y);
+	auto cz = _mm_set1_ps(camPos.z);
+	auto zero = _mm_setzero_ps();
+	auto movedMask = zero;
+	for(;i +4 <= size;i+=4)
+	{
+		auto x = _mm_loadu_ps(vx +i);
+		auto y = _mm_loadu_ps(vy +i);
+		auto z = _mm_loadu_ps(vz +i);
+		auto dx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(rs[0],x),_mm_mul_ps(rs[1],y)),_mm_mul_ps(rs[2],z));
+		auto dy = _mm_add_ps(_mm_add_ps(_mm_mul_ps(rs[3],x),_mm_mul_ps(rs[4],y)),_mm_mul_ps(rs[5],z));
+		auto dz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(rs[6],x),_mm_mul_ps(rs[7],y)),_mm_mul_ps(rs[8],z));
+		movedMask = _mm_or_ps(movedMask,_mm_cmpneq_ps(x,zero));
+		movedMask = _mm_or_ps(movedMask,_mm_cmpneq_ps(y,zero));
+		movedMask = _mm_or_ps(movedMask,_mm_cmpneq_ps(z,zero));
+		auto nx = _mm_add_ps(_mm_loadu_ps(px +i),dx);
+		auto ny = _mm_add_ps(_mm_loadu_ps(py +i),dy);
+		auto nz = _mm_add_ps(_mm_loadu_ps(pz +i),dz);
+		_mm_storeu_ps(px +i,nx);
+		_mm_storeu_ps(py +i,ny);
+		_mm_storeu_ps(pz +i,nz);
+		nx = _mm_sub_ps(nx,cx);
+		ny = _mm_sub_ps(ny,cy);
+		nz = _mm_sub_ps(nz,cz);
+		_mm_storeu_ps(camDist +i,_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx,nx),_mm_mul_ps(ny,ny)),_mm_mul_ps(nz,nz)));
+	}
+	moved = _mm_movemask_ps(movedMask) != 0;
+#endif
+	for(;i<size;++i)
+	{
+		if(vx[i] != 0.f || vy[i] != 0.f || vz[i] != 0.f)
+		{
+			px[i] += r[0] *vx[i] +r[1] *vy[i] +r[2] *vz[i];
+			py[i] += r[3] *vx[i] +r[4] *vy[i] +r[5] *vz[i];
+			pz[i] += r[6] *vx[i] +r[7] *vy[i] +r[8] *vz[i];
+			moved = true;
+		}
+		auto dx = px[i] -camPos.x;
+		auto dy = py[i] -camPos.y;
+		auto dz = pz[i] -camPos.z;
+		camDist[i] = dx *dx +dy *dy +dz *dz;
+	}
+	return moved;
+}
+
+//////////////////
+
+void ParticleStorage::Resize(uint32_t count)
+{
+	m_size = count;
+	if(count <= m_particleIndices.size())
+		return;
+	for(auto &field : m_fields)
+		field.resize(count);
+	m_particleIndices.resize(count);
+}
+
+ParticleSpan ParticleStorage::GetSpan()
+{
+	ParticleSpan span {};
+	for(auto i=decltype(m_fields.size()){0u};i<m_fields.size();++i)
+		span.fields[i] = m_fields[i].data();
+	span.particleIndices = m_particleIndices.data();
+	span.size = m_size;
+	return span;
+}
+
+void ParticleStorage::Gather(uint32_t idx,const CParticle &particle,uint32_t particleIndex)
+{
+	auto &pos = particle.GetPosition();
+	auto &vel = particle.GetVelocity();
+	auto &col = particle.GetColor();
+	for(uint8_t i=0;i<3;++i)
+	{
+		m_fields[umath::to_integral(ParticleSpan::Field::PositionX) +i][idx] = pos[i];
+		m_fields[umath::to_integral(ParticleSpan::Field::VelocityX) +i][idx] = vel[i];
+	}
+	for(uint8_t i=0;i<4;++i)
+		m_fields[umath::to_integral(ParticleSpan::Field::ColorR) +i][idx] = col[i];
+	m_fields[umath::to_integral(ParticleSpan::Field::Radius)][idx] = particle.GetRadius();
+	m_fields[umath::to_integral(ParticleSpan::Field::Life)][idx] = particle.GetLife();
+	m_fields[umath::to_integral(ParticleSpan::Field::TimeAlive)][idx] = particle.GetTimeAlive();
+	m_fields[umath::to_integral(ParticleSpan::Field::CameraDistance)][idx] = particle.GetCameraDistance();
+	m_particleIndices[idx] = particleIndex;
+}
+
+void ParticleStorage::Scatter(uint32_t idx,CParticle &particle) const
+{
+	auto getField = [this,idx](ParticleSpan::Field field,uint8_t offset=0) {return m_fields[umath::to_integral(field) +offset][idx];};
+	particle.SetPosition({getField(ParticleSpan::Field::PositionX),getField(ParticleSpan::Field::PositionX,1),getField(ParticleSpan::Field::PositionX,2)});
+	particle.SetVelocity({getField(ParticleSpan::Field::VelocityX),getField(ParticleSpan::Field::VelocityX,1),getField(ParticleSpan::Field::VelocityX,2)});
+	particle.SetColor(Vector4{getField(ParticleSpan::Field::ColorR),getField(ParticleSpan::Field::ColorR,1),getField(ParticleSpan::Field::ColorR,2),getField(ParticleSpan::Field::ColorR,3)});
+	particle.SetRadius(getField(ParticleSpan::Field::Radius));
+	particle.SetCameraDistance(getField(ParticleSpan::Field::CameraDistance));
+}
+
+//////////////////
+
+namespace
+{
+	// Per-particle reference implementation of the benchmarked operators, which mirrors the non-batched simulation path
+	struct BenchmarkParticle
+	{
+		Vector3 position;
+		Vector3 velocity;
+		float cameraDistance = 0.f;
+	};
+	struct BenchmarkOperator
+	{
+		virtual ~BenchmarkOperator()=default;
+		virtual void Simulate(BenchmarkParticle &pt)=0;
+	};
+	struct BenchmarkOperatorAddVelocity : public BenchmarkOperator
+	{
+		BenchmarkOperatorAddVelocity(const Vector3 &v) : v{v} {}
+		virtual void Simulate(BenchmarkParticle &pt) override {pt.velocity += v;}
+		Vector3 v;
+	};
+	struct BenchmarkOperatorLinearDrag : public BenchmarkOperator
+	{
+		BenchmarkOperatorLinearDrag(float drag) : drag{drag} {}
+		virtual void Simulate(BenchmarkParticle &pt) override {pt.velocity *= drag;}
+		float drag;
+	};
+	struct BenchmarkOperatorQuadraticDrag : public BenchmarkOperator
+	{
+		BenchmarkOperatorQuadraticDrag(float drag) : drag{drag} {}
+		virtual void Simulate(BenchmarkParticle &pt) override {pt.velocity *= umath::max(0.f,1.f -drag *uvec::length(pt.velocity));}
+		float drag;
+	};
+};
+
+void Console::commands::debug_particle_simulation_benchmark(NetworkState*,pragma::BasePlayerComponent*,std::vector<std::string> &argv)
+{
+	// Simulates synthetic particles with the gravity, wind, linear drag and quadratic drag kernels, which allows measuring
+	// the CPU cost without a particle system or GPU
+	auto numParticles = argv.empty() ? 1'000'000u : static_cast<uint32_t>(umath::max(util::to_int(argv[0]),1));
+	auto numIterations = (argv.size() > 1) ? static_cast<uint32_t>(umath::max(util::to_int(argv[1]),1)) : 10u;
+
+	std::mt19937 rng {0};
+	std::uniform_real_distribution<float> distPos {-1'000.f,1'000.f};
+	std::uniform_real_distribution<float> distVel {-100.f,100.f};
+	std::vector<BenchmarkParticle> particles;
+	particles.resize(numParticles);
+	ParticleStorage storage {};
+	storage.Resize(numParticles);
+	auto span = storage.GetSpan();
+	for(auto i=decltype(numParticles){0u};i<numParticles;++i)
+	{
+		auto &pt = particles[i];
+		pt.position = {distPos(rng),distPos(rng),distPos(rng)};
+		pt.velocity = {distVel(rng),distVel(rng),distVel(rng)};
+		for(uint8_t j=0;j<3;++j)
+		{
+			span.fields[umath::to_integral(ParticleSpan::Field::PositionX) +j][i] = pt.position[j];
+			span.fields[umath::to_integral(ParticleSpan::Field::VelocityX) +j][i] = pt.velocity[j];
+		}
+	}
+
+	constexpr auto tDelta = 1.f /60.f;
+	Vector3 gravity {0.f,-600.f *tDelta,0.f};
+	Vector3 wind {2.f *tDelta,0.f,0.f};
+	auto linearDrag = 1.f -0.5f *tDelta;
+	auto quadraticDrag = 0.001f *tDelta;
+	Vector3 camPos {0.f,0.f,0.f};
+	std::vector<std::unique_ptr<BenchmarkOperator>> operators;
+	operators.push_back(std::make_unique<BenchmarkOperatorAddVelocity>(gravity));
+	operators.push_back(std::make_unique<BenchmarkOperatorAddVelocity>(wind));
+	operators.push_back(std::make_unique<BenchmarkOperatorLinearDrag>(linearDrag));
+	operators.push_back(std::make_unique<BenchmarkOperatorQuadraticDrag>(quadraticDrag));
+
+	std::chrono::steady_clock::duration tScalar {0};
+	std::chrono::steady_clock::duration tBatch {0};
+	for(auto it=decltype(numIterations){0u};it<numIterations;++it)
+	{
+		auto t = std::chrono::steady_clock::now();
+		for(auto &pt : particles)
+		{
+			for(auto &op : operators)
+				op->Simulate(pt);
+			if(uvec::length(pt.velocity) > 0.f)
+				pt.position += pt.velocity *tDelta;
+			pt.cameraDistance = glm::length2(pt.position -camPos);
+		}
+		tScalar += std::chrono::steady_clock::now() -t;
+
+		t = std::chrono::steady_clock::now();
+		span.AddVelocity(gravity);
+		span.AddVelocity(wind);
+		span.ScaleVelocity(linearDrag);
+		span.ApplyQuadraticDrag(quadraticDrag);
+		span.IntegrateVelocity(tDelta,nullptr,camPos);
+		tBatch += std::chrono::steady_clock::now() -t;
+	}
+	uint32_t numMismatches = 0;
+	for(auto i=decltype(numParticles){0u};i<numParticles;++i)
+	{
+		auto &pt = particles[i];
+		Vector3 pos {span.GetField(ParticleSpan::Field::PositionX)[i],span.GetField(ParticleSpan::Field::PositionY)[i],span.GetField(ParticleSpan::Field::PositionZ)[i]};
+		if(uvec::distance(pos,pt.position) > 0.01f)
+			++numMismatches;
+	}
+	auto toMs = [numIterations](std::chrono::steady_clock::duration d) {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(d).count() /1'000'000.0 /static_cast<double>(numIterations);
+	};
+	Con::cout<<"Particle simulation benchmark ("<<numParticles<<" particles, "<<operators.size()<<" operators, "<<numIterations<<" iterations, average per iteration):"<<Con::endl;
+	Con::cout<<"Per-particle simulation: "<<toMs(tScalar)<<"ms; Batched SoA simulation: "<<toMs(tBatch)<<"ms"<<Con::endl;
+	if(numMismatches > 0)
+		Con::cwar<<"WARNING: Batched simulation disagrees with the per-particle simulation for "<<numMismatches<<" particles!"<<Con::endl;
+}
@@ -218,6 +218,11 @@ void CParticleOperator::Simulate(CParticle &particle,double tDelta,float strengt
 void CParticleOperator::PostSimulate(CParticle &particle,double tDelta)
 {}
 
+bool CParticleOperator::SupportsBatchSimulation() const {return false;}
+void CParticleOperator::PreSimulate(pragma::ParticleSpan &span,double tDelta) {}
+void CParticleOperator::Simulate(pragma::ParticleSpan &span,double tDelta) {}
+void CParticleOperator::PostSimulate(pragma::ParticleSpan &span,double tDelta) {}
+
 void CParticleOperatorLifespanDecay::Simulate(CParticle&,double,float strength)
 {}
 
@@ -27,6 +27,7 @@ float CParticleModifierComponentGradualFade::GetEndTime(CParticle &p) const
 	auto tEnd = m_fEnd.GetValue(p);
 	return GetTime(tEnd,p);
 }
+CParticleModifierComponentGradualFade::FadeTimes CParticleModifierComponentGradualFade::GetFadeTimes(CParticle &p) const {return {m_fStart.GetValue(p),m_fEnd.GetValue(p)};}
 bool CParticleModifierComponentGradualFade::GetFadeFraction(CParticle &p,float &outFraction) const
 {
 	auto tStart = GetStartTime(p);
@@ -41,6 +42,19 @@ bool CParticleModifierComponentGradualFade::GetFadeFraction(CParticle &p,float &
 	outFraction = (tDelta != 0.f) ? umath::clamp((t -tStart) /(tEnd -tStart),0.f,1.f) : 0.f;
 	return true;
 }
+bool CParticleModifierComponentGradualFade::GetFadeFraction(const FadeTimes &fadeTimes,float timeAlive,float lifeSpan,float &outFraction) const
+{
+	auto tStart = GetTime(fadeTimes.start,lifeSpan);
+	if(timeAlive < tStart)
+	{
+		outFraction = 0.f;
+		return false;
+	}
+	auto tEnd = GetTime(fadeTimes.end,lifeSpan);
+	auto tDelta = tEnd -tStart;
+	outFraction = (tDelta != 0.f) ? umath::clamp((timeAlive -tStart) /(tEnd -tStart),0.f,1.f) : 0.f;
+	return true;
+}
 float CParticleModifierComponentGradualFade::GetFadeFraction(CParticle &p) const
 {
 	auto fraction = 0.f;
@@ -54,6 +68,13 @@ bool CParticleModifierComponentGradualFade::GetEasedFadeFraction(CParticle &p,fl
 	outFraction = Ease(outFraction);
 	return true;
 }
+bool CParticleModifierComponentGradualFade::GetEasedFadeFraction(const FadeTimes &fadeTimes,float timeAlive,float lifeSpan,float &outFraction) const
+{
+	if(GetFadeFraction(fadeTimes,timeAlive,lifeSpan,outFraction) == false)
+		return false;
+	outFraction = Ease(outFraction);
+	return true;
+}
 float CParticleModifierComponentGradualFade::GetEasedFadeFraction(CParticle &p) const
 {
 	auto fraction = 0.f;
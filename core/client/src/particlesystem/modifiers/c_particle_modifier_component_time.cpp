@@ -22,17 +22,18 @@ void CParticleModifierComponentTime::Initialize(const std::string &prefix,const
 			m_bLifetimeFraction = util::to_boolean(it->second);
 	}
 }
-float CParticleModifierComponentTime::GetTime(float t,CParticle &p) const
+float CParticleModifierComponentTime::GetTime(float t,CParticle &p) const {return GetTime(t,p.GetLifeSpan());}
+float CParticleModifierComponentTime::GetTime(float t,float lifeSpan) const
 {
 	if(m_bLifetimeFraction == false)
 	{
 		if(t < 0.f)
-			t += p.GetLifeSpan();
+			t += lifeSpan;
 		return t;
 	}
 	if(t < 0.f)
 		t += 1.f;
-	return t *p.GetLifeSpan();
+	return t *lifeSpan;
 }
 
 
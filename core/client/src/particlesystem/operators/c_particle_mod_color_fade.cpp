@@ -8,6 +8,7 @@
 #include "stdafx_client.h"
 #include "pragma/particlesystem/operators/c_particle_mod_color_fade.h"
 #include "pragma/entities/environment/effects/c_env_particle_system.h"
+#include "pragma/particlesystem/c_particle_storage.hpp"
 
 REGISTER_PARTICLE_OPERATOR(color_fade,CParticleOperatorColorFade);
 
@@ -23,11 +24,18 @@ void CParticleOperatorColorFade::Initialize(pragma::CParticleSystemComponent &pS
 									  // Since that color cannot be known beforehand, we need to store it.
 	if(m_colorStart.IsSet() == false)
 		m_particleStartColors = std::make_unique<std::vector<Color>>(pSystem.GetMaxParticleCount(),Color(std::numeric_limits<int16_t>::max(),0,0,0));
+	m_particleFadeData.resize(pSystem.GetMaxParticleCount());
 }
 void CParticleOperatorColorFade::OnParticleCreated(CParticle &particle)
 {
+	auto &fadeData = m_particleFadeData.at(particle.GetIndex());
+	fadeData.fadeTimes = GetFadeTimes(particle);
+	fadeData.colorEnd = m_colorEnd.GetValue(particle);
 	if(m_particleStartColors == nullptr)
+	{
+		fadeData.colorStart = m_colorStart.GetValue(particle);
 		return;
+	}
 	m_particleStartColors->at(particle.GetIndex()) = Color(std::numeric_limits<int16_t>::max(),0,0,0);
 }
 void CParticleOperatorColorFade::Simulate(CParticle &particle,double,float strength)
@@ -51,8 +59,46 @@ void CParticleOperatorColorFade::Simulate(CParticle &particle,double,float stren
 		colorStart = m_colorStart.GetValue(particle);
 		componentFlags |= m_colorStart.GetComponentFlags();
 	}
+	particle.SetColor(CalcColor(colorStart,componentFlags,m_colorEnd.GetValue(particle),tFade));
+}
+void CParticleOperatorColorFade::Simulate(pragma::ParticleSpan &span,double tDelta)
+{
+	CParticleOperator::Simulate(span,tDelta);
+	auto *timeAlive = span.GetField(pragma::ParticleSpan::Field::TimeAlive);
+	auto *life = span.GetField(pragma::ParticleSpan::Field::Life);
+	std::array<float*,4> colors {
+		span.GetField(pragma::ParticleSpan::Field::ColorR),span.GetField(pragma::ParticleSpan::Field::ColorG),
+		span.GetField(pragma::ParticleSpan::Field::ColorB),span.GetField(pragma::ParticleSpan::Field::ColorA)
+	};
+	for(auto i=decltype(span.size){0u};i<span.size;++i)
+	{
+		auto ptIdx = span.particleIndices[i];
+		auto &fadeData = m_particleFadeData[ptIdx];
+		auto tFade = 0.f;
+		if(GetEasedFadeFraction(fadeData.fadeTimes,timeAlive[i],timeAlive[i] +life[i],tFade) == false)
+			continue;
+		auto colorStart = fadeData.colorStart;
+		auto componentFlags = CParticleModifierComponentRandomColor::ComponentFlags::None;
+		if(m_particleStartColors != nullptr)
+		{
+			// Use last known particle color
+			auto &ptColorStart = (*m_particleStartColors)[ptIdx];
+			if(ptColorStart.r == std::numeric_limits<int16_t>::max())
+				ptColorStart = Vector4{colors[0][i],colors[1][i],colors[2][i],colors[3][i]};
+			colorStart = ptColorStart;
+			componentFlags |= CParticleModifierComponentRandomColor::ComponentFlags::RGBA;
+		}
+		else
+			componentFlags |= m_colorStart.GetComponentFlags();
+		auto color = CalcColor(colorStart,componentFlags,fadeData.colorEnd,tFade).ToVector4();
+		for(uint8_t j=0;j<colors.size();++j)
+			colors[j][i] = color[j];
+	}
+}
+Color CParticleOperatorColorFade::CalcColor(const Color &colorStart,CParticleModifierComponentRandomColor::ComponentFlags componentFlags,const Color &colorEnd,float tFade) const
+{
 	componentFlags &= m_colorEnd.GetComponentFlags();
-	auto newColor = colorStart.Lerp(m_colorEnd.GetValue(particle),tFade);
+	auto newColor = colorStart.Lerp(colorEnd,tFade);
 
 	auto color = colorStart;
 	if((componentFlags &CParticleModifierComponentRandomColor::ComponentFlags::Red) != CParticleModifierComponentRandomColor::ComponentFlags::None)
@@ -63,6 +109,6 @@ void CParticleOperatorColorFade::Simulate(CParticle &particle,double,float stren
 		color.b = newColor.b;
 	if((componentFlags &CParticleModifierComponentRandomColor::ComponentFlags::Alpha) != CParticleModifierComponentRandomColor::ComponentFlags::None)
 		color.a = newColor.a;
-	particle.SetColor(color);
+	return color;
 }
 
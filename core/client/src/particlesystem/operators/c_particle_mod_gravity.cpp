@@ -8,6 +8,7 @@
 #include "stdafx_client.h"
 #include "pragma/particlesystem/operators/c_particle_mod_gravity.h"
 #include "pragma/entities/environment/effects/c_env_particle_system.h"
+#include "pragma/particlesystem/c_particle_storage.hpp"
 #include <mathutil/umath.h>
 #include <pragma/math/vector/wvvector3.h>
 #include <sharedutils/util_string.h>
@@ -53,3 +54,13 @@ void CParticleOperatorGravity::Simulate(CParticle &particle,double tDelta,float
 	auto &oldVel = particle.GetVelocity();
 	particle.SetVelocity(oldVel +(m_bUseCustomGravityForce ? m_gravityForce : gravity) *m_gravityScale *static_cast<float>(tDelta));
 }
+void CParticleOperatorGravity::Simulate(pragma::ParticleSpan &span,double tDelta)
+{
+	CParticleOperatorWorldBase::Simulate(span,tDelta);
+	if(m_bUseCustomGravityForce)
+	{
+		span.AddVelocity(m_dtGravity);
+		return;
+	}
+	span.AddVelocity(c_game->GetGravity() *m_gravityScale *static_cast<float>(tDelta));
+}
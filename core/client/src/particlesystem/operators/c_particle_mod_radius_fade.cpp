@@ -37,9 +37,19 @@ void CParticleOperatorRadiusFadeBase::Initialize(pragma::CParticleSystemComponen
 	// Since that radius cannot be known beforehand, we need to store it.
 	if(m_fRadiusStart.IsSet() == false)
 		m_particleStartRadiuses = std::make_unique<std::vector<float>>(pSystem.GetMaxParticleCount(),std::numeric_limits<float>::max());
+	if(GetRadiusField().has_value())
+		m_particleFadeData.resize(pSystem.GetMaxParticleCount());
 }
 void CParticleOperatorRadiusFadeBase::OnParticleCreated(CParticle &particle)
 {
+	if(m_particleFadeData.empty() == false)
+	{
+		auto &fadeData = m_particleFadeData.at(particle.GetIndex());
+		fadeData.fadeTimes = GetFadeTimes(particle);
+		fadeData.radiusEnd = m_fRadiusEnd.GetValue(particle);
+		if(m_particleStartRadiuses == nullptr)
+			fadeData.radiusStart = m_fRadiusStart.GetValue(particle);
+	}
 	if(m_particleStartRadiuses == nullptr)
 		return;
 	m_particleStartRadiuses->at(particle.GetIndex()) = std::numeric_limits<float>::max();
@@ -64,6 +74,34 @@ void CParticleOperatorRadiusFadeBase::Simulate(CParticle &particle,double,float
 	auto radius = radiusStart +(radiusEnd -radiusStart) *tFade;
 	ApplyRadius(particle,radius);
 }
+void CParticleOperatorRadiusFadeBase::Simulate(pragma::ParticleSpan &span,double tDelta)
+{
+	CParticleOperator::Simulate(span,tDelta);
+	auto field = GetRadiusField();
+	if(field.has_value() == false)
+		return;
+	auto *timeAlive = span.GetField(pragma::ParticleSpan::Field::TimeAlive);
+	auto *life = span.GetField(pragma::ParticleSpan::Field::Life);
+	auto *radii = span.GetField(*field);
+	for(auto i=decltype(span.size){0u};i<span.size;++i)
+	{
+		auto ptIdx = span.particleIndices[i];
+		auto &fadeData = m_particleFadeData[ptIdx];
+		auto tFade = 0.f;
+		if(GetEasedFadeFraction(fadeData.fadeTimes,timeAlive[i],timeAlive[i] +life[i],tFade) == false)
+			continue;
+		auto radiusStart = fadeData.radiusStart;
+		if(m_particleStartRadiuses != nullptr)
+		{
+			// Use last known particle radius
+			auto &ptRadiusStart = (*m_particleStartRadiuses)[ptIdx];
+			if(ptRadiusStart == std::numeric_limits<float>::max())
+				ptRadiusStart = radii[i];
+			radiusStart = ptRadiusStart;
+		}
+		radii[i] = radiusStart +(fadeData.radiusEnd -radiusStart) *tFade;
+	}
+}
 
 ////////////////////////////
 
@@ -7,6 +7,7 @@
 
 #include "stdafx_client.h"
 #include "pragma/particlesystem/operators/c_particle_mod_velocity.h"
+#include "pragma/particlesystem/c_particle_storage.hpp"
 #include <mathutil/umath.h>
 #include <pragma/math/vector/wvvector3.h>
 #include <sharedutils/util_string.h>
@@ -32,4 +33,8 @@ void CParticleOperatorVelocity::Simulate(CParticle &particle,double tDelta,float
 	vel += m_velocity *(float) tDelta;
 	particle.SetVelocity(vel);
 }
+void CParticleOperatorVelocity::Simulate(pragma::ParticleSpan &span,double tDelta)
+{
+	span.AddVelocity(m_velocity *static_cast<float>(tDelta));
+}
 float CParticleOperatorVelocity::GetSpeed() const {return uvec::length(m_velocity);}
@@ -7,6 +7,7 @@
 
 #include "stdafx_client.h"
 #include "pragma/particlesystem/operators/c_particle_operator_cylindrical_vortex.hpp"
+#include "pragma/particlesystem/c_particle_storage.hpp"
 #include "pragma/entities/environment/effects/c_env_particle_system.h"
 #include <mathutil/umath.h>
 #include <pragma/math/vector/wvvector3.h>
@@ -58,3 +59,27 @@ void CParticleOperatorCylindricalVortex::Simulate(CParticle &particle,double tDe
 	uvec::rotate(&v,m_dtRotation);
 	particle.SetVelocity(particle.GetVelocity() +v);
 }
+void CParticleOperatorCylindricalVortex::Simulate(pragma::ParticleSpan &span,double tDelta)
+{
+	CParticleOperatorWorldBase::Simulate(span,tDelta);
+	auto *px = span.GetField(pragma::ParticleSpan::Field::PositionX);
+	auto *py = span.GetField(pragma::ParticleSpan::Field::PositionY);
+	auto *pz = span.GetField(pragma::ParticleSpan::Field::PositionZ);
+	auto *vx = span.GetField(pragma::ParticleSpan::Field::VelocityX);
+	auto *vy = span.GetField(pragma::ParticleSpan::Field::VelocityY);
+	auto *vz = span.GetField(pragma::ParticleSpan::Field::VelocityZ);
+	// The divergence rotation is the same for all particles
+	auto rot = glm::mat3_cast(m_dtRotation);
+	const auto EPSILON = 0.0001f;
+	for(auto i=decltype(span.size){0u};i<span.size;++i)
+	{
+		auto v = uvec::cross(m_dtAxis,Vector3{px[i],py[i],pz[i]} -m_dtOrigin);
+		auto l = uvec::length(v);
+		if(l < EPSILON)
+			continue; // particle is on the axis
+		v = rot *(v *(m_dtStrength /l));
+		vx[i] += v.x;
+		vy[i] += v.y;
+		vz[i] += v.z;
+	}
+}
@@ -7,6 +7,7 @@
 
 #include "stdafx_client.h"
 #include "pragma/particlesystem/operators/c_particle_operator_jitter.hpp"
+#include "pragma/particlesystem/c_particle_storage.hpp"
 #include <mathutil/umath.h>
 #include <pragma/math/vector/wvvector3.h>
 #include <sharedutils/util_string.h>
@@ -35,3 +36,18 @@ void CParticleOperatorJitter::Simulate(CParticle &particle,double tDelta,float s
 		util::noise::get_noise(time,pid +2) *m_dtStrength
 	));
 }
+void CParticleOperatorJitter::Simulate(pragma::ParticleSpan &span,double tDelta)
+{
+	CParticleOperatorWorldBase::Simulate(span,tDelta);
+	auto *px = span.GetField(pragma::ParticleSpan::Field::PositionX);
+	auto *py = span.GetField(pragma::ParticleSpan::Field::PositionY);
+	auto *pz = span.GetField(pragma::ParticleSpan::Field::PositionZ);
+	for(auto i=decltype(span.size){0u};i<span.size;++i)
+	{
+		auto pid = m_hashCodes[span.particleIndices[i]];
+		auto time = m_dtTime +(pid &255) /256.f;
+		px[i] += util::noise::get_noise(time,pid) *m_dtStrength;
+		py[i] += util::noise::get_noise(time,pid +1) *m_dtStrength;
+		pz[i] += util::noise::get_noise(time,pid +2) *m_dtStrength;
+	}
+}
@@ -7,6 +7,7 @@
 
 #include "stdafx_client.h"
 #include "pragma/particlesystem/operators/c_particle_operator_linear_drag.hpp"
+#include "pragma/particlesystem/c_particle_storage.hpp"
 #include <mathutil/umath.h>
 #include <pragma/math/vector/wvvector3.h>
 #include <sharedutils/util_string.h>
@@ -36,3 +37,8 @@ void CParticleOperatorLinearDrag::Simulate(CParticle &particle,double tDelta,flo
 	CParticleOperator::Simulate(particle,tDelta,strength);
 	particle.SetVelocity(particle.GetVelocity() *m_fTickDrag);
 }
+void CParticleOperatorLinearDrag::Simulate(pragma::ParticleSpan &span,double tDelta)
+{
+	CParticleOperator::Simulate(span,tDelta);
+	span.ScaleVelocity(m_fTickDrag);
+}
@@ -7,6 +7,7 @@
 
 #include "stdafx_client.h"
 #include "pragma/particlesystem/operators/c_particle_operator_quadratic_drag.hpp"
+#include "pragma/particlesystem/c_particle_storage.hpp"
 #include <mathutil/umath.h>
 #include <pragma/math/vector/wvvector3.h>
 #include <sharedutils/util_string.h>
@@ -37,3 +38,8 @@ void CParticleOperatorQuadraticDrag::Simulate(CParticle &particle,double tDelta,
 	auto &velocity = particle.GetVelocity();
 	particle.SetVelocity(velocity *umath::max(0.f,1.f -m_fTickDrag *uvec::length(velocity)));
 }
+void CParticleOperatorQuadraticDrag::Simulate(pragma::ParticleSpan &span,double tDelta)
+{
+	CParticleOperator::Simulate(span,tDelta);
+	span.ApplyQuadraticDrag(m_fTickDrag);
+}
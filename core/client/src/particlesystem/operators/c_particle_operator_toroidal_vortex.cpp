@@ -7,6 +7,7 @@
 
 #include "stdafx_client.h"
 #include "pragma/particlesystem/operators/c_particle_operator_toroidal_vortex.hpp"
+#include "pragma/particlesystem/c_particle_storage.hpp"
 #include "pragma/entities/environment/effects/c_env_particle_system.h"
 #include <mathutil/umath.h>
 #include <pragma/math/vector/wvvector3.h>
@@ -80,3 +81,38 @@ void CParticleOperatorToroidalVortex::Simulate(CParticle &particle,double tDelta
 	uvec::rotate(&v,rot);
 	particle.SetVelocity(particle.GetVelocity() +v);
 }
+void CParticleOperatorToroidalVortex::Simulate(pragma::ParticleSpan &span,double tDelta)
+{
+	CParticleOperatorWorldBase::Simulate(span,tDelta);
+	auto *px = span.GetField(pragma::ParticleSpan::Field::PositionX);
+	auto *py = span.GetField(pragma::ParticleSpan::Field::PositionY);
+	auto *pz = span.GetField(pragma::ParticleSpan::Field::PositionZ);
+	auto *vx = span.GetField(pragma::ParticleSpan::Field::VelocityX);
+	auto *vy = span.GetField(pragma::ParticleSpan::Field::VelocityY);
+	auto *vz = span.GetField(pragma::ParticleSpan::Field::VelocityZ);
+	const auto EPSILON = 0.0001f;
+	for(auto i=decltype(span.size){0u};i<span.size;++i)
+	{
+		auto pos = Vector3{px[i],py[i],pz[i]} -m_dtOrigin;
+		auto tangent = uvec::cross(m_dtAxis,pos);
+		auto l = uvec::length(tangent);
+		if(l < EPSILON)
+			continue; // particle is on the axis
+		tangent *= 1.f /l;
+
+		auto v = uvec::cross(tangent,m_dtAxis) *m_fRadius;
+		v += m_dtAxis *m_fHeight;
+		v -= pos;
+		l = uvec::length(v);
+		if(l < EPSILON)
+			continue; // particle is on the ring
+		v *= 1.f /l;
+
+		auto rot = uquat::create(tangent,m_fDivergence);
+		v = uvec::cross(v,tangent) *static_cast<float>(tDelta);
+		uvec::rotate(&v,rot);
+		vx[i] += v.x;
+		vy[i] += v.y;
+		vz[i] += v.z;
+	}
+}
@@ -7,6 +7,7 @@
 
 #include "stdafx_client.h"
 #include "pragma/particlesystem/operators/c_particle_operator_wander.hpp"
+#include "pragma/particlesystem/c_particle_storage.hpp"
 #include "pragma/entities/environment/effects/c_env_particle_system.h"
 #include <mathutil/umath.h>
 #include <pragma/math/vector/wvvector3.h>
@@ -61,3 +62,18 @@ void CParticleOperatorWander::Simulate(CParticle &particle,double tDelta,float s
 		util::noise::get_noise(time,pid +2) *m_dtStrength
 	));
 }
+void CParticleOperatorWander::Simulate(pragma::ParticleSpan &span,double tDelta)
+{
+	CParticleOperatorWorldBase::Simulate(span,tDelta);
+	auto *vx = span.GetField(pragma::ParticleSpan::Field::VelocityX);
+	auto *vy = span.GetField(pragma::ParticleSpan::Field::VelocityY);
+	auto *vz = span.GetField(pragma::ParticleSpan::Field::VelocityZ);
+	for(auto i=decltype(span.size){0u};i<span.size;++i)
+	{
+		auto pid = m_hashCodes[span.particleIndices[i]];
+		auto time = m_dtTime +(pid &255) /256.f;
+		vx[i] += util::noise::get_noise(time,pid) *m_dtStrength;
+		vy[i] += util::noise::get_noise(time,pid +1) *m_dtStrength;
+		vz[i] += util::noise::get_noise(time,pid +2) *m_dtStrength;
+	}
+}
@@ -7,6 +7,7 @@
 
 #include "stdafx_client.h"
 #include "pragma/particlesystem/operators/c_particle_operator_wind.hpp"
+#include "pragma/particlesystem/c_particle_storage.hpp"
 #include "pragma/entities/environment/effects/c_env_particle_system.h"
 #include "pragma/entities/components/c_transform_component.hpp"
 #include <mathutil/umath.h>
@@ -48,3 +49,8 @@ void CParticleOperatorWind::Simulate(CParticle &particle,double tDelta,float str
 	CParticleOperator::Simulate(particle,tDelta,strength);
 	particle.SetVelocity(particle.GetVelocity() +m_vDelta);
 }
+void CParticleOperatorWind::Simulate(pragma::ParticleSpan &span,double tDelta)
+{
+	CParticleOperator::Simulate(span,tDelta);
+	span.AddVelocity(m_vDelta);
+}
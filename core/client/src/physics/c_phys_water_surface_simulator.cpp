@@ -268,9 +268,10 @@ void CPhysWaterSurfaceSimulator::Draw(std::shared_ptr<prosper::IPrimaryCommandBu
 	m_positionBuffer->Read(0ull,particlePositions.size() *sizeof(particlePositions.front()),particlePositions.data());
 
 	auto numVerts = umath::min(verts.size(),GetParticleCount());
+	HeightView heights {*this};
 	for(auto i=decltype(numVerts){0};i<numVerts;++i)
 	{
-		auto pos = CalcParticlePosition(i);//m_particlePositions.at(i); // TODO: Remove m_particlePositions?
+		auto pos = CalcParticlePosition(heights,i);//m_particlePositions.at(i); // TODO: Remove m_particlePositions?
 
 		pos.y = particlePositions.at(i).y; // TODO: Write data directly into mesh vertex buffer, so there's no need for a separate position buffer
 		//lines.push_back(prevPos);
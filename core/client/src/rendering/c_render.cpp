@@ -246,14 +246,23 @@ void CGame::RenderScenes(util::DrawSceneInfo &drawSceneInfo)
 	auto &cmd = *drawSceneInfo.commandBuffer;
 	EntityIterator itParticles {*this};
 	itParticles.AttachFilter<TEntityIteratorFilterComponent<pragma::CParticleSystemComponent>>();
+	std::vector<pragma::CParticleSystemComponent*> particleSystems;
+	std::vector<pragma::ComponentHandle<pragma::CParticleSystemComponent>> hParticleSystems;
 	for(auto *ent : itParticles)
 	{
-		auto &tDelta = DeltaTime();
 		auto pt = ent->GetComponent<pragma::CParticleSystemComponent>();
 		if(pt.valid() && pt->GetParent() == nullptr && pt->ShouldAutoSimulate())
 		{
-			pt->Simulate(tDelta);
-
+			particleSystems.push_back(pt.get());
+			hParticleSystems.push_back(pt);
+		}
+	}
+	// Simulates all particle systems at once, so their particles can be simulated in parallel
+	pragma::CParticleSystemComponent::Simulate(particleSystems,DeltaTime());
+	for(auto &pt : hParticleSystems)
+	{
+		if(pt.valid())
+		{
 			auto &renderers = pt->GetRenderers();
 			if(!renderers.empty())
 			{
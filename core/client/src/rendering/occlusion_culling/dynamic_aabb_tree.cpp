@@ -0,0 +1,487 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright (c) 2021 Silverlan
+ */
+
+#include "stdafx_client.h"
+#include "pragma/rendering/occlusion_culling/dynamic_aabb_tree.hpp"
+#include "pragma/rendering/occlusion_culling/c_occlusion_octree_impl.hpp"
+#include "pragma/console/c_cvar_global_functions.h"
+#include <pragma/math/intersection.h>
+#include <mathutil/umath.h>
+#include <random>
+#include <chrono>
+
+using namespace pragma;
+
+static float get_surface_area(const Vector3 &min,const Vector3 &max)
+{
+	auto d = max -min;
+	return 2.f *(d.x *d.y +d.y *d.z +d.z *d.x);
+}
+static Vector3 get_min(Vector3 a,const Vector3 &b)
+{
+	uvec::min(&a,b);
+	return a;
+}
+static Vector3 get_max(Vector3 a,const Vector3 &b)
+{
+	uvec::max(&a,b);
+	return a;
+}
+static bool contains(const Vector3 &outerMin,const Vector3 &outerMax,const Vector3 &innerMin,const Vector3 &innerMax)
+{
+	return innerMin.x >= outerMin.x && innerMin.y >= outerMin.y && innerMin.z >= outerMin.z &&
+		innerMax.x <= outerMax.x && innerMax.y <= outerMax.y && innerMax.z <= outerMax.z;
+}
+
+DynamicAabbTree::DynamicAabbTree(float margin)
+	: m_margin{margin}
+{}
+
+uint32_t DynamicAabbTree::AllocateNode()
+{
+	if(m_freeList == INVALID_NODE)
+	{
+		m_nodes.push_back({});
+		return static_cast<uint32_t>(m_nodes.size() -1);
+	}
+	auto nodeIdx = m_freeList;
+	auto &node = m_nodes[nodeIdx];
+	m_freeList = node.parent;
+	node = {};
+	return nodeIdx;
+}
+void DynamicAabbTree::FreeNode(uint32_t nodeIdx)
+{
+	auto &node = m_nodes[nodeIdx];
+	node.parent = m_freeList;
+	node.height = -1;
+	m_freeList = nodeIdx;
+}
+
+DynamicAabbTree::ProxyId DynamicAabbTree::CreateProxy(const Vector3 &min,const Vector3 &max,uint32_t userData)
+{
+	auto leafIdx = AllocateNode();
+	auto &leaf = m_nodes[leafIdx];
+	Vector3 margin {m_margin,m_margin,m_margin};
+	leaf.min = min -margin;
+	leaf.max = max +margin;
+	leaf.userData = userData;
+	leaf.height = 0;
+	InsertLeaf(leafIdx);
+	++m_proxyCount;
+	return leafIdx;
+}
+void DynamicAabbTree::DestroyProxy(ProxyId proxyId)
+{
+	if(proxyId >= m_nodes.size() || m_nodes[proxyId].height != 0)
+		return;
+	RemoveLeaf(proxyId);
+	FreeNode(proxyId);
+	--m_proxyCount;
+}
+bool DynamicAabbTree::MoveProxy(ProxyId proxyId,const Vector3 &min,const Vector3 &max)
+{
+	if(proxyId >= m_nodes.size() || m_nodes[proxyId].height != 0)
+		return false;
+	auto &leaf = m_nodes[proxyId];
+	if(contains(leaf.min,leaf.max,min,max))
+		return false; // Still within the fat bounds, nothing to do
+	RemoveLeaf(proxyId);
+	Vector3 margin {m_margin,m_margin,m_margin};
+	leaf.min = min -margin;
+	leaf.max = max +margin;
+	InsertLeaf(proxyId);
+	return true;
+}
+uint32_t DynamicAabbTree::GetUserData(ProxyId proxyId) const {return m_nodes[proxyId].userData;}
+std::pair<Vector3,Vector3> DynamicAabbTree::GetFatBounds(ProxyId proxyId) const
+{
+	auto &node = m_nodes[proxyId];
+	return {node.min,node.max};
+}
+void DynamicAabbTree::Clear()
+{
+	m_nodes.clear();
+	m_root = INVALID_NODE;
+	m_freeList = INVALID_NODE;
+	m_proxyCount = 0;
+}
+uint32_t DynamicAabbTree::GetProxyCount() const {return m_proxyCount;}
+uint32_t DynamicAabbTree::GetHeight() const {return (m_root != INVALID_NODE) ? static_cast<uint32_t>(m_nodes[m_root].height) : 0u;}
+float DynamicAabbTree::GetMargin() const {return m_margin;}
+
+void DynamicAabbTree::InsertLeaf(uint32_t leafIdx)
+{
+	if(m_root == INVALID_NODE)
+	{
+		m_root = leafIdx;
+		m_nodes[leafIdx].parent = INVALID_NODE;
+		return;
+	}
+
+	// Find the best sibling for the new leaf, using the increase in surface area as cost
+	auto leafMin = m_nodes[leafIdx].min;
+	auto leafMax = m_nodes[leafIdx].max;
+	auto siblingIdx = m_root;
+	while(m_nodes[siblingIdx].IsLeaf() == false)
+	{
+		auto &node = m_nodes[siblingIdx];
+		auto area = get_surface_area(node.min,node.max);
+		auto combinedArea = get_surface_area(get_min(node.min,leafMin),get_max(node.max,leafMax));
+		// Cost of creating a new parent for this node and the new leaf
+		auto cost = 2.f *combinedArea;
+		// Minimum cost of pushing the leaf further down the tree
+		auto inheritanceCost = 2.f *(combinedArea -area);
+
+		std::array<float,2> childCosts;
+		for(auto i=0u;i<2u;++i)
+		{
+			auto &child = m_nodes[node.children[i]];
+			auto childCombinedArea = get_surface_area(get_min(child.min,leafMin),get_max(child.max,leafMax));
+			childCosts[i] = child.IsLeaf() ? (childCombinedArea +inheritanceCost) : (childCombinedArea -get_surface_area(child.min,child.max) +inheritanceCost);
+		}
+		if(cost < childCosts[0] && cost < childCosts[1])
+			break;
+		siblingIdx = (childCosts[0] < childCosts[1]) ? node.children[0] : node.children[1];
+	}
+
+	// Create a new parent for the sibling and the leaf
+	auto oldParentIdx = m_nodes[siblingIdx].parent;
+	auto newParentIdx = AllocateNode(); // Note: This may invalidate references to nodes
+	auto &newParent = m_nodes[newParentIdx];
+	auto &sibling = m_nodes[siblingIdx];
+	newParent.parent = oldParentIdx;
+	newParent.min = get_min(sibling.min,leafMin);
+	newParent.max = get_max(sibling.max,leafMax);
+	newParent.height = sibling.height +1;
+	newParent.children = {siblingIdx,leafIdx};
+	sibling.parent = newParentIdx;
+	m_nodes[leafIdx].parent = newParentIdx;
+	if(oldParentIdx != INVALID_NODE)
+	{
+		auto &oldParent = m_nodes[oldParentIdx];
+		oldParent.children[(oldParent.children[0] == siblingIdx) ? 0 : 1] = newParentIdx;
+	}
+	else
+		m_root = newParentIdx;
+
+	RefitAncestors(m_nodes[leafIdx].parent);
+}
+
+void DynamicAabbTree::RemoveLeaf(uint32_t leafIdx)
+{
+	if(leafIdx == m_root)
+	{
+		m_root = INVALID_NODE;
+		return;
+	}
+	auto parentIdx = m_nodes[leafIdx].parent;
+	auto &parent = m_nodes[parentIdx];
+	auto grandParentIdx = parent.parent;
+	auto siblingIdx = (parent.children[0] == leafIdx) ? parent.children[1] : parent.children[0];
+	if(grandParentIdx != INVALID_NODE)
+	{
+		// Replace the parent with the sibling
+		auto &grandParent = m_nodes[grandParentIdx];
+		grandParent.children[(grandParent.children[0] == parentIdx) ? 0 : 1] = siblingIdx;
+		m_nodes[siblingIdx].parent = grandParentIdx;
+		FreeNode(parentIdx);
+		RefitAncestors(grandParentIdx);
+	}
+	else
+	{
+		m_root = siblingIdx;
+		m_nodes[siblingIdx].parent = INVALID_NODE;
+		FreeNode(parentIdx);
+	}
+	m_nodes[leafIdx].parent = INVALID_NODE;
+}
+
+void DynamicAabbTree::RefitAncestors(uint32_t nodeIdx)
+{
+	while(nodeIdx != INVALID_NODE)
+	{
+		nodeIdx = Balance(nodeIdx);
+		auto &node = m_nodes[nodeIdx];
+		auto &child0 = m_nodes[node.children[0]];
+		auto &child1 = m_nodes[node.children[1]];
+		node.height = 1 +umath::max(child0.height,child1.height);
+		node.min = get_min(child0.min,child1.min);
+		node.max = get_max(child0.max,child1.max);
+		nodeIdx = node.parent;
+	}
+}
+
+uint32_t DynamicAabbTree::Balance(uint32_t aIdx)
+{
+	// Rotates the higher child of A up if the subtrees of A differ in height by more than one
+	auto &a = m_nodes[aIdx];
+	if(a.IsLeaf() || a.height < 2)
+		return aIdx;
+	auto bIdx = a.children[0];
+	auto cIdx = a.children[1];
+	auto balance = m_nodes[cIdx].height -m_nodes[bIdx].height;
+	if(balance >= -1 && balance <= 1)
+		return aIdx;
+
+	// The higher child becomes the new root of the subtree
+	auto rotate = [this,aIdx](uint32_t upIdx,uint32_t otherIdx,uint32_t upChildSlot) -> uint32_t {
+		auto &a = m_nodes[aIdx];
+		auto &up = m_nodes[upIdx];
+		auto fIdx = up.children[0];
+		auto gIdx = up.children[1];
+		auto &f = m_nodes[fIdx];
+		auto &g = m_nodes[gIdx];
+		auto &other = m_nodes[otherIdx];
+
+		up.children[0] = aIdx;
+		up.parent = a.parent;
+		a.parent = upIdx;
+		if(up.parent != INVALID_NODE)
+		{
+			auto &upParent = m_nodes[up.parent];
+			upParent.children[(upParent.children[0] == aIdx) ? 0 : 1] = upIdx;
+		}
+		else
+			m_root = upIdx;
+
+		// The higher grandchild stays with the rotated node, the other one is moved to A
+		auto keepIdx = (f.height > g.height) ? fIdx : gIdx;
+		auto moveIdx = (f.height > g.height) ? gIdx : fIdx;
+		auto &keep = m_nodes[keepIdx];
+		auto &move = m_nodes[moveIdx];
+		up.children[1] = keepIdx;
+		a.children[upChildSlot] = moveIdx;
+		move.parent = aIdx;
+		a.min = get_min(other.min,move.min);
+		a.max = get_max(other.max,move.max);
+		a.height = 1 +umath::max(other.height,move.height);
+		up.min = get_min(a.min,keep.min);
+		up.max = get_max(a.max,keep.max);
+		up.height = 1 +umath::max(a.height,keep.height);
+		return upIdx;
+	};
+	if(balance > 1)
+		return rotate(cIdx,bIdx,1);
+	return rotate(bIdx,cIdx,0);
+}
+
+void DynamicAabbTree::CollectLeaves(uint32_t nodeIdx,std::vector<uint32_t> &outUserData,std::vector<uint32_t> &stack) const
+{
+	auto stackBase = stack.size();
+	stack.push_back(nodeIdx);
+	while(stack.size() > stackBase)
+	{
+		auto &node = m_nodes[stack.back()];
+		stack.pop_back();
+		if(node.IsLeaf())
+		{
+			outUserData.push_back(node.userData);
+			continue;
+		}
+		stack.push_back(node.children[0]);
+		stack.push_back(node.children[1]);
+	}
+}
+
+void DynamicAabbTree::QueryAll(std::vector<uint32_t> &outUserData) const
+{
+	if(m_root == INVALID_NODE)
+		return;
+	outUserData.reserve(outUserData.size() +m_proxyCount);
+	std::vector<uint32_t> stack;
+	stack.reserve(64);
+	CollectLeaves(m_root,outUserData,stack);
+}
+
+void DynamicAabbTree::QueryFrustum(const std::vector<umath::Plane> &planes,std::vector<uint32_t> &outUserData) const
+{
+	if(m_root == INVALID_NODE)
+		return;
+	std::vector<uint32_t> stack;
+	stack.reserve(64);
+	stack.push_back(m_root);
+	while(stack.empty() == false)
+	{
+		auto nodeIdx = stack.back();
+		stack.pop_back();
+		auto &node = m_nodes[nodeIdx];
+		auto intersect = umath::intersection::aabb_in_plane_mesh(node.min,node.max,planes);
+		if(intersect == umath::intersection::Intersect::Outside)
+			continue;
+		if(intersect == umath::intersection::Intersect::Inside || node.IsLeaf())
+		{
+			// The entire subtree is visible, no need to test the remaining nodes
+			CollectLeaves(nodeIdx,outUserData,stack);
+			continue;
+		}
+		stack.push_back(node.children[0]);
+		stack.push_back(node.children[1]);
+	}
+}
+
+void DynamicAabbTree::QuerySphere(const Vector3 &origin,float radius,std::vector<uint32_t> &outUserData) const
+{
+	if(m_root == INVALID_NODE)
+		return;
+	std::vector<uint32_t> stack;
+	stack.reserve(64);
+	stack.push_back(m_root);
+	while(stack.empty() == false)
+	{
+		auto &node = m_nodes[stack.back()];
+		stack.pop_back();
+		if(umath::intersection::aabb_sphere(node.min,node.max,origin,radius) == false)
+			continue;
+		if(node.IsLeaf())
+		{
+			outUserData.push_back(node.userData);
+			continue;
+		}
+		stack.push_back(node.children[0]);
+		stack.push_back(node.children[1]);
+	}
+}
+
+void DynamicAabbTree::QueryAabb(const Vector3 &min,const Vector3 &max,std::vector<uint32_t> &outUserData) const
+{
+	if(m_root == INVALID_NODE)
+		return;
+	std::vector<uint32_t> stack;
+	stack.reserve(64);
+	stack.push_back(m_root);
+	while(stack.empty() == false)
+	{
+		auto &node = m_nodes[stack.back()];
+		stack.pop_back();
+		if(umath::intersection::aabb_aabb(node.min,node.max,min,max) == umath::intersection::Intersect::Outside)
+			continue;
+		if(node.IsLeaf())
+		{
+			outUserData.push_back(node.userData);
+			continue;
+		}
+		stack.push_back(node.children[0]);
+		stack.push_back(node.children[1]);
+	}
+}
+
+////////////////////
+
+static void iterate_benchmark_octree(const OcclusionOctree<uint32_t>::Node &node,const std::vector<umath::Plane> &planes,std::vector<uint32_t> &outObjects)
+{
+	if(node.IsEmpty() == true)
+		return;
+	auto &nodeBounds = node.GetWorldBounds();
+	if(umath::intersection::aabb_in_plane_mesh(nodeBounds.first,nodeBounds.second,planes) == umath::intersection::Intersect::Outside)
+		return;
+	auto &objs = node.GetObjects();
+	outObjects.insert(outObjects.end(),objs.begin(),objs.end());
+	if(node.GetChildObjectCount() == 0)
+		return;
+	auto *children = node.GetChildren();
+	if(children == nullptr)
+		return;
+	for(auto &c : *children)
+		iterate_benchmark_octree(static_cast<OcclusionOctree<uint32_t>::Node&>(*c),planes,outObjects);
+}
+
+void Console::commands::debug_occlusion_tree_benchmark(NetworkState*,pragma::BasePlayerComponent*,std::vector<std::string> &argv)
+{
+	// Moves synthetic objects every frame and updates and queries both the occlusion octree and the dynamic AABB tree
+	auto numObjects = argv.empty() ? 50'000u : static_cast<uint32_t>(umath::max(util::to_int(argv[0]),1));
+	auto numFrames = (argv.size() > 1) ? static_cast<uint32_t>(umath::max(util::to_int(argv[1]),1)) : 10u;
+
+	std::mt19937 rng {0};
+	std::uniform_real_distribution<float> distPos {-10'000.f,10'000.f};
+	std::uniform_real_distribution<float> distExtents {1.f,100.f};
+	std::uniform_real_distribution<float> distMove {-20.f,20.f};
+	std::vector<std::pair<Vector3,Vector3>> bounds;
+	bounds.reserve(numObjects);
+	for(auto i=decltype(numObjects){0u};i<numObjects;++i)
+	{
+		Vector3 pos {distPos(rng),distPos(rng),distPos(rng)};
+		Vector3 extents {distExtents(rng),distExtents(rng),distExtents(rng)};
+		bounds.push_back({pos -extents,pos +extents});
+	}
+
+	OcclusionOctree<uint32_t> octree {256.f,1'073'741'824.f,4096.f,[&bounds](const uint32_t &idx,Vector3 &min,Vector3 &max) {
+		min = bounds[idx].first;
+		max = bounds[idx].second;
+	}};
+	octree.Initialize();
+	octree.SetSingleReferenceMode(true);
+	DynamicAabbTree tree {};
+	std::vector<DynamicAabbTree::ProxyId> proxies;
+	proxies.reserve(numObjects);
+
+	auto t = std::chrono::steady_clock::now();
+	for(auto i=decltype(numObjects){0u};i<numObjects;++i)
+		octree.InsertObject(i);
+	auto tOctreeBuild = std::chrono::steady_clock::now() -t;
+	t = std::chrono::steady_clock::now();
+	for(auto i=decltype(numObjects){0u};i<numObjects;++i)
+		proxies.push_back(tree.CreateProxy(bounds[i].first,bounds[i].second,i));
+	auto tTreeBuild = std::chrono::steady_clock::now() -t;
+
+	// Approximation of a view frustum looking down the x-axis
+	std::vector<umath::Plane> planes {
+		umath::Plane{uvec::get_normal(Vector3{1.f,0.f,1.f}),2'000.0},
+		umath::Plane{uvec::get_normal(Vector3{1.f,0.f,-1.f}),2'000.0},
+		umath::Plane{uvec::get_normal(Vector3{1.f,1.f,0.f}),2'000.0},
+		umath::Plane{uvec::get_normal(Vector3{1.f,-1.f,0.f}),2'000.0},
+		umath::Plane{Vector3{1.f,0.f,0.f},0.0},
+		umath::Plane{Vector3{-1.f,0.f,0.f},8'000.0}
+	};
+
+	std::chrono::steady_clock::duration tOctreeUpdate {0};
+	std::chrono::steady_clock::duration tTreeUpdate {0};
+	std::chrono::steady_clock::duration tOctreeQuery {0};
+	std::chrono::steady_clock::duration tTreeQuery {0};
+	std::vector<uint32_t> octreeResults;
+	std::vector<uint32_t> treeResults;
+	uint32_t numReinserted = 0;
+	for(auto frame=decltype(numFrames){0u};frame<numFrames;++frame)
+	{
+		for(auto &b : bounds)
+		{
+			Vector3 offset {distMove(rng),distMove(rng),distMove(rng)};
+			b.first += offset;
+			b.second += offset;
+		}
+
+		t = std::chrono::steady_clock::now();
+		for(auto i=decltype(numObjects){0u};i<numObjects;++i)
+			octree.UpdateObject(i);
+		tOctreeUpdate += std::chrono::steady_clock::now() -t;
+
+		t = std::chrono::steady_clock::now();
+		for(auto i=decltype(numObjects){0u};i<numObjects;++i)
+		{
+			if(tree.MoveProxy(proxies[i],bounds[i].first,bounds[i].second))
+				++numReinserted;
+		}
+		tTreeUpdate += std::chrono::steady_clock::now() -t;
+
+		octreeResults.clear();
+		t = std::chrono::steady_clock::now();
+		iterate_benchmark_octree(octree.GetRootNode(),planes,octreeResults);
+		tOctreeQuery += std::chrono::steady_clock::now() -t;
+
+		treeResults.clear();
+		t = std::chrono::steady_clock::now();
+		tree.QueryFrustum(planes,treeResults);
+		tTreeQuery += std::chrono::steady_clock::now() -t;
+	}
+	auto toMs = [](std::chrono::steady_clock::duration d,uint32_t n) {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(d).count() /1'000'000.0 /static_cast<double>(n);
+	};
+	Con::cout<<"Occlusion tree benchmark ("<<numObjects<<" moving objects, "<<numFrames<<" frames, average per frame):"<<Con::endl;
+	Con::cout<<"Octree: Build: "<<toMs(tOctreeBuild,1)<<"ms; Update: "<<toMs(tOctreeUpdate,numFrames)<<"ms; Frustum query: "<<toMs(tOctreeQuery,numFrames)<<"ms ("<<octreeResults.size()<<" objects)"<<Con::endl;
+	Con::cout<<"Dynamic AABB tree: Build: "<<toMs(tTreeBuild,1)<<"ms; Update: "<<toMs(tTreeUpdate,numFrames)<<"ms ("<<(numReinserted /numFrames)<<" re-insertions); Frustum query: "
+		<<toMs(tTreeQuery,numFrames)<<"ms ("<<treeResults.size()<<" objects); Height: "<<tree.GetHeight()<<Con::endl;
+}
@@ -60,12 +60,26 @@ bool OcclusionCullingHandler::ShouldExamine(pragma::CSceneComponent &scene,const
 	*outPlanes = (pRenderComponent->GetSceneRenderPass() == pragma::rendering::SceneRenderPass::Sky) ? const_cast<std::vector<umath::Plane>*>(&renderer.GetFrustumPlanes()) : const_cast<std::vector<umath::Plane>*>(&renderer.GetClippedFrustumPlanes());
 	if(pRenderComponent->IsExemptFromOcclusionCulling() || outViewModel)
 		return true; // Always draw
+	if(m_frustumVisibilityValid)
+	{
+		auto &visibility = (pRenderComponent->GetSceneRenderPass() == pragma::rendering::SceneRenderPass::Sky) ? m_frustumVisibility : m_clippedFrustumVisibility;
+		return visibility.IsVisible(pRenderComponent->GetRenderBoundsSlot());
+	}
 	auto &sphere = pRenderComponent->GetUpdatedAbsoluteRenderSphere();
 	if(umath::intersection::sphere_in_plane_mesh(sphere.pos,sphere.radius,*(*outPlanes),true) == umath::intersection::Intersect::Outside)
 		return false;
 	auto &aabb = pRenderComponent->GetAbsoluteRenderBounds();
 	return umath::intersection::aabb_in_plane_mesh(aabb.min,aabb.max,*(*outPlanes)) != umath::intersection::Intersect::Outside;
 }
+void OcclusionCullingHandler::UpdateFrustumVisibility(const CRasterizationRendererComponent &renderer)
+{
+	auto &renderBoundsStorage = pragma::CRenderComponent::GetRenderBoundsStorage();
+	renderBoundsStorage.UpdateDirtyBounds();
+	renderBoundsStorage.CullByPlanes(renderer.GetFrustumPlanes(),m_frustumVisibility);
+	renderBoundsStorage.CullByPlanes(renderer.GetClippedFrustumPlanes(),m_clippedFrustumVisibility);
+	m_frustumVisibilityValid = true;
+}
+void OcclusionCullingHandler::ClearFrustumVisibility() {m_frustumVisibilityValid = false;}
 void OcclusionCullingHandler::PerformCulling(pragma::CSceneComponent &scene,const CRasterizationRendererComponent &renderer,std::vector<pragma::CParticleSystemComponent*> &particlesOut)
 {
 	auto &cam = scene.GetActiveCamera();
@@ -0,0 +1,126 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright (c) 2021 Silverlan
+ */
+
+#include "stdafx_client.h"
+#include "pragma/rendering/occlusion_culling/occlusion_culling_handler_aabb_tree.hpp"
+#include "pragma/rendering/occlusion_culling/c_occlusion_octree_impl.hpp"
+#include "pragma/rendering/renderers/rasterization_renderer.hpp"
+#include "pragma/entities/components/renderers/c_renderer_component.hpp"
+#include "pragma/entities/components/c_render_component.hpp"
+#include "pragma/entities/components/c_transform_component.hpp"
+#include "pragma/entities/components/renderers/c_rasterization_renderer_component.hpp"
+#include "pragma/entities/game/c_game_occlusion_culler.hpp"
+#include "pragma/model/c_modelmesh.h"
+#include <pragma/math/intersection.h>
+#include <pragma/entities/entity_iterator.hpp>
+#include <pragma/entities/entity_component_system_t.hpp>
+
+using namespace pragma;
+
+extern DLLCLIENT CGame *c_game;
+
+static void iterate_world_tree(const OcclusionOctree<std::shared_ptr<ModelMesh>>::Node &node,const std::vector<umath::Plane> *optFrustumPlanes,const std::function<void(const std::shared_ptr<ModelMesh>&)> &fObjectCallback)
+{
+	if(node.IsEmpty() == true)
+		return;
+	auto &nodeBounds = node.GetWorldBounds();
+	if(optFrustumPlanes && umath::intersection::aabb_in_plane_mesh(nodeBounds.first,nodeBounds.second,*optFrustumPlanes) == umath::intersection::Intersect::Outside)
+		return;
+	for(auto &o : node.GetObjects())
+		fObjectCallback(o);
+	if(node.GetChildObjectCount() == 0)
+		return;
+	auto *children = node.GetChildren();
+	if(children == nullptr)
+		return;
+	for(auto &c : *children)
+		iterate_world_tree(static_cast<OcclusionOctree<std::shared_ptr<ModelMesh>>::Node&>(*c),optFrustumPlanes,fObjectCallback);
+}
+
+void OcclusionCullingHandlerAabbTree::PerformCulling(
+	pragma::CSceneComponent &scene,const CRasterizationRendererComponent &renderer,const Vector3 &camPos,
+	std::vector<OcclusionMeshInfo> &culledMeshesOut,bool cullByViewFrustum
+)
+{
+	culledMeshesOut.clear();
+
+	// Occlusion-culling-exempt entities are just added without checking
+	for(auto *pRenderComponent : pragma::CRenderComponent::GetEntitiesExemptFromOcclusionCulling())
+	{
+		if(static_cast<CBaseEntity&>(pRenderComponent->GetEntity()).IsInScene(scene) == false)
+			continue;
+		auto &lodMeshes = pRenderComponent->GetLODMeshes();
+		for(auto &mesh : lodMeshes)
+			culledMeshesOut.push_back({*static_cast<CBaseEntity*>(&pRenderComponent->GetEntity()),*static_cast<CModelMesh*>(mesh.get())});
+	}
+
+	auto *culler = scene.FindOcclusionCuller();
+	if(culler)
+	{
+		// The tree query already culls the entity bounds by the frustum, so there's no need to update the frustum visibility here
+		auto &tree = culler->GetAabbTree();
+		m_queryResults.clear();
+		if(cullByViewFrustum)
+			tree.QueryFrustum(renderer.GetFrustumPlanes(),m_queryResults);
+		else
+			tree.QueryAll(m_queryResults);
+		for(auto localIdx : m_queryResults)
+		{
+			auto *ent = static_cast<CBaseEntity*>(c_game->GetEntityByLocalIndex(localIdx));
+			// World geometry is handled separately
+			if(ent == nullptr || ent->IsWorld() == true)
+				continue;
+			bool bViewModel = false;
+			std::vector<umath::Plane> *planes = nullptr;
+			if(ShouldExamine(scene,renderer,*ent,bViewModel,cullByViewFrustum ? &planes : nullptr) == false)
+				continue;
+			auto pRenderComponent = ent->GetRenderComponent();
+			if(!pRenderComponent)
+				continue;
+			auto pTrComponent = ent->GetTransformComponent();
+			auto exemptFromCulling = pRenderComponent->IsExemptFromOcclusionCulling();
+			auto &meshes = pRenderComponent->GetLODMeshes();
+			auto numMeshes = meshes.size();
+			auto pos = pTrComponent != nullptr ? pTrComponent->GetPosition() : Vector3{};
+			for(auto &mesh : meshes)
+			{
+				auto *cmesh = static_cast<CModelMesh*>(mesh.get());
+				if(cullByViewFrustum == true && exemptFromCulling == false && ShouldExamine(*cmesh,pos,bViewModel,numMeshes,planes) == false)
+					continue;
+				if(culledMeshesOut.capacity() -culledMeshesOut.size() == 0)
+					culledMeshesOut.reserve(culledMeshesOut.capacity() +100);
+				culledMeshesOut.push_back(OcclusionMeshInfo{*ent,*cmesh});
+			}
+		}
+	}
+
+	EntityIterator worldIt {*c_game};
+	worldIt.AttachFilter<TEntityIteratorFilterComponent<pragma::CWorldComponent>>();
+	for(auto *entWorld : worldIt)
+	{
+		auto worldC = entWorld->GetComponent<pragma::CWorldComponent>();
+		auto wrldTree = worldC->GetMeshTree();
+		if(wrldTree == nullptr)
+			continue;
+		auto &entWorld = static_cast<CBaseEntity&>(worldC->GetEntity());
+		auto bViewModel = false;
+		std::vector<umath::Plane> *planes = nullptr;
+		if(ShouldExamine(scene,renderer,entWorld,bViewModel,cullByViewFrustum ? &planes : nullptr) == false)
+			continue;
+		auto pTrComponent = entWorld.GetTransformComponent();
+		auto pos = pTrComponent != nullptr ? pTrComponent->GetPosition() : Vector3{};
+		std::size_t numMeshes = 2; // Value doesn't matter, but has to be > 1
+		iterate_world_tree(wrldTree->GetRootNode(),planes,[this,&pos,&bViewModel,&planes,&entWorld,numMeshes,&culledMeshesOut](const std::shared_ptr<ModelMesh> &mesh) {
+			auto *cmesh = static_cast<CModelMesh*>(mesh.get());
+			if(ShouldExamine(*cmesh,pos,bViewModel,numMeshes,planes) == false)
+				return;
+			if(culledMeshesOut.capacity() -culledMeshesOut.size() == 0)
+				culledMeshesOut.reserve(culledMeshesOut.capacity() +100);
+			culledMeshesOut.push_back(OcclusionMeshInfo{entWorld,*cmesh});
+		});
+	}
+}
@@ -25,6 +25,8 @@ void OcclusionCullingHandlerBruteForce::PerformCulling(
 	//auto d = uvec::distance(m_lastLodCamPos,posCam);
 	//auto bUpdateLod = (d >= LOD_SWAP_DISTANCE) ? true : false;
 	culledMeshesOut.clear();
+	if(cullByViewFrustum)
+		UpdateFrustumVisibility(renderer);
 
 	EntityIterator entIt {*c_game};
 	entIt.AttachFilter<TEntityIteratorFilterComponent<pragma::CRenderComponent>>();
@@ -61,6 +63,7 @@ void OcclusionCullingHandlerBruteForce::PerformCulling(
 			}
 		}
 	}
+	ClearFrustumVisibility();
 	//if(bUpdateLod == true)
 	//	m_lastLodCamPos = posCam;
 }
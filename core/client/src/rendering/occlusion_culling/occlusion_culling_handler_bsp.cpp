@@ -114,7 +114,7 @@ static void debug_bsp_nodes(NetworkState*,ConVar*,int32_t,int32_t val)
 		Con::cwar<<"WARNING: Camera not located in any leaf node!"<<Con::endl;
 		return;
 	}
-	auto &clusterVisibility = bspTree->GetClusterVisibility();
+	auto clusterVisibility = bspTree->DecompressClusterVisibility();
 	Con::cout<<"Camera position: ("<<camPos.x<<" "<<camPos.y<<" "<<camPos.z<<")"<<Con::endl;
 	Con::cout<<"Leaf cluster id: "<<pCurrentNode->cluster<<Con::endl;
 	Con::cout<<"Leaf bounds: ("<<pCurrentNode->min.x<<","<<pCurrentNode->min.y<<","<<pCurrentNode->min.z<<") ("<<pCurrentNode->max.x<<","<<pCurrentNode->max.y<<","<<pCurrentNode->max.z<<")"<<Con::endl;
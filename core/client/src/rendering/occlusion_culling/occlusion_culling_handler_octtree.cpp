@@ -53,6 +53,8 @@ void OcclusionCullingHandlerOctTree::PerformCulling(
 	m_lastLodCamPos = camPos;
 	auto bUpdateLod = (d >= LOD_SWAP_DISTANCE) ? true : false;
 	culledMeshesOut.clear();
+	if(cullByViewFrustum)
+		UpdateFrustumVisibility(renderer);
 
 	// Occlusion-culling-exempt entities are just added without checking
 	for(auto *pRenderComponent : pragma::CRenderComponent::GetEntitiesExemptFromOcclusionCulling())
@@ -142,4 +144,5 @@ void OcclusionCullingHandlerOctTree::PerformCulling(
 			});
 		}
 	}
+	ClearFrustumVisibility();
 }
@@ -0,0 +1,269 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright (c) 2021 Silverlan
+ */
+
+#include "stdafx_client.h"
+#include "pragma/rendering/render_bounds_storage.hpp"
+#include "pragma/entities/components/c_render_component.hpp"
+#include "pragma/console/c_cvar_global_functions.h"
+#include <pragma/math/intersection.h>
+#include <random>
+#include <chrono>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+	#define PRAGMA_RENDER_BOUNDS_SSE
+	#include <xmmintrin.h>
+#endif
+
+using namespace pragma::rendering;
+
+void VisibilityBitset::Reset(uint32_t count)
+{
+	m_count = count;
+	m_bits.assign((count +63) /64,0);
+}
+
+//////////////////
+
+// Bounds of unused slots; These are on the outer side of every plane
+static constexpr float EMPTY_BOUNDS_MIN = std::numeric_limits<float>::max();
+static constexpr float EMPTY_BOUNDS_MAX = std::numeric_limits<float>::lowest();
+
+uint32_t RenderBoundsStorage::AllocateSlot(CRenderComponent *renderC)
+{
+	std::scoped_lock lock {m_mutex};
+	uint32_t slot;
+	if(m_freeSlots.empty() == false)
+	{
+		slot = m_freeSlots.back();
+		m_freeSlots.pop_back();
+	}
+	else
+	{
+		slot = static_cast<uint32_t>(m_components.size());
+		m_components.push_back(nullptr);
+		m_dirtyFlags.push_back(false);
+		auto numPadded = ((m_components.size() +BATCH_SIZE -1) /BATCH_SIZE) *BATCH_SIZE;
+		if(numPadded > m_min[0].size())
+		{
+			for(auto i=0u;i<3u;++i)
+			{
+				m_min[i].resize(numPadded,EMPTY_BOUNDS_MIN);
+				m_max[i].resize(numPadded,EMPTY_BOUNDS_MAX);
+			}
+		}
+	}
+	m_components[slot] = renderC;
+	if(renderC)
+		MarkDirtyUnlocked(slot);
+	return slot;
+}
+void RenderBoundsStorage::FreeSlot(uint32_t slot)
+{
+	std::scoped_lock lock {m_mutex};
+	if(slot >= m_components.size())
+		return;
+	m_components[slot] = nullptr;
+	m_dirtyFlags[slot] = false; // The entry in the dirty list will be skipped
+	SetBoundsUnlocked(slot,Vector3{EMPTY_BOUNDS_MIN},Vector3{EMPTY_BOUNDS_MAX});
+	m_freeSlots.push_back(slot);
+}
+void RenderBoundsStorage::MarkDirty(uint32_t slot)
+{
+	std::scoped_lock lock {m_mutex};
+	MarkDirtyUnlocked(slot);
+}
+void RenderBoundsStorage::MarkDirtyUnlocked(uint32_t slot)
+{
+	if(slot >= m_dirtyFlags.size() || m_dirtyFlags[slot])
+		return;
+	m_dirtyFlags[slot] = true;
+	m_dirtySlots.push_back(slot);
+}
+void RenderBoundsStorage::SetBounds(uint32_t slot,const Vector3 &min,const Vector3 &max)
+{
+	std::scoped_lock lock {m_mutex};
+	SetBoundsUnlocked(slot,min,max);
+}
+void RenderBoundsStorage::SetBoundsUnlocked(uint32_t slot,const Vector3 &min,const Vector3 &max)
+{
+	if(slot >= m_components.size())
+		return;
+	for(auto i=0u;i<3u;++i)
+	{
+		m_min[i][slot] = min[i];
+		m_max[i][slot] = max[i];
+	}
+}
+void RenderBoundsStorage::UpdateDirtyBounds()
+{
+	std::scoped_lock lock {m_mutex};
+	for(auto slot : m_dirtySlots)
+	{
+		if(m_dirtyFlags[slot] == false)
+			continue;
+		m_dirtyFlags[slot] = false;
+		auto *renderC = m_components[slot];
+		if(renderC == nullptr)
+			continue;
+		auto &aabb = renderC->GetUpdatedAbsoluteRenderBounds();
+		SetBoundsUnlocked(slot,aabb.min,aabb.max);
+	}
+	m_dirtySlots.clear();
+}
+uint32_t RenderBoundsStorage::GetSlotCount() const {return static_cast<uint32_t>(m_components.size());}
+pragma::CRenderComponent *RenderBoundsStorage::GetComponent(uint32_t slot) const {return (slot < m_components.size()) ? m_components[slot] : nullptr;}
+
+// The batch test expects the planes in the form dot(n,p) +d >= 0 for points on the inner side. To guarantee that the results are
+// identical to those of umath::intersection::aabb_in_plane_mesh, the sign convention it uses is determined once with a known plane.
+static std::pair<float,float> get_plane_signs()
+{
+	static auto signs = []() -> std::pair<float,float> {
+		std::vector<umath::Plane> planes {umath::Plane{Vector3{1.f,0.f,0.f},1.0}};
+		auto isInside = [&planes](float x) -> bool {
+			Vector3 p {x,0.f,0.f};
+			return umath::intersection::aabb_in_plane_mesh(p,p,planes) != umath::intersection::Intersect::Outside;
+		};
+		auto normalSign = isInside(2.f) ? 1.f : -1.f;
+		auto distanceSign = isInside(0.f) ? 1.f : -1.f;
+		return {normalSign,distanceSign};
+	}();
+	return signs;
+}
+
+void RenderBoundsStorage::CullByPlanes(const std::vector<umath::Plane> &planes,VisibilityBitset &outVisibility) const
+{
+	std::scoped_lock lock {m_mutex};
+	auto numSlots = GetSlotCount();
+	outVisibility.Reset(numSlots);
+	if(numSlots == 0)
+		return;
+	struct BatchPlane
+	{
+		std::array<float,3> n;
+		float d;
+		// For every axis, either the min or max bounds, whichever is further along the plane normal
+		std::array<const float*,3> vertex;
+	};
+	auto [normalSign,distanceSign] = get_plane_signs();
+	std::vector<BatchPlane> batchPlanes;
+	batchPlanes.reserve(planes.size());
+	for(auto &plane : planes)
+	{
+		auto &n = plane.GetNormal();
+		auto &batchPlane = batchPlanes.emplace_back();
+		for(auto i=0u;i<3u;++i)
+		{
+			batchPlane.n[i] = n[i] *normalSign;
+			batchPlane.vertex[i] = (batchPlane.n[i] >= 0.f) ? m_max[i].data() : m_min[i].data();
+		}
+		batchPlane.d = static_cast<float>(plane.GetDistance()) *distanceSign;
+	}
+
+	auto *bits = outVisibility.GetData();
+	auto numBatches = static_cast<uint32_t>(m_min[0].size()) /BATCH_SIZE;
+	static_assert((64 %BATCH_SIZE) == 0);
+	constexpr auto batchesPerWord = 64 /BATCH_SIZE;
+	for(auto batch=decltype(numBatches){0u};batch<numBatches;++batch)
+	{
+		auto offset = batch *BATCH_SIZE;
+#ifdef PRAGMA_RENDER_BOUNDS_SSE
+		auto zero = _mm_setzero_ps();
+		auto visible = _mm_cmpeq_ps(zero,zero);
+		for(auto &plane : batchPlanes)
+		{
+			auto dist = _mm_mul_ps(_mm_set1_ps(plane.n[0]),_mm_loadu_ps(plane.vertex[0] +offset));
+			dist = _mm_add_ps(dist,_mm_mul_ps(_mm_set1_ps(plane.n[1]),_mm_loadu_ps(plane.vertex[1] +offset)));
+			dist = _mm_add_ps(dist,_mm_mul_ps(_mm_set1_ps(plane.n[2]),_mm_loadu_ps(plane.vertex[2] +offset)));
+			visible = _mm_and_ps(visible,_mm_cmpge_ps(dist,_mm_set1_ps(-plane.d)));
+		}
+		auto mask = static_cast<uint64_t>(_mm_movemask_ps(visible));
+#else
+		uint64_t mask = 0;
+		for(auto i=0u;i<BATCH_SIZE;++i)
+		{
+			auto isVisible = true;
+			for(auto &plane : batchPlanes)
+			{
+				auto dist = plane.n[0] *plane.vertex[0][offset +i] +plane.n[1] *plane.vertex[1][offset +i] +plane.n[2] *plane.vertex[2][offset +i];
+				if(dist < -plane.d)
+				{
+					isVisible = false;
+					break;
+				}
+			}
+			if(isVisible)
+				mask |= 1ull<<i;
+		}
+#endif
+		bits[batch /batchesPerWord] |= mask<<((batch %batchesPerWord) *BATCH_SIZE);
+	}
+}
+
+void Console::commands::debug_frustum_culling_benchmark(NetworkState*,pragma::BasePlayerComponent*,std::vector<std::string> &argv)
+{
+	// Culls synthetic bounding boxes, which allows measuring the CPU cost without a scene or GPU
+	auto numBoxes = argv.empty() ? 100'000u : static_cast<uint32_t>(umath::max(util::to_int(argv[0]),1));
+	auto numIterations = (argv.size() > 1) ? static_cast<uint32_t>(umath::max(util::to_int(argv[1]),1)) : 10u;
+
+	std::mt19937 rng {0};
+	std::uniform_real_distribution<float> distPos {-10'000.f,10'000.f};
+	std::uniform_real_distribution<float> distExtents {1.f,200.f};
+	RenderBoundsStorage storage {};
+	std::vector<std::pair<Vector3,Vector3>> bounds;
+	bounds.reserve(numBoxes);
+	for(auto i=decltype(numBoxes){0u};i<numBoxes;++i)
+	{
+		Vector3 pos {distPos(rng),distPos(rng),distPos(rng)};
+		Vector3 extents {distExtents(rng),distExtents(rng),distExtents(rng)};
+		bounds.push_back({pos -extents,pos +extents});
+		auto slot = storage.AllocateSlot();
+		storage.SetBounds(slot,bounds.back().first,bounds.back().second);
+	}
+
+	// Approximation of a view frustum looking down the x-axis
+	std::vector<umath::Plane> planes {
+		umath::Plane{uvec::get_normal(Vector3{1.f,0.f,1.f}),2'000.0},
+		umath::Plane{uvec::get_normal(Vector3{1.f,0.f,-1.f}),2'000.0},
+		umath::Plane{uvec::get_normal(Vector3{1.f,1.f,0.f}),2'000.0},
+		umath::Plane{uvec::get_normal(Vector3{1.f,-1.f,0.f}),2'000.0},
+		umath::Plane{Vector3{1.f,0.f,0.f},0.0},
+		umath::Plane{Vector3{-1.f,0.f,0.f},8'000.0}
+	};
+
+	std::vector<bool> scalarVisibility;
+	scalarVisibility.resize(numBoxes);
+	VisibilityBitset visibility {};
+	std::chrono::steady_clock::duration tScalar {0};
+	std::chrono::steady_clock::duration tBatch {0};
+	for(auto it=decltype(numIterations){0u};it<numIterations;++it)
+	{
+		auto t = std::chrono::steady_clock::now();
+		for(auto i=decltype(numBoxes){0u};i<numBoxes;++i)
+			scalarVisibility[i] = umath::intersection::aabb_in_plane_mesh(bounds[i].first,bounds[i].second,planes) != umath::intersection::Intersect::Outside;
+		tScalar += std::chrono::steady_clock::now() -t;
+
+		t = std::chrono::steady_clock::now();
+		storage.CullByPlanes(planes,visibility);
+		tBatch += std::chrono::steady_clock::now() -t;
+	}
+	uint32_t numVisible = 0;
+	uint32_t numMismatches = 0;
+	for(auto i=decltype(numBoxes){0u};i<numBoxes;++i)
+	{
+		if(scalarVisibility[i])
+			++numVisible;
+		if(scalarVisibility[i] != visibility.IsVisible(i))
+			++numMismatches;
+	}
+	auto toMs = [numIterations](std::chrono::steady_clock::duration d) {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(d).count() /1'000'000.0 /static_cast<double>(numIterations);
+	};
+	Con::cout<<"Frustum culling benchmark ("<<numBoxes<<" boxes, "<<numVisible<<" visible, "<<numIterations<<" iterations, average per iteration):"<<Con::endl;
+	Con::cout<<"Per-box test: "<<toMs(tScalar)<<"ms; Batched SoA test: "<<toMs(tBatch)<<"ms"<<Con::endl;
+	if(numMismatches > 0)
+		Con::cwar<<"WARNING: Batched test disagrees with the per-box test for "<<numMismatches<<" boxes!"<<Con::endl;
+}
@@ -11,7 +11,9 @@
 #include "pragma/rendering/shaders/world/c_shader_textured.hpp"
 #include "pragma/entities/components/c_render_component.hpp"
 #include "pragma/entities/environment/c_env_camera.h"
+#include "pragma/console/c_cvar_global_functions.h"
 #include <cmaterial.h>
+#include <random>
 
 using namespace pragma::rendering;
 
@@ -76,6 +78,10 @@ RenderQueueItem::RenderQueueItem(CBaseEntity &ent,RenderMeshIndex meshIdx,CMater
 	}
 }
 
+static thread_local uint32_t g_threadAppendBufferIndex = RenderQueue::SHARED_APPEND_BUFFER_INDEX;
+void RenderQueue::SetThreadAppendBufferIndex(uint32_t index) {g_threadAppendBufferIndex = (index < APPEND_BUFFER_COUNT) ? index : SHARED_APPEND_BUFFER_INDEX;}
+uint32_t RenderQueue::GetThreadAppendBufferIndex() {return g_threadAppendBufferIndex;}
+
 std::shared_ptr<RenderQueue> RenderQueue::Create(std::string name) {return std::shared_ptr<RenderQueue>{new RenderQueue{std::move(name)}};}
 
 RenderQueue::RenderQueue(std::string name)
@@ -96,6 +102,8 @@ void RenderQueue::Clear()
 {
 	queue.clear();
 	sortedItemIndices.clear();
+	for(auto &buf : m_appendBuffers)
+		buf.clear();
 }
 void RenderQueue::Add(CBaseEntity &ent,RenderMeshIndex meshIdx,CMaterial &mat,prosper::PipelineID pipelineId,const CCameraComponent *optCam)
 {
@@ -122,12 +130,95 @@ void RenderQueue::Add(const std::vector<RenderQueueItem> &items)
 		}
 	m_queueMutex.unlock();
 }
+void RenderQueue::Append(const RenderQueueItem &item)
+{
+	auto idx = g_threadAppendBufferIndex;
+	if(idx != SHARED_APPEND_BUFFER_INDEX)
+	{
+		m_appendBuffers[idx].push_back(item);
+		return;
+	}
+	m_sharedAppendBufferMutex.lock();
+		m_appendBuffers[SHARED_APPEND_BUFFER_INDEX].push_back(item);
+	m_sharedAppendBufferMutex.unlock();
+}
+void RenderQueue::MergeAppendBuffers()
+{
+	size_t numItems = 0;
+	for(auto &buf : m_appendBuffers)
+		numItems += buf.size();
+	if(numItems == 0)
+		return;
+	m_queueMutex.lock();
+		auto offset = queue.size();
+		queue.resize(offset +numItems);
+		sortedItemIndices.resize(queue.size());
+		for(auto &buf : m_appendBuffers)
+		{
+			for(auto &item : buf)
+			{
+				queue[offset] = item;
+				sortedItemIndices[offset] = {static_cast<RenderQueueItemIndex>(offset),item.sortingKey};
+				++offset;
+			}
+			buf.clear(); // Capacity is kept for the next frame
+		}
+	m_queueMutex.unlock();
+}
+static uint64_t get_sort_value(const SortingKey &key)
+{
+	static_assert(sizeof(SortingKey) == sizeof(uint64_t));
+	uint64_t v;
+	memcpy(&v,&key,sizeof(v));
+	return v;
+}
 void RenderQueue::Sort()
 {
-	std::sort(sortedItemIndices.begin(),sortedItemIndices.end(),[](const RenderQueueItemSortPair &a,const RenderQueueItemSortPair &b) {
-		static_assert(sizeof(decltype(a.second)) == sizeof(uint64_t));
-		return *reinterpret_cast<const uint64_t*>(&a.second) < *reinterpret_cast<const uint64_t*>(&b.second);
-	});
+	MergeAppendBuffers();
+
+	// LSD radix sort over the 64-bit sorting key, one byte per pass
+	auto numItems = sortedItemIndices.size();
+	constexpr size_t MIN_RADIX_SORT_ITEM_COUNT = 256;
+	if(numItems < MIN_RADIX_SORT_ITEM_COUNT)
+	{
+		// Not worth the histogram overhead
+		std::sort(sortedItemIndices.begin(),sortedItemIndices.end(),[](const RenderQueueItemSortPair &a,const RenderQueueItemSortPair &b) {
+			return get_sort_value(a.second) < get_sort_value(b.second);
+		});
+		return;
+	}
+	constexpr uint32_t NUM_PASSES = sizeof(uint64_t);
+	std::array<std::array<uint32_t,256>,NUM_PASSES> histograms {};
+	for(auto &pair : sortedItemIndices)
+	{
+		auto v = get_sort_value(pair.second);
+		for(auto pass=decltype(NUM_PASSES){0u};pass<NUM_PASSES;++pass)
+			++histograms[pass][(v>>(pass *8))&0xFF];
+	}
+	m_sortScratch.resize(numItems);
+	auto *src = &sortedItemIndices;
+	auto *dst = &m_sortScratch;
+	for(auto pass=decltype(NUM_PASSES){0u};pass<NUM_PASSES;++pass)
+	{
+		auto &histogram = histograms[pass];
+		auto shift = pass *8;
+		// If all keys share the same digit, this pass wouldn't change the order.
+		// This is usually the case for the unused distance bits of opaque items.
+		if(histogram[(get_sort_value(src->front().second)>>shift)&0xFF] == numItems)
+			continue;
+		uint32_t offset = 0;
+		for(auto &count : histogram)
+		{
+			auto n = count;
+			count = offset;
+			offset += n;
+		}
+		for(auto &pair : *src)
+			(*dst)[histogram[(get_sort_value(pair.second)>>shift)&0xFF]++] = pair;
+		std::swap(src,dst);
+	}
+	if(src != &sortedItemIndices)
+		sortedItemIndices.swap(m_sortScratch);
 }
 
 void RenderQueue::Merge(const RenderQueue &other)
@@ -263,3 +354,99 @@ void RenderQueueBuilder::BuildRenderQueues()
 {
 
 }
+
+//////////////////////
+
+void Console::commands::debug_render_queue_benchmark(NetworkState*,pragma::BasePlayerComponent*,std::vector<std::string> &argv)
+{
+	// Builds and sorts a render queue from synthetic items, which allows measuring the CPU cost without a scene or GPU
+	auto numItems = argv.empty() ? 100'000u : static_cast<uint32_t>(umath::max(util::to_int(argv[0]),1));
+	auto numThreads = (argv.size() > 1) ? static_cast<uint32_t>(umath::max(util::to_int(argv[1]),1)) : umath::max(std::thread::hardware_concurrency(),1u);
+	numThreads = umath::min(numThreads,RenderQueue::APPEND_BUFFER_COUNT -1);
+	auto numIterations = (argv.size() > 2) ? static_cast<uint32_t>(umath::max(util::to_int(argv[2]),1)) : 10u;
+
+	std::vector<RenderQueueItem> items;
+	items.resize(numItems);
+	std::mt19937 rng {0};
+	std::uniform_int_distribution<uint32_t> distMaterial {0,2'000};
+	std::uniform_int_distribution<uint32_t> distShader {0,64};
+	for(auto i=decltype(numItems){0u};i<numItems;++i)
+	{
+		auto &item = items[i];
+		item.material = distMaterial(rng);
+		item.pipelineId = distShader(rng);
+		item.entity = i;
+		item.mesh = i %8;
+		item.translucentKey = (i %10) == 0;
+		item.instanceSetIndex = RenderQueueItem::UNIQUE;
+		item.sortingKey = {item.material,static_cast<prosper::ShaderIndex>(item.pipelineId),(i %3) == 0,item.translucentKey};
+		if(item.translucentKey)
+			item.sortingKey.translucent.distance = rng();
+		else
+			item.sortingKey.opaque.distance = 0;
+	}
+
+	auto renderQueue = RenderQueue::Create("benchmark");
+	auto runThreads = [numThreads,numItems](const std::function<void(uint32_t,uint32_t)> &fAdd) {
+		std::vector<std::thread> threads;
+		threads.reserve(numThreads);
+		auto numPerThread = (numItems +numThreads -1) /numThreads;
+		for(auto t=decltype(numThreads){0u};t<numThreads;++t)
+		{
+			auto start = umath::min(t *numPerThread,numItems);
+			auto end = umath::min(start +numPerThread,numItems);
+			threads.push_back(std::thread{[t,start,end,&fAdd]() {
+				RenderQueue::SetThreadAppendBufferIndex(t +1);
+				fAdd(start,end);
+			}});
+		}
+		for(auto &thread : threads)
+			thread.join();
+	};
+	std::chrono::steady_clock::duration tBuildLocked {0};
+	std::chrono::steady_clock::duration tSortComparison {0};
+	std::chrono::steady_clock::duration tBuildAppend {0};
+	std::chrono::steady_clock::duration tSortRadix {0};
+	auto isSorted = true;
+	for(auto it=decltype(numIterations){0u};it<numIterations;++it)
+	{
+		// Previous approach: Every item is added under a lock, followed by a comparison sort
+		renderQueue->Clear();
+		auto t = std::chrono::steady_clock::now();
+		runThreads([&renderQueue,&items](uint32_t start,uint32_t end) {
+			for(auto i=start;i<end;++i)
+				renderQueue->Add(items[i]);
+		});
+		tBuildLocked += std::chrono::steady_clock::now() -t;
+		t = std::chrono::steady_clock::now();
+		std::sort(renderQueue->sortedItemIndices.begin(),renderQueue->sortedItemIndices.end(),[](const RenderQueueItemSortPair &a,const RenderQueueItemSortPair &b) {
+			return get_sort_value(a.second) < get_sort_value(b.second);
+		});
+		tSortComparison += std::chrono::steady_clock::now() -t;
+
+		// Per-thread append buffers with a single merge, followed by the radix sort
+		renderQueue->Clear();
+		t = std::chrono::steady_clock::now();
+		runThreads([&renderQueue,&items](uint32_t start,uint32_t end) {
+			for(auto i=start;i<end;++i)
+				renderQueue->Append(items[i]);
+		});
+		renderQueue->MergeAppendBuffers();
+		tBuildAppend += std::chrono::steady_clock::now() -t;
+		t = std::chrono::steady_clock::now();
+		renderQueue->Sort();
+		tSortRadix += std::chrono::steady_clock::now() -t;
+
+		isSorted = isSorted && std::is_sorted(renderQueue->sortedItemIndices.begin(),renderQueue->sortedItemIndices.end(),[](const RenderQueueItemSortPair &a,const RenderQueueItemSortPair &b) {
+			return get_sort_value(a.second) < get_sort_value(b.second);
+		});
+	}
+	auto toMs = [numIterations](std::chrono::steady_clock::duration d) {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(d).count() /1'000'000.0 /static_cast<double>(numIterations);
+	};
+	Con::cout<<"Render queue benchmark ("<<numItems<<" items, "<<numThreads<<" threads, "<<numIterations<<" iterations, average per iteration):"<<Con::endl;
+	Con::cout<<"Locked add: "<<toMs(tBuildLocked)<<"ms; Comparison sort: "<<toMs(tSortComparison)<<"ms"<<Con::endl;
+	Con::cout<<"Append buffers: "<<toMs(tBuildAppend)<<"ms; Radix sort: "<<toMs(tSortRadix)<<"ms"<<Con::endl;
+	if(isSorted == false)
+		Con::cwar<<"WARNING: Radix sort produced an incorrect order!"<<Con::endl;
+}
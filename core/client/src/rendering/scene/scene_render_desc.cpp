@@ -17,6 +17,7 @@
 #include "pragma/rendering/occlusion_culling/occlusion_culling_handler_chc.hpp"
 #include "pragma/rendering/occlusion_culling/occlusion_culling_handler_inert.hpp"
 #include "pragma/rendering/occlusion_culling/occlusion_culling_handler_octtree.hpp"
+#include "pragma/rendering/occlusion_culling/occlusion_culling_handler_aabb_tree.hpp"
 #include "pragma/rendering/occlusion_culling/c_occlusion_octree_impl.hpp"
 #include "pragma/rendering/renderers/base_renderer.hpp"
 #include "pragma/rendering/renderers/rasterization_renderer.hpp"
@@ -89,6 +90,9 @@ void SceneRenderDesc::SetOcclusionCullingMethod(OcclusionCullingMethod method)
 	case OcclusionCullingMethod::Octree: /* Octtree */
 		m_occlusionCullingHandler = std::make_shared<pragma::OcclusionCullingHandlerOctTree>();
 		break;
+	case OcclusionCullingMethod::AabbTree: /* Dynamic AABB tree */
+		m_occlusionCullingHandler = std::make_shared<pragma::OcclusionCullingHandlerAabbTree>();
+		break;
 	case OcclusionCullingMethod::Inert: /* Off */
 	default:
 		m_occlusionCullingHandler = std::make_shared<pragma::OcclusionCullingHandlerInert>();
@@ -154,9 +158,11 @@ void SceneRenderDesc::AddRenderMeshesToRenderQueue(
 	const std::function<pragma::rendering::RenderQueue*(pragma::rendering::SceneRenderPass,bool)> &getRenderQueue,
 	const pragma::CSceneComponent &scene,const pragma::CCameraComponent &cam,const Mat4 &vp,const std::function<bool(const Vector3&,const Vector3&)> &fShouldCull,
 	int32_t lodBias,const std::function<void(pragma::rendering::RenderQueue&,const pragma::rendering::RenderQueueItem&)> &fOptInsertItemToQueue,
-	pragma::GameShaderSpecializationConstantFlag baseSpecializationFlags
+	pragma::GameShaderSpecializationConstantFlag baseSpecializationFlags,const pragma::rendering::VisibilityBitset *renderBoundsVisibility
 )
 {
+	if(renderBoundsVisibility && renderBoundsVisibility->IsVisible(renderC.GetRenderBoundsSlot()) == false)
+		return;
 	auto *mdlC = renderC.GetModelComponent();
 	auto lod = umath::max(static_cast<int32_t>(mdlC->GetLOD()) +lodBias,0);
 	auto &renderMeshes = renderC.GetRenderMeshes();
@@ -252,11 +258,11 @@ void SceneRenderDesc::AddRenderMeshesToRenderQueue(
 void SceneRenderDesc::AddRenderMeshesToRenderQueue(
 	pragma::CRasterizationRendererComponent *optRasterizationRenderer,
 	RenderFlags renderFlags,pragma::CRenderComponent &renderC,const pragma::CSceneComponent &scene,const pragma::CCameraComponent &cam,const Mat4 &vp,
-	const std::function<bool(const Vector3&,const Vector3&)> &fShouldCull,
+	const std::function<bool(const Vector3&,const Vector3&)> &fShouldCull,const pragma::rendering::VisibilityBitset *renderBoundsVisibility,
 	pragma::GameShaderSpecializationConstantFlag baseSpecializationFlags
 )
 {
-	AddRenderMeshesToRenderQueue(optRasterizationRenderer,renderFlags,renderC,[this](pragma::rendering::SceneRenderPass renderMode,bool translucent) {return GetRenderQueue(renderMode,translucent);},scene,cam,vp,fShouldCull,0,nullptr,baseSpecializationFlags);
+	AddRenderMeshesToRenderQueue(optRasterizationRenderer,renderFlags,renderC,[this](pragma::rendering::SceneRenderPass renderMode,bool translucent) {return GetRenderQueue(renderMode,translucent);},scene,cam,vp,fShouldCull,0,nullptr,baseSpecializationFlags,renderBoundsVisibility);
 }
 
 bool SceneRenderDesc::ShouldCull(CBaseEntity &ent,const std::function<bool(const Vector3&,const Vector3&)> &fShouldCull)
@@ -297,14 +303,14 @@ void SceneRenderDesc::CollectRenderMeshesFromOctree(
 	const std::function<pragma::rendering::RenderQueue*(pragma::rendering::SceneRenderPass,bool)> &getRenderQueue,
 	const std::function<bool(const Vector3&,const Vector3&)> &fShouldCull,const std::vector<util::BSPTree*> *bspTrees,const std::vector<util::BSPTree::Node*> *bspLeafNodes,
 	int32_t lodBias,const std::function<bool(CBaseEntity&,const pragma::CSceneComponent&,RenderFlags)> &shouldConsiderEntity,
-	pragma::GameShaderSpecializationConstantFlag baseSpecializationFlags
+	pragma::GameShaderSpecializationConstantFlag baseSpecializationFlags,const pragma::rendering::VisibilityBitset *renderBoundsVisibility
 )
 {
 	if(enableClipping)
 		baseSpecializationFlags |= pragma::GameShaderSpecializationConstantFlag::EnableClippingBit;
 	auto numEntitiesPerWorkerJob = umath::max(cvEntitiesPerJob->GetInt(),1);
 	std::function<void(const OcclusionOctree<CBaseEntity*>::Node &node)> iterateTree = nullptr;
-	iterateTree = [&iterateTree,&shouldConsiderEntity,&scene,&cam,renderFlags,fShouldCull,optRasterizationRenderer,renderMask,&getRenderQueue,&vp,bspLeafNodes,bspTrees,lodBias,numEntitiesPerWorkerJob,baseSpecializationFlags](const OcclusionOctree<CBaseEntity*>::Node &node) {
+	iterateTree = [&iterateTree,&shouldConsiderEntity,&scene,&cam,renderFlags,fShouldCull,optRasterizationRenderer,renderMask,&getRenderQueue,&vp,bspLeafNodes,bspTrees,lodBias,numEntitiesPerWorkerJob,baseSpecializationFlags,renderBoundsVisibility](const OcclusionOctree<CBaseEntity*>::Node &node) {
 		auto &nodeBounds = node.GetWorldBounds();
 		if(fShouldCull && fShouldCull(nodeBounds.first,nodeBounds.second))
 			return;
@@ -331,11 +337,9 @@ void SceneRenderDesc::CollectRenderMeshesFromOctree(
 		{
 			auto iStart = i *numEntitiesPerWorkerJob;
 			auto iEnd = umath::min(static_cast<size_t>(iStart +numEntitiesPerWorkerJob),numObjects);
-			c_game->GetRenderQueueWorkerManager().AddJob([iStart,iEnd,shouldConsiderEntity,renderMask,optRasterizationRenderer,&objs,renderFlags,getRenderQueue,&scene,&cam,vp,fShouldCull,lodBias,baseSpecializationFlags]() {
-				// Note: We don't add individual items directly to the render queue, because that would invoke
-				// a mutex lock which can stall all of the worker threads.
-				// Instead we'll collect the entire batch of items, then add all of them to the render queue at once.
-				std::unordered_map<pragma::rendering::RenderQueue*,std::vector<pragma::rendering::RenderQueueItem>> items;
+			c_game->GetRenderQueueWorkerManager().AddJob([iStart,iEnd,shouldConsiderEntity,renderMask,optRasterizationRenderer,&objs,renderFlags,getRenderQueue,&scene,&cam,vp,fShouldCull,lodBias,baseSpecializationFlags,renderBoundsVisibility]() {
+				// Note: Items are added to the worker's own append buffer of the render queue, which doesn't require a lock.
+				// The append buffers are merged into the queue once when it is sorted, after all workers have completed.
 				for(auto i=iStart;i<iEnd;++i)
 				{
 					auto *ent = objs[i];
@@ -360,17 +364,13 @@ void SceneRenderDesc::CollectRenderMeshesFromOctree(
 						//(camClusterIdx.has_value() && renderC->IsVisibleInCluster(*camClusterIdx) == false)
 					)
 						continue;
-					if(fShouldCull && ShouldCull(*renderC,fShouldCull))
+					// If a visibility bitset was specified, the entity bounds have already been culled in batches
+					if(renderBoundsVisibility == nullptr && fShouldCull && ShouldCull(*renderC,fShouldCull))
 						continue;
-					AddRenderMeshesToRenderQueue(optRasterizationRenderer,renderFlags,*renderC,getRenderQueue,scene,cam,vp,fShouldCull,lodBias,[&items](pragma::rendering::RenderQueue &renderQueue,const pragma::rendering::RenderQueueItem &item) {
-						auto &v = items[&renderQueue];
-						if(v.size() == v.capacity())
-							v.reserve(v.size() *1.1f +50);
-						v.push_back(item);
-					},baseSpecializationFlags);
+					AddRenderMeshesToRenderQueue(optRasterizationRenderer,renderFlags,*renderC,getRenderQueue,scene,cam,vp,fShouldCull,lodBias,[](pragma::rendering::RenderQueue &renderQueue,const pragma::rendering::RenderQueueItem &item) {
+						renderQueue.Append(item);
+					},baseSpecializationFlags,renderBoundsVisibility);
 				}
-				for(auto &pair : items)
-					pair.first->Add(pair.second);
 			});
 		}
 		auto *children = node.GetChildren();
@@ -394,7 +394,7 @@ void SceneRenderDesc::CollectRenderMeshesFromOctree(
 	CollectRenderMeshesFromOctree(optRasterizationRenderer,renderFlags,enableClipping,tree,scene,cam,vp,renderMask,[this](pragma::rendering::SceneRenderPass renderMode,bool translucent) {return GetRenderQueue(renderMode,translucent);},
 	[frustumPlanes](const Vector3 &min,const Vector3 &max) -> bool {
 		return umath::intersection::aabb_in_plane_mesh(min,max,frustumPlanes) == umath::intersection::Intersect::Outside;
-	},bspTrees,bspLeafNodes,0,nullptr);
+	},bspTrees,bspLeafNodes,0,nullptr,static_cast<pragma::GameShaderSpecializationConstantFlag>(0),&m_renderBoundsVisibility);
 }
 
 bool SceneRenderDesc::ShouldConsiderEntity(CBaseEntity &ent,const pragma::CSceneComponent &scene,RenderFlags renderFlags,pragma::rendering::RenderMask renderMask)
@@ -693,6 +693,19 @@ void SceneRenderDesc::BuildRenderQueues(
 		auto fShouldCull = [&frustumPlanes](const Vector3 &min,const Vector3 &max) -> bool {return SceneRenderDesc::ShouldCull(min,max,frustumPlanes);};
 		auto vp = cam.GetProjectionMatrix() *cam.GetViewMatrix();
 
+		std::chrono::steady_clock::time_point t;
+		if(stats)
+			t = std::chrono::steady_clock::now();
+
+		// The render bounds of all entities are culled against the frustum in batches up front. Entity transforms can't change
+		// while render queues are being built, so the result stays valid for the entire pass.
+		auto &renderBoundsStorage = pragma::CRenderComponent::GetRenderBoundsStorage();
+		renderBoundsStorage.UpdateDirtyBounds();
+		renderBoundsStorage.CullByPlanes(frustumPlanes,m_renderBoundsVisibility);
+
+		if(stats)
+			(*stats)->AddTime(RenderQueueBuilderStats::Timer::FrustumCulling,std::chrono::steady_clock::now() -t);
+
 		std::vector<util::BSPTree::Node*> bspLeafNodes;
 		std::vector<util::BSPTree*> bspTrees;
 		// Note: World geometry is handled differently than other entities. World entities have their
@@ -702,7 +715,6 @@ void SceneRenderDesc::BuildRenderQueues(
 		// Translucent world meshes still need to be sorted with other entity meshes, so they are just copied over to the
 		// main render queue.
 
-		std::chrono::steady_clock::time_point t;
 		if(stats)
 			t = std::chrono::steady_clock::now();
 
@@ -812,7 +824,10 @@ void SceneRenderDesc::BuildRenderQueues(
 				{
 					if(ShouldConsiderEntity(*static_cast<CBaseEntity*>(ent),m_scene,drawSceneInfo.renderFlags,renderMask) == false)
 						continue;
-					AddRenderMeshesToRenderQueue(&rasterizer,drawSceneInfo.renderFlags,*static_cast<CBaseEntity*>(ent)->GetRenderComponent(),m_scene,cam,vp,nullptr);
+					auto &renderC = *static_cast<CBaseEntity*>(ent)->GetRenderComponent();
+					// View models are never culled, since their render bounds don't account for animations
+					auto cull = renderC.IsExemptFromOcclusionCulling() == false && renderC.GetSceneRenderPass() != pragma::rendering::SceneRenderPass::View;
+					AddRenderMeshesToRenderQueue(&rasterizer,drawSceneInfo.renderFlags,renderC,m_scene,cam,vp,nullptr,cull ? &m_renderBoundsVisibility : nullptr);
 				}
 			}
 
@@ -825,7 +840,8 @@ void SceneRenderDesc::BuildRenderQueues(
 		if(stats)
 			t = std::chrono::steady_clock::now();
 
-		// All render queues (aside from world render queues) need to be sorted
+		// All render queues (aside from world render queues) need to be sorted.
+		// This also merges the items collected by the worker threads into the queues.
 		for(auto &renderQueue : m_renderQueues)
 		{
 			if(stats)
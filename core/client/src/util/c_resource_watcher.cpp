@@ -100,9 +100,11 @@ void CResourceWatcherManager::ReloadTexture(const std::string &path)
 	texManager.LoadAsset(path,std::move(loadInfo));
 }
 
-void CResourceWatcherManager::OnMaterialReloaded(const std::string &path,const std::unordered_set<Model*> &modelMap)
+void CResourceWatcherManager::OnMaterialsReloaded(const std::vector<std::string> &paths,const std::unordered_set<Model*> &models)
 {
-	ResourceWatcherManager::OnMaterialReloaded(path,modelMap);
+	ResourceWatcherManager::OnMaterialsReloaded(paths,models);
+	if(models.empty())
+		return;
 	if(c_game == nullptr)
 		return;
 	EntityIterator entIt {*c_game,EntityIterator::FilterFlags::Default | EntityIterator::FilterFlags::Pending};
@@ -112,8 +114,8 @@ void CResourceWatcherManager::OnMaterialReloaded(const std::string &path,const s
 		auto &mdl = ent->GetModel();
 		if(mdl == nullptr)
 			continue;
-		auto it = modelMap.find(mdl.get());
-		if(it == modelMap.end())
+		auto it = models.find(mdl.get());
+		if(it == models.end())
 			continue;
 		auto mdlC = static_cast<pragma::CModelComponent*>(ent->GetModelComponent());
 		mdlC->SetRenderMeshesDirty();
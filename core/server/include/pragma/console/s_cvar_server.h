@@ -46,6 +46,9 @@ REGISTER_CONCOMMAND_SV(heartbeat,CMD_heartbeat,ConVarFlags::None,"Instantly send
 DLLSERVER void CMD_sv_debug_netmessages(NetworkState *state,pragma::BasePlayerComponent *pl,std::vector<std::string> &argv);
 REGISTER_CONCOMMAND_SV(sv_debug_netmessages,CMD_sv_debug_netmessages,ConVarFlags::None,"Prints out debug information about recent net-messages.");
 
+DLLSERVER void CMD_sv_debug_snapshot_benchmark(NetworkState *state,pragma::BasePlayerComponent *pl,std::vector<std::string> &argv);
+REGISTER_CONCOMMAND_SV(sv_debug_snapshot_benchmark,CMD_sv_debug_snapshot_benchmark,ConVarFlags::None,"Measures the average size and build time of the snapshots sent to all clients over the specified number of ticks. Usage: sv_debug_snapshot_benchmark <tickCount>");
+
 REGISTER_CONVAR_SV(sv_port_tcp,"29150",ConVarFlags::Archive,"TCP port which will be used when starting a server.");
 REGISTER_CONVAR_SV(sv_port_udp,"29150",ConVarFlags::Archive,"UDP port which will be used when starting a server.");
 REGISTER_CONVAR_SV(sv_use_p2p_if_available,"1",ConVarFlags::Archive,"Use a peer-to-peer connection if the selected networking layer supports it.");
@@ -13,6 +13,12 @@
 REGISTER_CONVAR_SV(sv_password,"",ConVarFlags::Archive,"Sets a password for the server. No player will be able to join, unless they provide the correct password using the 'password' command.");
 REGISTER_CONVAR_SV(sv_maxplayers,"1",ConVarFlags::Archive,"Specifies the maximum amount of players that are allowed to join the server.");
 
+REGISTER_CONVAR_SV(sv_snapshot_delta_compression,"1",ConVarFlags::Archive,"If enabled, entity transform data will only be sent to clients if it has changed since the last snapshot the client has acknowledged.");
+REGISTER_CONVAR_SV(sv_snapshot_max_distance,"0",ConVarFlags::Archive,"Entities further away from a player than this distance will not be included in the player's snapshots. 0 = No limit.");
+REGISTER_CONVAR_SV(sv_snapshot_pvs_culling,"1",ConVarFlags::Archive,"If enabled, entities which can't be seen from a player's position according to the potentially visible set of the map will not be included in the player's snapshots. Has no effect on maps without a BSP tree.");
+REGISTER_CONVAR_SV(sv_net_event_pvs_culling,"0",ConVarFlags::Archive,"If enabled, unreliable entity net events without an explicit recipient filter are only sent to players that could potentially see the entity.");
+REGISTER_CONVAR_SV(sv_snapshot_multithreaded,"1",ConVarFlags::Archive,"If enabled, the snapshots for all clients are assembled in parallel on the engine job system.");
+
 REGISTER_CONVAR_SV(sv_physics_simulation_enabled,"1",ConVarFlags::Cheat,"Enables or disables physics simulation.");
 
 REGISTER_CONVAR_SV(sv_water_surface_simulation_edge_iteration_count,"5",ConVarFlags::Archive,"The more iterations, the more detailed the water simulation will be, but at a great performance cost.");
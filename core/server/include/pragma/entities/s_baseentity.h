@@ -16,16 +16,31 @@ class TimerHandle;
 namespace pragma
 {
 	namespace networking {enum class Protocol : uint8_t; class ClientRecipientFilter;};
+	class SBaseNetComponent;
+	class SBaseSnapshotComponent;
 };
 class DLLSERVER SBaseEntity
 	: public BaseEntity
 {
 public:
+	template<class TNetComponent>
+		struct TNetComponentInfo
+	{
+		pragma::BaseEntityComponent *component = nullptr;
+		TNetComponent *netComponent = nullptr;
+	};
+	using NetComponentInfo = TNetComponentInfo<pragma::SBaseNetComponent>;
+	using SnapshotComponentInfo = TNetComponentInfo<pragma::SBaseSnapshotComponent>;
 	SBaseEntity();
 	virtual pragma::ComponentHandle<pragma::BaseEntityComponent> AddNetworkedComponent(const std::string &name) override;
+	// Components derived from SBaseNetComponent / SBaseSnapshotComponent, in the order they were added
+	const std::vector<NetComponentInfo> &GetNetComponents() const;
+	const std::vector<SnapshotComponentInfo> &GetSnapshotComponents() const;
 protected:
 	bool m_bShared;
 	Bool m_bSynchronized;
+	std::vector<NetComponentInfo> m_netComponents;
+	std::vector<SnapshotComponentInfo> m_snapshotComponents;
 	void EraseFunction(int function);
 	virtual void OnComponentAdded(pragma::BaseEntityComponent &component) override;
 	virtual void OnComponentRemoved(pragma::BaseEntityComponent &component) override;
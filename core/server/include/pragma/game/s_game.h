@@ -9,10 +9,13 @@
 #include <pragma/game/game.h>
 #include "pragma/serverdefinitions.h"
 #include "pragma/entities/world.h"
+#include "pragma/networking/s_snapshot_frame.hpp"
+#include "pragma/networking/s_potential_visibility_cache.hpp"
 #include <vector>
 #include <unordered_map>
 #include <string>
 #include <optional>
+#include <chrono>
 #include <mathutil/color.h>
 #include <sharedutils/datastream.h>
 #ifdef __linux__
@@ -50,6 +53,28 @@ private:
 	std::unordered_map<std::string,udm::PProperty> m_preTransitionWorldState {};
 	// Delta landmark offset between this level and the previous level (in case there was a level change)
 	Vector3 m_deltaTransitionLandmarkOffset {};
+
+	struct SnapshotBenchmark
+	{
+		uint32_t remainingTicks = 0;
+		uint32_t numTicks = 0;
+		uint32_t numSnapshots = 0;
+		uint32_t numClients = 0;
+		uint64_t numBytes = 0;
+		uint64_t numEntitiesSent = 0;
+		std::chrono::steady_clock::duration duration {};
+	};
+	std::optional<SnapshotBenchmark> m_snapshotBenchmark {};
+	pragma::networking::SnapshotFrame m_snapshotFrame {};
+	std::vector<pragma::networking::SnapshotClientFrame> m_snapshotClientFrames {};
+	pragma::networking::PotentialVisibilityCache m_potentialVisibilityCache {};
+	bool IsEntityInSnapshotRange(const pragma::networking::SnapshotFrame::EntityData &entData,pragma::SPlayerComponent &pl,float maxDistance) const;
+	bool IsEntityPotentiallyVisibleForSnapshot(const pragma::networking::SnapshotFrame::EntityData &entData,pragma::SPlayerComponent &pl,bool pvsCulling) const;
+	void BuildSnapshotFrame(const std::vector<pragma::networking::SnapshotClientFrame*> &clients);
+	void SelectSnapshotEntities(pragma::networking::SnapshotClientFrame &client) const;
+	void WriteSnapshotCustomData(pragma::networking::SnapshotClientFrame &client);
+	void WriteSnapshotPacket(pragma::networking::SnapshotClientFrame &client) const;
+	void UpdateSnapshotBenchmark(uint32_t numClients);
 public:
 	enum class CPUProfilingPhase : uint32_t
 	{
@@ -77,6 +102,7 @@ protected:
 	virtual void RegisterLuaEntityComponents(luabind::module_ &gameMod) override;
 	virtual void RegisterLuaEntityComponent(luabind::class_<pragma::BaseEntityComponent> &classDef) override;
 	virtual bool InitializeGameMode() override;
+	virtual void InitializeWorldData(pragma::asset::WorldData &worldData) override;
 
 	const pragma::NetEventManager &GetEntityNetEventManager() const;
 	pragma::NetEventManager &GetEntityNetEventManager();
@@ -109,6 +135,14 @@ public:
 	virtual void RegisterLuaClasses() override;
 	void SendSnapshot();
 	void SendSnapshot(pragma::SPlayerComponent *pl);
+	void SendSnapshot(const std::vector<pragma::SPlayerComponent*> &players);
+	// Measures the size and build time of all snapshots over the next few ticks and prints the results to the console
+	void StartSnapshotBenchmark(uint32_t numTicks);
+	// Potential visibility of entities for each player, based on the BSP tree of the world. Updated once per tick.
+	const pragma::networking::PotentialVisibilityCache &GetPotentialVisibilityCache() const;
+	// Only includes clients whose player could potentially see the entity or position
+	pragma::networking::ClientRecipientFilter CreatePotentiallyVisibleRecipientFilter(const SBaseEntity &ent) const;
+	pragma::networking::ClientRecipientFilter CreatePotentiallyVisibleRecipientFilter(const Vector3 &pos) const;
 	virtual std::shared_ptr<ModelMesh> CreateModelMesh() const override;
 	virtual std::shared_ptr<ModelSubMesh> CreateModelSubMesh() const override;
 	virtual void GetRegisteredEntities(std::vector<std::string> &classes,std::vector<std::string> &luaClasses) const override;
@@ -10,6 +10,7 @@
 #include "pragma/serverdefinitions.h"
 #include "pragma/networking/enums.hpp"
 #include "pragma/networking/ip_address.hpp"
+#include "pragma/networking/s_snapshot_baseline.hpp"
 #include <cinttypes>
 
 class Resource;
@@ -56,6 +57,8 @@ namespace pragma::networking
 		bool IsTransferring() const;
 
 		uint8_t SwapSnapshotId();
+		SnapshotBaseline &GetSnapshotBaseline();
+		const SnapshotBaseline &GetSnapshotBaseline() const;
 		void Reset();
 		void ScheduleResource(const std::string &fileName);
 		std::vector<std::string> &GetScheduledResources();
@@ -71,7 +74,7 @@ namespace pragma::networking
 		std::vector<std::shared_ptr<Resource>> m_resourceTransfer;
 		TransferState m_initialResourceTransferState = TransferState::Initial;
 
-		uint8_t m_snapshotId = 0;
+		SnapshotBaseline m_snapshotBaseline {};
 		std::vector<std::string> m_scheduledResources; // Scheduled resource files for download
 
 		// TODO: Move this somewhere else?
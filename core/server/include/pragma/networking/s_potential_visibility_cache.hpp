@@ -0,0 +1,82 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright (c) 2021 Silverlan */
+
+#ifndef __PRAGMA_S_POTENTIAL_VISIBILITY_CACHE_HPP__
+#define __PRAGMA_S_POTENTIAL_VISIBILITY_CACHE_HPP__
+
+#include "pragma/serverdefinitions.h"
+#include <pragma/util/util_bsp_tree.hpp>
+#include <mathutil/uvec.h>
+#include <vector>
+#include <array>
+#include <memory>
+
+class SBaseEntity;
+namespace pragma {class SPlayerComponent;};
+namespace util {using Uuid = std::array<uint64_t,2>;};
+namespace pragma::networking
+{
+	// Uses the potentially visible set of the world's BSP tree to determine which entities each player could see from
+	// their view position. The results are cached and have to be updated once per tick.
+	// Entities are considered visible if there is no BSP tree, if their position can't be mapped to a cluster,
+	// or if they were created after the last update.
+	class DLLSERVER PotentialVisibilityCache
+	{
+	public:
+		PotentialVisibilityCache()=default;
+		void SetBSPTree(const std::shared_ptr<util::BSPTree> &bspTree);
+		const util::BSPTree *GetBSPTree() const;
+		void Clear();
+
+		void Update(const std::vector<SBaseEntity*> &entities,const std::vector<SPlayerComponent*> &players);
+		bool IsEntityPotentiallyVisible(const SPlayerComponent &pl,const SBaseEntity &ent) const;
+		bool IsPositionPotentiallyVisible(const SPlayerComponent &pl,const Vector3 &pos) const;
+		// Returns true if the entity wasn't visible to the player during the previous update, but is now.
+		// Entities that have changed while they were hidden have to be re-transmitted in that case.
+		bool HasEntityBecomeVisible(const SPlayerComponent &pl,const SBaseEntity &ent) const;
+		bool HasEntityBecomeVisibleToAnyPlayer(const SBaseEntity &ent) const;
+	private:
+		static constexpr auto INVALID_CLUSTER = std::numeric_limits<util::BSPTree::ClusterIndex>::max();
+		struct PlayerVisibility
+		{
+			const SPlayerComponent *player = nullptr;
+			util::BSPTree::ClusterIndex cluster = INVALID_CLUSTER;
+			std::vector<uint64_t> visibleEntities;
+			std::vector<uint64_t> newlyVisibleEntities;
+			bool updated = false;
+		};
+		struct EntityClusters
+		{
+			util::Uuid uuid {};
+			// The clusters are only re-computed if the bounds of the entity have changed
+			Vector3 position {};
+			float radius = 0.f;
+			// Entities that weren't part of the last update have no clusters and are always visible
+			uint32_t lastUpdate = 0;
+			bool valid = false;
+			std::vector<util::BSPTree::ClusterIndex> clusters;
+		};
+		const PlayerVisibility *FindPlayerVisibility(const SPlayerComponent &pl) const;
+		const EntityClusters *FindEntityClusters(const SBaseEntity &ent) const;
+		util::BSPTree::ClusterIndex FindCluster(const Vector3 &pos) const;
+		void UpdateEntityClusters(const std::vector<SBaseEntity*> &entities);
+		void UpdatePlayerVisibility(PlayerVisibility &plVis);
+
+		std::shared_ptr<util::BSPTree> m_bspTree = nullptr;
+		std::vector<PlayerVisibility> m_players;
+		// Indexed by entity index. Entities without any clusters are always visible.
+		std::vector<EntityClusters> m_entityClusters;
+		uint32_t m_updateIndex = 0;
+		std::vector<uint64_t> m_newlyVisibleEntitiesAny;
+		// One bit per cluster, re-used for every player
+		std::vector<uint64_t> m_visibleClusters;
+		// Scratch buffers for the entity cluster lookups; The cluster bits are cleared after every entity
+		std::vector<util::BSPTree::Node*> m_leafNodes;
+		std::vector<uint64_t> m_entityClusterBits;
+	};
+};
+
+#endif
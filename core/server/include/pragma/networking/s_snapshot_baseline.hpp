@@ -0,0 +1,96 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright (c) 2021 Silverlan */
+
+#ifndef __PRAGMA_S_SNAPSHOT_BASELINE_HPP__
+#define __PRAGMA_S_SNAPSHOT_BASELINE_HPP__
+
+#include "pragma/serverdefinitions.h"
+#include <pragma/networking/snapshot_flags.hpp>
+#include <mathutil/uvec.h>
+#include <mathutil/uquat.h>
+#include <array>
+#include <vector>
+
+class BaseEntity;
+namespace util {using Uuid = std::array<uint64_t,2>;};
+namespace pragma::networking
+{
+	// Keeps track of the entity state that was last transmitted to a client, as well as which snapshots
+	// the client has acknowledged. A field only has to be re-transmitted if it has changed since it was last sent,
+	// or if the snapshot that carried its current value has been lost. A snapshot is considered lost once a
+	// later snapshot has been acknowledged without it, or once it has fallen out of the acknowledgement window.
+	// Acknowledgements are tracked per snapshot, so acknowledging a later snapshot which didn't carry the
+	// entity (e.g. because it wasn't relevant to the client at the time) doesn't confirm fields of a lost snapshot.
+	class DLLSERVER SnapshotBaseline
+	{
+	public:
+		using SequenceId = uint32_t;
+		struct EntityFields
+		{
+			Vector3 position {};
+			Vector3 velocity {};
+			Vector3 angularVelocity {};
+			Quat rotation = uquat::identity();
+		};
+		static constexpr float FIELD_EPSILON = 0.001f;
+		// Number of most recent snapshots for which acknowledgements are tracked. Fields sent with older snapshots
+		// that haven't been confirmed in time are re-transmitted.
+		static constexpr uint32_t ACK_WINDOW = 256;
+
+		SnapshotBaseline()=default;
+		// Returns the network id of the next snapshot (wraps around after 255)
+		uint8_t BeginSnapshot();
+		// Called whenever the client confirms it has received the snapshot with the specified network id.
+		// Bit i of the mask is set if the client has received the snapshot 'snapshotId -i -1' as well.
+		void Acknowledge(uint8_t snapshotId,uint32_t receivedMask=0);
+
+		void SetDeltaCompressionEnabled(bool enabled);
+		bool IsDeltaCompressionEnabled() const;
+
+		// Returns true if the entity has to be transmitted again even if it hasn't changed, i.e. if some of
+		// the data that was last sent for it has been lost, or if it was out of range for the client.
+		// Acknowledged fields are cached, so this should be called for every entity that isn't updated otherwise.
+		bool RequiresUpdate(const BaseEntity &ent);
+		// Determines which fields have to be transmitted for the entity and updates the baseline accordingly.
+		// Must only be called between BeginSnapshot and the transmission of the snapshot.
+		SnapshotEntityFieldFlags UpdateEntity(const BaseEntity &ent,const EntityFields &fields);
+		// All fields of the entity will be transmitted the next time it is updated
+		void InvalidateEntity(const BaseEntity &ent);
+		// Entities that were skipped because they were too far away from the client may have changed in the meantime,
+		// so their full state has to be sent once they're back in range
+		void SetEntityOutOfRange(const BaseEntity &ent,bool outOfRange);
+		bool IsEntityOutOfRange(const BaseEntity &ent) const;
+	private:
+		struct EntityState
+		{
+			util::Uuid uuid {};
+			EntityFields fields {};
+			// First snapshot that carried the current value of each field
+			std::array<SequenceId,4> sentSequence {};
+			// Bit i is set once the snapshot that carried the current value of field i has been acknowledged
+			uint8_t acknowledgedFields = 0;
+			bool valid = false;
+		};
+		void AcknowledgeSequence(SequenceId seq);
+		bool IsAcknowledged(SequenceId seq) const;
+		bool IsLost(SequenceId seq) const;
+		// Updates the cached acknowledgement of the field and returns true if its current value has to be sent again
+		bool IsFieldLost(EntityState &state,uint32_t fieldIdx) const;
+		EntityState *FindEntityState(const BaseEntity &ent);
+		const EntityState *FindEntityState(const BaseEntity &ent) const;
+		std::vector<EntityState> m_entityStates {};
+		// Uuids of the entities that are out of range, indexed by entity index
+		std::vector<util::Uuid> m_outOfRangeEntities {};
+		// Sequence id +1 of the acknowledged snapshot for each slot, or 0 if the slot's snapshot hasn't been acknowledged
+		std::array<SequenceId,ACK_WINDOW> m_acknowledgedSequences {};
+		// Sequence id +1 of the most recent snapshot that has been acknowledged, or 0 if there is none
+		SequenceId m_latestAcknowledgedSequence = 0;
+		SequenceId m_nextSequence = 0;
+		bool m_deltaCompressionEnabled = true;
+	};
+};
+
+#endif
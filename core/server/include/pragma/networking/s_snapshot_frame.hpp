@@ -0,0 +1,98 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright (c) 2021 Silverlan */
+
+#ifndef __PRAGMA_S_SNAPSHOT_FRAME_HPP__
+#define __PRAGMA_S_SNAPSHOT_FRAME_HPP__
+
+#include "pragma/serverdefinitions.h"
+#include "pragma/networking/s_snapshot_baseline.hpp"
+#include <pragma/networking/snapshot_flags.hpp>
+#include <pragma/types.hpp>
+#include <sharedutils/netpacket.hpp>
+#include <vector>
+
+class SBaseEntity;
+namespace pragma
+{
+	class SPlayerComponent;
+	class SBaseSnapshotComponent;
+};
+namespace pragma::networking
+{
+	class IServerClient;
+	// Client-independent snapshot data, which is gathered once per tick and shared between all clients
+	struct DLLSERVER SnapshotFrame
+	{
+		struct EntityData
+		{
+			SBaseEntity *entity = nullptr;
+			SnapshotBaseline::EntityFields fields {};
+			Vector3 relevanceOrigin {};
+			float relevanceRadius = 0.f;
+			bool markedForSnapshot = false;
+			bool alwaysRelevant = false;
+			// Physics data is only required if one of the transform fields is transmitted as well
+			bool physicsDataRequiresFieldChange = false;
+			bool hasPhysicsData = false;
+			// Range within SnapshotFrame::physicsData
+			uint32_t physicsDataOffset = 0;
+			uint32_t physicsDataSize = 0;
+			// Range within SnapshotFrame::snapshotComponents
+			uint32_t firstSnapshotComponent = 0;
+			uint32_t snapshotComponentCount = 0;
+		};
+		struct PlayerData
+		{
+			SPlayerComponent *player = nullptr;
+			Quat viewOrientation = uquat::identity();
+		};
+		struct SnapshotComponentData
+		{
+			ComponentId componentId = 0;
+			SBaseSnapshotComponent *component = nullptr;
+		};
+		std::vector<EntityData> entities;
+		std::vector<SnapshotComponentData> snapshotComponents;
+		std::vector<PlayerData> players;
+		NetPacket physicsData;
+		double time = 0.0;
+		void Clear();
+	};
+
+	// Per-client part of a snapshot
+	struct DLLSERVER SnapshotClientFrame
+	{
+		struct Entry
+		{
+			uint32_t entityDataIndex = 0;
+			SnapshotEntityFieldFlags fields = SnapshotEntityFieldFlags::None;
+			// Range within SnapshotClientFrame::customData
+			uint32_t entityDataOffset = 0;
+			uint32_t entityDataSize = 0;
+			// Range within SnapshotClientFrame::components
+			uint32_t firstComponent = 0;
+			uint32_t componentCount = 0;
+		};
+		struct ComponentEntry
+		{
+			ComponentId componentId = 0;
+			// Range within SnapshotClientFrame::customData
+			uint32_t dataOffset = 0;
+			uint32_t dataSize = 0;
+		};
+		SPlayerComponent *player = nullptr;
+		IServerClient *session = nullptr;
+		uint8_t snapshotId = 0;
+		std::vector<Entry> entries;
+		std::vector<ComponentEntry> components;
+		// Output of the SendSnapshotData-methods of the entities and components, which have to be invoked on the main thread
+		NetPacket customData;
+		NetPacket packet;
+		void Clear();
+	};
+};
+
+#endif
@@ -289,3 +289,14 @@ void CMD_sv_debug_netmessages(NetworkState *state,pragma::BasePlayerComponent *p
 	sv->DebugDump("sv_netmessages.dump",*svMsgs,*clMsgs);
 }
 
+void CMD_sv_debug_snapshot_benchmark(NetworkState *state,pragma::BasePlayerComponent *pl,std::vector<std::string> &argv)
+{
+	if(s_game == nullptr)
+	{
+		Con::cwar<<"WARNING: No game is active!"<<Con::endl;
+		return;
+	}
+	auto numTicks = argv.empty() ? 100u : static_cast<uint32_t>(umath::max(ustring::to_int(argv.front()),1));
+	s_game->StartSnapshotBenchmark(numTicks);
+	Con::cout<<"Running snapshot benchmark for "<<numTicks<<" ticks..."<<Con::endl;
+}
@@ -16,6 +16,7 @@
 #include <pragma/lua/luafunction_call.h>
 #include "pragma/entities/player.h"
 #include "pragma/networking/recipient_filter.hpp"
+#include "pragma/console/s_cvar.h"
 #include "pragma/lua/lua_handles.hpp"
 #include "pragma/model/s_modelmanager.h"
 #include "pragma/entities/components/s_entity_component.hpp"
@@ -69,9 +70,23 @@ void SBaseEntity::DoSpawn()
 	game->SpawnEntity(this);
 }
 
+const std::vector<SBaseEntity::NetComponentInfo> &SBaseEntity::GetNetComponents() const {return m_netComponents;}
+const std::vector<SBaseEntity::SnapshotComponentInfo> &SBaseEntity::GetSnapshotComponents() const {return m_snapshotComponents;}
+
 void SBaseEntity::OnComponentAdded(pragma::BaseEntityComponent &component)
 {
 	BaseEntity::OnComponentAdded(component);
+	// Only components in these lists are transmitted, so components that want to transmit data have to derive from the respective class
+	auto *netComponent = dynamic_cast<pragma::SBaseNetComponent*>(&component);
+	auto *snapshotComponent = dynamic_cast<pragma::SBaseSnapshotComponent*>(&component);
+	if(netComponent == nullptr && component.ShouldTransmitNetData())
+		throw std::logic_error("Component must be derived from SBaseNetComponent if net data is enabled!");
+	if(snapshotComponent == nullptr && component.ShouldTransmitSnapshotData())
+		throw std::logic_error("Component must be derived from SBaseSnapshotComponent if snapshot data is enabled!");
+	if(netComponent != nullptr)
+		m_netComponents.push_back({&component,netComponent});
+	if(snapshotComponent != nullptr)
+		m_snapshotComponents.push_back({&component,snapshotComponent});
 	if(typeid(component) == typeid(pragma::STransformComponent))
 		m_transformComponent = &static_cast<pragma::STransformComponent&>(component);
 	else if(typeid(component) == typeid(pragma::SPhysicsComponent))
@@ -86,6 +101,12 @@ void SBaseEntity::OnComponentAdded(pragma::BaseEntityComponent &component)
 void SBaseEntity::OnComponentRemoved(pragma::BaseEntityComponent &component)
 {
 	BaseEntity::OnComponentRemoved(component);
+	auto itNet = std::find_if(m_netComponents.begin(),m_netComponents.end(),[&component](const NetComponentInfo &info) {return info.component == &component;});
+	if(itNet != m_netComponents.end())
+		m_netComponents.erase(itNet);
+	auto itSnapshot = std::find_if(m_snapshotComponents.begin(),m_snapshotComponents.end(),[&component](const SnapshotComponentInfo &info) {return info.component == &component;});
+	if(itSnapshot != m_snapshotComponents.end())
+		m_snapshotComponents.erase(itSnapshot);
 	if(typeid(component) == typeid(pragma::SWorldComponent))
 		umath::set_flag(m_stateFlags,StateFlags::HasWorldComponent,false);
 	else if(typeid(component) == typeid(pragma::STransformComponent))
@@ -140,36 +161,29 @@ void SBaseEntity::SendData(NetPacket &packet,pragma::networking::ClientRecipient
 	packet->Write<uint32_t>(GetSpawnFlags());
 	packet->Write(GetUuid());
 
-	auto &componentManager = s_game->GetEntityComponentManager();
-	auto &components = GetComponents();
-	auto offset = packet->GetOffset();
-	auto numComponents = umath::min(components.size(),static_cast<size_t>(std::numeric_limits<uint8_t>::max()));
-	packet->Write<uint8_t>(numComponents);
-	for(auto &pComponent : components)
+	// Component data is written to a separate buffer first, since the sizes are variable-length encoded
+	NetPacket componentData {};
+	std::vector<std::pair<pragma::ComponentId,uint32_t>> componentSizes {};
+	componentSizes.reserve(m_netComponents.size());
+	for(auto &info : m_netComponents)
 	{
-		if(pComponent->ShouldTransmitNetData() == false)
-		{
-			--numComponents;
+		if(info.component->ShouldTransmitNetData() == false)
 			continue;
-		}
-		auto *pNetComponent = dynamic_cast<pragma::SBaseNetComponent*>(pComponent.get());
-		if(pNetComponent == nullptr)
-		{
-			throw std::logic_error("Component must be derived from SBaseNetComponent if net data is enabled!");
+		auto offset = componentData->GetSize();
+		info.netComponent->SendData(componentData,rp);
+		componentSizes.push_back({info.component->GetComponentId(),static_cast<uint32_t>(componentData->GetSize() -offset)});
+	}
+	nwm::write_varint(packet,componentSizes.size());
+	auto *data = componentData->GetData();
+	for(auto &pair : componentSizes)
+	{
+		packet->Write<pragma::ComponentId>(pair.first);
+		nwm::write_varint(packet,pair.second);
+		if(pair.second == 0)
 			continue;
-		}
-		auto id = pComponent->GetComponentId();
-		packet->Write<pragma::ComponentId>(id);
-		auto szComponent = 0u;
-		auto offset = packet->GetOffset();
-		packet->Write<uint8_t>(static_cast<uint8_t>(0u));
-		pNetComponent->SendData(packet,rp);
-		szComponent = packet->GetOffset() -(offset +sizeof(uint8_t));
-		if(szComponent > std::numeric_limits<uint8_t>::max())
-			throw std::runtime_error("Component size mustn't exceed " +std::to_string(std::numeric_limits<uint8_t>::max()) +" bytes!");
-		packet->Write<uint8_t>(szComponent,&offset);
+		packet->Write(data,pair.second);
+		data += pair.second;
 	}
-	packet->Write<uint8_t>(numComponents,&offset);
 }
 
 void SBaseEntity::SendSnapshotData(NetPacket&,pragma::BasePlayerComponent&) {}
@@ -204,10 +218,17 @@ void SBaseEntity::SendNetEvent(pragma::NetEventId eventId,NetPacket &packet,prag
 	packet->Write<UInt32>(eventId);
 	server->SendPacket("ent_event",packet,protocol,rf);
 }
+static CVar cvNetEventPvsCulling = GetServerConVar("sv_net_event_pvs_culling");
 void SBaseEntity::SendNetEvent(pragma::NetEventId eventId,NetPacket &packet,pragma::networking::Protocol protocol)
 {
 	if(!IsShared() || !IsSpawned())
 		return;
+	// Unreliable events may be lost anyway, so clients that can't see the entity can safely be skipped
+	if(protocol == pragma::networking::Protocol::FastUnreliable && s_game && cvNetEventPvsCulling->GetBool())
+	{
+		SendNetEvent(eventId,packet,protocol,s_game->CreatePotentiallyVisibleRecipientFilter(*this));
+		return;
+	}
 	SendNetEvent(eventId,packet,protocol,pragma::networking::ClientRecipientFilter{});
 }
 void SBaseEntity::SendNetEvent(pragma::NetEventId eventId,NetPacket &packet)
@@ -225,12 +246,9 @@ void SBaseEntity::SendNetEvent(pragma::NetEventId eventId,pragma::networking::Pr
 }
 Bool SBaseEntity::ReceiveNetEvent(pragma::BasePlayerComponent &pl,pragma::NetEventId eventId,NetPacket &packet)
 {
-	for(auto &pComponent : GetComponents())
+	for(auto &info : m_netComponents)
 	{
-		auto *pNetComponent = dynamic_cast<pragma::SBaseNetComponent*>(pComponent.get());
-		if(pNetComponent == nullptr)
-			continue;
-		if(pNetComponent->ReceiveNetEvent(pl,eventId,packet))
+		if(info.netComponent->ReceiveNetEvent(pl,eventId,packet))
 			return true;
 	}
 	Con::csv<<"WARNING: Unhandled net event '"<<eventId<<"' for entity "<<GetClass()<<Con::endl;
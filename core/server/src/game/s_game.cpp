@@ -73,6 +73,7 @@
 #include <pragma/entities/components/map_component.hpp>
 #include <pragma/entities/components/velocity_component.hpp>
 #include <pragma/entities/entity_component_system_t.hpp>
+#include <pragma/asset_types/world.hpp>
 #include <udm.hpp>
 
 extern "C" {
@@ -479,6 +480,13 @@ void SGame::GenerateLuaCache()
 	}
 }
 
+void SGame::InitializeWorldData(pragma::asset::WorldData &worldData)
+{
+	Game::InitializeWorldData(worldData);
+	auto *bspTree = worldData.GetBSPTree();
+	m_potentialVisibilityCache.SetBSPTree(bspTree ? bspTree->shared_from_this() : nullptr);
+}
+
 bool SGame::InitializeGameMode()
 {
 	if(Game::InitializeGameMode() == false)
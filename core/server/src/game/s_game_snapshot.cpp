@@ -7,6 +7,7 @@
 #include "stdafx_server.h"
 #include "pragma/game/s_game.h"
 #include "pragma/entities/components/s_player_component.hpp"
+#include "pragma/entities/components/s_entity_component.hpp"
 #include "pragma/networking/iserver_client.hpp"
 #include "pragma/networking/recipient_filter.hpp"
 #include "pragma/entities/player.h"
@@ -19,180 +20,457 @@
 #include <pragma/entities/entity_component_system_t.hpp>
 #include <pragma/networking/nwm_util.h>
 #include <pragma/networking/enums.hpp>
+#include "pragma/console/s_cvar.h"
+#include <pragma/util/job_system.hpp>
+#include <chrono>
 
+extern DLLNETWORK Engine *engine;
 extern DLLSERVER ServerState *server;
 
-void SGame::SendSnapshot(pragma::SPlayerComponent *pl)
+static CVar cvDeltaCompression = GetServerConVar("sv_snapshot_delta_compression");
+static CVar cvMaxDistance = GetServerConVar("sv_snapshot_max_distance");
+static CVar cvMultithreaded = GetServerConVar("sv_snapshot_multithreaded");
+static CVar cvPvsCulling = GetServerConVar("sv_snapshot_pvs_culling");
+static CVar cvNetEventPvsCulling = GetServerConVar("sv_net_event_pvs_culling");
+
+void pragma::networking::SnapshotFrame::Clear()
+{
+	entities.clear();
+	snapshotComponents.clear();
+	players.clear();
+	physicsData = {};
+}
+
+void pragma::networking::SnapshotClientFrame::Clear()
+{
+	player = nullptr;
+	session = nullptr;
+	entries.clear();
+	components.clear();
+	customData = {};
+	packet = {};
+}
+
+bool SGame::IsEntityInSnapshotRange(const pragma::networking::SnapshotFrame::EntityData &entData,pragma::SPlayerComponent &pl,float maxDistance) const
+{
+	if(entData.alwaysRelevant || entData.entity == &pl.GetEntity() || maxDistance <= 0.f)
+		return true;
+	auto maxDistWithRadius = maxDistance +entData.relevanceRadius;
+	return uvec::length_sqr(entData.relevanceOrigin -pl.GetViewPos()) <= umath::pow2(maxDistWithRadius);
+}
+bool SGame::IsEntityPotentiallyVisibleForSnapshot(const pragma::networking::SnapshotFrame::EntityData &entData,pragma::SPlayerComponent &pl,bool pvsCulling) const
+{
+	if(pvsCulling == false || entData.alwaysRelevant || entData.entity == &pl.GetEntity())
+		return true;
+	return m_potentialVisibilityCache.IsEntityPotentiallyVisible(pl,*entData.entity);
+}
+
+const pragma::networking::PotentialVisibilityCache &SGame::GetPotentialVisibilityCache() const {return m_potentialVisibilityCache;}
+pragma::networking::ClientRecipientFilter SGame::CreatePotentiallyVisibleRecipientFilter(const SBaseEntity &ent) const
+{
+	auto hEnt = ent.GetHandle();
+	return pragma::networking::ClientRecipientFilter{[this,hEnt](const pragma::networking::IServerClient &client) -> bool {
+		auto *pl = client.GetPlayer();
+		if(pl == nullptr || hEnt.valid() == false)
+			return true;
+		return m_potentialVisibilityCache.IsEntityPotentiallyVisible(*pl,static_cast<const SBaseEntity&>(*hEnt.get()));
+	}};
+}
+pragma::networking::ClientRecipientFilter SGame::CreatePotentiallyVisibleRecipientFilter(const Vector3 &pos) const
 {
-	auto *session = pl ? pl->GetClientSession() : nullptr;
-	if(session == nullptr)
+	return pragma::networking::ClientRecipientFilter{[this,pos](const pragma::networking::IServerClient &client) -> bool {
+		auto *pl = client.GetPlayer();
+		return pl == nullptr || m_potentialVisibilityCache.IsPositionPotentiallyVisible(*pl,pos);
+	}};
+}
+
+static void write_physics_data(NetPacket &packet,PhysObj &physObj)
+{
+	if(physObj.IsController())
+	{
+		packet->Write<uint8_t>(1u);
+		auto &physController = static_cast<ControllerPhysObj&>(physObj);
+		packet->Write<Vector3>(physController.GetPosition());
+		packet->Write<Quat>(physController.GetOrientation());
+		packet->Write<Vector3>(physController.GetLinearVelocity());
+		packet->Write<Vector3>(physController.GetAngularVelocity());
 		return;
-	NetPacket packet;
-	packet->Write<uint8_t>(session->SwapSnapshotId());
-	packet->Write<double>(CurTime());
+	}
+	auto &colObjs = physObj.GetCollisionObjects();
+	packet->Write<uint8_t>(static_cast<uint8_t>(colObjs.size()));
+	for(auto &hObj : colObjs)
+	{
+		Vector3 pos {0.f,0.f,0.f};
+		auto rot = uquat::identity();
+		Vector3 vel {0.f,0.f,0.f};
+		Vector3 angVel {0.f,0.f,0.f};
+		if(hObj.IsValid())
+		{
+			auto *o = hObj.Get();
+			pos = o->GetPos();
+			rot = o->GetRotation();
+			if(o->IsRigid())
+			{
+				auto *rigid = o->GetRigidBody();
+				vel = rigid->GetLinearVelocity();
+				angVel = rigid->GetAngularVelocity();
+			}
+		}
+		packet->Write<Vector3>(pos);
+		packet->Write<Quat>(rot);
+		packet->Write<Vector3>(vel);
+		packet->Write<Vector3>(angVel);
+	}
+}
+
+void SGame::BuildSnapshotFrame(const std::vector<pragma::networking::SnapshotClientFrame*> &clients)
+{
+	auto &frame = m_snapshotFrame;
+	frame.Clear();
+	frame.time = CurTime();
+	auto pvsCulling = cvPvsCulling->GetBool();
 
 	std::vector<SBaseEntity*> *entities;
 	GetEntities(&entities);
-	auto numEntities = entities->size();
-	auto posNumEnts = packet->GetSize();
-	packet->Write<unsigned int>((unsigned int)(0));
-	size_t numEntitiesValid = 0;
-	for(size_t i=0;i<numEntities;i++)
+	frame.entities.reserve(entities->size());
+	for(auto *ent : *entities)
 	{
-		SBaseEntity *ent = (*entities)[i];
-		if(ent != NULL && ent->IsShared() && ent->IsSynchronized() && ent->IsMarkedForSnapshot())
+		if(ent == nullptr || ent->IsShared() == false || ent->IsSynchronized() == false)
+			continue;
+		// Entities that haven't changed are only re-sent if a client has lost their last state or if they were out of range
+		// for a client, or if they have just become visible to a client (in which case they may have changed while they were hidden)
+		auto marked = ent->IsMarkedForSnapshot();
+		if(marked == false && (pvsCulling == false || m_potentialVisibilityCache.HasEntityBecomeVisibleToAnyPlayer(*ent) == false))
 		{
-			numEntitiesValid++;
-			auto pTrComponent = ent->GetTransformComponent();
-			auto pVelComponent = ent->GetComponent<pragma::VelocityComponent>();
-			nwm::write_entity(packet,ent);
-			nwm::write_vector(packet,pTrComponent != nullptr ? pTrComponent->GetPosition() : Vector3{});
-			nwm::write_vector(packet,pVelComponent.valid() ? pVelComponent->GetVelocity() : Vector3{});
-			nwm::write_vector(packet,pVelComponent.valid() ? pVelComponent->GetAngularVelocity() : Vector3{});
-			nwm::write_quat(packet,pTrComponent != nullptr ? pTrComponent->GetRotation() : uquat::identity());
-
-			auto offsetEntData = packet->GetSize();
-			packet->Write<UInt8>(UInt8(0));
-			auto offset = packet->GetSize();
-			ent->SendSnapshotData(packet,*pl);
-			auto entDataSize = packet->GetSize() -offset;
-#ifdef _DEBUG
-			assert(entDataSize <= std::numeric_limits<UInt8>::max());
-#endif
-			packet->Write<UInt8>(CUInt8(entDataSize),&offsetEntData);
-
-			auto flags = pragma::SnapshotFlags::None;
-			auto offsetSnapshotFlags = packet->GetOffset();
-			packet->Write<decltype(flags)>(flags);
-
-			auto pPhysComponent = ent->GetPhysicsComponent();
-			PhysObj *physObj = pPhysComponent != nullptr ? pPhysComponent->GetPhysicsObject() : nullptr;
-			if(physObj != NULL && !physObj->IsStatic())
-			{
-				flags |= pragma::SnapshotFlags::PhysicsData;
-				if(physObj->IsController())
-				{
-					packet->Write<uint8_t>(1u);
-					auto *physController = static_cast<ControllerPhysObj*>(physObj);
-					packet->Write<Vector3>(physController->GetPosition());
-					packet->Write<Quat>(physController->GetOrientation());
-					packet->Write<Vector3>(physController->GetLinearVelocity());
-					packet->Write<Vector3>(physController->GetAngularVelocity());
-				}
-				else
-				{
-					auto colObjs = physObj->GetCollisionObjects();
-					packet->Write<uint8_t>(static_cast<uint8_t>(colObjs.size()));
-					//auto i = 0;
-					for(auto &hObj : colObjs)
-					{
-						Vector3 pos {0.f,0.f,0.f};
-						auto rot = uquat::identity();
-						Vector3 vel {0.f,0.f,0.f};
-						Vector3 angVel {0.f,0.f,0.f};
-						if(hObj.IsValid())
-						{
-							auto *o = hObj.Get();
-							pos = o->GetPos();
-							rot = o->GetRotation();
-							if(o->IsRigid())
-							{
-								auto *rigid = o->GetRigidBody();
-								vel = rigid->GetLinearVelocity();
-								angVel = rigid->GetAngularVelocity();
-							}
-						}
-						packet->Write<Vector3>(pos);
-						packet->Write<Quat>(rot);
-						packet->Write<Vector3>(vel);
-						packet->Write<Vector3>(angVel);
-					}
-				}
-			}
+			// Every client has to be checked, since this also caches the acknowledgements
+			auto requiresUpdate = false;
+			for(auto *client : clients)
+				requiresUpdate = client->session->GetSnapshotBaseline().RequiresUpdate(*ent) || requiresUpdate;
+			if(requiresUpdate == false)
+				continue;
+		}
+		frame.entities.push_back({});
+		auto &entData = frame.entities.back();
+		entData.entity = ent;
+		entData.markedForSnapshot = marked;
+		entData.alwaysRelevant = ent->IsPlayer();
+
+		auto pTrComponent = ent->GetTransformComponent();
+		auto pVelComponent = ent->GetComponent<pragma::VelocityComponent>();
+		if(pTrComponent != nullptr)
+		{
+			entData.fields.position = pTrComponent->GetPosition();
+			entData.fields.rotation = pTrComponent->GetRotation();
+		}
+		else
+			entData.alwaysRelevant = true;
+		if(pVelComponent.valid())
+		{
+			entData.fields.velocity = pVelComponent->GetVelocity();
+			entData.fields.angularVelocity = pVelComponent->GetAngularVelocity();
+		}
+		entData.relevanceOrigin = entData.fields.position;
+
+		auto pPhysComponent = ent->GetPhysicsComponent();
+		if(pPhysComponent != nullptr)
+			entData.relevanceRadius = pPhysComponent->GetCollisionRadius();
+		PhysObj *physObj = pPhysComponent != nullptr ? pPhysComponent->GetPhysicsObject() : nullptr;
+		if(physObj != NULL && !physObj->IsStatic())
+		{
+			entData.hasPhysicsData = true;
+			// The state of single-body physics objects follows the entity transform, so there's nothing new to send if none of the fields have changed
+			entData.physicsDataRequiresFieldChange = !physObj->IsController() && physObj->GetCollisionObjects().size() <= 1;
+			entData.physicsDataOffset = frame.physicsData->GetSize();
+			write_physics_data(frame.physicsData,*physObj);
+			entData.physicsDataSize = frame.physicsData->GetSize() -entData.physicsDataOffset;
+		}
+
+		entData.firstSnapshotComponent = frame.snapshotComponents.size();
+		for(auto &info : ent->GetSnapshotComponents())
+		{
+			if(info.netComponent->ShouldTransmitSnapshotData() == false)
+				continue;
+			frame.snapshotComponents.push_back({info.component->GetComponentId(),info.netComponent});
+			++entData.snapshotComponentCount;
+		}
+	}
+
+	auto &players = pragma::SPlayerComponent::GetAll();
+	frame.players.reserve(players.size());
+	for(auto *plComponent : players)
+	{
+		auto *ent = (plComponent != nullptr) ? static_cast<Player*>(plComponent->GetBasePlayer()) : nullptr;
+		if(ent == nullptr)
+			continue;
+		auto charComponent = ent->GetCharacterComponent();
+		frame.players.push_back({plComponent,charComponent.valid() ? charComponent->GetViewOrientation() : uquat::identity()});
+	}
+}
 
-			auto offsetNumComponents = 0u;
-			auto numComponents = 0u;
-			auto bFirst = true;
-			for(auto &pComponent : ent->GetComponents())
+void SGame::SelectSnapshotEntities(pragma::networking::SnapshotClientFrame &client) const
+{
+	auto &frame = m_snapshotFrame;
+	auto &pl = *client.player;
+	auto &baseline = client.session->GetSnapshotBaseline();
+	auto maxDistance = cvMaxDistance->GetFloat();
+	auto pvsCulling = cvPvsCulling->GetBool();
+	client.entries.reserve(frame.entities.size());
+	for(auto i=decltype(frame.entities.size()){0u};i<frame.entities.size();++i)
+	{
+		auto &entData = frame.entities[i];
+		auto &ent = *entData.entity;
+		auto becameVisible = pvsCulling && m_potentialVisibilityCache.HasEntityBecomeVisible(pl,ent);
+		// Always evaluated, since this also caches the acknowledgements
+		auto requiresUpdate = baseline.RequiresUpdate(ent);
+		if(entData.markedForSnapshot == false && becameVisible == false && requiresUpdate == false)
+			continue;
+		if(IsEntityInSnapshotRange(entData,pl,maxDistance) == false)
+		{
+			// Changes are missed while the entity is out of range, so it is kept in the snapshot frame until it is back in range
+			baseline.SetEntityOutOfRange(ent,true);
+			continue;
+		}
+		// The entity hasn't been transmitted to this client while it was out of range or hidden, so its full state is sent again.
+		// If it is still hidden, it will be invalidated once it becomes visible.
+		auto reenteredRange = baseline.IsEntityOutOfRange(ent);
+		if(reenteredRange)
+			baseline.SetEntityOutOfRange(ent,false);
+		if(IsEntityPotentiallyVisibleForSnapshot(entData,pl,pvsCulling) == false)
+			continue;
+		if(becameVisible || reenteredRange)
+			baseline.InvalidateEntity(ent);
+		client.entries.push_back({});
+		auto &entry = client.entries.back();
+		entry.entityDataIndex = i;
+		entry.fields = baseline.UpdateEntity(ent,entData.fields);
+	}
+}
+
+void SGame::WriteSnapshotCustomData(pragma::networking::SnapshotClientFrame &client)
+{
+	// SendSnapshotData may call into Lua, so this has to happen on the main thread
+	auto &frame = m_snapshotFrame;
+	auto &pl = *client.player;
+	auto &data = client.customData;
+	for(auto &entry : client.entries)
+	{
+		auto &entData = frame.entities[entry.entityDataIndex];
+		entry.entityDataOffset = data->GetSize();
+		entData.entity->SendSnapshotData(data,pl);
+		entry.entityDataSize = data->GetSize() -entry.entityDataOffset;
+
+		entry.firstComponent = client.components.size();
+		for(auto i=entData.firstSnapshotComponent;i<entData.firstSnapshotComponent +entData.snapshotComponentCount;++i)
+		{
+			auto &componentData = frame.snapshotComponents[i];
+			auto offset = data->GetSize();
+			componentData.component->SendSnapshotData(data,pl);
+			client.components.push_back({componentData.componentId,static_cast<uint32_t>(offset),static_cast<uint32_t>(data->GetSize() -offset)});
+			++entry.componentCount;
+		}
+	}
+}
+
+void SGame::WriteSnapshotPacket(pragma::networking::SnapshotClientFrame &client) const
+{
+	auto &frame = m_snapshotFrame;
+	auto *pl = client.player;
+	auto &packet = client.packet;
+	auto *customData = client.customData->GetData();
+	packet->Write<uint8_t>(client.snapshotId);
+	packet->Write<double>(frame.time);
+
+	packet->Write<UInt32>(static_cast<UInt32>(client.entries.size()));
+	for(auto &entry : client.entries)
+	{
+		auto &entData = frame.entities[entry.entityDataIndex];
+		auto fieldFlags = entry.fields;
+		nwm::write_entity(packet,entData.entity);
+		packet->Write<pragma::SnapshotEntityFieldFlags>(fieldFlags);
+		if((fieldFlags &pragma::SnapshotEntityFieldFlags::Position) != pragma::SnapshotEntityFieldFlags::None)
+			nwm::write_vector(packet,entData.fields.position);
+		if((fieldFlags &pragma::SnapshotEntityFieldFlags::Velocity) != pragma::SnapshotEntityFieldFlags::None)
+			nwm::write_vector(packet,entData.fields.velocity);
+		if((fieldFlags &pragma::SnapshotEntityFieldFlags::AngularVelocity) != pragma::SnapshotEntityFieldFlags::None)
+			nwm::write_vector(packet,entData.fields.angularVelocity);
+		if((fieldFlags &pragma::SnapshotEntityFieldFlags::Rotation) != pragma::SnapshotEntityFieldFlags::None)
+			nwm::write_quat(packet,entData.fields.rotation);
+
+		nwm::write_varint(packet,entry.entityDataSize);
+		if(entry.entityDataSize > 0)
+			packet->Write(customData +entry.entityDataOffset,entry.entityDataSize);
+
+		auto flags = pragma::SnapshotFlags::None;
+		auto physDataRequired = entData.hasPhysicsData && (fieldFlags != pragma::SnapshotEntityFieldFlags::None || entData.physicsDataRequiresFieldChange == false);
+		if(physDataRequired)
+			flags |= pragma::SnapshotFlags::PhysicsData;
+		if(entry.componentCount > 0)
+			flags |= pragma::SnapshotFlags::ComponentData;
+		packet->Write<decltype(flags)>(flags);
+		if(physDataRequired)
+			packet->Write(frame.physicsData->GetData() +entData.physicsDataOffset,entData.physicsDataSize);
+		if(entry.componentCount > 0)
+		{
+			nwm::write_varint(packet,entry.componentCount);
+			for(auto i=entry.firstComponent;i<entry.firstComponent +entry.componentCount;++i)
 			{
-				if(pComponent->ShouldTransmitSnapshotData() == false)
-					continue;
-				auto *pSnapshotComponent = dynamic_cast<pragma::SBaseSnapshotComponent*>(pComponent.get());
-				if(pSnapshotComponent == nullptr)
-					throw std::logic_error("Component must be derived from SBaseSnapshotComponent if snapshot data is enabled!");
-				if(bFirst)
-				{
-					bFirst = false;
-					flags |= pragma::SnapshotFlags::ComponentData;
-					offsetNumComponents = packet->GetOffset();
-					packet->Write<uint8_t>(static_cast<uint8_t>(0u));
-				}
-				packet->Write<pragma::ComponentId>(pComponent->GetComponentId());
-				auto offsetComponentSize = packet->GetOffset();
-				packet->Write<uint8_t>(static_cast<uint8_t>(0u));
-
-				auto offsetComponentDataStart = packet->GetOffset();
-				pSnapshotComponent->SendSnapshotData(packet,*pl);
-				auto szComponent = packet->GetOffset() -offsetComponentDataStart;
-				if(szComponent > std::numeric_limits<uint8_t>::max())
-					throw std::runtime_error("Component size mustn't exceed " +std::to_string(std::numeric_limits<uint8_t>::max()) +" bytes!");
-				packet->Write<uint8_t>(szComponent,&offsetComponentSize);
-
-				if(++numComponents == std::numeric_limits<uint8_t>::max())
-				{
-					Con::csv<<"WARNING: Attempted to send data for more than "<<std::numeric_limits<uint8_t>::max()<<" components for a single entity! This is not allowed!"<<Con::endl;
-					break;
-				}
+				auto &componentEntry = client.components[i];
+				packet->Write<pragma::ComponentId>(componentEntry.componentId);
+				nwm::write_varint(packet,componentEntry.dataSize);
+				if(componentEntry.dataSize > 0)
+					packet->Write(customData +componentEntry.dataOffset,componentEntry.dataSize);
 			}
-			packet->Write<decltype(flags)>(flags,&offsetSnapshotFlags);
-			if((flags &pragma::SnapshotFlags::ComponentData) != pragma::SnapshotFlags::None)
-				packet->Write<uint8_t>(numComponents,&offsetNumComponents);
 		}
 	}
-	packet->Write<UInt32>(CUInt32(numEntitiesValid),&posNumEnts);
 
-	//unsigned int numPlayers = Player::GetPlayerCount();
 	auto posNumPls = packet->GetSize();
 	packet->Write<unsigned char>((unsigned char)(0));
-	auto &players = pragma::SPlayerComponent::GetAll();
 	unsigned char numPlayersValid = 0;
-	for(auto *plComponent : players)
+	auto &keyStack = pl->GetKeyStack();
+	for(auto &plData : frame.players)
 	{
-		if(plComponent != NULL && plComponent != pl)
+		if(plData.player == pl)
+			continue;
+		numPlayersValid++;
+		nwm::write_player(packet,plData.player);
+		nwm::write_quat(packet,plData.viewOrientation);
+		auto sz = CUChar(keyStack.size());
+		packet->Write<UChar>(sz);
+		for(UChar k=0;k<sz;k++) // TODO: Same as above
 		{
-			auto *ent = static_cast<Player*>(plComponent->GetBasePlayer());
-			if(ent != nullptr)
-			{
-				numPlayersValid++;
-				nwm::write_player(packet,plComponent);
-				auto charComponent = ent->GetCharacterComponent();
-				nwm::write_quat(packet,charComponent.valid() ? charComponent->GetViewOrientation() : uquat::identity());
-				std::vector<InputAction> &keyStack = pl->GetKeyStack();
-				auto sz = CUChar(keyStack.size());
-				packet->Write<UChar>(sz);
-				for(UChar k=0;k<sz;k++) // TODO: Same as above
-				{
-					InputAction &ka = keyStack[k];
-					packet->Write<unsigned short>(CUInt16(ka.action));
-					packet->Write<char>(ka.task == GLFW_PRESS);
-				}
-			}
+			auto &ka = keyStack[k];
+			packet->Write<unsigned short>(CUInt16(ka.action));
+			packet->Write<char>(ka.task == GLFW_PRESS);
 		}
 	}
 	packet->Write<unsigned char>(numPlayersValid,&posNumPls);
-	server->SendPacket("snapshot",packet,pragma::networking::Protocol::FastUnreliable,*session);
+}
+
+void SGame::SendSnapshot(const std::vector<pragma::SPlayerComponent*> &players)
+{
+	auto tStart = std::chrono::steady_clock::now();
+	auto deltaCompression = cvDeltaCompression->GetBool();
+	auto &clients = m_snapshotClientFrames;
+	if(clients.size() < players.size())
+		clients.resize(players.size());
+	std::vector<pragma::networking::SnapshotClientFrame*> activeClients {};
+	activeClients.reserve(players.size());
+	for(auto *pl : players)
+	{
+		auto *session = pl->GetClientSession();
+		if(session == nullptr)
+			continue;
+		auto &client = clients[activeClients.size()];
+		client.Clear();
+		client.player = pl;
+		client.session = session;
+		session->GetSnapshotBaseline().SetDeltaCompressionEnabled(deltaCompression);
+		client.snapshotId = session->SwapSnapshotId();
+		activeClients.push_back(&client);
+	}
+	if(activeClients.empty())
+		return;
+
+	// Client-independent stage
+	BuildSnapshotFrame(activeClients);
+
+	// Per-client stage; Everything except for the custom snapshot data can be done in parallel
+	if(cvMultithreaded->GetBool() && activeClients.size() > 1)
+	{
+		auto &jobSystem = engine->GetJobSystem();
+		auto runParallel = [&jobSystem,&activeClients](const std::function<void(pragma::networking::SnapshotClientFrame&)> &f) {
+			pragma::JobCounter counter {};
+			for(auto *client : activeClients)
+				jobSystem.Schedule([client,&f]() {f(*client);},&counter);
+			jobSystem.Wait(counter);
+		};
+		runParallel([this](pragma::networking::SnapshotClientFrame &client) {SelectSnapshotEntities(client);});
+		for(auto *client : activeClients)
+			WriteSnapshotCustomData(*client);
+		runParallel([this](pragma::networking::SnapshotClientFrame &client) {WriteSnapshotPacket(client);});
+	}
+	else
+	{
+		for(auto *client : activeClients)
+		{
+			SelectSnapshotEntities(*client);
+			WriteSnapshotCustomData(*client);
+			WriteSnapshotPacket(*client);
+		}
+	}
+
+	for(auto *client : activeClients)
+		server->SendPacket("snapshot",client->packet,pragma::networking::Protocol::FastUnreliable,*client->session);
+
+	if(m_snapshotBenchmark.has_value())
+	{
+		auto &benchmark = *m_snapshotBenchmark;
+		for(auto *client : activeClients)
+		{
+			++benchmark.numSnapshots;
+			benchmark.numBytes += client->packet->GetSize();
+			benchmark.numEntitiesSent += client->entries.size();
+		}
+		benchmark.duration += std::chrono::steady_clock::now() -tStart;
+	}
+}
+
+void SGame::SendSnapshot(pragma::SPlayerComponent *pl)
+{
+	if(pl == nullptr)
+		return;
+	SendSnapshot(std::vector<pragma::SPlayerComponent*>{pl});
+}
+
+void SGame::StartSnapshotBenchmark(uint32_t numTicks)
+{
+	m_snapshotBenchmark = SnapshotBenchmark{};
+	m_snapshotBenchmark->remainingTicks = numTicks;
+}
+
+void SGame::UpdateSnapshotBenchmark(uint32_t numClients)
+{
+	if(m_snapshotBenchmark.has_value() == false)
+		return;
+	auto &benchmark = *m_snapshotBenchmark;
+	++benchmark.numTicks;
+	benchmark.numClients = umath::max(benchmark.numClients,numClients);
+	if(benchmark.remainingTicks > 0 && --benchmark.remainingTicks > 0)
+		return;
+	std::vector<SBaseEntity*> *entities;
+	GetEntities(&entities);
+	auto numEntities = std::count_if(entities->begin(),entities->end(),[](const SBaseEntity *ent) {
+		return ent != nullptr && ent->IsShared() && ent->IsSynchronized();
+	});
+	auto numSnapshots = umath::max(benchmark.numSnapshots,static_cast<uint32_t>(1));
+	auto durationUs = std::chrono::duration_cast<std::chrono::nanoseconds>(benchmark.duration).count() /1'000.0;
+	Con::cout<<"Snapshot benchmark ("<<benchmark.numTicks<<" ticks, "<<numEntities<<" synchronized entities, "<<benchmark.numClients<<" clients, delta compression "<<(cvDeltaCompression->GetBool() ? "enabled" : "disabled")<<"):"<<Con::endl;
+	Con::cout<<"Average bytes per snapshot: "<<(benchmark.numBytes /static_cast<double>(numSnapshots))<<Con::endl;
+	Con::cout<<"Average entities per snapshot: "<<(benchmark.numEntitiesSent /static_cast<double>(numSnapshots))<<Con::endl;
+	Con::cout<<"Average time per snapshot: "<<(durationUs /static_cast<double>(numSnapshots))<<"us"<<Con::endl;
+	Con::cout<<"Average time per tick: "<<(durationUs /static_cast<double>(benchmark.numTicks))<<"us"<<Con::endl;
+	m_snapshotBenchmark = {};
 }
 
 void SGame::SendSnapshot()
 {
 	//Con::csv<<"[SERVER] Sending snapshot.."<<Con::endl;
 	auto &players = pragma::SPlayerComponent::GetAll();
-	//unsigned char numPlayersValid = 0;
+	std::vector<pragma::SPlayerComponent*> readyPlayers {};
+	readyPlayers.reserve(players.size());
 	for(auto *plComponent : players)
 	{
 		if(plComponent != nullptr && plComponent->IsGameReady())
-			SendSnapshot(plComponent);
+			readyPlayers.push_back(plComponent);
+	}
+	if(cvPvsCulling->GetBool() || cvNetEventPvsCulling->GetBool())
+	{
+		std::vector<SBaseEntity*> *entities;
+		GetEntities(&entities);
+		m_potentialVisibilityCache.Update(*entities,readyPlayers);
 	}
+	SendSnapshot(readyPlayers);
+	UpdateSnapshotBenchmark(readyPlayers.size());
 	std::vector<SBaseEntity*> *entities;
 	GetEntities(&entities);
 	for(unsigned int i=0;i<entities->size();i++)
@@ -76,8 +76,10 @@ void pragma::networking::IServerClient::ClearResourceTransfer()
 
 uint8_t pragma::networking::IServerClient::SwapSnapshotId()
 {
-	return m_snapshotId++; // Overflow doesn't matter
+	return m_snapshotBaseline.BeginSnapshot();
 }
+pragma::networking::SnapshotBaseline &pragma::networking::IServerClient::GetSnapshotBaseline() {return m_snapshotBaseline;}
+const pragma::networking::SnapshotBaseline &pragma::networking::IServerClient::GetSnapshotBaseline() const {return m_snapshotBaseline;}
 
 void pragma::networking::IServerClient::ScheduleResource(const std::string &fileName)
 {
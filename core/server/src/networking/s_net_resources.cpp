@@ -291,6 +291,14 @@ void ServerState::ReceiveUserInput(pragma::networking::IServerClient &client,Net
 		}
 	}
 	pl->SetActionInputs(actions,bController);
+
+	auto hasSnapshotAck = packet->Read<bool>();
+	if(hasSnapshotAck)
+	{
+		auto snapshotId = packet->Read<uint8_t>();
+		auto receivedMask = packet->Read<uint32_t>();
+		client.GetSnapshotBaseline().Acknowledge(snapshotId,receivedMask);
+	}
 	//Con::csv<<"Action inputs "<<actions<<" for player "<<pl<<" ("<<pl->GetClientSession()->GetIP()<<")"<<Con::endl;
 
 	SendPacket("playerinput",pOut,pragma::networking::Protocol::FastUnreliable,{client,pragma::networking::ClientRecipientFilter::FilterType::Exclude});
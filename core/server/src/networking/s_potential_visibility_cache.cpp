@@ -0,0 +1,194 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright (c) 2021 Silverlan */
+
+#include "stdafx_server.h"
+#include "pragma/networking/s_potential_visibility_cache.hpp"
+#include "pragma/entities/components/s_player_component.hpp"
+#include "pragma/entities/s_baseentity.h"
+#include <pragma/entities/components/base_transform_component.hpp>
+#include <pragma/entities/components/base_physics_component.hpp>
+
+using namespace pragma::networking;
+
+static bool is_bit_set(const std::vector<uint64_t> &bits,uint32_t idx) {return (idx /64) < bits.size() && (bits[idx /64] &(1ull<<(idx %64))) != 0;}
+static void set_bit(std::vector<uint64_t> &bits,uint32_t idx) {bits[idx /64] |= 1ull<<(idx %64);}
+static void clear_bit(std::vector<uint64_t> &bits,uint32_t idx) {bits[idx /64] &= ~(1ull<<(idx %64));}
+
+void PotentialVisibilityCache::SetBSPTree(const std::shared_ptr<util::BSPTree> &bspTree)
+{
+	Clear();
+	m_bspTree = (bspTree && bspTree->IsValid() && bspTree->GetClusterCount() > 0) ? bspTree : nullptr;
+}
+const util::BSPTree *PotentialVisibilityCache::GetBSPTree() const {return m_bspTree.get();}
+void PotentialVisibilityCache::Clear()
+{
+	m_players.clear();
+	m_entityClusters.clear();
+	m_newlyVisibleEntitiesAny.clear();
+	m_entityClusterBits.clear();
+}
+
+util::BSPTree::ClusterIndex PotentialVisibilityCache::FindCluster(const Vector3 &pos) const
+{
+	auto *node = m_bspTree->FindLeafNode(pos);
+	if(node == nullptr || node->cluster >= m_bspTree->GetClusterCount())
+		return INVALID_CLUSTER;
+	return node->cluster;
+}
+
+void PotentialVisibilityCache::UpdateEntityClusters(const std::vector<SBaseEntity*> &entities)
+{
+	++m_updateIndex;
+	if(m_entityClusters.size() < entities.size())
+		m_entityClusters.resize(entities.size());
+	auto numClusters = m_bspTree->GetClusterCount();
+	m_entityClusterBits.resize((numClusters +63) /64,0ull);
+	for(auto *ent : entities)
+	{
+		if(ent == nullptr || ent->IsShared() == false || ent->IsWorld())
+			continue;
+		auto pTrComponent = ent->GetTransformComponent();
+		if(pTrComponent == nullptr)
+			continue;
+		auto idx = ent->GetIndex();
+		if(idx >= m_entityClusters.size())
+			m_entityClusters.resize(idx +1);
+		auto &info = m_entityClusters[idx];
+		auto &pos = pTrComponent->GetPosition();
+		auto pPhysComponent = ent->GetPhysicsComponent();
+		auto radius = (pPhysComponent != nullptr) ? pPhysComponent->GetCollisionRadius() : 0.f;
+		auto uuid = ent->GetUuid();
+		info.lastUpdate = m_updateIndex;
+		if(info.valid && info.uuid == uuid && info.position == pos && info.radius == radius)
+			continue;
+		info.uuid = uuid;
+		info.position = pos;
+		info.radius = radius;
+		info.valid = true;
+		info.clusters.clear();
+		if(radius <= 0.f)
+		{
+			auto cluster = FindCluster(pos);
+			if(cluster != INVALID_CLUSTER)
+				info.clusters.push_back(cluster);
+			continue;
+		}
+		Vector3 extents {radius,radius,radius};
+		m_leafNodes.clear();
+		m_bspTree->FindLeafNodesInAabb(pos -extents,pos +extents,m_leafNodes);
+		for(auto *node : m_leafNodes)
+		{
+			if(node->cluster >= numClusters || is_bit_set(m_entityClusterBits,node->cluster))
+				continue;
+			set_bit(m_entityClusterBits,node->cluster);
+			info.clusters.push_back(node->cluster);
+		}
+		for(auto cluster : info.clusters)
+			clear_bit(m_entityClusterBits,cluster);
+	}
+}
+
+void PotentialVisibilityCache::UpdatePlayerVisibility(PlayerVisibility &plVis)
+{
+	auto numEntities = static_cast<uint32_t>(m_entityClusters.size());
+	auto numWords = (numEntities +63) /64;
+	auto prevVisibleEntities = std::move(plVis.visibleEntities);
+	plVis.visibleEntities.assign(numWords,0ull);
+	plVis.newlyVisibleEntities.assign(numWords,0ull);
+	plVis.cluster = FindCluster(plVis.player->GetViewPos());
+
+	auto allVisible = (plVis.cluster == INVALID_CLUSTER);
+	if(allVisible == false)
+	{
+		m_visibleClusters.assign((m_bspTree->GetClusterCount() +63) /64,0ull);
+		m_bspTree->IterateVisibleClusters(plVis.cluster,[this](util::BSPTree::ClusterIndex cluster) {
+			set_bit(m_visibleClusters,cluster);
+		});
+	}
+	for(auto i=decltype(numEntities){0u};i<numEntities;++i)
+	{
+		auto &info = m_entityClusters[i];
+		auto visible = allVisible || info.lastUpdate != m_updateIndex || info.clusters.empty();
+		for(auto j=decltype(info.clusters.size()){0u};visible == false && j<info.clusters.size();++j)
+			visible = is_bit_set(m_visibleClusters,info.clusters[j]);
+		if(visible == false)
+			continue;
+		set_bit(plVis.visibleEntities,i);
+		if(is_bit_set(prevVisibleEntities,i) == false)
+		{
+			set_bit(plVis.newlyVisibleEntities,i);
+			set_bit(m_newlyVisibleEntitiesAny,i);
+		}
+	}
+}
+
+void PotentialVisibilityCache::Update(const std::vector<SBaseEntity*> &entities,const std::vector<SPlayerComponent*> &players)
+{
+	if(m_bspTree == nullptr)
+		return;
+	UpdateEntityClusters(entities);
+	m_newlyVisibleEntitiesAny.assign((m_entityClusters.size() +63) /64,0ull);
+	for(auto &plVis : m_players)
+		plVis.updated = false;
+	for(auto *pl : players)
+	{
+		if(pl == nullptr)
+			continue;
+		auto it = std::find_if(m_players.begin(),m_players.end(),[pl](const PlayerVisibility &plVis) {return plVis.player == pl;});
+		if(it == m_players.end())
+		{
+			m_players.push_back({});
+			it = m_players.end() -1;
+			it->player = pl;
+		}
+		UpdatePlayerVisibility(*it);
+		it->updated = true;
+	}
+	// Players that weren't updated have either left, or aren't ready yet
+	m_players.erase(std::remove_if(m_players.begin(),m_players.end(),[](const PlayerVisibility &plVis) {return plVis.updated == false;}),m_players.end());
+}
+
+const PotentialVisibilityCache::PlayerVisibility *PotentialVisibilityCache::FindPlayerVisibility(const SPlayerComponent &pl) const
+{
+	auto it = std::find_if(m_players.begin(),m_players.end(),[&pl](const PlayerVisibility &plVis) {return plVis.player == &pl;});
+	return (it != m_players.end()) ? &*it : nullptr;
+}
+
+const PotentialVisibilityCache::EntityClusters *PotentialVisibilityCache::FindEntityClusters(const SBaseEntity &ent) const
+{
+	auto idx = ent.GetIndex();
+	if(idx >= m_entityClusters.size())
+		return nullptr;
+	auto &info = m_entityClusters[idx];
+	if(info.lastUpdate != m_updateIndex || info.uuid != ent.GetUuid())
+		return nullptr; // Entity has been created after the last update, or its index has been re-used
+	return &info;
+}
+
+bool PotentialVisibilityCache::IsEntityPotentiallyVisible(const SPlayerComponent &pl,const SBaseEntity &ent) const
+{
+	auto *plVis = FindPlayerVisibility(pl);
+	if(plVis == nullptr || FindEntityClusters(ent) == nullptr)
+		return true;
+	return is_bit_set(plVis->visibleEntities,ent.GetIndex());
+}
+
+bool PotentialVisibilityCache::IsPositionPotentiallyVisible(const SPlayerComponent &pl,const Vector3 &pos) const
+{
+	auto *plVis = FindPlayerVisibility(pl);
+	if(plVis == nullptr || plVis->cluster == INVALID_CLUSTER)
+		return true;
+	auto cluster = FindCluster(pos);
+	return cluster == INVALID_CLUSTER || m_bspTree->IsClusterVisible(plVis->cluster,cluster);
+}
+
+bool PotentialVisibilityCache::HasEntityBecomeVisible(const SPlayerComponent &pl,const SBaseEntity &ent) const
+{
+	auto *plVis = FindPlayerVisibility(pl);
+	return plVis && is_bit_set(plVis->newlyVisibleEntities,ent.GetIndex());
+}
+
+bool PotentialVisibilityCache::HasEntityBecomeVisibleToAnyPlayer(const SBaseEntity &ent) const {return is_bit_set(m_newlyVisibleEntitiesAny,ent.GetIndex());}
@@ -0,0 +1,167 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright (c) 2021 Silverlan */
+
+#include "stdafx_server.h"
+#include "pragma/networking/s_snapshot_baseline.hpp"
+#include <pragma/entities/baseentity.h>
+
+using namespace pragma::networking;
+
+uint8_t SnapshotBaseline::BeginSnapshot()
+{
+	return static_cast<uint8_t>(m_nextSequence++); // Overflow doesn't matter
+}
+
+void SnapshotBaseline::Acknowledge(uint8_t snapshotId,uint32_t receivedMask)
+{
+	if(m_nextSequence == 0)
+		return; // Nothing has been sent yet
+	// Map the 8-bit network id back to the most recent sequence id it could refer to
+	auto lastSequence = m_nextSequence -1;
+	auto age = static_cast<uint8_t>(static_cast<uint8_t>(lastSequence) -snapshotId);
+	if(age > lastSequence)
+		return;
+	auto seq = lastSequence -age;
+	AcknowledgeSequence(seq);
+	for(auto i=0u;i<32u && i < seq;++i)
+	{
+		if((receivedMask &(1u<<i)) != 0)
+			AcknowledgeSequence(seq -i -1);
+	}
+}
+void SnapshotBaseline::AcknowledgeSequence(SequenceId seq)
+{
+	if(m_nextSequence -1 -seq >= ACK_WINDOW)
+		return; // The slot belongs to a more recent snapshot by now
+	m_acknowledgedSequences[seq %ACK_WINDOW] = seq +1;
+	m_latestAcknowledgedSequence = umath::max(m_latestAcknowledgedSequence,seq +1);
+}
+
+void SnapshotBaseline::SetDeltaCompressionEnabled(bool enabled) {m_deltaCompressionEnabled = enabled;}
+bool SnapshotBaseline::IsDeltaCompressionEnabled() const {return m_deltaCompressionEnabled;}
+
+bool SnapshotBaseline::IsAcknowledged(SequenceId seq) const {return m_acknowledgedSequences[seq %ACK_WINDOW] == seq +1;}
+bool SnapshotBaseline::IsLost(SequenceId seq) const
+{
+	// The acknowledgement slot may have been re-used by a later snapshot, so we can't tell anymore
+	if(m_nextSequence -1 -seq >= ACK_WINDOW)
+		return true;
+	// Every acknowledgement covers the preceding snapshots as well, so the snapshot hasn't arrived if a later one has been acknowledged without it
+	return m_latestAcknowledgedSequence > seq +1;
+}
+bool SnapshotBaseline::IsFieldLost(EntityState &state,uint32_t fieldIdx) const
+{
+	// The acknowledgement is cached, since the slot of the sequence will eventually be re-used
+	auto fieldBit = static_cast<uint8_t>(1u<<fieldIdx);
+	if((state.acknowledgedFields &fieldBit) != 0)
+		return false;
+	auto seq = state.sentSequence[fieldIdx];
+	if(IsAcknowledged(seq))
+	{
+		state.acknowledgedFields |= fieldBit;
+		return false;
+	}
+	// The field is still in flight if neither applies
+	return IsLost(seq);
+}
+
+SnapshotBaseline::EntityState *SnapshotBaseline::FindEntityState(const BaseEntity &ent)
+{
+	return const_cast<EntityState*>(const_cast<const SnapshotBaseline*>(this)->FindEntityState(ent));
+}
+const SnapshotBaseline::EntityState *SnapshotBaseline::FindEntityState(const BaseEntity &ent) const
+{
+	auto idx = ent.GetIndex();
+	if(idx >= m_entityStates.size())
+		return nullptr;
+	auto &state = m_entityStates[idx];
+	if(state.valid == false || state.uuid != ent.GetUuid())
+		return nullptr; // Entity index has been re-used by a different entity
+	return &state;
+}
+
+bool SnapshotBaseline::RequiresUpdate(const BaseEntity &ent)
+{
+	if(IsEntityOutOfRange(ent))
+		return true;
+	auto *state = FindEntityState(ent);
+	if(state == nullptr)
+		return false;
+	auto lost = false;
+	for(auto i=decltype(state->sentSequence.size()){0u};i<state->sentSequence.size();++i)
+		lost = IsFieldLost(*state,i) || lost;
+	return lost;
+}
+
+void SnapshotBaseline::InvalidateEntity(const BaseEntity &ent)
+{
+	auto *state = FindEntityState(ent);
+	if(state != nullptr)
+		state->valid = false;
+}
+
+void SnapshotBaseline::SetEntityOutOfRange(const BaseEntity &ent,bool outOfRange)
+{
+	auto idx = ent.GetIndex();
+	if(outOfRange == false)
+	{
+		if(IsEntityOutOfRange(ent))
+			m_outOfRangeEntities[idx] = {};
+		return;
+	}
+	if(idx >= m_outOfRangeEntities.size())
+		m_outOfRangeEntities.resize(idx +1);
+	m_outOfRangeEntities[idx] = ent.GetUuid();
+}
+bool SnapshotBaseline::IsEntityOutOfRange(const BaseEntity &ent) const
+{
+	auto idx = ent.GetIndex();
+	return idx < m_outOfRangeEntities.size() && m_outOfRangeEntities[idx] == ent.GetUuid();
+}
+
+SnapshotEntityFieldFlags SnapshotBaseline::UpdateEntity(const BaseEntity &ent,const EntityFields &fields)
+{
+	auto idx = ent.GetIndex();
+	if(idx >= m_entityStates.size())
+		m_entityStates.resize(idx +1);
+	auto &state = m_entityStates[idx];
+	auto curSequence = m_nextSequence -1;
+	if(m_deltaCompressionEnabled == false || state.valid == false || state.uuid != ent.GetUuid())
+	{
+		state.uuid = ent.GetUuid();
+		state.fields = fields;
+		state.sentSequence.fill(curSequence);
+		state.acknowledgedFields = 0;
+		state.valid = true;
+		return SnapshotEntityFieldFlags::All;
+	}
+	auto flags = SnapshotEntityFieldFlags::None;
+	auto updateField = [this,&state,&flags,curSequence](uint32_t fieldIdx,bool changed) {
+		// Unchanged fields are only re-sent if the snapshot that carried their current value has been lost
+		if(changed == false && IsFieldLost(state,fieldIdx) == false)
+			return false;
+		state.sentSequence[fieldIdx] = curSequence;
+		state.acknowledgedFields &= ~static_cast<uint8_t>(1u<<fieldIdx);
+		flags |= static_cast<SnapshotEntityFieldFlags>(1u<<fieldIdx);
+		return true;
+	};
+	auto vecChanged = [](const Vector3 &a,const Vector3 &b) {
+		return umath::abs(a.x -b.x) > FIELD_EPSILON || umath::abs(a.y -b.y) > FIELD_EPSILON || umath::abs(a.z -b.z) > FIELD_EPSILON;
+	};
+	if(updateField(0,vecChanged(state.fields.position,fields.position)))
+		state.fields.position = fields.position;
+	if(updateField(1,vecChanged(state.fields.velocity,fields.velocity)))
+		state.fields.velocity = fields.velocity;
+	if(updateField(2,vecChanged(state.fields.angularVelocity,fields.angularVelocity)))
+		state.fields.angularVelocity = fields.angularVelocity;
+	auto &rotOld = state.fields.rotation;
+	auto &rotNew = fields.rotation;
+	auto rotChanged = umath::abs(rotOld.w -rotNew.w) > FIELD_EPSILON || umath::abs(rotOld.x -rotNew.x) > FIELD_EPSILON ||
+		umath::abs(rotOld.y -rotNew.y) > FIELD_EPSILON || umath::abs(rotOld.z -rotNew.z) > FIELD_EPSILON;
+	if(updateField(3,rotChanged))
+		state.fields.rotation = fields.rotation;
+	return flags;
+}
@@ -0,0 +1,101 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright (c) 2021 Silverlan */
+
+#ifndef __NAV_PATH_SERVICE_HPP__
+#define __NAV_PATH_SERVICE_HPP__
+
+#include "pragma/networkdefinitions.h"
+#include "pragma/ai/navsystem.h"
+#include <mathutil/uvec.h>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+
+class dtQueryFilter;
+namespace pragma::nav
+{
+	class PathService;
+	class DLLNETWORK PathRequest
+	{
+	public:
+		enum class State : uint8_t
+		{
+			Pending = 0u,
+			Complete,
+			Failed,
+			Cancelled
+		};
+		PathRequest(const Vector3 &start,const Vector3 &end);
+		State GetState() const;
+		// Returns true if the request is no longer pending
+		bool IsDone() const;
+		// Only valid if the state is State::Complete
+		const std::shared_ptr<RcPathResult> &GetResult() const;
+		const Vector3 &GetStart() const;
+		const Vector3 &GetEnd() const;
+		// The request will be skipped (or aborted if it is currently in progress) by the next update
+		void Cancel();
+	private:
+		friend PathService;
+		Vector3 m_start;
+		Vector3 m_end;
+		Vector3 m_startPoint {};
+		Vector3 m_endPoint {};
+		State m_state = State::Pending;
+		std::shared_ptr<RcPathResult> m_result = nullptr;
+	};
+
+	// Resolves path requests asynchronously using Detour's sliced pathfinding. Every update only processes
+	// as many search iterations as the budget allows, the remaining work is continued in the next update.
+	// Paths between polygon pairs that have been resolved recently are taken from a cache.
+	// Note: This class is not thread-safe and should only be used from the main thread.
+	class DLLNETWORK PathService
+	{
+	public:
+		static constexpr uint32_t DEFAULT_MAX_CACHE_SIZE = 512;
+		PathService(Mesh &mesh);
+		~PathService();
+		std::shared_ptr<PathRequest> RequestPath(const Vector3 &start,const Vector3 &end);
+		// Queues one request per start/end pair, in the same order as the pairs
+		void RequestPaths(const std::vector<std::pair<Vector3,Vector3>> &startEndPairs,std::vector<std::shared_ptr<PathRequest>> &outRequests);
+		void Update(uint32_t iterationBudget);
+
+		void SetMaxCacheSize(uint32_t size);
+		uint32_t GetMaxCacheSize() const;
+		void ClearCache();
+		uint32_t GetPendingRequestCount() const;
+	private:
+		struct CacheEntry
+		{
+			std::vector<uint32_t> path;
+			uint64_t lastUsed = 0;
+		};
+		static uint64_t GetCacheKey(uint32_t startRef,uint32_t endRef);
+		bool PrepareQuery();
+		void ReleaseQuery();
+		// Returns false if there are no more pending requests
+		bool StartNextRequest();
+		void FinalizeActiveRequest();
+		void CompleteRequest(PathRequest &request,const uint32_t *path,uint32_t pathCount);
+		void AddToCache(uint64_t key,const uint32_t *path,uint32_t pathCount);
+
+		Mesh &m_mesh;
+		std::deque<std::shared_ptr<PathRequest>> m_pendingRequests;
+		std::shared_ptr<PathRequest> m_activeRequest = nullptr;
+		uint64_t m_activeCacheKey = 0;
+		Mesh::QueryPtr m_query = nullptr;
+		// Detour keeps a pointer to the filter for the duration of the sliced search
+		std::unique_ptr<dtQueryFilter> m_filter;
+
+		std::unordered_map<uint64_t,CacheEntry> m_cache;
+		const dtNavMesh *m_cacheNavMesh = nullptr;
+		uint64_t m_cacheClock = 0;
+		uint32_t m_maxCacheSize = DEFAULT_MAX_CACHE_SIZE;
+	};
+};
+
+#endif
@@ -10,6 +10,7 @@
 #include "pragma/networkdefinitions.h"
 #include <udm_types.hpp>
 #include <mathutil/glmutil.h>
+#include <mutex>
 
 class Game;
 class rcContext;
@@ -107,10 +108,23 @@ namespace pragma
 			float sampleDetailMaxError = 1.f;
 			PartitionType partitionType = PartitionType::Watershed;
 		};
+		// Parameters used for path queries and ray casts on a navigation mesh
+		struct DLLNETWORK QueryConfig
+		{
+			// Search extents around the start and end positions when looking for the nearest polygon
+			Vector3 extents {256.f,256.f,256.f};
+			PolyFlags includeFlags = PolyFlags::All;
+			PolyFlags excludeFlags = PolyFlags::None;
+			// Maximum number of polygons in a path
+			uint32_t maxPathLength = 128;
+			// Maximum number of search nodes per query object
+			uint32_t maxNodes = 2048;
+		};
 		DLLNETWORK std::shared_ptr<RcNavMesh> generate(Game &game,const Config &config,std::string *err=nullptr);
 		DLLNETWORK std::shared_ptr<RcNavMesh> generate(Game &game,const Config &config,const BaseEntity &ent,std::string *err=nullptr);
 		DLLNETWORK std::shared_ptr<RcNavMesh> generate(Game &game,const Config &config,const std::vector<Vector3> &verts,const std::vector<int32_t> &indices,const std::vector<ConvexArea> *areas=nullptr,std::string *err=nullptr);
 		DLLNETWORK std::shared_ptr<RcNavMesh> load(Game &game,const std::string &fname,Config &outConfig);
+		class PathService;
 		class DLLNETWORK Mesh
 		{
 		public:
@@ -121,12 +135,21 @@ namespace pragma
 			static std::shared_ptr<Mesh> Create(const std::shared_ptr<RcNavMesh> &rcMesh,const Config &config);
 			static std::shared_ptr<Mesh> Load(Game &game,const std::string &fname);
 
+			~Mesh();
+			// Note: The query methods are thread-safe, as long as the query configuration isn't changed at the same time
 			std::shared_ptr<RcPathResult> FindPath(const Vector3 &start,const Vector3 &end);
+			// Resolves multiple paths in parallel on the engine job system. The results are in the same order as the queries and may contain nullptr for paths that couldn't be found.
+			// Must not be called from multiple threads at the same time.
+			void FindPaths(const std::vector<std::pair<Vector3,Vector3>> &startEndPairs,std::vector<std::shared_ptr<RcPathResult>> &outResults);
 			bool RayCast(const Vector3 &start,const Vector3 &end,Vector3 &hit);
 			bool Save(Game &game,udm::AssetDataArg outData,std::string &outErr);
 			bool Save(Game &game,const std::string &fileName,std::string &outErr);
 
 			const Config &GetConfig() const;
+			void SetQueryConfig(const QueryConfig &queryConfig);
+			const QueryConfig &GetQueryConfig() const;
+			// Service for asynchronous path requests, see Game::Tick
+			PathService &GetPathService();
 
 			const std::shared_ptr<RcNavMesh> &GetRcNavMesh() const;
 			std::shared_ptr<RcNavMesh> &GetRcNavMesh();
@@ -137,8 +160,26 @@ namespace pragma
 			bool LoadFromAssetData(Game &game,const udm::AssetData &data,std::string &outErr);
 			bool FindNearestPoly(const Vector3 &pos,dtPolyRef &ref);
 		private:
+			friend PathService;
+			struct QueryDeleter {void operator()(dtNavMeshQuery *query) const;};
+			using QueryPtr = std::unique_ptr<dtNavMeshQuery,QueryDeleter>;
+			// Query objects are expensive to initialize (they allocate a node pool), so they're pooled and re-used
+			QueryPtr AcquireQuery();
+			void ReleaseQuery(QueryPtr query);
+			void ClearQueryPool();
+			bool FindNearestPoly(dtNavMeshQuery &query,const Vector3 &pos,dtPolyRef &ref,Vector3 *optOutNearestPoint=nullptr) const;
+			std::shared_ptr<RcPathResult> FindPath(dtNavMeshQuery &query,const Vector3 &start,const Vector3 &end);
+			std::shared_ptr<dtNavMeshQuery> GetPathResultQuery();
+
 			std::shared_ptr<RcNavMesh> m_rcMesh;
 			Config m_config = {};
+			QueryConfig m_queryConfig = {};
+
+			std::mutex m_queryPoolMutex;
+			std::vector<QueryPtr> m_queryPool;
+			// Only used by RcPathResult::GetNode, which doesn't require a node pool
+			std::shared_ptr<dtNavMeshQuery> m_pathResultQuery = nullptr;
+			std::unique_ptr<PathService> m_pathService = nullptr;
 		};
 	};
 };
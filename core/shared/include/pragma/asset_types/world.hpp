@@ -146,7 +146,7 @@ namespace pragma::asset
 		void WriteEntities(VFilePtrReal &f);
 
 		std::vector<msys::MaterialHandle> ReadMaterials(VFilePtr &f);
-		void ReadBSPTree(VFilePtr &f,uint32_t version);
+		bool ReadBSPTree(VFilePtr &f,uint32_t version,std::string *errMsg);
 		void ReadEntities(VFilePtr &f,const std::vector<msys::MaterialHandle> &materials,EntityData::Flags entMask);
 
 		NetworkState &m_nw;
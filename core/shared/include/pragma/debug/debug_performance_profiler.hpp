@@ -46,6 +46,12 @@ namespace pragma
 		{
 		public:
 			using StageId = uint32_t;
+			using CounterId = uint32_t;
+			struct Counter
+			{
+				std::string name;
+				uint64_t value = 0;
+			};
 			template<class TProfilingStage>
 				static std::shared_ptr<TProfilingStage> Create(Profiler &profiler,const std::string &name,TProfilingStage *parent=nullptr);
 			static std::shared_ptr<ProfilingStage> Create(Profiler &profiler,const std::string &name,ProfilingStage *parent=nullptr);
@@ -65,6 +71,11 @@ namespace pragma
 			const std::vector<std::weak_ptr<ProfilingStage>> &GetChildren() const;
 			const Timer &GetTimer() const;
 			Timer &GetTimer();
+
+			// Counters can be used to record arbitrary per-frame values (e.g. number of processed objects) alongside the timings
+			CounterId AddCounter(const std::string &name);
+			void SetCounterValue(CounterId id,uint64_t value);
+			const std::vector<Counter> &GetCounters() const;
 		protected:
 			ProfilingStage(Profiler &profiler,const std::string &name);
 			virtual void InitializeTimer();
@@ -73,6 +84,7 @@ namespace pragma
 			Profiler &m_profiler;
 			std::weak_ptr<ProfilingStage> m_parent = {};
 			std::vector<std::weak_ptr<ProfilingStage>> m_children = {};
+			std::vector<Counter> m_counters = {};
 			StageId m_stage;
 			std::string m_name;
 		};
@@ -21,6 +21,7 @@
 #include "pragma/types.hpp"
 #include <materialmanager.h>
 #include <thread>
+#include <chrono>
 #include <atomic>
 #include <mutex>
 #include <sharedutils/callback_handler.h>
@@ -45,11 +46,13 @@ namespace Con {enum class MessageFlags : uint8_t;};
 namespace upad {class PackageManager;};
 namespace util {class ParallelJobWrapper; class FileAssetManager;};
 namespace pragma::asset {class AssetManager;};
+namespace pragma {class JobSystem;};
 class DLLNETWORK Engine
 	: public CVarHandler,public CallbackHandler
 {
 public:
 	static const uint32_t DEFAULT_TICK_RATE;
+	static constexpr uint32_t DEFAULT_JOB_SYSTEM_WORKER_COUNT = 4;
 // For internal use only! Not to be used directly!
 private:
 	// Note: m_libServer needs to be the first member, to ensure it's destroyed last!
@@ -237,9 +240,15 @@ public:
 	void UnlockResourceWatchers();
 	util::ScopeGuard ScopeLockResourceWatchers();
 	void PollResourceWatchers();
+	// Time budget for asset and Lua script hot-reloads (sh_asset_reload_budget), shared by all resource and script watchers.
+	// It is reset at the beginning of every frame.
+	std::chrono::microseconds GetAssetReloadBudget() const;
+	void ConsumeAssetReloadBudget(std::chrono::microseconds t);
 
 	pragma::asset::AssetManager &GetAssetManager();
 	const pragma::asset::AssetManager &GetAssetManager() const;
+	// General-purpose job system, which can be used by both the client and the server
+	pragma::JobSystem &GetJobSystem();
 
 	// For internal use only
 	void SetReplicatedConVar(const std::string &cvar,const std::string &val);
@@ -286,6 +295,8 @@ protected:
 	uint64_t m_tickCount = 0;
 	std::shared_ptr<VFilePtrInternalReal> m_logFile;
 	std::unique_ptr<pragma::asset::AssetManager> m_assetManager = nullptr;
+	std::unique_ptr<pragma::JobSystem> m_jobSystem = nullptr;
+	std::chrono::microseconds m_assetReloadBudget {0};
 
 	struct JobInfo
 	{
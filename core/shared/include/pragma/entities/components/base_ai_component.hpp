@@ -9,6 +9,7 @@
 
 #include "pragma/entities/components/base_entity_component.hpp"
 #include "pragma/ai/navsystem.h"
+#include "pragma/ai/nav_path_service.hpp"
 #include "pragma/model/animation/activities.h"
 #include <pragma/math/orientation.h>
 #include <atomic>
@@ -28,25 +29,6 @@ namespace pragma
 				std::array<std::unique_ptr<Vector3>,2> splineNodes; // Antepenult and penultimate
 				uint32_t pathIdx;
 			};
-			struct PathQuery
-			{
-				PathQuery(const Vector3 &start,const Vector3 &end);
-				std::atomic<bool> complete;
-				std::shared_ptr<PathInfo> pathInfo;
-				Vector3 start;
-				Vector3 end;
-				util::WeakHandle<BaseAIComponent> npc = {};
-			};
-			struct NavThread
-			{
-				std::thread thread;
-				std::atomic<bool> running = true;
-				CallbackHandle releaseCallback = {};
-				std::queue<std::shared_ptr<PathQuery>> queryQueue {};
-
-				std::mutex pendingQueueMutex = {};
-				std::queue<std::shared_ptr<PathQuery>> pendingQueue {};
-			};
 		};
 	};
 
@@ -71,8 +53,6 @@ namespace pragma
 			FaceTarget = TurnSpeed<<1u
 		};
 		static const char *MoveResultToString(MoveResult result);
-		static void ReloadNavThread(Game &game);
-		static void ReleaseNavThread();
 		struct DLLNETWORK MoveInfo
 		{
 			MoveInfo() {}
@@ -117,7 +97,6 @@ namespace pragma
 		virtual void OnModelChanged(const std::shared_ptr<Model> &model);
 		virtual void OnEntityComponentAdded(BaseEntityComponent &component) override;
 		static std::atomic<uint32_t> s_npcCount;
-		static std::shared_ptr<ai::navigation::NavThread> s_navThread;
 		//
 	protected:
 		BaseAIComponent(BaseEntity &ent);
@@ -133,7 +112,7 @@ namespace pragma
 	
 		// Navigation Path
 		struct {
-			std::shared_ptr<ai::navigation::PathQuery> queuedPath;
+			std::shared_ptr<nav::PathRequest> queuedPath;
 			std::shared_ptr<ai::navigation::PathInfo> pathInfo;
 			Vector3 pathTarget;
 			bool bPathUpdateRequired = false;
@@ -12,6 +12,7 @@
 #include "pragma/model/animation/play_animation_flags.hpp"
 #include "pragma/model/animation/activities.h"
 #include "pragma/model/animation/animation_event.h"
+#include "pragma/model/animation/pose_blend.hpp"
 #include <sharedutils/property/util_property.hpp>
 #include <pragma/math/orientation.h>
 #include <mathutil/transform.hpp>
@@ -61,7 +62,9 @@ namespace pragma
 		{
 			None = 0u,
 			AbsolutePosesDirty = 1u,
-			BaseAnimationDirty = AbsolutePosesDirty<<1u
+			BaseAnimationDirty = AbsolutePosesDirty<<1u,
+			DeferPoseEvaluation = BaseAnimationDirty<<1u,
+			AnimationsHandledByEvent = DeferPoseEvaluation<<1u
 		};
 
 		struct DLLNETWORK AnimationSlotInfo
@@ -231,6 +234,15 @@ namespace pragma
 		virtual bool MaintainAnimations(double dt);
 		void UpdateAnimations(double dt);
 		bool MaintainGestures(double dt);
+
+		// UpdateAnimations split into three stages, which allows the pose evaluation of multiple entities to run in parallel (see Game::UpdateEntityAnimations).
+		// PrepareAnimationUpdate advances the animation cycles and invokes all events that may be handled by Lua (main thread only),
+		// EvaluateAnimationPoses blends the bone poses and may be called from any thread, as long as no other thread accesses this component,
+		// FinalizeAnimationUpdate applies the poses to the skeleton and dispatches the animation events (main thread only).
+		// If PrepareAnimationUpdate returns false, the other two stages must not be called.
+		bool PrepareAnimationUpdate(double dt);
+		void EvaluateAnimationPoses();
+		virtual void FinalizeAnimationUpdate();
 		
 		virtual bool GetVertexTransformMatrix(const ModelSubMesh &subMesh,uint32_t vertexId,umath::ScaledTransform &outPose) const;
 		virtual std::optional<Mat4> GetVertexTransformMatrix(const ModelSubMesh &subMesh,uint32_t vertexId) const;
@@ -290,7 +302,24 @@ namespace pragma
 		};
 		//
 
+		// Pose evaluation that has been scheduled by MaintainAnimation
+		struct PendingPoseEvaluation
+		{
+			std::shared_ptr<pragma::animation::Animation> animation = nullptr;
+			int32_t animId = -1;
+			int32_t layeredSlot = -1;
+			double dt = 0.0;
+			float cycle = 0.f;
+			float cycleLast = 0.f;
+			bool evaluated = false;
+		};
 		bool MaintainAnimation(AnimationSlotInfo &animInfo,double dt,int32_t layeredSlot=-1);
+		AnimationSlotInfo *FindAnimationSlotInfo(int32_t layeredSlot);
+		bool EvaluateAnimationPose(const PendingPoseEvaluation &pending);
+		void FinalizeAnimationPose(const PendingPoseEvaluation &pending);
+		// Returns true if the gesture has been completed and the slot can be removed
+		bool ApplyGesture(AnimationSlotInfo &animInfo);
+		bool ApplyAnimationPoses();
 		virtual void ApplyAnimationBlending(AnimationSlotInfo &animInfo,double tDelta);
 		void HandleAnimationEvent(const AnimationEvent &ev);
 		void PlayLayeredAnimation(int slot,int animation,FPlayAnim flags,AnimationSlotInfo **animInfo);
@@ -317,6 +346,19 @@ namespace pragma
 		// We have to collect the animation events for the current frame and execute them after ALL animations have been completed (In case some events need to access animation data)
 		std::queue<AnimationEventQueueItem> m_animEventQueue = std::queue<AnimationEventQueueItem>{};
 
+		// Pose evaluations scheduled by PrepareAnimationUpdate
+		std::vector<PendingPoseEvaluation> m_pendingPoseEvaluations;
+
+		// Persistent scratch buffers for MaintainAnimation
+		struct PoseBlendScratch
+		{
+			pragma::animation::PoseBuffer frameSrc;
+			pragma::animation::PoseBuffer frameDst;
+			pragma::animation::PoseBuffer bcSrc;
+			pragma::animation::PoseBuffer bcDst;
+			pragma::animation::PoseBuffer result;
+		} m_poseBlendScratch;
+
 		// Custom animation events
 		void ApplyAnimationEventTemplate(const TemplateAnimationEvent &t);
 		void ApplyAnimationEventTemplates();
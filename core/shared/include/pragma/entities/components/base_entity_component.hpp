@@ -49,6 +49,7 @@ namespace pragma
 	struct ComponentEvent;
 	class BaseEntityComponentSystem;
 	class EntityComponentManager;
+	class EntityTickScheduler;
 	struct ComponentMemberInfo;
 	using ComponentMemberIndex = uint32_t;
 
@@ -58,11 +59,27 @@ namespace pragma
 		WhenVisible, // Not yet implemented!
 		Always
 	};
+	// Components in a tick group other than Main are ticked on worker threads, in parallel with the components of other
+	// entities in the same group. Components of the same entity within a group are always ticked sequentially on the same thread.
+	// OnTick of such components must only read or modify the state of their own entity and must not create or remove
+	// entities or components, or change the tick state of other components. Lua components always tick on the main thread.
+	enum class TickGroup : uint8_t
+	{
+		Main = 0u,
+		Ai, // Ticked after all Main components
+		Late, // Ticked after all Ai components
+
+		Count
+	};
 	struct DLLNETWORK TickData
 	{
 		TickPolicy tickPolicy = TickPolicy::Never;
+		TickGroup tickGroup = TickGroup::Main;
 		double lastTick = 0.0;
 		double nextTick = 0.0;
+		// Used by EntityTickScheduler
+		uint32_t schedulerIndex = 0;
+		uint8_t schedulerState = 0;
 	};
 
 	class DLLNETWORK BaseEntityComponent
@@ -190,6 +207,9 @@ namespace pragma
 		// Tick updates
 		void SetTickPolicy(TickPolicy policy);
 		TickPolicy GetTickPolicy() const;
+		// Only for C++ components with a thread-safe OnTick implementation, see TickGroup
+		void SetTickGroup(TickGroup group);
+		TickGroup GetTickGroup() const;
 		bool ShouldThink() const;
 		double LastTick() const;
 		double GetNextTick() const;
@@ -215,6 +235,11 @@ namespace pragma
 		BaseEntityComponent(BaseEntity &ent);
 		void UpdateTickPolicy();
 		virtual util::EventReply HandleEvent(ComponentEventId eventId,ComponentEvent &evData);
+		// std::true_type if TComponent doesn't override HandleEvent (Overrides aren't accessible from here, which also results in std::false_type)
+		template<class TComponent>
+			static constexpr auto UsesDefaultEventHandler(int) -> std::is_same<decltype(&TComponent::HandleEvent),util::EventReply(BaseEntityComponent::*)(ComponentEventId,ComponentEvent&)> {return {};}
+		template<class TComponent>
+			static constexpr std::false_type UsesDefaultEventHandler(...) {return {};}
 		virtual void Load(udm::LinkedPropertyWrapperArg udm,uint32_t version);
 		virtual std::optional<ComponentMemberIndex> DoGetMemberIndex(const std::string &name) const;
 		virtual void OnMembersChanged();
@@ -249,6 +274,7 @@ namespace pragma
 		TickData m_tickData {};
 	private:
 		friend BaseEntityComponentSystem;
+		friend EntityTickScheduler;
 	};
 };
 REGISTER_BASIC_BITWISE_OPERATORS(pragma::BaseEntityComponent::StateFlags)
@@ -203,7 +203,11 @@ namespace pragma
 		// in the past.
 		MakeNetworked = Networked<<1u,
 
-		LuaBased = MakeNetworked<<1u
+		LuaBased = MakeNetworked<<1u,
+
+		// Component doesn't override BaseEntityComponent::HandleEvent, so broadcasted events
+		// only have to be dispatched to it if it has bound a callback to them.
+		DefaultEventHandler = LuaBased<<1u
 	};
 	class DLLNETWORK BaseNetComponent
 	{
@@ -344,6 +348,8 @@ template<class TComponent,typename>
 	auto flags = ComponentFlags::None;
 	if(std::is_base_of<pragma::BaseNetComponent,TComponent>::value)
 		flags |= ComponentFlags::Networked;
+	if(decltype(TComponent::template UsesDefaultEventHandler<TComponent>(0))::value)
+		flags |= ComponentFlags::DefaultEventHandler;
 	auto componentId = PreRegisterComponentType(name);
 	TComponent::RegisterEvents(*this,[this,componentId](const std::string &evName,EventInfo::Type type) {
 		auto id = RegisterEvent<TComponent>(evName,type);
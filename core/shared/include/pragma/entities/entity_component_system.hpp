@@ -62,6 +62,8 @@ namespace pragma
 		// For internal use only
 		EntityComponentManager *GetComponentManager();
 		const EntityComponentManager *GetComponentManager() const;
+		// For internal use only; Has to be called whenever one of the components starts listening to an event id it wasn't listening to before
+		void InvalidateEventSubscriptions();
 	protected:
 		BaseEntityComponentSystem()=default;
 
@@ -69,6 +71,23 @@ namespace pragma
 		virtual void OnComponentAdded(BaseEntityComponent &component);
 		virtual void OnComponentRemoved(BaseEntityComponent &component);
 	private:
+		// Components which have to receive an event, in the order they were added to the entity
+		struct EventSubscribers
+		{
+			uint32_t epoch = 0;
+			std::vector<BaseEntityComponent*> components;
+		};
+		const std::vector<BaseEntityComponent*> &GetEventSubscribers(ComponentEventId ev) const;
+		void EndEventDispatch() const;
+
+		// Subscriber lists are built on demand and rebuilt whenever the epoch has changed since they were built.
+		// Components removed during a broadcast (and subscriber lists which were replaced) are kept alive until the outermost broadcast has ended.
+		mutable std::unordered_map<ComponentEventId,EventSubscribers> m_eventSubscribers;
+		mutable std::vector<std::vector<BaseEntityComponent*>> m_retiredEventSubscribers;
+		mutable std::vector<util::TSharedHandle<BaseEntityComponent>> m_deferredComponentReleases;
+		mutable uint32_t m_eventDispatchDepth = 0;
+		uint32_t m_eventSubscriptionEpoch = 1;
+
 		std::unordered_map<ComponentId,ComponentHandle<BaseEntityComponent>> m_componentLookupTable; // Only contains one (the first) component per type; Used for fast lookups
 		std::vector<util::TSharedHandle<BaseEntityComponent>> m_components;
 		EntityComponentManager *m_componentManager;
@@ -0,0 +1,100 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright (c) 2021 Silverlan */
+
+#ifndef __ENTITY_TICK_SCHEDULER_HPP__
+#define __ENTITY_TICK_SCHEDULER_HPP__
+
+#include "pragma/networkdefinitions.h"
+#include <vector>
+#include <cinttypes>
+
+namespace pragma
+{
+	class BaseEntityComponent;
+	enum class TickGroup : uint8_t;
+	// Keeps track of all components that require logic ticks. Components whose next tick lies in the future
+	// are moved into a min-heap keyed on their next tick time and aren't visited again until they're due,
+	// so sleeping components have no per-tick cost. Removal is O(1) (swap-remove).
+	// Components in the Main tick group are ticked serially on the main thread, all other tick groups
+	// are ticked afterwards (in order) on the engine job system, see TickGroup.
+	class DLLNETWORK EntityTickScheduler
+	{
+	public:
+		struct Stats
+		{
+			uint32_t numTicked = 0;
+			uint32_t numSkipped = 0;
+		};
+		EntityTickScheduler();
+		EntityTickScheduler(const EntityTickScheduler&)=delete;
+		EntityTickScheduler &operator=(const EntityTickScheduler&)=delete;
+
+		void Register(BaseEntityComponent &component);
+		void Unregister(BaseEntityComponent &component);
+		// Has to be called if the next tick time of a registered component has changed
+		void Wake(BaseEntityComponent &component);
+		bool IsRegistered(const BaseEntityComponent &component) const;
+
+		void Tick(double tCur,double tDelta);
+		void Clear();
+
+		// If disabled (or if the engine job system has no workers), all groups are ticked on the main thread
+		void SetMultithreaded(bool multithreaded);
+		// If enabled, parallel tick groups are ticked on the main thread in a fixed order (by entity index and component id),
+		// which makes it possible to reproduce bugs that depend on the execution order
+		void SetDeterministic(bool deterministic);
+
+		uint32_t GetComponentCount() const;
+		// Statistics for the last call to Tick
+		const Stats &GetStats() const;
+	private:
+		enum class SlotState : uint8_t
+		{
+			None = 0,
+			Active,
+			Sleeping
+		};
+		struct SleepSlot
+		{
+			BaseEntityComponent *component = nullptr;
+			// Incremented whenever the slot is released, which invalidates all heap entries referring to it
+			uint32_t generation = 0;
+		};
+		struct SleepEntry
+		{
+			double nextTick = 0.0;
+			uint32_t slot = 0;
+			uint32_t generation = 0;
+		};
+		static bool CompareSleepEntries(const SleepEntry &a,const SleepEntry &b);
+		bool IsSleepEntryValid(const SleepEntry &entry) const;
+		void PushActive(BaseEntityComponent &component);
+		void EraseActive(uint32_t idx);
+		void Sleep(uint32_t idx);
+		void ReleaseSleepSlot(uint32_t slot);
+		void WakeDueComponents(double tCur);
+		void CompactSleepHeap();
+		void TickParallelGroup(std::vector<BaseEntityComponent*> &components,double tDelta);
+
+		// Active components; Removed components are set to nullptr while Tick is running
+		std::vector<BaseEntityComponent*> m_active;
+		std::vector<SleepSlot> m_sleepSlots;
+		std::vector<uint32_t> m_freeSleepSlots;
+		std::vector<SleepEntry> m_sleepHeap;
+		uint32_t m_sleepingCount = 0;
+		bool m_ticking = false;
+
+		// Due components for each parallel tick group (indexed by TickGroup)
+		std::vector<std::vector<BaseEntityComponent*>> m_groupComponents;
+		std::vector<std::pair<uint32_t,uint32_t>> m_groupEntityRanges;
+		std::vector<uint8_t> m_groupResults;
+		bool m_multithreaded = true;
+		bool m_deterministic = false;
+		Stats m_stats {};
+	};
+};
+
+#endif
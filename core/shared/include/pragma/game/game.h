@@ -20,6 +20,7 @@
 #include "pragma/lua/lua_callback_handler.h"
 #include <sharedutils/chronotime.h>
 #include "pragma/util/timertypes.h"
+#include "pragma/lua/libraries/ltimer.h"
 #include <fsys/vfileptr.h>
 #include "pragma/lua/sh_lua_entity_manager.h"
 #include "pragma/util/ammo_type.h"
@@ -30,6 +31,7 @@
 #include <sharedutils/util_shared_handle.hpp>
 #include <pragma/console/fcvar.h>
 #include <pragma/debug/debug_performance_profiler.hpp>
+#include "pragma/entities/entity_tick_scheduler.hpp"
 #ifdef __linux__
 #include "pragma/lua/lua_script_watcher.h"
 #include "pragma/physics/environment.hpp"
@@ -54,6 +56,7 @@ class CvarCallback;
 class NetworkState;
 class ConConf;
 struct TraceResult;
+struct TraceQuery;
 class BaseEntity;
 class WVPxEventCallback;
 class PhysObj;
@@ -71,12 +74,14 @@ struct GameModeInfo;
 struct Color;
 class GibletCreateInfo;
 enum class RayCastFlags : uint32_t;
+enum class TraceType : uint8_t;
 namespace pragma
 {
 	using ComponentId = uint32_t;
 	class BaseWorldComponent;
 	class BaseEntityComponent;
 	class BasePhysicsComponent;
+	class BaseAnimatedComponent;
 	class EntityComponentManager;
 	class BasePlayerComponent;
 	class BaseGamemodeComponent;
@@ -187,6 +192,8 @@ public:
 	TraceResult Overlap(const TraceData &data) const;
 	TraceResult RayCast(const TraceData &data) const;
 	TraceResult Sweep(const TraceData &data) const;
+	// See pragma::physics::IEnvironment::BatchTrace
+	uint32_t BatchTrace(TraceType type,const TraceData &data,const TraceQuery *queries,uint32_t numQueries,TraceResult *outResults,bool resolveMeshes=false) const;
 
 	virtual void CreateGiblet(const GibletCreateInfo &info)=0;
 
@@ -323,6 +330,7 @@ public:
 	Timer *CreateTimer(float delay,int reps,LuaFunctionObject luaFunction,TimerType timeType=TimerType::CurTime);
 	Timer *CreateTimer(float delay,int reps,const CallbackHandle &hCallback,TimerType timeType=TimerType::CurTime);
 	void ClearTimers();
+	TimerManager &GetTimerManager();
 	// ConVars
 	template<class T>
 		T *GetConVar(const std::string &scmd);
@@ -344,7 +352,7 @@ public:
 	virtual bool IsPhysicsSimulationEnabled() const=0;
 
 	std::vector<pragma::ComponentHandle<pragma::BasePhysicsComponent>> &GetAwakePhysicsComponents();
-	std::vector<pragma::BaseEntityComponent*> &GetEntityTickComponents() {return m_entityTickComponents;}
+	pragma::EntityTickScheduler &GetEntityTickScheduler() {return m_entityTickScheduler;}
 	std::vector<pragma::BaseGamemodeComponent*> &GetGamemodeComponents() {return m_gamemodeComponents;}
 
 	void UpdateEntityAnimations(double dt);
@@ -365,17 +373,19 @@ protected:
 	pragma::ComponentId m_animatedComponentId = std::numeric_limits<pragma::ComponentId>::max();
 	pragma::ComponentId m_animated2ComponentId = std::numeric_limits<pragma::ComponentId>::max();
 	pragma::ComponentId m_animationDriverComponentId = std::numeric_limits<pragma::ComponentId>::max();
+	// Buffer for the animated components whose poses are evaluated in parallel during UpdateEntityAnimations
+	std::vector<pragma::ComponentHandle<pragma::BaseAnimatedComponent>> m_animationUpdateComponents;
 	std::vector<BaseEntity*> m_baseEnts;
 	std::queue<EntityHandle> m_entsScheduledForRemoval;
 	std::vector<pragma::ComponentHandle<pragma::BasePhysicsComponent>> m_awakePhysicsEntities;
-	std::vector<pragma::BaseEntityComponent*> m_entityTickComponents;
+	pragma::EntityTickScheduler m_entityTickScheduler;
 	std::vector<pragma::BaseGamemodeComponent*> m_gamemodeComponents;
 	std::shared_ptr<Lua::Interface> m_lua = nullptr;
 	std::unique_ptr<pragma::lua::ClassManager> m_luaClassManager = nullptr;
 	std::unique_ptr<LuaDirectoryWatcherManager> m_scriptWatcher = nullptr;
 	std::unique_ptr<SurfaceMaterialManager> m_surfaceMaterialManager = nullptr;
 	std::unordered_map<std::string,std::vector<std::shared_ptr<CvarCallback>>> m_cvarCallbacks;
-	std::vector<std::unique_ptr<Timer>> m_timers;
+	TimerManager m_timerManager;
 	std::unordered_map<std::string,int> m_luaNetMessages;
 	std::vector<std::string> m_luaNetMessageIndex;
 	MapInfo m_mapInfo = {};
@@ -404,6 +414,8 @@ protected:
 	EntityHandle m_entGame;
 	CallbackHandle m_cbProfilingHandle = {};
 	std::unique_ptr<pragma::debug::ProfilingStageManager<pragma::debug::ProfilingStage,CPUProfilingPhase>> m_profilingStageManager = nullptr;
+	pragma::debug::ProfilingStage::CounterId m_counterComponentsTicked = 0;
+	pragma::debug::ProfilingStage::CounterId m_counterComponentsSkipped = 0;
 	std::shared_ptr<pragma::nav::Mesh> m_navMesh = nullptr;
 	std::unique_ptr<AmmoTypeManager> m_ammoTypes = nullptr;
 	std::unique_ptr<LuaEntityManager> m_luaEnts = nullptr;
@@ -8,6 +8,6 @@
 #define __LEVEL_INFO_HPP__
 
 // TODO: Move this somewhere else
-#define WLD_VERSION 12
+#define WLD_VERSION 13
 
 #endif
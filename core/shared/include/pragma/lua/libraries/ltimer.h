@@ -8,6 +8,7 @@
 #define __LTIMER_H__
 #include "pragma/networkdefinitions.h"
 #include <sharedutils/functioncallback.h>
+#include <array>
 
 class TimerHandle;
 namespace Lua
@@ -25,6 +26,7 @@ namespace Lua
 
 class Game;
 class TimerHandle;
+class TimerManager;
 class DLLNETWORK Timer
 {
 private:
@@ -39,8 +41,16 @@ private:
 	bool m_bIsValid;
 	std::vector<std::shared_ptr<TimerHandle>> m_handles;
 
-	double GetCurTime(Game *game);
-	double GetDeltaTime(Game *game);
+	// Scheduling state, see TimerManager
+	TimerManager *m_manager = nullptr;
+	uint32_t m_slot = 0;
+	uint32_t m_scheduleId = 0;
+	double m_expiry = 0.0;
+
+	float GetRemainingTime() const;
+	void ScheduleExpiry();
+	void CancelExpiry();
+	friend TimerManager;
 protected:
 	float m_next;
 	virtual void Reset();
@@ -49,6 +59,7 @@ public:
 	Timer(float delay,unsigned int reps,LuaFunctionObject luaFunction,TimerType timetype=TimerType::CurTime);
 	Timer(float delay,unsigned int reps,const CallbackHandle &hCallback,TimerType timetype=TimerType::CurTime);
 	~Timer();
+	// Called by the TimerManager once the timer has expired
 	void Update(Game *game);
 	void Start(Game *game);
 	void Pause();
@@ -70,6 +81,59 @@ public:
 	void Call(Game *game);
 };
 
+// Owns all timers of a game. Running timers are kept in a min-heap (one per timer type) keyed on their expiry time,
+// so an update only has to touch the timers that actually fire. Pausing, stopping or removing a timer is O(1), the
+// respective heap entry is invalidated and discarded lazily.
+class DLLNETWORK TimerManager
+{
+public:
+	TimerManager()=default;
+	~TimerManager();
+	TimerManager(const TimerManager&)=delete;
+	TimerManager &operator=(const TimerManager&)=delete;
+	Timer *CreateTimer(float delay,int reps,LuaFunctionObject luaFunction,TimerType timeType=TimerType::CurTime);
+	Timer *CreateTimer(float delay,int reps,const CallbackHandle &hCallback,TimerType timeType=TimerType::CurTime);
+	// Advances the clock for all timers of the specified type
+	void Advance(TimerType type,double dt);
+	// Calls all timers that have expired. Each timer is called at most once per update.
+	void Update(Game *game);
+	void Clear();
+
+	double GetTime(TimerType type) const;
+	uint32_t GetTimerCount() const;
+private:
+	friend Timer;
+	static constexpr uint32_t TIMER_TYPE_COUNT = 3;
+	struct Slot
+	{
+		std::unique_ptr<Timer> timer = nullptr;
+		// Incremented whenever the timer in this slot is destroyed, which invalidates all heap entries referring to it
+		uint32_t generation = 0;
+	};
+	struct ScheduleEntry
+	{
+		double expiry = 0.0;
+		uint32_t slot = 0;
+		uint32_t generation = 0;
+		uint32_t scheduleId = 0;
+	};
+	static bool CompareEntries(const ScheduleEntry &a,const ScheduleEntry &b);
+	Timer *AddTimer(std::unique_ptr<Timer> timer);
+	void Schedule(Timer &timer);
+	void ScheduleRemoval(Timer &timer);
+	bool IsEntryValid(const ScheduleEntry &entry) const;
+	void CompactQueues();
+
+	std::array<double,TIMER_TYPE_COUNT> m_clocks {};
+	std::array<std::vector<ScheduleEntry>,TIMER_TYPE_COUNT> m_queues {};
+	std::vector<ScheduleEntry> m_dueTimers;
+	std::vector<Slot> m_slots;
+	std::vector<uint32_t> m_freeSlots;
+	std::vector<uint32_t> m_pendingRemoval;
+	uint32_t m_timerCount = 0;
+	bool m_updating = false;
+};
+
 #include "pragma/util/timer_handle.h"
 
 DLLNETWORK void Lua_Timer_Start(lua_State *l,TimerHandle &timer);
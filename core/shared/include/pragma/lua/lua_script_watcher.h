@@ -9,6 +9,7 @@
 #define __LUA_SCRIPT_WATCHER_H__
 
 #include "pragma/networkdefinitions.h"
+#include "pragma/util/asset_reload_scheduler.hpp"
 #include <fsys/directory_watcher.h>
 
 class DLLNETWORK LuaDirectoryWatcherManager
@@ -17,6 +18,8 @@ private:
 	std::unordered_map<std::string,std::function<void()>> m_watchFiles;
 	std::vector<std::shared_ptr<DirectoryWatcherCallback>> m_watchers;
 	Game *m_game;
+	// Scripts are reloaded within a time budget per frame
+	pragma::AssetReloadScheduler m_reloadScheduler;
 protected:
 	virtual void OnLuaFileChanged(const std::string &path);
 	bool IsLuaFile(const std::string &path,bool bAllowCompiled=false) const;
@@ -24,6 +27,7 @@ public:
 	LuaDirectoryWatcherManager(Game *game);
 	bool MountDirectory(const std::string &path,bool bAbsolutePath=false);
 	void Poll();
+	const pragma::AssetReloadScheduler &GetReloadScheduler() const;
 };
 
 #endif
@@ -51,12 +51,24 @@ namespace Intersection
 		// Only for precise results
 		std::shared_ptr<Precise> precise = nullptr;
 	};
+	struct DLLNETWORK Line
+	{
+		Vector3 start;
+		Vector3 dir;
+	};
+	// Hits within the line are preferred over hits beyond its end, closer hits are preferred over hits further away.
+	// If precise is false, the search stops at the first hit within the line.
 	DLLNETWORK bool LineMesh(const Vector3 &start,const Vector3 &dir,ModelMesh &mesh,LineMeshResult &outResult,bool precise=false,const Vector3 *origin=nullptr,const Quat *rot=nullptr);
 	DLLNETWORK bool LineMesh(const Vector3 &start,const Vector3 &dir,ModelSubMesh &subMesh,LineMeshResult &outResult,bool precise=false,const Vector3 *origin=nullptr,const Quat *rot=nullptr);
 	DLLNETWORK bool LineMesh(const Vector3 &start,const Vector3 &dir,Model &mdl,LineMeshResult &outResult,bool precise,const std::vector<uint32_t> *bodyGroups,uint32_t lod,const Vector3 &origin,const Quat &rot);
 	DLLNETWORK bool LineMesh(const Vector3 &start,const Vector3 &dir,Model &mdl,LineMeshResult &outResult,bool precise,uint32_t lod,const Vector3 &origin,const Quat &rot);
 	DLLNETWORK bool LineMesh(const Vector3 &start,const Vector3 &dir,Model &mdl,LineMeshResult &outResult,bool precise,const std::vector<uint32_t> &bodyGroups,const Vector3 &origin,const Quat &rot);
 	DLLNETWORK bool LineMesh(const Vector3 &start,const Vector3 &dir,Model &mdl,LineMeshResult &outResult,bool precise,const Vector3 &origin,const Quat &rot);
+	// Batched variants, which trace the lines against the triangle hierarchy of each sub-mesh in packets. Lines which start close to
+	// each other and point in a similar direction should be consecutive. Each result is updated the same way as by the variants above.
+	// Returns the number of results that were updated.
+	DLLNETWORK uint32_t LineMesh(const Line *lines,uint32_t numLines,ModelMesh &mesh,LineMeshResult *outResults,bool precise=false,const Vector3 *origin=nullptr,const Quat *rot=nullptr);
+	DLLNETWORK uint32_t LineMesh(const Line *lines,uint32_t numLines,ModelSubMesh &subMesh,LineMeshResult *outResults,bool precise=false,const Vector3 *origin=nullptr,const Quat *rot=nullptr);
 };
 
 #endif // __COLLISIONS_H__
\ No newline at end of file
@@ -0,0 +1,65 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright (c) 2021 Silverlan
+ */
+
+#ifndef __POSE_BLEND_HPP__
+#define __POSE_BLEND_HPP__
+
+#include "pragma/networkdefinitions.h"
+#include <mathutil/uvec.h>
+#include <vector>
+#include <array>
+
+namespace umath {class Transform;};
+namespace pragma::animation
+{
+	// Bone poses in structure-of-arrays layout, which allows the blending kernels to be vectorized by the compiler.
+	// The buffers never shrink, so a re-used PoseBuffer stops allocating once it has reached the largest bone count.
+	class DLLNETWORK PoseBuffer
+	{
+	public:
+		enum class Channel : uint8_t
+		{
+			PositionX = 0,
+			PositionY,
+			PositionZ,
+			RotationW,
+			RotationX,
+			RotationY,
+			RotationZ,
+			ScaleX,
+			ScaleY,
+			ScaleZ,
+
+			Count
+		};
+		PoseBuffer()=default;
+		void Resize(size_t numBones);
+		size_t GetBoneCount() const {return m_numBones;}
+		bool HasScales() const {return m_hasScales;}
+		void SetHasScales(bool hasScales) {m_hasScales = hasScales;}
+		// If scales is nullptr or empty, all scales are set to 1
+		void Load(const std::vector<umath::Transform> &poses,const std::vector<Vector3> *scales);
+		// If the buffer has no scales, outScales will be cleared
+		void Store(std::vector<umath::Transform> &outPoses,std::vector<Vector3> *outScales) const;
+		void SetIdentity(size_t offset=0);
+
+		float *GetChannel(Channel channel) {return m_channels[static_cast<size_t>(channel)].data();}
+		const float *GetChannel(Channel channel) const {return m_channels[static_cast<size_t>(channel)].data();}
+	private:
+		std::array<std::vector<float>,static_cast<size_t>(Channel::Count)> m_channels {};
+		size_t m_numBones = 0;
+		bool m_hasScales = false;
+	};
+
+	// Equivalent to BaseAnimatedComponent::BlendBonePoses: For each bone, the source pose is interpolated towards
+	// the destination pose by interpFactor *boneWeight (rotations use a polynomial slerp approximation along the shortest path),
+	// scales are interpolated between the source scale and the destination scale multiplied by the bone weight.
+	// Bones without a weight in boneWeights have a weight of 1. out may be the same buffer as src or dst.
+	DLLNETWORK void blend_poses(const PoseBuffer &src,const PoseBuffer &dst,const std::vector<float> &boneWeights,float interpFactor,PoseBuffer &out);
+};
+
+#endif
@@ -24,6 +24,7 @@
 #include <sharedutils/asset_loader/asset_format_loader.hpp>
 #include <sharedutils/asset_loader/file_asset_processor.hpp>
 #include <unordered_set>
+#include <mutex>
 
 namespace pragma::asset
 {
@@ -172,6 +173,14 @@ namespace pragma::asset
 		virtual std::shared_ptr<Model> CreateModel(uint32_t numBones,const std::string &mdlName);
 		virtual std::shared_ptr<ModelMesh> CreateMesh();
 		virtual std::shared_ptr<ModelSubMesh> CreateSubMesh();
+
+		// Index of the models which use a specific material, which is used to find the models that are affected when a material is reloaded.
+		// Materials are identified by their file name without extension (case-insensitive). Loaded models are registered automatically.
+		void RegisterMaterialUser(Model &mdl,const std::string &material);
+		void RegisterMaterialUsers(Model &mdl);
+		// Only returns models which still use the material
+		std::vector<std::shared_ptr<Model>> FindMaterialUsers(const std::string &material);
+		static std::string GetMaterialIndexKey(const std::string &material);
 	protected:
 		virtual void InitializeProcessor(util::IAssetProcessor &processor) override;
 		virtual util::AssetObject InitializeAsset(const util::Asset &asset,const util::AssetLoadJob &job) override;
@@ -179,6 +188,11 @@ namespace pragma::asset
 		//std::shared_ptr<Model> LoadModel(const std::string &cacheName,const std::shared_ptr<ufile::IFile> &file,const std::string &ext);
 
 		NetworkState &m_nw;
+		// Models can be loaded on worker threads
+		std::mutex m_materialUserMutex;
+		// Keyed by the model address, so registering a model doesn't have to lock the handles of all other users.
+		// Expired entries are removed lazily by FindMaterialUsers, or replaced if the address is reused.
+		std::unordered_map<std::string,std::unordered_map<const Model*,std::weak_ptr<Model>>> m_materialUsers;
 		//virtual std::shared_ptr<Model> LoadModel(FWMD &wmd,const std::string &mdlName) const;
 	};
 };
@@ -24,6 +24,7 @@ namespace umath
 };
 
 namespace udm {struct AssetData; using Version = uint32_t;};
+namespace pragma {class TriangleBvh;};
 
 namespace pragma::model
 {
@@ -118,6 +119,11 @@ public:
 	void ReserveVertices(size_t num);
 	virtual void Update(ModelUpdateFlags flags=ModelUpdateFlags::AllData);
 
+	// Bounding volume hierarchy of the triangles of this mesh for ray queries. It is built on first use and
+	// discarded when the mesh is updated or transformed. Returns nullptr if the mesh has no triangles.
+	std::shared_ptr<const pragma::TriangleBvh> GetTriangleBvh() const;
+	void ClearTriangleBvh();
+
 	GeometryType GetGeometryType() const;
 	void SetGeometryType(GeometryType type);
 
@@ -215,6 +221,7 @@ protected:
 	pragma::model::IndexType m_indexType = pragma::model::IndexType::UInt16;
 	uint32_t m_referenceId = std::numeric_limits<uint32_t>::max();
 	umath::ScaledTransform m_pose = umath::ScaledTransform{};
+	mutable std::shared_ptr<const pragma::TriangleBvh> m_triangleBvh = nullptr;
 	void ClipAgainstPlane(const Vector3 &n,double d,ModelSubMesh &clippedMesh,const std::vector<Mat4> *boneMatrices=nullptr,ModelSubMesh *clippedCoverMesh=nullptr);
 };
 
@@ -0,0 +1,93 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright (c) 2021 Silverlan
+ */
+
+#ifndef __TRIANGLE_BVH_HPP__
+#define __TRIANGLE_BVH_HPP__
+
+#include "pragma/networkdefinitions.h"
+#include <mathutil/uvec.h>
+#include <vector>
+#include <memory>
+#include <limits>
+
+class ModelSubMesh;
+namespace pragma
+{
+	// Bounding volume hierarchy over the triangles of a sub-mesh. All nodes are stored in a single flat array in depth-first order,
+	// the split planes are chosen with a binned surface area heuristic.
+	// The hierarchy is immutable once it has been built, so it can be queried from multiple threads at the same time.
+	class DLLNETWORK TriangleBvh
+	{
+	public:
+		static constexpr uint32_t INVALID_TRIANGLE = std::numeric_limits<uint32_t>::max();
+		// Number of rays that are traversed together by the batched raycast
+		static constexpr uint32_t PACKET_SIZE = 8;
+		static constexpr uint32_t MAX_LEAF_TRIANGLES = 4;
+		static constexpr uint32_t SAH_BIN_COUNT = 16;
+
+		struct DLLNETWORK Ray
+		{
+			Vector3 start {};
+			// Does not need to be normalized; Hit distances are multiples of this vector
+			Vector3 dir {};
+			float tMin = 0.f;
+			float tMax = 1.f;
+		};
+		struct DLLNETWORK Hit
+		{
+			// Index of the triangle in the index data of the sub-mesh
+			uint32_t triIdx = INVALID_TRIANGLE;
+			float t = std::numeric_limits<float>::max();
+			float u = 0.f;
+			float v = 0.f;
+			bool IsValid() const {return triIdx != INVALID_TRIANGLE;}
+		};
+
+		// Returns nullptr if the sub-mesh has no triangles
+		static std::shared_ptr<TriangleBvh> Create(const ModelSubMesh &subMesh);
+
+		// Back faces are culled. Returns the closest hit within [tMin,tMax], or the first hit found if anyHit is true.
+		bool Raycast(const Ray &ray,Hit &outHit,bool anyHit=false) const;
+		// Rays are traversed in packets of PACKET_SIZE, so consecutive rays should start close to each other and point in a similar direction.
+		// Returns the number of rays that hit a triangle.
+		uint32_t Raycast(const Ray *rays,Hit *outHits,uint32_t numRays,bool anyHit=false) const;
+
+		uint32_t GetTriangleCount() const;
+		uint32_t GetNodeCount() const;
+		const Vector3 &GetMin() const;
+		const Vector3 &GetMax() const;
+	private:
+		struct Node
+		{
+			Vector3 min;
+			// Index of the right child for inner nodes (the left child always follows its parent), or index of the first triangle for leaves
+			uint32_t index = 0;
+			Vector3 max;
+			// 0 for inner nodes
+			uint32_t triangleCount = 0;
+			bool IsLeaf() const {return triangleCount > 0;}
+		};
+		struct Triangle
+		{
+			Vector3 v0;
+			Vector3 v1;
+			Vector3 v2;
+		};
+		struct BuildTriangle;
+		TriangleBvh()=default;
+		void BuildNode(uint32_t nodeIdx,std::vector<BuildTriangle> &buildTris,uint32_t first,uint32_t count,uint32_t depth);
+		void RaycastPacket(const Ray *rays,Hit *outHits,uint32_t numRays,bool anyHit) const;
+		bool IntersectTriangles(const Node &node,const Ray &ray,float tMax,Hit &outHit) const;
+
+		std::vector<Node> m_nodes;
+		// Sorted by leaf
+		std::vector<Triangle> m_triangles;
+		std::vector<uint32_t> m_triangleIndices;
+	};
+};
+
+#endif
@@ -35,6 +35,10 @@ namespace nwm
 	template<class T>
 		T *read_entity(NetPacket &packet,const std::function<void(BaseEntity*)> &onCreated);
 
+	// Writes an unsigned integer using 7 bits per byte, with the highest bit indicating whether another byte follows
+	DLLNETWORK void write_varint(NetPacket &packet,uint32_t value);
+	DLLNETWORK uint32_t read_varint(NetPacket &packet);
+
 	DLLNETWORK void write_player(NetPacket &packet,const BaseEntity *pl);
 	DLLNETWORK void write_player(NetPacket &packet,const pragma::BasePlayerComponent *pl);
 	DLLNETWORK pragma::BasePlayerComponent *read_player(NetPacket &packet);
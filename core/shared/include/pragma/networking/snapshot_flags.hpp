@@ -19,6 +19,20 @@ namespace pragma
 		ComponentData = PhysicsData<<1u
 	};
 	REGISTER_BASIC_BITWISE_OPERATORS(SnapshotFlags);
+
+	// Transform fields that are included in a snapshot entity entry. Fields that
+	// haven't changed since the last acknowledged snapshot are omitted.
+	enum class SnapshotEntityFieldFlags : uint8_t
+	{
+		None = 0u,
+		Position = 1u,
+		Velocity = Position<<1u,
+		AngularVelocity = Velocity<<1u,
+		Rotation = AngularVelocity<<1u,
+
+		All = Position | Velocity | AngularVelocity | Rotation
+	};
+	REGISTER_BASIC_BITWISE_OPERATORS(SnapshotEntityFieldFlags);
 };
 
 #endif
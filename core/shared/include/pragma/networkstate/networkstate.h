@@ -74,6 +74,7 @@ public:
 	enum class CPUProfilingPhase : uint32_t
 	{
 		UpdateSounds = 0u,
+		ReloadAssets,
 		Count
 	};
 public:
@@ -207,6 +208,8 @@ protected:
 	std::queue<std::function<void()>> m_tickCallQueue;
 	CallbackHandle m_cbProfilingHandle = {};
 	std::unique_ptr<pragma::debug::ProfilingStageManager<pragma::debug::ProfilingStage,CPUProfilingPhase>> m_profilingStageManager = nullptr;
+	pragma::debug::ProfilingStage::CounterId m_counterPendingReloads = 0;
+	pragma::debug::ProfilingStage::CounterId m_counterReloadLatency = 0;
 
 	// Library handles are stored as shared_ptrs of shared_ptr because we need the
 	// use count of each library in the network states to determine when to detach
@@ -19,7 +19,7 @@ class Game;
 struct PhysSoftBodyInfo;
 class ModelSubMesh;
 class Model;
-namespace pragma::physics {class IShape;};
+namespace pragma::physics {class IShape; class BuoyancyVolumeTable;};
 namespace udm {struct AssetData; using Version = uint32_t;};
 class DLLNETWORK CollisionMesh
 	: public std::enable_shared_from_this<CollisionMesh>
@@ -79,6 +79,7 @@ private:
 	int m_surfaceMaterialId = 0;
 	Vector3 m_centerOfMass = {};
 	double m_volume = 0.0;
+	std::shared_ptr<const pragma::physics::BuoyancyVolumeTable> m_buoyancyVolumeTable = nullptr;
 	void ClipAgainstPlane(const Vector3 &n,double d,CollisionMesh &clippedMesh);
 	bool LoadFromAssetData(Game &game,Model &mdl,const udm::AssetData &data,std::string &outErr);
 public:
@@ -125,6 +126,11 @@ public:
 
 	void ClipAgainstPlane(const Vector3 &n,double d,CollisionMesh &clippedMeshA,CollisionMesh &clippedMeshB);
 
+	// Cached by the water buoyancy simulator and cleared whenever the vertices of the mesh are changed
+	const std::shared_ptr<const pragma::physics::BuoyancyVolumeTable> &GetBuoyancyVolumeTable() const;
+	void SetBuoyancyVolumeTable(const std::shared_ptr<const pragma::physics::BuoyancyVolumeTable> &table);
+	void ClearBuoyancyVolumeTable();
+
 	void SetSoftBody(bool b);
 	bool IsSoftBody() const;
 	ModelSubMesh *GetSoftBodyMesh() const;
@@ -27,7 +27,9 @@ class NetworkState;
 class BaseEntity;
 class PhysObj;
 struct TraceResult;
+struct TraceQuery;
 class TraceData;
+enum class TraceType : uint8_t;
 struct PhysSoftBodyInfo;
 enum class RayCastFlags : uint32_t;
 
@@ -171,6 +173,14 @@ namespace pragma::physics
 		virtual Bool Overlap(const TraceData &data,std::vector<TraceResult> *optOutResults=nullptr) const=0;
 		virtual Bool RayCast(const TraceData &data,std::vector<TraceResult> *optOutResults=nullptr) const=0;
 		virtual Bool Sweep(const TraceData &data,std::vector<TraceResult> *optOutResults=nullptr) const=0;
+		// Returns true if Overlap, RayCast and Sweep may be called from multiple threads at the same time.
+		// Physics engine implementations have to opt in explicitly.
+		virtual bool SupportsConcurrentQueries() const;
+		// Runs every query with the flags, shape, collision filter and filter callback of the trace data and writes its first result to
+		// outResults (RayCastFlags::ReportAllResults is ignored). The queries are distributed across the engine job system if the physics engine
+		// supports concurrent queries and the filter callback is thread-safe. If resolveMeshes is true, the hit meshes of each result are determined
+		// as well on the calling thread (see TraceResult::GetMeshes). Returns the number of queries that hit something.
+		uint32_t BatchTrace(TraceType type,const TraceData &data,const TraceQuery *queries,uint32_t numQueries,TraceResult *outResults,bool resolveMeshes=false) const;
 
 		const std::vector<util::TSharedHandle<IConstraint>> &GetConstraints() const;
 		std::vector<util::TSharedHandle<IConstraint>> &GetConstraints();
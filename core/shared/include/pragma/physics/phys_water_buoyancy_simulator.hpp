@@ -9,16 +9,67 @@
 #define __PHYS_WATER_BUOYANCY_SIMULATOR_HPP__
 
 #include "pragma/networkdefinitions.h"
+#include <mathutil/uvec.h>
+#include <vector>
+#include <memory>
+#include <unordered_map>
 
 class BaseEntity;
+class CollisionMesh;
 class PhysWaterSurfaceSimulator;
 struct PhysLiquid;
 namespace pragma::physics
 {
+	class WaterBuoyancySimulator;
+	// Precomputed submerged volumes of a mesh for a set of plane orientations and plane distances.
+	// Plane orientations are sampled on the faces of a cube and the distances between the lowest and highest
+	// vertex along each orientation, the volume for an arbitrary plane is interpolated from the closest samples.
+	class DLLNETWORK BuoyancyVolumeTable
+	{
+	public:
+		// Number of orientation samples along each edge of a cube face
+		static constexpr uint32_t DIRECTION_RESOLUTION = 6;
+		// Number of distance samples per orientation
+		static constexpr uint32_t SAMPLE_COUNT = 12;
+		struct DLLNETWORK Result
+		{
+			double volume = 0.0;
+			Vector3 center {};
+		};
+		// The plane has to be in the coordinate system of the mesh, everything below the plane is submerged
+		Result Evaluate(const Vector3 &n,double d) const;
+		const Vector3 &GetBodyCenter() const;
+		// Used to detect changes to meshes which don't clear their cached table
+		bool IsValid(std::size_t meshHash) const;
+		// Hash of the vertices and triangles of the mesh (or its bounds if it has no triangles)
+		static std::size_t CalcMeshHash(CollisionMesh &colMesh);
+	private:
+		friend WaterBuoyancySimulator;
+		struct Range
+		{
+			float min = 0.f;
+			float max = 0.f;
+		};
+		struct Sample
+		{
+			float volume = 0.f;
+			Vector3 center {};
+		};
+		BuoyancyVolumeTable()=default;
+		static Vector3 GetDirection(uint32_t face,uint32_t x,uint32_t y);
+		std::vector<Range> m_ranges;
+		// SAMPLE_COUNT samples per orientation
+		std::vector<Sample> m_samples;
+		Vector3 m_bodyCenter {};
+		std::size_t m_meshHash = 0;
+	};
+
 	class DLLNETWORK WaterBuoyancySimulator
 	{
 	public:
 		WaterBuoyancySimulator();
+		// Waits for all volume tables which are still being built
+		~WaterBuoyancySimulator();
 		template<class InputItVert,class InputItIndex>
 			double CalcBuoyancy(
 			const Quat &rorigin,
@@ -37,9 +88,47 @@ namespace pragma::physics
 			Vector3 *torque=nullptr,
 			Vector3 *optOutSubmergedCenter=nullptr
 		) const;
-		// Not safe to call, unless particle heights of surface simulator were locked!
 		void Simulate(BaseEntity &entWater,const PhysLiquid &liquid,BaseEntity &ent,Vector3 waterPlane,double waterPlaneDist,const Vector3 &waterVelocity,const PhysWaterSurfaceSimulator *surfaceSim=nullptr) const;
+		// Simulates all entities in the same liquid at once. If volume tables are enabled (sh_water_buoyancy_volume_tables),
+		// the forces of all rigid bodies are calculated on the engine job system.
+		void Simulate(BaseEntity &entWater,const PhysLiquid &liquid,const std::vector<BaseEntity*> &ents,const Vector3 &waterPlane,double waterPlaneDist,const Vector3 &waterVelocity,const PhysWaterSurfaceSimulator *surfaceSim=nullptr) const;
+
+		// Returns the cached volume table of the mesh. If there is none, it is built on the engine job system in the background
+		// and nullptr is returned until it is ready. Has to be called from the thread that runs the simulation.
+		std::shared_ptr<const BuoyancyVolumeTable> GetVolumeTable(CollisionMesh &colMesh) const;
+		// Builds the table immediately
+		std::shared_ptr<BuoyancyVolumeTable> CreateVolumeTable(const std::vector<Vector3> &verts,const std::vector<uint16_t> &triangles) const;
 	protected:
+		struct PendingVolumeTable;
+		std::shared_ptr<BuoyancyVolumeTable> InitializeVolumeTable(const std::vector<Vector3> &verts,const std::vector<uint16_t> &triangles) const;
+		void BuildVolumeTableDirections(BuoyancyVolumeTable &table,const std::vector<Vector3> &verts,const std::vector<uint16_t> &triangles,uint32_t firstDir,uint32_t numDirs) const;
+		// Removes tables which have been completed for meshes that don't exist anymore
+		void ClearExpiredVolumeTables() const;
+		// Clips every triangle against the liquid plane
+		void SimulateExact(BaseEntity &entWater,const PhysLiquid &liquid,BaseEntity &ent,Vector3 waterPlane,double waterPlaneDist,const Vector3 &waterVelocity,const PhysWaterSurfaceSimulator *surfaceSim) const;
+		template<class InputItVert,class InputItIndex>
+			double CalcSubmergedVolume(
+			const Vector3 &waterPlaneRelObj,double waterPlaneDistRelObj,
+			InputItVert vertsBegin,
+			InputItIndex indicesBegin,InputItIndex indicesEnd,
+			Vector3 &outBodyCenter,Vector3 &outSubmergedCenter
+		) const;
+		void CalcForces(
+			const Quat &rorigin,
+			const PhysLiquid &liquid,
+			const Vector3 &waterPlane,
+			const Vector3 &waterVelocity,
+			double gravity,
+			double submergedVolume,
+			const Vector3 &bodyCenter,
+			const Vector3 &submergedCenter,
+			double mass,
+			double volBody,
+			const Vector3 &bodyVelocity,
+			const Vector3 &bodyAngularVelocity,
+			Vector3 *force,
+			Vector3 *torque
+		) const;
 		Vector3 CalcBuoyancy(double liquidDensity,double submergedVolume,double gravity,const Vector3 &liquidUpVec) const;
 		Vector3 CalcTorque(const Quat &rorigin,const Vector3 &centerBody,const Vector3 &centerSubmergedVolume,double liquidDensity,double submergedVolume,double gravity,const Vector3 &liquidUpVec) const;
 
@@ -51,6 +140,9 @@ namespace pragma::physics
 
 		Vector3 CalcCattoDragLinearForceApproximation(double dragCoefficientHz,double mass,double submergedLiquidVolume,double volume,const Vector3 &liquidVel,const Vector3 &velSubmergedVolume) const;
 		Vector3 CalcCattoDragTorqueForceApproximation(double dragCoefficientHz,double mass,double submergedLiquidVolume,double volume,double lenPolyhedron,const Vector3 &bodyAngularVelocity) const;
+
+		// Volume tables that are currently being built, by collision mesh
+		mutable std::unordered_map<const CollisionMesh*,std::unique_ptr<PendingVolumeTable>> m_pendingVolumeTables;
 	};
 };
 
@@ -10,9 +10,11 @@
 
 #include "pragma/networkdefinitions.h"
 #include <vector>
+#include <array>
 #include <cinttypes>
 #include <mutex>
 #include <atomic>
+#include <functional>
 
 class DLLNETWORK PhysWaterSurfaceSimulator
 	: public std::enable_shared_from_this<PhysWaterSurfaceSimulator>
@@ -82,10 +84,23 @@ public:
 	void Initialize();
 	void CreateSplash(const Vector3 &origin,float radius,float force);
 
-	void LockParticleHeights();
-	void UnlockParticleHeights();
+	// Read-only access to the most recently published particle heights. The simulation never writes to heights
+	// which are still referenced by a view, so views should not be kept around for longer than necessary.
+	class DLLNETWORK HeightView
+	{
+	public:
+		HeightView(const PhysWaterSurfaceSimulator &sim);
+		HeightView(const HeightView&)=delete;
+		HeightView &operator=(const HeightView&)=delete;
+		~HeightView();
+		const std::vector<float> &GetHeights() const;
+	private:
+		const std::vector<float> *m_heights = nullptr;
+		std::atomic<uint32_t> *m_readers = nullptr;
+	};
 
-	// Not safe to call, unless particle heights were locked!
+	Vector3 CalcParticlePosition(const HeightView &heights,std::size_t ptIdx) const;
+	// Creates a new height view for every call, use the overload above to calculate multiple positions
 	Vector3 CalcParticlePosition(std::size_t ptIdx) const;
 	bool CalcPointSurfaceIntersection(const Vector3 &origin,Vector3 &intersection) const;
 protected:
@@ -105,7 +120,6 @@ protected:
 	SurfaceInfo m_surfaceInfo = {};
 	std::queue<SplashInfo> m_splashQueue;
 	std::vector<Edge> m_particleEdges;
-	std::vector<float> m_particleHeights;
 	std::array<Vector2,2> m_bounds {};
 	float m_originY = 0.f;
 	bool m_bUseThread = true;
@@ -115,21 +129,48 @@ protected:
 	virtual uint8_t GetEdgeIterationCount() const;
 	Vector3 CalcParticlePosition(const SurfaceInfo &surfInfo,const std::vector<float> &heights,std::size_t ptIdx) const;
 
-	// Threaded data (Not thread-safe!)
-	std::vector<float> m_threadParticleHeights;
+	// Particle state of the CPU solver as a structure of arrays, stored row by row (see GetParticleIndex)
+	struct DLLNETWORK ParticleState
+	{
+		void Resize(std::size_t count);
+		std::vector<float> heights;
+		std::vector<float> oldHeights;
+		std::vector<float> targetHeights;
+		std::vector<float> velocities;
+	};
+	struct DLLNETWORK HeightBuffer
+	{
+		std::vector<float> heights;
+		// Number of height views referencing this buffer
+		mutable std::atomic<uint32_t> readers = {0};
+	};
+	// Minimum number of particles that are processed by a single job of the solver
+	static constexpr uint32_t MIN_PARTICLES_PER_JOB = 4'096;
+
+	// Initial particle data for the GPU solver
 	std::vector<Particle> m_particleField;
+
+	// Threaded data (Not thread-safe!)
+	ParticleState m_particleState;
 	std::thread m_simThread;
 	std::atomic<bool> m_bRunThread = {true};
 	std::mutex m_splashMutex;
 	std::mutex m_settingsMutex;
-	std::mutex m_heightMutex;
+	// Heights are published by swapping the front and back buffer once a step is complete
+	std::array<HeightBuffer,2> m_heightBuffers;
+	std::atomic<uint32_t> m_frontHeightBuffer = {0};
 	void SimulateWaves(double dt);
 	void JoinThread();
-	void SolveDepths(const SurfaceInfo &surfInfo);
-	void SolveEdges(const SurfaceInfo &surfInfo);
+	void ApplySplash(const SurfaceInfo &surfInfo,const SplashInfo &splash);
+	// Splits the range [0,count) into jobs on the engine job system and waits for all of them to complete.
+	// itemSize is the number of particles per item and is used to determine the number of jobs.
+	void ParallelFor(uint32_t count,uint32_t itemSize,const std::function<void(uint32_t,uint32_t)> &fn) const;
 	void Integrate(const SurfaceInfo &surfInfo,double dt);
-	void VelocityFixup(const SurfaceInfo &surfInfo,double invDt);
-	void SetParticleHeight(const SurfaceInfo &surfInfo,std::size_t ptIdx,float height);
+	// Edges are solved in batches which don't share any particles: Horizontal edges with an even and odd start column
+	// (rows are independent of each other), followed by vertical edges with an even and odd start row.
+	void SolveEdges(const SurfaceInfo &surfInfo);
+	// Also applies the velocity fixup and writes the final heights to outHeights
+	void SolveDepths(const SurfaceInfo &surfInfo,double invDt,std::vector<float> &outHeights);
 	std::size_t GetParticleIndex(const SurfaceInfo &surfInfo,uint32_t x,uint32_t y) const;
 	std::pair<uint32_t,uint32_t> GetParticleCoordinates(const SurfaceInfo &surfInfo,std::size_t idx) const;
 };
@@ -28,6 +28,8 @@ namespace pragma::physics
 		virtual RayCastHitType PostFilter(pragma::physics::IShape &shape,pragma::physics::IRigidBody &rigidBody) const=0;
 		virtual bool HasPreFilter() const=0;
 		virtual bool HasPostFilter() const=0;
+		// If true, the filter may be called from multiple threads at the same time (e.g. by batched traces)
+		virtual bool IsThreadSafe() const {return false;}
 		virtual ~IRayCastFilterCallback()=default;
 	};
 
@@ -40,6 +42,7 @@ namespace pragma::physics
 		virtual RayCastHitType PostFilter(pragma::physics::IShape &shape,pragma::physics::IRigidBody &rigidBody) const override;
 		virtual bool HasPreFilter() const override;
 		virtual bool HasPostFilter() const override;
+		virtual bool IsThreadSafe() const override;
 	private:
 		EntityHandle m_hEnt = {};
 	};
@@ -53,6 +56,7 @@ namespace pragma::physics
 		virtual RayCastHitType PostFilter(pragma::physics::IShape &shape,pragma::physics::IRigidBody &rigidBody) const override;
 		virtual bool HasPreFilter() const override;
 		virtual bool HasPostFilter() const override;
+		virtual bool IsThreadSafe() const override;
 	private:
 		std::vector<EntityHandle> m_ents = {};
 	};
@@ -66,6 +70,7 @@ namespace pragma::physics
 		virtual RayCastHitType PostFilter(pragma::physics::IShape &shape,pragma::physics::IRigidBody &rigidBody) const override;
 		virtual bool HasPreFilter() const override;
 		virtual bool HasPostFilter() const override;
+		virtual bool IsThreadSafe() const override;
 	private:
 		PhysObjHandle m_hPhys = {};
 	};
@@ -79,6 +84,7 @@ namespace pragma::physics
 		virtual RayCastHitType PostFilter(pragma::physics::IShape &shape,pragma::physics::IRigidBody &rigidBody) const override;
 		virtual bool HasPreFilter() const override;
 		virtual bool HasPostFilter() const override;
+		virtual bool IsThreadSafe() const override;
 	private:
 		util::TWeakSharedHandle<ICollisionObject> m_hColObj = {};
 	};
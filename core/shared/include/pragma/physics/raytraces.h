@@ -41,6 +41,13 @@ enum class RayCastHitType : uint8_t
 	Block
 };
 
+enum class TraceType : uint8_t
+{
+	RayCast = 0,
+	Sweep,
+	Overlap
+};
+
 namespace pragma::physics {class IConvexShape; class IRayCastFilterCallback;};
 class DLLNETWORK TraceData
 {
@@ -95,6 +102,13 @@ private:
 	util::WeakHandle<pragma::physics::IConvexShape> m_shape = {};
 };
 
+// Source and target of a single query of a batched trace; Everything else is shared by all queries of the batch
+struct DLLNETWORK TraceQuery
+{
+	umath::Transform source;
+	umath::Transform target;
+};
+
 class ModelMesh;
 class ModelSubMesh;
 class Material;
@@ -0,0 +1,77 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright (c) 2021 Silverlan
+ */
+
+#ifndef __ASSET_RELOAD_SCHEDULER_HPP__
+#define __ASSET_RELOAD_SCHEDULER_HPP__
+
+#include "pragma/networkdefinitions.h"
+#include <unordered_map>
+#include <functional>
+#include <optional>
+#include <string>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <list>
+
+namespace pragma
+{
+	class JobSystem;
+	// Coalesces file change events and applies the resulting reloads on the main thread within a time budget per frame.
+	// Changes are only applied once no further changes have occurred for DEBOUNCE_TIME, so that saving many files at once
+	// doesn't result in a reload per change event. If a prefetch path is specified for a change, the file is read on the job system
+	// before the change is applied, so the reload itself doesn't have to wait for the file I/O.
+	class DLLNETWORK AssetReloadScheduler
+	{
+	public:
+		using Clock = std::chrono::steady_clock;
+		static constexpr std::chrono::milliseconds DEBOUNCE_TIME {200};
+		// Pending changes are applied after this amount of time, even if files are still being changed
+		static constexpr std::chrono::milliseconds MAX_DELAY {2'000};
+		struct Stats
+		{
+			// Number of changes which haven't been applied yet
+			uint32_t queueDepth = 0;
+			// Number of changes that have been applied by the last Process call
+			uint32_t numApplied = 0;
+			// Largest delay between the first change event and the application of the change, of all changes applied by the last Process call
+			std::chrono::microseconds maxApplyLatency {0};
+		};
+
+		// If no job system is specified, files are prefetched on the main thread
+		AssetReloadScheduler(JobSystem *jobSystem=nullptr);
+		AssetReloadScheduler(const AssetReloadScheduler&)=delete;
+		AssetReloadScheduler &operator=(const AssetReloadScheduler&)=delete;
+		// Changes with the same key are coalesced, only the most recent apply function will be called
+		void AddChange(const std::string &key,const std::function<void()> &apply,const std::optional<std::string> &prefetchPath={});
+		// Applies ready changes until the budget has been exceeded. At least one change is applied per call (if there are any ready changes).
+		// Returns the remaining budget.
+		std::chrono::microseconds Process(std::chrono::microseconds budget);
+		bool HasPendingChanges() const;
+		const Stats &GetStats() const;
+	private:
+		struct Change
+		{
+			std::string key;
+			std::function<void()> apply;
+			std::optional<std::string> prefetchPath {};
+			Clock::time_point tFirstChange {};
+			// Set once the prefetch job has been scheduled
+			std::shared_ptr<std::atomic<bool>> prefetched = nullptr;
+		};
+		bool IsReady(Change &change,Clock::time_point t,bool settled);
+		void Prefetch(Change &change);
+
+		JobSystem *m_jobSystem = nullptr;
+		std::list<Change> m_changes;
+		std::unordered_map<std::string,std::list<Change>::iterator> m_keyToChange;
+		Clock::time_point m_tLastChange {};
+		Stats m_stats {};
+	};
+};
+
+#endif
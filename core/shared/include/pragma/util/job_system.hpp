@@ -0,0 +1,132 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright (c) 2021 Silverlan
+ */
+
+#ifndef __JOB_SYSTEM_HPP__
+#define __JOB_SYSTEM_HPP__
+
+#include "pragma/networkdefinitions.h"
+#include <functional>
+#include <condition_variable>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <limits>
+
+namespace pragma
+{
+	class JobSystem;
+	// Keeps track of the number of outstanding jobs that were scheduled with it. Jobs can also depend on a counter,
+	// in which case they will only be executed after the counter has reached zero.
+	// Note: The counter must outlive all jobs associated with it. If it is destroyed after a wait, the wait has
+	// to be done via JobSystem::Wait (and not just by polling IsComplete).
+	class DLLNETWORK JobCounter
+	{
+	public:
+		JobCounter()=default;
+		JobCounter(const JobCounter&)=delete;
+		JobCounter &operator=(const JobCounter&)=delete;
+		bool IsComplete() const;
+		uint32_t GetValue() const;
+	private:
+		friend JobSystem;
+		struct Continuation
+		{
+			std::function<void()> job;
+			JobCounter *counter = nullptr;
+		};
+		std::atomic<uint32_t> m_value = 0;
+		std::mutex m_mutex;
+		// Jobs that have been scheduled with this counter as dependency
+		std::vector<Continuation> m_continuations;
+	};
+
+	// General-purpose job system. Every worker thread has its own job deque; Jobs scheduled from a worker thread are pushed to
+	// that worker's deque, all other jobs are distributed between the workers. A worker will execute the most recently added
+	// job in its own deque first, and will steal the oldest job from the other workers if its own deque is empty.
+	// Threads waiting for jobs to complete help with the execution of pending jobs instead of blocking.
+	class DLLNETWORK JobSystem
+	{
+	public:
+		using Job = std::function<void()>;
+		using WorkerCallback = std::function<void(uint32_t)>;
+		static constexpr uint32_t INVALID_WORKER_INDEX = std::numeric_limits<uint32_t>::max();
+		// Returns the index of the worker thread the function was called from, or INVALID_WORKER_INDEX if it isn't a worker thread of any job system
+		static uint32_t GetCurrentWorkerIndex();
+
+		// onWorkerStarted is called on every worker thread with the worker index before any jobs are executed
+		JobSystem(std::string name,uint32_t numWorkers,const WorkerCallback &onWorkerStarted=nullptr);
+		~JobSystem();
+		JobSystem(const JobSystem&)=delete;
+		JobSystem &operator=(const JobSystem&)=delete;
+
+		// Waits for all pending jobs before changing the number of workers. If the count is zero, jobs are only executed by waiting threads.
+		void SetWorkerCount(uint32_t numWorkers);
+		uint32_t GetWorkerCount() const;
+		const std::string &GetName() const;
+		// Returns true if the calling thread is one of the workers of this job system
+		bool IsWorkerThread() const;
+
+		// If a counter is specified, it will be incremented immediately and decremented once the job has been completed.
+		// If a dependency is specified, the job will not be started before the dependency counter has reached zero.
+		void Schedule(const Job &job,JobCounter *counter=nullptr,JobCounter *dependency=nullptr);
+		// Blocks until the counter has reached zero. The calling thread executes pending jobs in the meantime.
+		void Wait(JobCounter &counter);
+		// Blocks until all scheduled jobs have been completed (including jobs waiting for a dependency)
+		void WaitForAll();
+		// Executes one pending job on the calling thread. Returns false if there were no pending jobs.
+		bool ExecuteJob();
+		// Number of jobs that have been scheduled and have not been completed yet
+		uint32_t GetPendingJobCount() const;
+	private:
+		struct JobInfo
+		{
+			Job job;
+			JobCounter *counter = nullptr;
+		};
+		struct WorkerQueue
+		{
+			std::mutex mutex;
+			std::deque<JobInfo> jobs;
+		};
+		void StartWorkers(uint32_t numWorkers);
+		void StopWorkers();
+		void WorkerMain(uint32_t workerIndex);
+		void Push(JobInfo &&info);
+		bool PopJob(uint32_t queueIndex,JobInfo &outInfo);
+		bool StealJob(uint32_t thiefIndex,JobInfo &outInfo);
+		bool AcquireJob(JobInfo &outInfo);
+		void RunJob(JobInfo &info);
+		// Executes pending jobs on the calling thread until the condition is met
+		void HelpUntil(const std::function<bool()> &isDone);
+		void NotifyWaiters();
+
+		std::string m_name;
+		WorkerCallback m_onWorkerStarted = nullptr;
+		std::vector<std::thread> m_workers;
+		// There's always at least one queue, even if there are no workers
+		std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+		std::atomic<uint32_t> m_nextQueue = 0;
+		std::atomic<bool> m_running = false;
+
+		// Number of jobs in the worker queues
+		std::atomic<uint32_t> m_numQueuedJobs = 0;
+		// Number of jobs that have been scheduled but not completed yet
+		std::atomic<uint32_t> m_numPendingJobs = 0;
+		std::mutex m_workAvailableMutex;
+		std::condition_variable m_workAvailableCondition;
+
+		std::atomic<uint32_t> m_numWaiters = 0;
+		std::mutex m_waitMutex;
+		std::condition_variable m_waitCondition;
+	};
+};
+
+#endif
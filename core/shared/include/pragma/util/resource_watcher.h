@@ -11,8 +11,10 @@
 #include "pragma/networkdefinitions.h"
 #include <sharedutils/util_extensible_enum.hpp>
 #include <sharedutils/scope_guard.h>
+#include "pragma/util/asset_reload_scheduler.hpp"
 #include <fsys/directory_watcher.h>
 #include <unordered_set>
+#include <chrono>
 
 #define RESOURCE_WATCHER_VERBOSE 0
 
@@ -44,6 +46,7 @@ protected:
 DEFINE_STD_HASH_SPECIALIZATION(EResourceWatcherCallbackType);
 
 class Model;
+class Material;
 class LuaDirectoryWatcherManager;
 class DLLNETWORK ResourceWatcherManager
 {
@@ -60,21 +63,63 @@ public:
 	util::ScopeGuard ScopeLock();
 	bool IsLocked() const;
 	CallbackHandle AddChangeCallback(EResourceWatcherCallbackType type,const std::function<void(std::reference_wrapper<const std::string>,std::reference_wrapper<const std::string>)> &fcallback);
+	// Returns the names of all cached materials which use the specified texture
+	std::vector<std::string> FindTextureUsers(const std::string &texture);
+	const pragma::AssetReloadScheduler &GetReloadScheduler() const;
+	// Number of file changes and material reloads which haven't been processed yet
+	uint32_t GetPendingReloadCount() const;
 protected:
 	NetworkState *m_networkState = nullptr;
 	uint32_t m_lockedCount = 0;
 	std::recursive_mutex m_watcherMutex;
 	void OnResourceChanged(const util::Path &rootPath,const util::Path &path);
+	// Materials are reloaded by Poll once all changes of the current frame have been processed
 	void ReloadMaterial(const std::string &path);
-	virtual void OnMaterialReloaded(const std::string &path,const std::unordered_set<Model*> &modelMap) {}
+	// Reloads pending materials until the budget has been exceeded (but at least one)
+	void ReloadPendingMaterials(std::chrono::microseconds budget);
+	virtual void OnMaterialsReloaded(const std::vector<std::string> &paths,const std::unordered_set<Model*> &models) {}
 	virtual void OnResourceChanged(const util::Path &rootPath,const util::Path &path,const std::string &ext);
 	virtual void GetWatchPaths(std::vector<std::string> &paths);
 	virtual void ReloadTexture(const std::string &path);
 	void CallChangeCallbacks(EResourceWatcherCallbackType type,const std::string &path,const std::string &ext);
 private:
+	struct DeferredCallback
+	{
+		EResourceWatcherCallbackType type;
+		std::string path;
+		std::string ext;
+	};
+	struct IndexedMaterial
+	{
+		const Material *material = nullptr;
+		std::vector<std::string> textures;
+	};
+	// Indexes all materials which have been added to the cache (or have been reloaded) since the last update
+	void UpdateTextureIndex();
+	void IndexMaterial(Material &mat);
+	void RemoveFromTextureIndex(const std::string &matName,const IndexedMaterial &indexed);
+	// Queues the materials which use the changed textures for a reload. The index is only updated once for all textures.
+	void ReloadTextureUsers();
+	static std::string GetTextureIndexKey(const std::string &texture);
+
 	std::unordered_map<EResourceWatcherCallbackType,std::vector<CallbackHandle>> m_callbacks;
 	std::unordered_map<std::string,std::function<void()>> m_watchFiles;
 	std::vector<std::shared_ptr<DirectoryWatcherCallback>> m_watchers;
+
+	pragma::AssetReloadScheduler m_reloadScheduler;
+	std::vector<std::string> m_pendingMaterialReloads;
+	// Index keys of m_pendingMaterialReloads
+	std::unordered_set<std::string> m_pendingMaterialReloadKeys;
+	// Change callbacks are deferred while changes are being processed
+	bool m_processingChanges = false;
+	std::vector<DeferredCallback> m_deferredCallbacks;
+
+	// Textures which have changed since the last poll
+	std::vector<std::string> m_changedTextures;
+	// Texture -> names of the materials which use it
+	std::unordered_map<std::string,std::unordered_set<std::string>> m_textureUsers;
+	// Material name -> indexed textures
+	std::unordered_map<std::string,IndexedMaterial> m_indexedMaterials;
 };
 
 #endif
@@ -21,7 +21,7 @@ namespace util
 		: public std::enable_shared_from_this<BSPTree>
 	{
 	public:
-		static constexpr uint32_t PBSP_VERSION = 1;
+		static constexpr uint32_t PBSP_VERSION = 2;
 		static constexpr auto PBSP_IDENTIFIER = "PBSP";
 		using ClusterIndex = uint16_t;
 		using ChildIndex = uint32_t;
@@ -52,39 +52,108 @@ namespace util
 			// Only valid if this is a non-leaf node
 			umath::Plane plane = {};
 		};
+		// Potentially visible set of a single cluster. If no more than 1/16th of all clusters are visible, the row
+		// contains the sorted indices of the visible clusters, otherwise it contains one bit per cluster.
+		struct DLLNETWORK ClusterVisibilityRow
+		{
+			// Offset into the cluster visibility data
+			uint32_t offset = 0;
+			// Number of visible clusters
+			uint32_t count = 0;
+		};
 		static std::shared_ptr<BSPTree> Create();
 		static std::shared_ptr<BSPTree> Load(const udm::AssetData &data,std::string &outErr);
 		
 		bool IsValid() const;
 		bool IsClusterVisible(ClusterIndex clusterSrc,ClusterIndex clusterDst) const;
+		// Calls the function for every cluster that is visible from the source cluster, in ascending order
+		template<class TFunc>
+			void IterateVisibleClusters(ClusterIndex clusterSrc,const TFunc &func) const;
+		uint32_t GetVisibleClusterCount(ClusterIndex clusterSrc) const;
 		const Node &GetRootNode() const;
 		Node &GetRootNode();
 		const std::vector<Node> &GetNodes() const;
 		std::vector<Node> &GetNodes();
+		// Uncompressed numClusters*numClusters visibility bit matrix. Only used to build the tree,
+		// it is empty once CompressClusterVisibility has been called.
 		const std::vector<uint8_t> &GetClusterVisibility() const;
 		std::vector<uint8_t> &GetClusterVisibility();
+		// Converts the uncompressed visibility matrix into one row per cluster and releases the matrix
+		void CompressClusterVisibility();
+		bool IsClusterVisibilityCompressed() const;
+		// Returns the visibility of all clusters as uncompressed bit matrix
+		std::vector<uint8_t> DecompressClusterVisibility() const;
+		// Returns false (and leaves the current visibility untouched) if the rows don't match the cluster count
+		// or refer to data outside of the data buffer
+		bool SetCompressedClusterVisibility(std::vector<ClusterVisibilityRow> &&rows,std::vector<uint16_t> &&data);
+		const std::vector<ClusterVisibilityRow> &GetClusterVisibilityRows() const;
+		const std::vector<uint16_t> &GetClusterVisibilityData() const;
 		uint64_t GetClusterCount() const;
 		void SetClusterCount(uint64_t numClusters);
 		Node *FindLeafNode(const Vector3 &pos);
 		std::vector<Node*> FindLeafNodesInAabb(const Vector3 &min,const Vector3 &max);
+		// Appends the leaf nodes to outNodes, which allows re-using the vector between queries
+		void FindLeafNodesInAabb(const Vector3 &min,const Vector3 &max,std::vector<Node*> &outNodes);
 		bool IsAabbVisibleInCluster(const Vector3 &min,const Vector3 &max,ClusterIndex clusterIdx) const;
+		// Updates the visible bounds of all leaves. Runs in linear time in the number of nodes and visible cluster pairs.
 		void UpdateVisibilityBounds();
 
 		bool Save(udm::AssetDataArg outData,std::string &outErr);
 		Node &CreateNode();
 	protected:
 		BSPTree()=default;
-		void UpdateVisibilityBounds(BSPTree::Node &node);
+		bool IsDenseClusterVisibilityRow(const ClusterVisibilityRow &row) const;
+		uint32_t GetDenseClusterVisibilityRowSize() const;
+		bool IsClusterVisibilityValid(const std::vector<ClusterVisibilityRow> &rows,const std::vector<uint16_t> &data) const;
 		BSPTree::Node *FindLeafNode(BSPTree::Node &node,const Vector3 &point);
 		void FindLeafNodesInAabb(BSPTree::Node &node,const std::array<Vector3,8> &aabbPoints,std::vector<BSPTree::Node*> &outNodes);
 		bool IsAabbVisibleInCluster(const BSPTree::Node &node,const std::array<Vector3,8> &aabbPoints,BSPTree::ClusterIndex clusterIdx) const;
 		ChildIndex m_rootNode = std::numeric_limits<ChildIndex>::max();
 		std::vector<Node> m_nodes = {};
 		std::vector<uint8_t> m_clusterVisibility = {};
+		std::vector<ClusterVisibilityRow> m_clusterVisibilityRows = {};
+		std::vector<uint16_t> m_clusterVisibilityData = {};
 		uint64_t m_clusterCount = 0ull;
 		friend Node;
 	};
 #pragma pack(pop)
 };
 
+template<class TFunc>
+	void util::BSPTree::IterateVisibleClusters(ClusterIndex clusterSrc,const TFunc &func) const
+{
+	if(IsClusterVisibilityCompressed() == false)
+	{
+		for(auto clusterDst=decltype(m_clusterCount){0u};clusterDst<m_clusterCount;++clusterDst)
+		{
+			if(IsClusterVisible(clusterSrc,clusterDst))
+				func(static_cast<ClusterIndex>(clusterDst));
+		}
+		return;
+	}
+	if(clusterSrc >= m_clusterVisibilityRows.size())
+		return;
+	auto &row = m_clusterVisibilityRows[clusterSrc];
+	auto *data = m_clusterVisibilityData.data() +row.offset;
+	if(IsDenseClusterVisibilityRow(row) == false)
+	{
+		for(auto i=decltype(row.count){0u};i<row.count;++i)
+			func(static_cast<ClusterIndex>(data[i]));
+		return;
+	}
+	auto numWords = GetDenseClusterVisibilityRowSize();
+	for(auto i=decltype(numWords){0u};i<numWords;++i)
+	{
+		auto word = data[i];
+		while(word != 0)
+		{
+			auto bit = 0u;
+			while((word &(1u<<bit)) == 0)
+				++bit;
+			word &= ~(1u<<bit);
+			func(static_cast<ClusterIndex>(i *16u +bit));
+		}
+	}
+}
+
 #endif
@@ -7,6 +7,8 @@
 
 #include "stdafx_shared.h"
 #include "pragma/entities/components/base_ai_component.hpp"
+#include "pragma/networkstate/networkstate.h"
+#include <pragma/game/game.h>
 #include "pragma/entities/components/base_character_component.hpp"
 #include "pragma/ai/ai_definitions.h"
 #include "pragma/entities/components/base_transform_component.hpp"
@@ -61,31 +63,21 @@ void BaseAIComponent::UpdatePath()
 	auto charComponent = GetEntity().GetCharacterComponent();
 	if((charComponent.valid() && charComponent->CanMove() == false) || m_moveInfo.moveOnPath == false)
 		return;
-	if(m_navInfo.queuedPath != nullptr)
+	if(m_navInfo.queuedPath != nullptr && m_navInfo.queuedPath->IsDone())
 	{
-		if(s_navThread == nullptr)
-			m_navInfo.queuedPath = nullptr;
+		// The path has been resolved by the path service of the nav mesh (see Game::Tick)
+		if(m_navInfo.queuedPath->GetState() == nav::PathRequest::State::Complete)
+		{
+			m_navInfo.pathInfo = std::make_shared<ai::navigation::PathInfo>(m_navInfo.queuedPath->GetResult());
+			m_navInfo.pathState = PathResult::Success;
+		}
 		else
 		{
-			auto bPathChanged = false;
-			if(m_navInfo.queuedPath->complete == true)
-			{
-				if(m_navInfo.queuedPath->pathInfo != nullptr)
-				{
-					m_navInfo.pathInfo = m_navInfo.queuedPath->pathInfo;
-					m_navInfo.pathState = PathResult::Success;
-				}
-				else
-				{
-					//Con::cerr<<"Failed to generate path!"<<Con::endl;
-					m_navInfo.pathState = PathResult::Failed;
-				}
-				m_navInfo.queuedPath = nullptr;
-				bPathChanged = true;
-			}
-			if(bPathChanged == true)
-				OnPathChanged();
+			//Con::cerr<<"Failed to generate path!"<<Con::endl;
+			m_navInfo.pathState = PathResult::Failed;
 		}
+		m_navInfo.queuedPath = nullptr;
+		OnPathChanged();
 	}
 	auto bPathUpdateRequired = (m_navInfo.pathInfo == nullptr || m_navInfo.bPathUpdateRequired == true) ? true : false;
 	if(bPathUpdateRequired == false)
@@ -121,13 +113,12 @@ void BaseAIComponent::ResetPath()
 	m_navInfo.bPathUpdateRequired = true;
 	m_navInfo.bTargetReached = false;
 	m_navInfo.pathState = PathResult::Updating;
-	if(s_navThread != nullptr)
-	{
-		m_navInfo.queuedPath = std::make_shared<ai::navigation::PathQuery>(pTrComponent->GetPosition(),GetMoveTarget());
-		s_navThread->pendingQueueMutex.lock();
-			s_navThread->pendingQueue.push(m_navInfo.queuedPath);
-		s_navThread->pendingQueueMutex.unlock();
-	}
+	if(m_navInfo.queuedPath != nullptr)
+		m_navInfo.queuedPath->Cancel(); // Previous request is obsolete
+	m_navInfo.queuedPath = nullptr;
+	auto &navMesh = ent.GetNetworkState()->GetGameState()->GetNavMesh();
+	if(navMesh != nullptr)
+		m_navInfo.queuedPath = navMesh->GetPathService().RequestPath(pTrComponent->GetPosition(),GetMoveTarget());
 }
 
 const Vector3 &BaseAIComponent::GetMoveTarget() const {return m_moveInfo.moveTarget;}
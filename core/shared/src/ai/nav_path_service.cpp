@@ -0,0 +1,253 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright (c) 2021 Silverlan */
+
+#include "stdafx_shared.h"
+#include "pragma/ai/nav_path_service.hpp"
+#include "pragma/ai/navsystem.h"
+#include "DetourNavMesh.h"
+#include "DetourNavMeshQuery.h"
+#include <mathutil/umath.h>
+#include <algorithm>
+
+using namespace pragma::nav;
+
+PathRequest::PathRequest(const Vector3 &start,const Vector3 &end)
+	: m_start{start},m_end{end}
+{}
+PathRequest::State PathRequest::GetState() const {return m_state;}
+bool PathRequest::IsDone() const {return m_state != State::Pending;}
+const std::shared_ptr<RcPathResult> &PathRequest::GetResult() const {return m_result;}
+const Vector3 &PathRequest::GetStart() const {return m_start;}
+const Vector3 &PathRequest::GetEnd() const {return m_end;}
+void PathRequest::Cancel()
+{
+	if(m_state == State::Pending)
+		m_state = State::Cancelled;
+}
+
+//////////////////
+
+PathService::PathService(Mesh &mesh)
+	: m_mesh{mesh},m_filter{std::make_unique<dtQueryFilter>()}
+{}
+PathService::~PathService()
+{
+	for(auto &request : m_pendingRequests)
+		request->Cancel();
+	if(m_activeRequest)
+		m_activeRequest->Cancel();
+	ReleaseQuery();
+}
+
+std::shared_ptr<PathRequest> PathService::RequestPath(const Vector3 &start,const Vector3 &end)
+{
+	auto request = std::make_shared<PathRequest>(start,end);
+	m_pendingRequests.push_back(request);
+	return request;
+}
+void PathService::RequestPaths(const std::vector<std::pair<Vector3,Vector3>> &startEndPairs,std::vector<std::shared_ptr<PathRequest>> &outRequests)
+{
+	outRequests.clear();
+	outRequests.reserve(startEndPairs.size());
+	for(auto &pair : startEndPairs)
+		outRequests.push_back(RequestPath(pair.first,pair.second));
+}
+
+void PathService::SetMaxCacheSize(uint32_t size)
+{
+	m_maxCacheSize = size;
+	if(m_cache.size() > size)
+		ClearCache();
+}
+uint32_t PathService::GetMaxCacheSize() const {return m_maxCacheSize;}
+void PathService::ClearCache() {m_cache.clear();}
+uint32_t PathService::GetPendingRequestCount() const {return static_cast<uint32_t>(m_pendingRequests.size()) +((m_activeRequest != nullptr) ? 1 : 0);}
+
+uint64_t PathService::GetCacheKey(uint32_t startRef,uint32_t endRef) {return (static_cast<uint64_t>(startRef)<<32u) | endRef;}
+
+bool PathService::PrepareQuery()
+{
+	auto &rcMesh = m_mesh.GetRcNavMesh();
+	if(rcMesh == nullptr)
+		return false;
+	auto *navMesh = &rcMesh->GetNavMesh();
+	if(m_cacheNavMesh != navMesh)
+	{
+		// The polygon references of the cached paths are only valid for the nav mesh they were generated for
+		ClearCache();
+		m_cacheNavMesh = navMesh;
+	}
+	if(m_query && m_query->getAttachedNavMesh() != navMesh)
+	{
+		if(m_activeRequest)
+		{
+			// Restart the search on the new nav mesh
+			m_pendingRequests.push_front(m_activeRequest);
+			m_activeRequest = nullptr;
+		}
+		ReleaseQuery();
+	}
+	if(m_query == nullptr)
+		m_query = m_mesh.AcquireQuery();
+	if(m_query == nullptr)
+		return false;
+	auto &queryConfig = m_mesh.GetQueryConfig();
+	m_filter->setIncludeFlags(umath::to_integral(queryConfig.includeFlags));
+	m_filter->setExcludeFlags(umath::to_integral(queryConfig.excludeFlags));
+	return true;
+}
+void PathService::ReleaseQuery()
+{
+	if(m_query == nullptr)
+		return;
+	m_mesh.ReleaseQuery(std::move(m_query));
+	m_query = nullptr;
+}
+
+void PathService::AddToCache(uint64_t key,const uint32_t *path,uint32_t pathCount)
+{
+	if(m_maxCacheSize == 0)
+		return;
+	if(m_cache.size() >= m_maxCacheSize && m_cache.find(key) == m_cache.end())
+	{
+		// Evict the least recently used path
+		auto itOldest = std::min_element(m_cache.begin(),m_cache.end(),[](const auto &a,const auto &b) {
+			return a.second.lastUsed < b.second.lastUsed;
+		});
+		m_cache.erase(itOldest);
+	}
+	auto &entry = m_cache[key];
+	entry.path.assign(path,path +pathCount);
+	entry.lastUsed = ++m_cacheClock;
+}
+
+void PathService::CompleteRequest(PathRequest &request,const uint32_t *path,uint32_t pathCount)
+{
+	auto resultQuery = m_mesh.GetPathResultQuery();
+	if(resultQuery == nullptr || pathCount == 0)
+	{
+		request.m_state = PathRequest::State::Failed;
+		return;
+	}
+	auto r = std::make_shared<RcPathResult>(*m_mesh.GetRcNavMesh(),resultQuery,request.m_startPoint,request.m_endPoint,pathCount);
+	std::copy(path,path +pathCount,r->path.begin());
+	r->pathCount = pathCount +2;
+	request.m_result = r;
+	request.m_state = PathRequest::State::Complete;
+}
+
+bool PathService::StartNextRequest()
+{
+	while(m_pendingRequests.empty() == false)
+	{
+		auto request = m_pendingRequests.front();
+		m_pendingRequests.pop_front();
+		if(request->m_state != PathRequest::State::Pending)
+			continue; // Cancelled
+
+		dtPolyRef startRef,endRef;
+		if(
+			m_mesh.FindNearestPoly(*m_query,request->m_start,startRef,&request->m_startPoint) == false || startRef == 0 ||
+			m_mesh.FindNearestPoly(*m_query,request->m_end,endRef,&request->m_endPoint) == false || endRef == 0
+		)
+		{
+			request->m_state = PathRequest::State::Failed;
+			return true;
+		}
+
+		auto key = GetCacheKey(startRef,endRef);
+		auto it = m_cache.find(key);
+		if(it != m_cache.end())
+		{
+			it->second.lastUsed = ++m_cacheClock;
+			CompleteRequest(*request,it->second.path.data(),static_cast<uint32_t>(it->second.path.size()));
+			return true;
+		}
+
+		auto status = m_query->initSlicedFindPath(startRef,endRef,&request->m_startPoint[0],&request->m_endPoint[0],m_filter.get());
+		if(dtStatusFailed(status))
+		{
+			request->m_state = PathRequest::State::Failed;
+			return true;
+		}
+		m_activeRequest = request;
+		m_activeCacheKey = key;
+		return true;
+	}
+	return false;
+}
+
+void PathService::FinalizeActiveRequest()
+{
+	auto request = m_activeRequest;
+	m_activeRequest = nullptr;
+	auto maxPath = static_cast<int32_t>(m_mesh.GetQueryConfig().maxPathLength);
+	std::vector<dtPolyRef> path;
+	path.resize(maxPath);
+	int32_t pathCount = 0;
+	auto status = m_query->finalizeSlicedFindPath(path.data(),&pathCount,maxPath);
+	if(dtStatusFailed(status))
+	{
+		request->m_state = PathRequest::State::Failed;
+		return;
+	}
+	// Partial paths (e.g. if the goal is unreachable) are still returned, but aren't cached, since they
+	// may depend on the search limits
+	if(dtStatusDetail(status,DT_PARTIAL_RESULT) == false)
+		AddToCache(m_activeCacheKey,path.data(),pathCount);
+	CompleteRequest(*request,path.data(),pathCount);
+}
+
+void PathService::Update(uint32_t iterationBudget)
+{
+	if(m_pendingRequests.empty() && m_activeRequest == nullptr)
+	{
+		ReleaseQuery(); // Give the query object back to the pool while we're idle
+		return;
+	}
+	if(PrepareQuery() == false)
+	{
+		for(auto &request : m_pendingRequests)
+		{
+			if(request->m_state == PathRequest::State::Pending)
+				request->m_state = PathRequest::State::Failed;
+		}
+		m_pendingRequests.clear();
+		if(m_activeRequest)
+			m_activeRequest->m_state = PathRequest::State::Failed;
+		m_activeRequest = nullptr;
+		return;
+	}
+
+	auto remaining = static_cast<int32_t>(umath::min(iterationBudget,static_cast<uint32_t>(std::numeric_limits<int32_t>::max())));
+	while(remaining > 0)
+	{
+		if(m_activeRequest == nullptr)
+		{
+			if(StartNextRequest() == false)
+				break;
+			--remaining; // Looking up the start and end polygons isn't free either
+			continue;
+		}
+		if(m_activeRequest->m_state != PathRequest::State::Pending)
+		{
+			m_activeRequest = nullptr; // Cancelled while in progress
+			continue;
+		}
+		int32_t numIterations = 0;
+		auto status = m_query->updateSlicedFindPath(remaining,&numIterations);
+		remaining -= umath::max(numIterations,1);
+		if(dtStatusInProgress(status))
+			continue;
+		if(dtStatusFailed(status))
+		{
+			m_activeRequest->m_state = PathRequest::State::Failed;
+			m_activeRequest = nullptr;
+			continue;
+		}
+		FinalizeActiveRequest();
+	}
+}
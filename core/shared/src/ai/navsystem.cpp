@@ -13,6 +13,8 @@
 #include "pragma/model/brush/brushmesh.h"
 #include "pragma/model/side.h"
 #include "pragma/ai/navsystem.h"
+#include "pragma/ai/nav_path_service.hpp"
+#include "pragma/console/engine_cvar.h"
 #include "Recast.h"
 #include "DetourNavMesh.h"
 #include "DetourNavMeshBuilder.h"
@@ -25,7 +27,11 @@
 #include "pragma/model/model.h"
 #include "pragma/util/util_game.hpp"
 #include <sharedutils/scope_guard.h>
+#include "pragma/util/job_system.hpp"
 #include <udm.hpp>
+#include <atomic>
+
+extern DLLNETWORK Engine *engine;
 
 RcNavMesh::RcNavMesh(
 	const std::shared_ptr<rcPolyMesh> &polyMesh,
@@ -886,7 +892,25 @@ std::shared_ptr<pragma::nav::Mesh> pragma::nav::Mesh::Load(Game &game,const std:
 pragma::nav::Mesh::Mesh(const std::shared_ptr<RcNavMesh> &rcMesh,const Config &config)
 	: m_rcMesh(rcMesh),m_config(config)
 {}
+pragma::nav::Mesh::~Mesh()
+{
+	m_pathService = nullptr;
+	ClearQueryPool();
+}
 const pragma::nav::Config &pragma::nav::Mesh::GetConfig() const {return m_config;}
+void pragma::nav::Mesh::SetQueryConfig(const QueryConfig &queryConfig)
+{
+	m_queryConfig = queryConfig;
+	if(m_pathService)
+		m_pathService->ClearCache(); // Cached paths may not be valid for the new filter
+}
+const pragma::nav::QueryConfig &pragma::nav::Mesh::GetQueryConfig() const {return m_queryConfig;}
+pragma::nav::PathService &pragma::nav::Mesh::GetPathService()
+{
+	if(m_pathService == nullptr)
+		m_pathService = std::make_unique<PathService>(*this);
+	return *m_pathService;
+}
 const std::shared_ptr<RcNavMesh> &pragma::nav::Mesh::GetRcNavMesh() const {return const_cast<Mesh*>(this)->GetRcNavMesh();}
 std::shared_ptr<RcNavMesh> &pragma::nav::Mesh::GetRcNavMesh() {return m_rcMesh;}
 
@@ -1138,103 +1162,141 @@ std::shared_ptr<RcNavMesh> pragma::nav::load(Game &game,const std::string &fname
 	return mesh.GetRcNavMesh();
 }
 
-bool pragma::nav::Mesh::FindNearestPoly(const Vector3 &pos,dtPolyRef &ref)
+void pragma::nav::Mesh::QueryDeleter::operator()(dtNavMeshQuery *query) const {dtFreeNavMeshQuery(query);}
+
+pragma::nav::Mesh::QueryPtr pragma::nav::Mesh::AcquireQuery()
 {
 	if(m_rcMesh == nullptr)
-		return false;
-	auto &mesh = *m_rcMesh;
-	auto navQuery = std::unique_ptr<dtNavMeshQuery,decltype(&dtFreeNavMeshQuery)>(dtAllocNavMeshQuery(),dtFreeNavMeshQuery);
-	auto status = navQuery->init(&mesh.GetNavMesh(),2048); // TODO
-	if(dtStatusFailed(status))
-		return false;
-	const Vector3 extents(256.f,256.f,256.f); // TODO
+		return nullptr;
+	auto *navMesh = &m_rcMesh->GetNavMesh();
+	QueryPtr query = nullptr;
+	m_queryPoolMutex.lock();
+		if(m_queryPool.empty() == false)
+		{
+			query = std::move(m_queryPool.back());
+			m_queryPool.pop_back();
+		}
+	m_queryPoolMutex.unlock();
+	if(query == nullptr)
+	{
+		query = QueryPtr{dtAllocNavMeshQuery()};
+		if(query == nullptr)
+			return nullptr;
+	}
+	// The query only has to be re-initialized if the nav mesh has changed or the node pool is too small
+	auto maxNodes = static_cast<int32_t>(m_queryConfig.maxNodes);
+	if(query->getAttachedNavMesh() != navMesh || query->getNodePool() == nullptr || query->getNodePool()->getMaxNodes() < maxNodes)
+	{
+		auto status = query->init(navMesh,maxNodes);
+		if(dtStatusFailed(status))
+			return nullptr;
+	}
+	return query;
+}
+void pragma::nav::Mesh::ReleaseQuery(QueryPtr query)
+{
+	if(query == nullptr)
+		return;
+	std::scoped_lock lock {m_queryPoolMutex};
+	m_queryPool.push_back(std::move(query));
+}
+void pragma::nav::Mesh::ClearQueryPool()
+{
+	std::scoped_lock lock {m_queryPoolMutex};
+	m_queryPool.clear();
+	m_pathResultQuery = nullptr;
+}
+
+std::shared_ptr<dtNavMeshQuery> pragma::nav::Mesh::GetPathResultQuery()
+{
+	std::scoped_lock lock {m_queryPoolMutex};
+	auto *navMesh = &m_rcMesh->GetNavMesh();
+	if(m_pathResultQuery != nullptr && m_pathResultQuery->getAttachedNavMesh() == navMesh)
+		return m_pathResultQuery;
+	// Path results only need the query for polygon lookups, which don't use the node pool
+	m_pathResultQuery = std::shared_ptr<dtNavMeshQuery>(dtAllocNavMeshQuery(),[](dtNavMeshQuery *navQuery) {
+		dtFreeNavMeshQuery(navQuery);
+	});
+	if(m_pathResultQuery != nullptr && dtStatusFailed(m_pathResultQuery->init(navMesh,8)))
+		m_pathResultQuery = nullptr;
+	return m_pathResultQuery;
+}
+
+static dtQueryFilter get_query_filter(const pragma::nav::QueryConfig &queryConfig)
+{
 	dtQueryFilter filter;
-	filter.setIncludeFlags(0xFFFF); // TODO
-	filter.setExcludeFlags(0); // TODO
+	filter.setIncludeFlags(umath::to_integral(queryConfig.includeFlags));
+	filter.setExcludeFlags(umath::to_integral(queryConfig.excludeFlags));
+	return filter;
+}
+
+bool pragma::nav::Mesh::FindNearestPoly(dtNavMeshQuery &query,const Vector3 &pos,dtPolyRef &ref,Vector3 *optOutNearestPoint) const
+{
+	auto filter = get_query_filter(m_queryConfig);
 	Vector3 nearestPoint {};
-	status = navQuery->findNearestPoly(&pos[0],&extents[0],&filter,&ref,&nearestPoint[0]);
+	auto status = query.findNearestPoly(&pos[0],&m_queryConfig.extents[0],&filter,&ref,&nearestPoint[0]);
 	if(dtStatusFailed(status))
 		return false;
+	if(optOutNearestPoint)
+		*optOutNearestPoint = nearestPoint;
 	return true;
 }
 
-bool pragma::nav::Mesh::RayCast(const Vector3 &start,const Vector3 &end,Vector3 &hit)
+bool pragma::nav::Mesh::FindNearestPoly(const Vector3 &pos,dtPolyRef &ref)
 {
-	if(m_rcMesh == nullptr)
+	auto query = AcquireQuery();
+	if(query == nullptr)
 		return false;
-	auto &mesh = *m_rcMesh;
-	auto navQuery = std::unique_ptr<dtNavMeshQuery,decltype(&dtFreeNavMeshQuery)>(dtAllocNavMeshQuery(),dtFreeNavMeshQuery);
-	auto status = navQuery->init(&mesh.GetNavMesh(),2048); // TODO
-	if(dtStatusFailed(status))
+	auto r = FindNearestPoly(*query,pos,ref);
+	ReleaseQuery(std::move(query));
+	return r;
+}
+
+bool pragma::nav::Mesh::RayCast(const Vector3 &start,const Vector3 &end,Vector3 &hit)
+{
+	auto query = AcquireQuery();
+	if(query == nullptr)
 		return false;
+	util::ScopeGuard sgQuery {[this,&query]() {ReleaseQuery(std::move(query));}};
 	dtPolyRef startRef;
 	dtPolyRef endRef;
-	if(FindNearestPoly(start,startRef) == false || FindNearestPoly(end,endRef) == false)
+	if(FindNearestPoly(*query,start,startRef) == false || FindNearestPoly(*query,end,endRef) == false)
 		return false;
-	const Vector3 extents(256.f,256.f,256.f); // TODO
-	dtQueryFilter filter;
-	filter.setIncludeFlags(0xFFFF); // TODO
-	filter.setExcludeFlags(0); // TODO
-
-	static std::unique_ptr<dtRaycastHit> rayHit = nullptr;
-	static std::array<dtPolyRef,2048> hitRefs;
-	if(rayHit == nullptr)
-	{
-		rayHit = std::make_unique<dtRaycastHit>();
-		rayHit->pathCount = static_cast<int32_t>(hitRefs.size());
-		rayHit->path = hitRefs.data();
-	}
-
-	status = navQuery->raycast(startRef,&start[0],&end[0],&filter,0,rayHit.get());
-	if(dtStatusFailed(status) || rayHit->t == 0.f)
+	auto filter = get_query_filter(m_queryConfig);
+
+	// We're not interested in the visited polygons, so no path buffer is required
+	dtRaycastHit rayHit {};
+	rayHit.path = nullptr;
+	rayHit.maxPath = 0;
+	auto status = query->raycast(startRef,&start[0],&end[0],&filter,0,&rayHit);
+	if(dtStatusFailed(status) || rayHit.t == 0.f)
 		return false;
-	if(rayHit->t > 1.f)
+	if(rayHit.t > 1.f)
 		hit = end;
 	else
-		hit = start +(end -start) *rayHit->t;
+		hit = start +(end -start) *rayHit.t;
 	return true;
 }
 
-std::shared_ptr<RcPathResult> pragma::nav::Mesh::FindPath(const Vector3 &start,const Vector3 &end)
+std::shared_ptr<RcPathResult> pragma::nav::Mesh::FindPath(dtNavMeshQuery &query,const Vector3 &start,const Vector3 &end)
 {
-	if(m_rcMesh == nullptr)
-		return nullptr;
 	auto &mesh = *m_rcMesh;
-	auto navQuery = std::shared_ptr<dtNavMeshQuery>(dtAllocNavMeshQuery(),[](dtNavMeshQuery *navQuery) {
-		dtFreeNavMeshQuery(navQuery);
-	});
-	auto status = navQuery->init(&mesh.GetNavMesh(),2048); // TODO
-	if(dtStatusFailed(status))
-	{
-		//Con::cerr<<"FAILED #1: "<<start.x<<","<<start.y<<","<<start.z<<" => "<<end.x<<","<<end.y<<","<<end.z<<Con::endl;
-		return nullptr;
-	}
-	const Vector3 extents(256.f,256.f,256.f); // TODO
-	dtQueryFilter filter;
-	filter.setIncludeFlags(0xFFFF); // TODO
-	filter.setExcludeFlags(0); // TODO
+	auto filter = get_query_filter(m_queryConfig);
 	dtPolyRef startRef;
 	Vector3 startPoint;
-	auto statusStart = navQuery->findNearestPoly(
-		&start[0],&extents[0],
-		&filter,&startRef,
-		&startPoint[0]
-	);
-	if(dtStatusFailed(statusStart) == false && startRef != 0)
+	if(FindNearestPoly(query,start,startRef,&startPoint) && startRef != 0)
 	{
 		dtPolyRef endRef;
 		Vector3 endPoint;
-		auto statusEnd = navQuery->findNearestPoly(
-			&end[0],&extents[0],
-			&filter,&endRef,
-			&endPoint[0]
-		);
-		if(!dtStatusFailed(statusEnd) && endRef != 0)
+		if(FindNearestPoly(query,end,endRef,&endPoint) && endRef != 0)
 		{
-			int maxPath = 128; // TODO
-			auto r = std::make_shared<RcPathResult>(mesh,navQuery,startPoint,endPoint,maxPath); // TODO
+			auto maxPath = static_cast<int32_t>(m_queryConfig.maxPathLength);
+			auto resultQuery = GetPathResultQuery();
+			if(resultQuery == nullptr)
+				return nullptr;
+			auto r = std::make_shared<RcPathResult>(mesh,resultQuery,startPoint,endPoint,maxPath);
 			int32_t pathCount = 0;
-			auto findStatus = navQuery->findPath(
+			auto findStatus = query.findPath(
 				startRef,endRef,
 				&startPoint[0],&endPoint[0],
 				&filter,&r->path[0],
@@ -1248,6 +1310,53 @@ std::shared_ptr<RcPathResult> pragma::nav::Mesh::FindPath(const Vector3 &start,c
 	return nullptr;
 }
 
+std::shared_ptr<RcPathResult> pragma::nav::Mesh::FindPath(const Vector3 &start,const Vector3 &end)
+{
+	auto query = AcquireQuery();
+	if(query == nullptr)
+		return nullptr;
+	auto r = FindPath(*query,start,end);
+	ReleaseQuery(std::move(query));
+	return r;
+}
+
+void pragma::nav::Mesh::FindPaths(const std::vector<std::pair<Vector3,Vector3>> &startEndPairs,std::vector<std::shared_ptr<RcPathResult>> &outResults)
+{
+	outResults.clear();
+	outResults.resize(startEndPairs.size(),nullptr);
+	auto numQueries = static_cast<uint32_t>(startEndPairs.size());
+	if(numQueries == 0 || m_rcMesh == nullptr)
+		return;
+	// Every worker uses a single query object for all of the paths it resolves
+	std::atomic<uint32_t> nextQuery = 0;
+	auto worker = [this,&startEndPairs,&outResults,&nextQuery,numQueries]() {
+		auto query = AcquireQuery();
+		if(query == nullptr)
+			return;
+		for(;;)
+		{
+			auto idx = nextQuery.fetch_add(1);
+			if(idx >= numQueries)
+				break;
+			auto &pair = startEndPairs[idx];
+			outResults[idx] = FindPath(*query,pair.first,pair.second);
+		}
+		ReleaseQuery(std::move(query));
+	};
+	auto &jobSystem = engine->GetJobSystem();
+	if(jobSystem.GetWorkerCount() == 0 || numQueries < 2)
+	{
+		worker();
+		return;
+	}
+	auto numJobs = umath::min(jobSystem.GetWorkerCount(),numQueries -1);
+	pragma::JobCounter counter {};
+	for(auto i=decltype(numJobs){0u};i<numJobs;++i)
+		jobSystem.Schedule(worker,&counter);
+	worker();
+	jobSystem.Wait(counter);
+}
+
 ////////////////////////////////////
 
 RcPathResult::RcPathResult(RcNavMesh &pNavMesh,const std::shared_ptr<dtNavMeshQuery> &pQuery,Vector3 &pStart,Vector3 &pEnd,unsigned int numResults)
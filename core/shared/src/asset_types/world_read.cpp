@@ -55,8 +55,8 @@ bool pragma::asset::WorldData::Read(VFilePtr &f,EntityData::Flags entMask,std::s
 	auto headerData = f->Read<HeaderData>();
 
 	auto materials = ReadMaterials(f);
-	if(umath::is_flag_set(headerData.flags,DataFlags::HasBSPTree))
-		ReadBSPTree(f,version);
+	if(umath::is_flag_set(headerData.flags,DataFlags::HasBSPTree) && ReadBSPTree(f,version,errMsg) == false)
+		return false;
 	if(umath::is_flag_set(headerData.flags,DataFlags::HasLightmapAtlas))
 	{
 		m_lightMapIntensity = f->Read<float>();
@@ -79,7 +79,7 @@ std::vector<msys::MaterialHandle> pragma::asset::WorldData::ReadMaterials(VFileP
 	}
 	return materials;
 }
-void pragma::asset::WorldData::ReadBSPTree(VFilePtr &f,uint32_t version)
+bool pragma::asset::WorldData::ReadBSPTree(VFilePtr &f,uint32_t version,std::string *errMsg)
 {
 	m_bspTree = util::BSPTree::Create();
 	auto &nodes = m_bspTree->GetNodes();
@@ -114,18 +114,37 @@ void pragma::asset::WorldData::ReadBSPTree(VFilePtr &f,uint32_t version)
 	fReadNode(m_bspTree->GetRootNode());
 
 	auto numClusters = f->Read<uint64_t>();
-	auto numCompressedClusters = umath::pow2(numClusters);
-	numCompressedClusters = numCompressedClusters /8u +((numCompressedClusters %8u) > 0u ? 1u : 0u);
-	auto &compressedClusterData = m_bspTree->GetClusterVisibility();
-	compressedClusterData.resize(numCompressedClusters);
-	f->Read(compressedClusterData.data(),compressedClusterData.size() *sizeof(compressedClusterData.front()));
 	m_bspTree->SetClusterCount(numClusters);
+	if(version <= 12)
+	{
+		auto numCompressedClusters = umath::pow2(numClusters);
+		numCompressedClusters = numCompressedClusters /8u +((numCompressedClusters %8u) > 0u ? 1u : 0u);
+		auto &clusterVisibility = m_bspTree->GetClusterVisibility();
+		clusterVisibility.resize(numCompressedClusters);
+		f->Read(clusterVisibility.data(),clusterVisibility.size() *sizeof(clusterVisibility.front()));
+		m_bspTree->CompressClusterVisibility();
+	}
+	else
+	{
+		std::vector<util::BSPTree::ClusterVisibilityRow> rows;
+		rows.resize(numClusters);
+		f->Read(rows.data(),rows.size() *sizeof(rows.front()));
+		std::vector<uint16_t> data;
+		data.resize(f->Read<uint64_t>());
+		f->Read(data.data(),data.size() *sizeof(data.front()));
+		if(m_bspTree->SetCompressedClusterVisibility(std::move(rows),std::move(data)) == false)
+		{
+			if(errMsg)
+				*errMsg = "Invalid cluster visibility data!";
+			return false;
+		}
+	}
 
 	if(version <= 11)
-		return;
+		return true;
 	auto hasClusterMeshList = f->Read<bool>();
 	if(hasClusterMeshList == false)
-		return;
+		return true;
 	m_meshesPerCluster.resize(numClusters);
 	for(auto i=decltype(numClusters){0u};i<numClusters;++i)
 	{
@@ -134,6 +153,7 @@ void pragma::asset::WorldData::ReadBSPTree(VFilePtr &f,uint32_t version)
 		meshIndices.resize(n);
 		f->Read(meshIndices.data(),meshIndices.size() *sizeof(meshIndices.front()));
 	}
+	return true;
 }
 void pragma::asset::WorldData::ReadEntities(VFilePtr &f,const std::vector<msys::MaterialHandle> &materials,EntityData::Flags entMask)
 {
@@ -63,44 +63,6 @@ bool pragma::asset::WorldData::Write(const std::string &fileName,std::string *op
 	return true;
 }
 
-static void preprocess_bsp_data(util::BSPTree &bspTree,std::vector<std::vector<size_t>> &outClusterNodes,std::vector<std::vector<uint16_t>> &outClusterToClusterVisibility)
-{
-	auto numClusters = bspTree.GetClusterCount();
-	auto &bspNodes = bspTree.GetNodes();
-
-	// Pre-processing to speed up some calculations
-	{
-		// Nodes per cluster
-		outClusterNodes.resize(numClusters);
-		for(auto i=decltype(bspNodes.size()){0u};i<bspNodes.size();++i)
-		{
-			auto &bspNode = bspNodes.at(i);
-			if(bspNode.cluster >= outClusterNodes.size())
-				continue;
-			auto &nodeList = outClusterNodes.at(bspNode.cluster);
-			if(nodeList.size() == nodeList.capacity())
-				nodeList.reserve(nodeList.size() *1.5f +100);
-			nodeList.push_back(i);
-		}
-
-		// List of clusters visible from every other cluster
-		outClusterToClusterVisibility.resize(numClusters);
-		for(auto cluster0=decltype(numClusters){0u};cluster0<numClusters;++cluster0)
-		{
-			auto &visibleClusters = outClusterToClusterVisibility.at(cluster0);
-			for(auto cluster1=decltype(numClusters){0u};cluster1<numClusters;++cluster1)
-			{
-				if(bspTree.IsClusterVisible(cluster0,cluster1) == false)
-					continue;
-				if(visibleClusters.size() == visibleClusters.capacity())
-					visibleClusters.reserve(visibleClusters.size() *1.5f +50);
-				visibleClusters.push_back(cluster1);
-			}
-		}
-	}
-	//
-}
-
 bool pragma::asset::WorldData::LoadFromAssetData(const udm::AssetData &data,EntityData::Flags entMask,std::string &outErr)
 {
 	if(data.GetAssetType() != PMAP_IDENTIFIER)
@@ -295,10 +257,6 @@ bool pragma::asset::WorldData::Save(udm::AssetDataArg outData,const std::string
 		if(bspTree.Save(udm::AssetData{udmBsp["tree"]},outErr) == false)
 			return false;
 
-		std::vector<std::vector<size_t>> clusterNodes;
-		std::vector<std::vector<uint16_t>> clusterToClusterVisibility;
-		preprocess_bsp_data(bspTree,clusterNodes,clusterToClusterVisibility);
-
 		auto &clusterMeshIndices = GetClusterMeshIndices();
 		if(clusterMeshIndices.empty() == false)
 		{
@@ -344,7 +302,7 @@ void pragma::asset::WorldData::Write(VFilePtrReal &f)
 	f->Write(header.data(),header.size());
 
 	f->Write<uint32_t>(WLD_VERSION);
-	static_assert(WLD_VERSION == 12);
+	static_assert(WLD_VERSION == 13);
 	auto offsetToDataFlags = f->Tell();
 	f->Write<DataFlags>(DataFlags::None);
 	auto offsetMaterials = f->Tell();
@@ -432,15 +390,14 @@ void pragma::asset::WorldData::WriteMaterials(VFilePtrReal &f)
 void pragma::asset::WorldData::WriteBSPTree(VFilePtrReal &f)
 {
 	auto &bspTree = *m_bspTree;
-	std::vector<std::vector<size_t>> clusterNodes;
-	std::vector<std::vector<uint16_t>> clusterToClusterVisibility;
-	preprocess_bsp_data(bspTree,clusterNodes,clusterToClusterVisibility);
-	
+	if(bspTree.IsClusterVisibilityCompressed() == false)
+		bspTree.CompressClusterVisibility();
+	// Calculate AABBs encompassing all nodes visible by each leaf
+	bspTree.UpdateVisibilityBounds();
+
 	auto &bspNodes = bspTree.GetNodes();
-	auto numClusters = bspTree.GetClusterCount();
-	auto &clusterVisibility = bspTree.GetClusterVisibility();
 	std::function<void(const util::BSPTree::Node&)> fWriteNode = nullptr;
-	fWriteNode = [&f,&fWriteNode,&clusterVisibility,&clusterToClusterVisibility,&bspNodes,&clusterNodes,&bspTree,numClusters](const util::BSPTree::Node &node) {
+	fWriteNode = [&f,&fWriteNode,&bspNodes](const util::BSPTree::Node &node) {
 		f->Write<bool>(node.leaf);
 		f->Write<Vector3>(node.min);
 		f->Write<Vector3>(node.max);
@@ -450,23 +407,8 @@ void pragma::asset::WorldData::WriteBSPTree(VFilePtrReal &f)
 		if(node.leaf)
 		{
 			f->Write<uint16_t>(node.cluster);
-			auto itNode = std::find_if(bspNodes.begin(),bspNodes.end(),[&node](const util::BSPTree::Node &nodeOther) {
-				return &nodeOther == &node;
-				});
-			// Calculate AABB encompassing all nodes visible by this node
-			auto min = node.min;
-			auto max = node.max;
-			if(itNode != bspNodes.end() && node.cluster != std::numeric_limits<uint16_t>::max())
-			{
-				for(auto clusterDst : clusterToClusterVisibility.at(node.cluster))
-				{
-					for(auto nodeOtherIdx : clusterNodes.at(clusterDst))
-					{
-						auto &nodeOther = bspNodes.at(nodeOtherIdx);
-						uvec::to_min_max(min,max,nodeOther.min,nodeOther.max);
-					}
-				}
-			}
+			auto min = node.minVisible;
+			auto max = node.maxVisible;
 			uvec::to_min_max(min,max); // Vertex conversion rotates the vectors, which will change the signs, so we have to re-order the vector components
 			f->Write<Vector3>(min);
 			f->Write<Vector3>(max);
@@ -481,7 +423,11 @@ void pragma::asset::WorldData::WriteBSPTree(VFilePtrReal &f)
 	fWriteNode(bspTree.GetRootNode());
 
 	f->Write<uint64_t>(bspTree.GetClusterCount());
-	f->Write(clusterVisibility.data(),clusterVisibility.size() *sizeof(clusterVisibility.front()));
+	auto &clusterVisibilityRows = bspTree.GetClusterVisibilityRows();
+	f->Write(clusterVisibilityRows.data(),clusterVisibilityRows.size() *sizeof(clusterVisibilityRows.front()));
+	auto &clusterVisibilityData = bspTree.GetClusterVisibilityData();
+	f->Write<uint64_t>(clusterVisibilityData.size());
+	f->Write(clusterVisibilityData.data(),clusterVisibilityData.size() *sizeof(clusterVisibilityData.front()));
 }
 
 void pragma::asset::WorldData::WriteEntities(VFilePtrReal &f)
@@ -13,6 +13,7 @@
 #include <pragma/console/c_convars.h>
 #include <pragma/lua/luaapi.h>
 #include <pragma/game/game.h>
+#include <pragma/entities/components/base_entity_component.hpp>
 #include <fsys/filesystem.h>
 #include <mathutil/uvec.h>
 #include <sharedutils/util_string.h>
@@ -42,6 +43,14 @@ REGISTER_ENGINE_CONVAR(cache_version_target,"7",ConVarFlags::None,"If cache_vers
 REGISTER_ENGINE_CONVAR(log_enabled,"0",ConVarFlags::Archive,"0 = Log disabled; 1 = Log errors only; 2 = Log errors and warnings; 3 = Log all console output");
 REGISTER_ENGINE_CONVAR(log_file,"log.txt",ConVarFlags::Archive,"The log-file the console output will be logged to.");
 REGISTER_ENGINE_CONVAR(debug_profiling_enabled,"0",ConVarFlags::None,"Enables profiling timers.");
+REGISTER_ENGINE_CONVAR(sh_job_system_thread_count,"4",ConVarFlags::Archive,"Number of worker threads of the general-purpose engine job system. If set to 0, jobs are only executed by threads waiting for them.");
+REGISTER_ENGINE_CONVAR(sh_entity_tick_multithreaded,"1",ConVarFlags::Archive,"If enabled, entity components in parallel tick groups are ticked on the engine job system. Otherwise all components are ticked on the main thread.");
+REGISTER_ENGINE_CONVAR(debug_entity_tick_deterministic,"0",ConVarFlags::None,"If enabled, entity components in parallel tick groups are ticked on the main thread in a fixed order. Useful for reproducing bugs.");
+REGISTER_ENGINE_CONVAR(sh_animation_multithreaded,"1",ConVarFlags::Archive,"If enabled, the animation poses of animated entities are evaluated in parallel on the engine job system.");
+REGISTER_ENGINE_CONVAR(sh_nav_path_iteration_budget,"4096",ConVarFlags::Archive,"Maximum number of pathfinding search iterations per tick for asynchronous path requests. Requests that exceed the budget are continued in the next tick.");
+REGISTER_ENGINE_CONVAR(sh_asset_reload_budget,"4",ConVarFlags::Archive,"Time budget in milliseconds per frame for applying asset and Lua script hot-reloads. Reloads that exceed the budget are continued in the next frame, but at least one reload is applied per frame.");
+REGISTER_ENGINE_CONVAR(sh_water_buoyancy_volume_tables,"1",ConVarFlags::Archive,"If enabled, the submerged volume of floating physics objects is interpolated from precomputed tables instead of clipping every triangle of the collision mesh against the water plane every tick.");
+REGISTER_ENGINE_CONVAR(sh_trace_batch_multithreaded,"1",ConVarFlags::Archive,"If enabled, the queries of batched physics traces are distributed across the engine job system. Traces with filters that are not thread-safe (e.g. Lua functions), or of physics engines that don't support concurrent queries, always run on the calling thread.");
 REGISTER_ENGINE_CONVAR(sh_mount_external_game_resources,"1",ConVarFlags::Archive,"If set to 1, the game will attempt to load missing resources from external games.");
 REGISTER_ENGINE_CONVAR(sh_lua_remote_debugging,"0",ConVarFlags::Archive,"0 = Remote debugging is disabled; 1 = Remote debugging is enabled serverside; 2 = Remote debugging is enabled clientside.\nCannot be changed during an active game. Also requires the \"-luaext\" launch parameter.\nRemote debugging cannot be enabled clientside and serverside at the same time.");
 REGISTER_ENGINE_CONVAR(lua_open_editor_on_error,"1",ConVarFlags::Archive,"1 = Whenever there's a Lua error, the engine will attempt to automatically open a Lua IDE and open the file and line which caused the error.");
@@ -294,6 +303,8 @@ static void debug_profiling_print(NetworkState*,pragma::BasePlayerComponent*,std
 				sTime += " (" +std::to_string(result->duration->count()) +" ns)";
 			}
 			Con::cout<<t<<stage.GetName()<<": "<<sTime<<Con::endl;
+			for(auto &counter : stage.GetCounters())
+				Con::cout<<t<<"\t"<<counter.name<<": "<<counter.value<<Con::endl;
 		}
 		for(auto &wpChild : stage.GetChildren())
 		{
@@ -328,6 +339,119 @@ static void debug_profiling_physics_end(NetworkState *nw,pragma::BasePlayerCompo
 }
 REGISTER_ENGINE_CONCOMMAND(debug_profiling_physics_end,debug_profiling_physics_end,ConVarFlags::None,"Prints physics profiling information for the last simulation step.");
 
+static void debug_timer_benchmark(NetworkState *nw,pragma::BasePlayerComponent*,std::vector<std::string> &argv)
+{
+	auto *game = nw->GetGameState();
+	if(game == nullptr)
+		return;
+	auto numTimers = !argv.empty() ? util::to_int(argv.front()) : 100'000;
+	auto numTicks = (argv.size() > 1) ? util::to_int(argv[1]) : 600;
+	constexpr auto tickDelta = 1.0 /60.0;
+
+	// Uses a separate timer manager, so the game's timers aren't affected
+	TimerManager timerManager {};
+	uint64_t numCalls = 0;
+	std::vector<Timer*> timers {};
+	timers.reserve(numTimers);
+	auto t = util::Clock::now();
+	for(auto i=decltype(numTimers){0};i<numTimers;++i)
+	{
+		// Mix of one-shot and repeating timers with delays between 0.1 and 10 seconds
+		auto delay = umath::random(0.1f,10.f);
+		auto *timer = timerManager.CreateTimer(delay,(i %4 == 0) ? 0 : 1,FunctionCallback<void>::Create([&numCalls]() {++numCalls;}));
+		timer->Start(game);
+		timers.push_back(timer);
+	}
+	auto dtCreate = util::Clock::now() -t;
+
+	t = util::Clock::now();
+	for(auto i=decltype(numTicks){0};i<numTicks;++i)
+	{
+		timerManager.Advance(TimerType::CurTime,tickDelta);
+		timerManager.Update(game);
+	}
+	auto dtUpdate = util::Clock::now() -t;
+
+	// Cancel all remaining repeating timers
+	t = util::Clock::now();
+	for(auto i=decltype(timers.size()){0u};i<timers.size();i+=4)
+		timers[i]->Remove(game);
+	timerManager.Update(game);
+	auto dtCancel = util::Clock::now() -t;
+
+	auto toMs = [](auto dt) {return util::round_string(util::clock::to_milliseconds(dt),3) +" ms";};
+	Con::cout<<"Timer benchmark ("<<numTimers<<" timers, "<<numTicks<<" ticks):"<<Con::endl;
+	Con::cout<<"Creation: "<<toMs(dtCreate)<<Con::endl;
+	Con::cout<<"Updates: "<<toMs(dtUpdate)<<" ("<<util::round_string(util::clock::to_milliseconds(dtUpdate) /static_cast<double>(umath::max(numTicks,1)),4)<<" ms per tick, "<<numCalls<<" calls)"<<Con::endl;
+	Con::cout<<"Cancellation: "<<toMs(dtCancel)<<Con::endl;
+}
+REGISTER_SHARED_CONCOMMAND(debug_timer_benchmark,debug_timer_benchmark,ConVarFlags::None,"Measures the cost of creating, updating and cancelling timers. Usage: debug_timer_benchmark <timerCount> <tickCount>");
+
+static void debug_component_event_benchmark(NetworkState *nw,pragma::BasePlayerComponent*,std::vector<std::string> &argv)
+{
+	auto *game = nw->GetGameState();
+	if(game == nullptr)
+		return;
+	auto numBroadcasts = !argv.empty() ? util::to_int(argv.front()) : 1'000'000;
+	auto *ent = game->CreateEntity();
+	if(ent == nullptr)
+		return;
+	// The entity is never spawned, so these components stay inert
+	for(auto *name : {
+		"transform","color","surface","score","health","name","observable","radius","toggle","io","time_scale","attachable","parent","ownable",
+		"model","animated","damageable","logic","gravity","submergible","velocity","usable","global","map","flammable","sound_emitter","physics"
+	})
+		ent->AddComponent(name);
+	auto &componentManager = game->GetEntityComponentManager();
+	auto &components = ent->GetComponents();
+	// The events are only registered by the first run of the benchmark in this game
+	auto getEventId = [&componentManager,&components](const std::string &name) {
+		pragma::ComponentEventId evId;
+		if(componentManager.GetEventId(name,evId) == false)
+			evId = componentManager.RegisterEventById(name,components.front()->GetComponentId());
+		return evId;
+	};
+	auto evBound = getEventId("debug_component_event_benchmark_bound");
+	auto evUnbound = getEventId("debug_component_event_benchmark_unbound");
+
+	// Every fourth component listens to the bound event
+	uint64_t numCalls = 0;
+	std::vector<CallbackHandle> callbacks {};
+	for(auto i=decltype(components.size()){0u};i<components.size();i+=4)
+	{
+		callbacks.push_back(components[i]->BindEventUnhandled(evBound,[&numCalls](std::reference_wrapper<pragma::ComponentEvent>) {
+			++numCalls;
+		}));
+	}
+	auto numComponents = components.size();
+
+	auto measure = [ent,numBroadcasts](pragma::ComponentEventId evId) {
+		pragma::CEGenericComponentEvent evData {};
+		auto t = util::Clock::now();
+		for(auto i=decltype(numBroadcasts){0};i<numBroadcasts;++i)
+			ent->BroadcastEvent(evId,evData);
+		return util::Clock::now() -t;
+	};
+	auto dtBound = measure(evBound);
+	auto dtUnbound = measure(evUnbound);
+
+	for(auto &hCb : callbacks)
+	{
+		if(hCb.IsValid())
+			hCb.Remove();
+	}
+	ent->Remove();
+
+	auto toResult = [numBroadcasts](auto dt) {
+		auto ms = util::clock::to_milliseconds(dt);
+		return util::round_string(ms,3) +" ms (" +util::round_string((ms *1'000'000.0) /static_cast<double>(umath::max(numBroadcasts,1)),1) +" ns per broadcast)";
+	};
+	Con::cout<<"Component event benchmark ("<<numComponents<<" components, "<<numBroadcasts<<" broadcasts per event):"<<Con::endl;
+	Con::cout<<"Bound event: "<<toResult(dtBound)<<" ("<<numCalls<<" calls)"<<Con::endl;
+	Con::cout<<"Unbound event: "<<toResult(dtUnbound)<<Con::endl;
+}
+REGISTER_SHARED_CONCOMMAND(debug_component_event_benchmark,debug_component_event_benchmark,ConVarFlags::None,"Measures the throughput of broadcasting component events on an entity with many components. Usage: debug_component_event_benchmark <broadcastCount>");
+
 //////////////// SERVER ////////////////
 
 REGISTER_SHARED_CONVAR(rcon_password,"",ConVarFlags::Password,"Specifies a password which can be used to run console commands remotely on a server. If no password is specified, this feature is disabled.");
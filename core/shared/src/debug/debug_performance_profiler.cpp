@@ -109,6 +109,18 @@ const pragma::debug::Timer &ProfilingStage::GetTimer() const {return const_cast<
 pragma::debug::Timer &ProfilingStage::GetTimer() {return *m_timer;}
 bool ProfilingStage::Start() {return GetTimer().Start();}
 bool ProfilingStage::Stop() {return GetTimer().Stop();}
+ProfilingStage::CounterId ProfilingStage::AddCounter(const std::string &name)
+{
+	m_counters.push_back({name});
+	return m_counters.size() -1;
+}
+void ProfilingStage::SetCounterValue(CounterId id,uint64_t value)
+{
+	if(id >= m_counters.size())
+		return;
+	m_counters[id].value = value;
+}
+const std::vector<ProfilingStage::Counter> &ProfilingStage::GetCounters() const {return m_counters;}
 
 /////////////////
 
@@ -51,6 +51,7 @@
 #include <util_zip.h>
 #include <pragma/game/game_resources.hpp>
 #include <pragma/util/resource_watcher.h>
+#include <pragma/util/job_system.hpp>
 #include <util_pad.hpp>
 #include <material_manager2.hpp>
 #include <pragma/networking/iserver.hpp>
@@ -145,6 +146,8 @@ Engine::Engine(int,char*[])
 	// Link package system to file system
 	m_padPackageManager = upad::link_to_file_system();
 	m_assetManager = std::make_unique<pragma::asset::AssetManager>();
+	// The worker count will be updated once the config has been loaded
+	m_jobSystem = std::make_unique<pragma::JobSystem>("engine_job_worker",DEFAULT_JOB_SYSTEM_WORKER_COUNT);
 
 	pragma::register_engine_animation_events();
 	pragma::register_engine_activities();
@@ -179,6 +182,7 @@ Engine::Engine(int,char*[])
 
 pragma::asset::AssetManager &Engine::GetAssetManager() {return *m_assetManager;}
 const pragma::asset::AssetManager &Engine::GetAssetManager() const {return const_cast<Engine*>(this)->GetAssetManager();}
+pragma::JobSystem &Engine::GetJobSystem() {return *m_jobSystem;}
 
 void Engine::ClearConsole()
 {
@@ -282,6 +286,8 @@ void Engine::PollResourceWatchers()
 	if(cl)
 		cl->GetResourceWatcher().Poll();
 }
+std::chrono::microseconds Engine::GetAssetReloadBudget() const {return m_assetReloadBudget;}
+void Engine::ConsumeAssetReloadBudget(std::chrono::microseconds t) {m_assetReloadBudget = (t < m_assetReloadBudget) ? (m_assetReloadBudget -t) : std::chrono::microseconds{0};}
 util::ScopeGuard Engine::ScopeLockResourceWatchers()
 {
 	auto *sv = GetServerNetworkState();
@@ -324,6 +330,8 @@ void Engine::Close()
 
 	umath::set_flag(m_stateFlags,StateFlags::Running,false);
 	util::close_external_archive_manager();
+	// All jobs have to be completed before the game states are released
+	m_jobSystem->WaitForAll();
 	CloseServerState();
 
 	CloseConsole();
@@ -991,6 +999,7 @@ void Engine::Think()
 {
 	AddonSystem::Poll(); // Required for dynamic mounting of addons
 	UpdateTickCount();
+	m_assetReloadBudget = std::chrono::microseconds{static_cast<int64_t>(umath::max(GetConVarFloat("sh_asset_reload_budget"),0.f) *1'000.f)};
 	CallCallbacks<void>("Think");
 	auto *sv = GetServerNetworkState();
 	if(sv != NULL)
@@ -1053,6 +1062,11 @@ Engine::~Engine()
 Engine *pragma::get_engine() {return engine;}
 ServerState *pragma::get_server_state() {return engine->GetServerStateInterface().get_server_state();}
 
+REGISTER_ENGINE_CONVAR_CALLBACK(sh_job_system_thread_count,[](NetworkState*,ConVar*,int,int val) {
+	if(engine == nullptr)
+		return;
+	engine->GetJobSystem().SetWorkerCount(static_cast<uint32_t>(umath::clamp(val,0,32)));
+});
 REGISTER_ENGINE_CONVAR_CALLBACK(debug_profiling_enabled,[](NetworkState*,ConVar*,bool,bool enabled) {
 	if(engine == nullptr)
 		return;
@@ -426,7 +426,6 @@ void BaseAnimatedComponent::ClearPreviousAnimation()
 }
 Frame *BaseAnimatedComponent::GetPreviousAnimationBlendFrame(AnimationSlotInfo &animInfo,double tDelta,float &blendScale)
 {
-	auto mdlComponent = GetEntity().GetModelComponent();
 	auto &hModel = GetEntity().GetModel();
 	if(hModel == nullptr)
 		return nullptr;
@@ -507,7 +506,7 @@ bool BaseAnimatedComponent::MaintainAnimation(AnimationSlotInfo &animInfo,double
 			if(cycle != 1.f || animId != animInfo.animation)
 			{
 				SetBaseAnimationDirty();
-				return MaintainAnimation(animInfo,dt);
+				return MaintainAnimation(animInfo,dt,layeredSlot);
 			}
 			if(bLoop == true)
 			{
@@ -517,7 +516,7 @@ bool BaseAnimatedComponent::MaintainAnimation(AnimationSlotInfo &animInfo,double
 					animId = SelectWeightedAnimation(act,animId);
 					cycle = cycleNew;
 					SetBaseAnimationDirty();
-					return MaintainAnimation(animInfo,dt);
+					return MaintainAnimation(animInfo,dt,layeredSlot);
 				}
 			}
 			else
@@ -542,30 +541,93 @@ bool BaseAnimatedComponent::MaintainAnimation(AnimationSlotInfo &animInfo,double
 	}
 #endif
 
-	// TODO: All of this is very inefficient and involves a lot of unnecessary buffers. FIXME
-
-	// Initialize buffer for blended/interpolated animation data
-	auto &animBoneList = anim->GetBoneList();
-	auto numBones = animBoneList.size();
-	std::vector<umath::Transform> bonePoses {};
-	std::vector<Vector3> boneScales {};
-
-	// Blend between the last frame and the current frame of this animation.
+	// The frames are only determined here to find out whether there's anything to evaluate,
+	// the actual blending happens in EvaluateAnimationPose.
 	Frame *srcFrame,*dstFrame;
 	float interpFactor;
 	if(GetBlendFramesFromCycle(*anim,cycle,&srcFrame,&dstFrame,interpFactor) == false)
 		return false; // This shouldn't happen unless the animation has no frames
 
-	//if(dstFrame)
+	PendingPoseEvaluation pending {};
+	pending.animation = anim;
+	pending.animId = animId;
+	pending.layeredSlot = layeredSlot;
+	pending.dt = dt;
+	pending.cycle = cycle;
+	pending.cycleLast = cycleLast;
+	if(umath::is_flag_set(m_stateFlags,StateFlags::DeferPoseEvaluation))
 	{
-		bonePoses.resize(numBones);
-		boneScales.resize(numBones,Vector3{1.f,1.f,1.f});
+		m_pendingPoseEvaluations.push_back(pending);
+		return true;
 	}
+	pending.evaluated = EvaluateAnimationPose(pending);
+	FinalizeAnimationPose(pending);
+	return true;
+}
+
+BaseAnimatedComponent::AnimationSlotInfo *BaseAnimatedComponent::FindAnimationSlotInfo(int32_t layeredSlot)
+{
+	if(layeredSlot == -1)
+		return &m_baseAnim;
+	auto it = m_animSlots.find(layeredSlot);
+	return (it != m_animSlots.end()) ? &it->second : nullptr;
+}
+
+bool BaseAnimatedComponent::EvaluateAnimationPose(const PendingPoseEvaluation &pending)
+{
+	// Note: This may be called from a worker thread, so no events may be invoked here!
+	auto &hModel = GetEntity().GetModel();
+	auto *pAnimInfo = FindAnimationSlotInfo(pending.layeredSlot);
+	if(hModel == nullptr || pAnimInfo == nullptr || pAnimInfo->animation != pending.animId)
+		return false; // Slot has been removed or changed since the evaluation was scheduled
+	auto &animInfo = *pAnimInfo;
+	auto &anim = pending.animation;
+	auto cycle = pending.cycle;
+	auto dt = pending.dt;
+	Frame *srcFrame,*dstFrame;
+	float interpFactor;
+	if(GetBlendFramesFromCycle(*anim,cycle,&srcFrame,&dstFrame,interpFactor) == false)
+		return false;
+
+	// The poses are blended in the persistent SoA scratch buffers of this component, so no allocations
+	// are required once the buffers have reached the bone count of the largest animation.
+	auto &animBoneList = anim->GetBoneList();
+	auto numBones = animBoneList.size();
+	auto &scratch = m_poseBlendScratch;
+	auto &result = scratch.result;
+
+	auto blendFrames = [&scratch,numBones](pragma::animation::Animation &anim,Frame &srcFrame,Frame *dstFrame,float interpFactor,pragma::animation::PoseBuffer &out) {
+		if(dstFrame == nullptr)
+		{
+			// Destination frame can be nullptr if no interpolation is required.
+			out.Load(srcFrame.GetBoneTransforms(),&srcFrame.GetBoneScales());
+			return;
+		}
+		scratch.frameSrc.Load(srcFrame.GetBoneTransforms(),&srcFrame.GetBoneScales());
+		scratch.frameDst.Load(dstFrame->GetBoneTransforms(),&dstFrame->GetBoneScales());
+		out.Resize(numBones);
+		pragma::animation::blend_poses(scratch.frameSrc,scratch.frameDst,anim.GetBoneWeights(),interpFactor,out);
+	};
+	// Interpolates between the two frames of the specified animation at the current cycle
+	auto interpolateAnimation = [this,&blendFrames,cycle](pragma::animation::Animation &anim,pragma::animation::PoseBuffer &out) -> bool {
+		Frame *srcFrame,*dstFrame;
+		float interpFactor;
+		if(GetBlendFramesFromCycle(anim,cycle,&srcFrame,&dstFrame,interpFactor) == false)
+		{
+			out.Resize(0);
+			return false;
+		}
+		blendFrames(anim,*srcFrame,dstFrame,interpFactor,out);
+		return true;
+	};
 
 	// Blend Controllers
 	auto *animBcData = anim->GetBlendController();
 	if(animBcData)
 	{
+		result.Resize(numBones);
+		result.SetIdentity();
+		result.SetHasScales(true);
 		auto *bc = hModel->GetBlendController(animBcData->controller);
 		if(animBcData->transitions.empty() == false && bc != nullptr)
 		{
@@ -591,94 +653,21 @@ bool BaseAnimatedComponent::MaintainAnimation(AnimationSlotInfo &animInfo,double
 				// Note: A blend controller blends between two different animations. That means that for each animation
 				// we have to interpolate the animation's frame, and then interpolate (i.e. blend) the resulting bone poses
 				// of both animations.
-
-				// Interpolated poses of source animation
-				Frame *srcFrame,*dstFrame;
-				float animInterpFactor;
-				std::vector<umath::Transform> ppBonePosesSrc {};
-				std::vector<Vector3> ppBoneScalesSrc {};
-				if(GetBlendFramesFromCycle(*blendAnimSrc,cycle,&srcFrame,&dstFrame,animInterpFactor))
-				{
-					if(dstFrame)
-					{
-						ppBonePosesSrc.resize(numBones);
-						ppBoneScalesSrc.resize(numBones,Vector3{1.f,1.f,1.f});
-						BlendBonePoses(
-							srcFrame->GetBoneTransforms(),&srcFrame->GetBoneScales(),
-							dstFrame->GetBoneTransforms(),&dstFrame->GetBoneScales(),
-							ppBonePosesSrc,&ppBoneScalesSrc,
-							*blendAnimSrc,animInterpFactor
-						);
-					}
-					else
-					{
-						ppBonePosesSrc = srcFrame->GetBoneTransforms();
-						ppBoneScalesSrc = srcFrame->GetBoneScales();
-					}
-				}
-
-				// Interpolated poses of destination animation
-				std::vector<umath::Transform> ppBonePosesDst {};
-				std::vector<Vector3> ppBoneScalesDst {};
-				if(GetBlendFramesFromCycle(*blendAnimDst,cycle,&srcFrame,&dstFrame,animInterpFactor))
-				{
-					if(dstFrame)
-					{
-						ppBonePosesDst.resize(numBones);
-						ppBoneScalesDst.resize(numBones,Vector3{1.f,1.f,1.f});
-						BlendBonePoses(
-							srcFrame->GetBoneTransforms(),&srcFrame->GetBoneScales(),
-							dstFrame->GetBoneTransforms(),&dstFrame->GetBoneScales(),
-							ppBonePosesDst,&ppBoneScalesDst,
-							*blendAnimSrc,animInterpFactor
-						);
-					}
-					else
-					{
-						ppBonePosesDst = srcFrame->GetBoneTransforms();
-						ppBoneScalesDst = srcFrame->GetBoneScales();
-					}
-				}
+				interpolateAnimation(*blendAnimSrc,scratch.bcSrc);
+				interpolateAnimation(*blendAnimDst,scratch.bcDst);
 
 				// Interpolate between the two frames
-				BlendBonePoses(
-					ppBonePosesSrc,&ppBoneScalesSrc,
-					ppBonePosesDst,&ppBoneScalesDst,
-					bonePoses,&boneScales,
-					*blendAnimSrc,interpFactor
-				);
+				pragma::animation::blend_poses(scratch.bcSrc,scratch.bcDst,blendAnimSrc->GetBoneWeights(),interpFactor,result);
 
 				if(animBcData->animationPostBlendController != std::numeric_limits<uint32_t>::max() && animBcData->animationPostBlendTarget != std::numeric_limits<uint32_t>::max())
 				{
 					auto blendAnimPost = hModel->GetAnimation(animBcData->animationPostBlendTarget);
-					if(blendAnimPost && GetBlendFramesFromCycle(*blendAnimPost,cycle,&srcFrame,&dstFrame,animInterpFactor))
+					if(blendAnimPost && interpolateAnimation(*blendAnimPost,scratch.bcSrc))
 					{
-						if(dstFrame)
-						{
-							ppBonePosesSrc.resize(numBones);
-							ppBoneScalesSrc.resize(numBones,Vector3{1.f,1.f,1.f});
-							BlendBonePoses(
-								srcFrame->GetBoneTransforms(),&srcFrame->GetBoneScales(),
-								dstFrame->GetBoneTransforms(),&dstFrame->GetBoneScales(),
-								ppBonePosesSrc,&ppBoneScalesSrc,
-								*blendAnimPost,animInterpFactor
-							);
-						}
-						else
-						{
-							ppBonePosesSrc = srcFrame->GetBoneTransforms();
-							ppBoneScalesSrc = srcFrame->GetBoneScales();
-						}
-
 						// Interpolate between the two frames
 						auto bcValuePostBlend = GetBlendController(animBcData->animationPostBlendController);
 						auto interpFactor = 1.f -bcValuePostBlend;
-						BlendBonePoses(
-							ppBonePosesSrc,&ppBoneScalesSrc,
-							bonePoses,&boneScales,
-							bonePoses,&boneScales,
-							*blendAnimPost,interpFactor
-						);
+						pragma::animation::blend_poses(scratch.bcSrc,result,blendAnimPost->GetBoneWeights(),interpFactor,result);
 					}
 				}
 			}
@@ -686,22 +675,7 @@ bool BaseAnimatedComponent::MaintainAnimation(AnimationSlotInfo &animInfo,double
 	}
 	else
 	{
-		if(dstFrame)
-		{
-			BlendBonePoses(
-				srcFrame->GetBoneTransforms(),&srcFrame->GetBoneScales(),
-				dstFrame->GetBoneTransforms(),&dstFrame->GetBoneScales(),
-				bonePoses,&boneScales,
-				*anim,interpFactor
-			);
-		}
-		else
-		{
-			// Destination frame can be nullptr if no interpolation is required.
-			bonePoses = srcFrame->GetBoneTransforms();
-			boneScales = srcFrame->GetBoneScales();
-		}
-		//
+		blendFrames(*anim,*srcFrame,dstFrame,interpFactor,result);
 
 		// Blend between previous animation and this animation
 		float interpFactorLastAnim;
@@ -711,20 +685,33 @@ bool BaseAnimatedComponent::MaintainAnimation(AnimationSlotInfo &animInfo,double
 			auto lastAnim = hModel->GetAnimation(animInfo.lastAnim.animation);
 			if(lastAnim)
 			{
-				BlendBonePoses(
-					lastPlayedFrameOfPreviousAnim->GetBoneTransforms(),&lastPlayedFrameOfPreviousAnim->GetBoneScales(),
-					bonePoses,&boneScales,
-					bonePoses,&boneScales,
-					*lastAnim,1.f -interpFactorLastAnim
-				);
+				scratch.frameSrc.Load(lastPlayedFrameOfPreviousAnim->GetBoneTransforms(),&lastPlayedFrameOfPreviousAnim->GetBoneScales());
+				pragma::animation::blend_poses(scratch.frameSrc,result,lastAnim->GetBoneWeights(),1.f -interpFactorLastAnim,result);
 			}
 		}
 		//
 	}
 	//
 
-	animInfo.bonePoses = std::move(bonePoses);
-	animInfo.boneScales = std::move(boneScales);
+	// Note: The slot's buffers keep their capacity, so this doesn't allocate either
+	result.Store(animInfo.bonePoses,&animInfo.boneScales);
+	return true;
+}
+
+void BaseAnimatedComponent::FinalizeAnimationPose(const PendingPoseEvaluation &pending)
+{
+	if(pending.evaluated == false)
+		return;
+	auto *pAnimInfo = FindAnimationSlotInfo(pending.layeredSlot);
+	if(pAnimInfo == nullptr)
+		return;
+	auto &animInfo = *pAnimInfo;
+	auto &anim = pending.animation;
+	auto animId = pending.animId;
+	auto act = anim->GetActivity();
+	auto numFrames = anim->GetFrameCount();
+	auto cycle = pending.cycle;
+	auto cycleLast = pending.cycleLast;
 
 	CEOnBlendAnimation evDataBlend{animInfo,act,animInfo.bonePoses,(animInfo.boneScales.empty() == false) ? &animInfo.boneScales : nullptr};
 	InvokeEventCallbacks(EVENT_ON_BLEND_ANIMATION,evDataBlend);
@@ -743,42 +730,38 @@ bool BaseAnimatedComponent::MaintainAnimation(AnimationSlotInfo &animInfo,double
 	eventItem.animation = anim;
 	eventItem.frameId = frameID;
 	eventItem.lastFrame = frameLast;
-	return true;
 }
 
 void BaseAnimatedComponent::SetBindPose(const Frame &frame) {m_bindPose = frame.shared_from_this();}
 const Frame *BaseAnimatedComponent::GetBindPose() const {return m_bindPose.get();}
 
-bool BaseAnimatedComponent::MaintainGestures(double dt)
+bool BaseAnimatedComponent::ApplyGesture(AnimationSlotInfo &animInfo)
 {
 	auto &hModel = GetEntity().GetModel();
-	if(hModel == nullptr)
-		return false;
 	auto &baseAnimInfo = m_baseAnim;
-	auto anim = hModel->GetAnimation(baseAnimInfo.animation);
-	auto &bones = anim->GetBoneList();
 	auto &bonePoses = baseAnimInfo.bonePoses;
 	auto &boneScales = baseAnimInfo.boneScales;
+	auto anim = hModel->GetAnimation(animInfo.animation);
+	auto baseAnim = hModel->GetAnimation(baseAnimInfo.animation);
+	TransformBoneFrames(
+		bonePoses,!boneScales.empty() ? &boneScales : nullptr,baseAnim,anim,animInfo.bonePoses,!animInfo.boneScales.empty() ? &animInfo.boneScales : nullptr,anim->HasFlag(FAnim::Gesture)
+	);
+	return animInfo.cycle >= 1.f && anim->HasFlag(FAnim::Loop) == false; // No need to keep the gesture information around anymore
+}
+bool BaseAnimatedComponent::MaintainGestures(double dt)
+{
+	auto &hModel = GetEntity().GetModel();
+	if(hModel == nullptr)
+		return false;
 
 	// Update gestures
 	for(auto it=m_animSlots.begin();it!=m_animSlots.end();)
 	{
 		auto &animInfo = it->second;
-		if(MaintainAnimation(animInfo,dt,it->first) == true)
+		if(MaintainAnimation(animInfo,dt,it->first) == true && ApplyGesture(animInfo))
 		{
-			auto anim = hModel->GetAnimation(animInfo.animation);
-			auto baseAnim = hModel->GetAnimation(baseAnimInfo.animation);
-			TransformBoneFrames(
-				bonePoses,!boneScales.empty() ? &boneScales : nullptr,baseAnim,anim,animInfo.bonePoses,!animInfo.boneScales.empty() ? &animInfo.boneScales : nullptr,anim->HasFlag(FAnim::Gesture)
-			);
-			if(animInfo.cycle >= 1.f)
-			{
-				if(anim->HasFlag(FAnim::Loop) == false)
-				{
-					it = m_animSlots.erase(it); // No need to keep the gesture information around anymore
-					continue;
-				}
-			}
+			it = m_animSlots.erase(it);
+			continue;
 		}
 		++it;
 	}
@@ -801,7 +784,77 @@ bool BaseAnimatedComponent::MaintainAnimations(double dt)
 	auto r = MaintainAnimation(m_baseAnim,dt);
 	if(r == true)
 		MaintainGestures(dt);
+	if(ApplyAnimationPoses() == false)
+		return false;
+	return r;
+}
+bool BaseAnimatedComponent::PrepareAnimationUpdate(double dt)
+{
+	if(ShouldUpdateBones() == false)
+		return false;
+	auto &ent = GetEntity();
+	auto &hModel = ent.GetModel();
+	if(hModel == nullptr)
+		return false;
+	auto pTimeScaleComponent = ent.GetTimeScaleComponent();
+	dt *= pTimeScaleComponent.valid() ? pTimeScaleComponent->GetEffectiveTimeScale() : 1.f;
+
+	m_pendingPoseEvaluations.clear();
+	CEMaintainAnimations evData{dt};
+	if(InvokeEventCallbacks(EVENT_MAINTAIN_ANIMATIONS,evData) == util::EventReply::Handled)
+	{
+		umath::set_flag(m_stateFlags,StateFlags::AnimationsHandledByEvent,true);
+		return true;
+	}
+	umath::set_flag(m_stateFlags,StateFlags::AnimationsHandledByEvent,false);
 
+	// Same as MaintainAnimations, except that the poses are only evaluated in EvaluateAnimationPoses
+	umath::set_flag(m_stateFlags,StateFlags::DeferPoseEvaluation,true);
+	if(MaintainAnimation(m_baseAnim,dt) == true)
+	{
+		for(auto &pair : m_animSlots)
+			MaintainAnimation(pair.second,dt,pair.first);
+	}
+	umath::set_flag(m_stateFlags,StateFlags::DeferPoseEvaluation,false);
+	return true;
+}
+void BaseAnimatedComponent::EvaluateAnimationPoses()
+{
+	for(auto &pending : m_pendingPoseEvaluations)
+		pending.evaluated = EvaluateAnimationPose(pending);
+}
+void BaseAnimatedComponent::FinalizeAnimationUpdate()
+{
+	if(umath::is_flag_set(m_stateFlags,StateFlags::AnimationsHandledByEvent))
+	{
+		umath::set_flag(m_stateFlags,StateFlags::AnimationsHandledByEvent,false);
+		InvokeEventCallbacks(EVENT_ON_ANIMATIONS_UPDATED);
+		InvokeEventCallbacks(EVENT_UPDATE_BONE_POSES);
+		InvokeEventCallbacks(EVENT_ON_BONE_POSES_FINALIZED);
+		return;
+	}
+	// The events invoked below may end up scheduling new evaluations, so we'll work on a separate list
+	std::vector<PendingPoseEvaluation> pendingPoseEvaluations {};
+	pendingPoseEvaluations.swap(m_pendingPoseEvaluations);
+	for(auto &pending : pendingPoseEvaluations)
+	{
+		FinalizeAnimationPose(pending);
+		if(pending.evaluated == false || pending.layeredSlot == -1)
+			continue;
+		auto it = m_animSlots.find(pending.layeredSlot);
+		if(it != m_animSlots.end() && ApplyGesture(it->second))
+			m_animSlots.erase(it);
+	}
+	pendingPoseEvaluations.clear();
+	if(m_pendingPoseEvaluations.empty())
+		pendingPoseEvaluations.swap(m_pendingPoseEvaluations); // Keep the capacity for the next update
+	ApplyAnimationPoses();
+}
+bool BaseAnimatedComponent::ApplyAnimationPoses()
+{
+	auto &hModel = GetEntity().GetModel();
+	if(hModel == nullptr)
+		return false;
 	auto &baseAnimInfo = m_baseAnim;
 	auto anim = hModel->GetAnimation(baseAnimInfo.animation);
 	if(!anim)
@@ -871,8 +924,9 @@ bool BaseAnimatedComponent::MaintainAnimations(double dt)
 
 		m_animEventQueue.pop();
 	}
-	return r;
+	return true;
 }
+
 Activity BaseAnimatedComponent::TranslateActivity(Activity act)
 {
 	CETranslateActivity evTranslateActivityData {act};
@@ -159,8 +159,7 @@ void BaseEntityComponent::OnRemove()
 	}
 	if(umath::is_flag_set(m_stateFlags,StateFlags::IsLogicEnabled))
 	{
-		auto &logicComponents = GetEntity().GetNetworkState()->GetGameState()->GetEntityTickComponents();
-		*std::find(logicComponents.begin(),logicComponents.end(),this) = nullptr;
+		GetEntity().GetNetworkState()->GetGameState()->GetEntityTickScheduler().Unregister(*this);
 		umath::set_flag(m_stateFlags,StateFlags::IsLogicEnabled,false);
 	}
 }
@@ -309,7 +308,11 @@ CallbackHandle BaseEntityComponent::BindEvent(ComponentEventId eventId,const std
 	}
 	auto itEv = m_boundEvents.find(eventId);
 	if(itEv == m_boundEvents.end())
+	{
 		itEv = m_boundEvents.insert(std::make_pair(eventId,std::vector<CallbackHandle>{})).first;
+		// This component has to be added to the entity's subscribers for this event
+		ent.InvalidateEventSubscriptions();
+	}
 	itEv->second.push_back(hCallback);
 	return itEv->second.back();
 }
@@ -458,18 +461,18 @@ void BaseEntityComponent::UpdateTickPolicy()
 {
 	if(!GetEntity().IsSpawned())
 		return;
-	auto &logicComponents = GetEntity().GetNetworkState()->GetGameState()->GetEntityTickComponents();
+	auto &tickScheduler = GetEntity().GetNetworkState()->GetGameState()->GetEntityTickScheduler();
 	if(ShouldThink())
 	{
 		if(umath::is_flag_set(m_stateFlags,StateFlags::IsLogicEnabled))
 			return;
-		logicComponents.push_back(this);
+		tickScheduler.Register(*this);
 		umath::set_flag(m_stateFlags,StateFlags::IsLogicEnabled);
 		return;
 	}
 	if(!umath::is_flag_set(m_stateFlags,StateFlags::IsLogicEnabled))
 		return;
-	logicComponents.erase(std::find(logicComponents.begin(),logicComponents.end(),this));
+	tickScheduler.Unregister(*this);
 	umath::set_flag(m_stateFlags,StateFlags::IsLogicEnabled,false);
 }
 void BaseEntityComponent::SetTickPolicy(TickPolicy policy)
@@ -483,8 +486,16 @@ void BaseEntityComponent::SetTickPolicy(TickPolicy policy)
 	UpdateTickPolicy();
 }
 
+void BaseEntityComponent::SetTickGroup(TickGroup group) {m_tickData.tickGroup = group;}
+TickGroup BaseEntityComponent::GetTickGroup() const {return m_tickData.tickGroup;}
+
 double BaseEntityComponent::GetNextTick() const {return m_tickData.nextTick;}
-void BaseEntityComponent::SetNextTick(double t) {m_tickData.nextTick = t;}
+void BaseEntityComponent::SetNextTick(double t)
+{
+	m_tickData.nextTick = t;
+	if(umath::is_flag_set(m_stateFlags,StateFlags::IsLogicEnabled))
+		GetEntity().GetNetworkState()->GetGameState()->GetEntityTickScheduler().Wake(*this);
+}
 
 double BaseEntityComponent::LastTick() const {return m_tickData.lastTick;}
 
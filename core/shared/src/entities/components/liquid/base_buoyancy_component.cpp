@@ -121,23 +121,22 @@ void BaseBuoyancyComponent::SimulateBuoyancy() const
 	m_surfaceC->GetPlaneWs(n,d);
 
 	auto *sim = m_surfSim.valid() ? m_surfSim->GetSurfaceSimulator() : nullptr;
-	if(sim != nullptr)
-		const_cast<PhysWaterSurfaceSimulator*>(sim)->LockParticleHeights();
 	//const std::vector<PhysTouch> &BaseTouchComponent::GetTouchingInfo() const {return m_touching;}
 	if(touchComponent != nullptr)
 	{
+		std::vector<BaseEntity*> touchingEnts;
+		touchingEnts.reserve(touchComponent->GetTouchingInfo().size());
 		for(auto &touchInfo : touchComponent->GetTouchingInfo())
 		{
 			if(touchInfo.touch.entity.valid() == false || touchInfo.triggered == false)
 				continue;
-			buoyancySim.Simulate(
-				const_cast<BaseEntity&>(ent),m_liquidControl->GetLiquidDescription(),const_cast<BaseEntity&>(*touchInfo.touch.entity.get()),n,d,
-				m_liquidControl->GetLiquidVelocity(),sim
-			);
+			touchingEnts.push_back(const_cast<BaseEntity*>(touchInfo.touch.entity.get()));
 		} // TODO: Trigger has to be higher than max surface height
+		buoyancySim.Simulate(
+			const_cast<BaseEntity&>(ent),m_liquidControl->GetLiquidDescription(),touchingEnts,n,d,
+			m_liquidControl->GetLiquidVelocity(),sim
+		);
 	}
-	if(sim)
-		const_cast<PhysWaterSurfaceSimulator*>(sim)->UnlockParticleHeights();
 	/*if(m_physSurfaceSim != nullptr)
 		m_physSurfaceSim->LockParticleHeights();
 	auto *ent = m_entity->GetNetworkState()->GetGameState()->FindEntityByClass("prop_physics");
@@ -84,6 +84,7 @@ bool BaseLiquidSurfaceSimulationComponent::CalcLineSurfaceIntersection(const Vec
 	{
 		auto width = m_physSurfaceSim->GetWidth();
 		auto length = m_physSurfaceSim->GetLength();
+		PhysWaterSurfaceSimulator::HeightView heights {*m_physSurfaceSim};
 		for(auto i=decltype(width){0};i<(width -1);++i)
 		{
 			for(auto j=decltype(length){0};j<(length -1);++j)
@@ -91,15 +92,15 @@ bool BaseLiquidSurfaceSimulationComponent::CalcLineSurfaceIntersection(const Vec
 				auto ptIdx0 = m_physSurfaceSim->GetParticleIndex(i,j);
 				auto ptIdx1 = m_physSurfaceSim->GetParticleIndex(i +1,j);
 				auto ptIdx2 = m_physSurfaceSim->GetParticleIndex(i,j +1);
-				auto v0 = m_physSurfaceSim->CalcParticlePosition(ptIdx0);
-				auto v1 = m_physSurfaceSim->CalcParticlePosition(ptIdx1);
-				auto v2 = m_physSurfaceSim->CalcParticlePosition(ptIdx2);
+				auto v0 = m_physSurfaceSim->CalcParticlePosition(heights,ptIdx0);
+				auto v1 = m_physSurfaceSim->CalcParticlePosition(heights,ptIdx1);
+				auto v2 = m_physSurfaceSim->CalcParticlePosition(heights,ptIdx2);
 				//m_triangleIndices.push_back(ptIdx0);
 				//m_triangleIndices.push_back(ptIdx1);
 				//m_triangleIndices.push_back(ptIdx2);
 
 				auto ptIdx3 = m_physSurfaceSim->GetParticleIndex(i +1,j +1);
-				auto v3 = m_physSurfaceSim->CalcParticlePosition(ptIdx3);
+				auto v3 = m_physSurfaceSim->CalcParticlePosition(heights,ptIdx3);
 				if(
 					umath::intersection::line_triangle(lineOrigin,lineDir,v0,v1,v2,t,u,v,bCull) == true ||
 					umath::intersection::line_triangle(lineOrigin,lineDir,v3,v2,v1,t,u,v,bCull) == true
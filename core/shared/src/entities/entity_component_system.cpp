@@ -10,6 +10,7 @@
 #include "pragma/entities/entity_component_manager.hpp"
 #include "pragma/entities/entity_component_system.hpp"
 #include "pragma/entities/components/base_generic_component.hpp"
+#include <sharedutils/scope_guard.h>
 #include <unordered_set>
 
 using namespace pragma;
@@ -35,17 +36,74 @@ void BaseEntityComponentSystem::ClearComponents()
 			throw std::logic_error("An unknown error occured when trying to remove an entity component!");
 	}
 }
+void BaseEntityComponentSystem::InvalidateEventSubscriptions() {++m_eventSubscriptionEpoch;}
+const std::vector<BaseEntityComponent*> &BaseEntityComponentSystem::GetEventSubscribers(ComponentEventId ev) const
+{
+	auto it = m_eventSubscribers.find(ev);
+	if(it == m_eventSubscribers.end())
+		it = m_eventSubscribers.insert(std::make_pair(ev,EventSubscribers{})).first;
+	auto &subscribers = it->second;
+	if(subscribers.epoch == m_eventSubscriptionEpoch)
+		return subscribers.components;
+	// The previous list may still be iterated by a broadcast further up the stack
+	if(m_eventDispatchDepth > 0 && subscribers.components.empty() == false)
+		m_retiredEventSubscribers.push_back(std::move(subscribers.components));
+	subscribers.components.clear();
+	subscribers.epoch = m_eventSubscriptionEpoch;
+
+	// The spawn events are handled by BaseEntityComponent::HandleEvent for every component
+	auto allComponents = (ev == BaseEntity::EVENT_ON_SPAWN || ev == BaseEntity::EVENT_ON_POST_SPAWN);
+	for(auto &component : m_components)
+	{
+		if(component == nullptr)
+			continue;
+		if(allComponents == false && component->m_boundEvents.find(ev) == component->m_boundEvents.end())
+		{
+			// Components with a custom event handler may be interested in any event
+			auto *info = m_componentManager->GetComponentInfo(component->GetComponentId());
+			if(info && umath::is_flag_set(info->flags,ComponentFlags::DefaultEventHandler) && umath::is_flag_set(info->flags,ComponentFlags::LuaBased) == false)
+				continue;
+		}
+		subscribers.components.push_back(component.get());
+	}
+	return subscribers.components;
+}
+void BaseEntityComponentSystem::EndEventDispatch() const
+{
+	if(--m_eventDispatchDepth > 0)
+		return;
+	m_retiredEventSubscribers.clear();
+	if(m_deferredComponentReleases.empty())
+		return;
+	// Releasing a component may trigger another broadcast, which may defer more releases
+	auto releases = std::move(m_deferredComponentReleases);
+	m_deferredComponentReleases.clear();
+	releases.clear();
+}
 util::EventReply BaseEntityComponentSystem::BroadcastEvent(ComponentEventId ev,ComponentEvent &evData,const BaseEntityComponent *src) const
 {
-	// We need to copy the current list of components, in case one of the events
-	// changes the container by adding or removing a component
-	auto tmpComponents = m_components;
-	for(auto &component : tmpComponents)
+	// Components may be added or removed by one of the event handlers. Instead of copying the component list,
+	// we iterate over the range of subscribers at the time of the broadcast, which stays valid until the
+	// outermost broadcast has ended (see EndEventDispatch). Components which have been removed in the meantime are skipped.
+	// An event handler may also remove the entity itself, in which case this system (and the subscriber list) has already been
+	// destroyed once the handler returns, so the entity handle has to be checked before anything else is accessed.
+	auto &subscribers = GetEventSubscribers(ev);
+	auto *components = subscribers.data();
+	auto numComponents = subscribers.size();
+	auto hEnt = m_entity->GetHandle();
+	++m_eventDispatchDepth;
+	util::ScopeGuard sg([this,&hEnt]() {
+		if(hEnt.valid())
+			EndEventDispatch();
+	});
+	for(auto i=decltype(numComponents){0u};i<numComponents;++i)
 	{
-		if(component == nullptr || component.get() == src)
+		auto *component = components[i];
+		if(component == src || umath::is_flag_set(component->m_stateFlags,BaseEntityComponent::StateFlags::Removed))
 			continue;
-		if(component->HandleEvent(ev,evData) == util::EventReply::Handled)
-			return util::EventReply::Handled;
+		auto reply = component->HandleEvent(ev,evData);
+		if(hEnt.valid() == false || reply == util::EventReply::Handled)
+			return reply;
 	}
 	return util::EventReply::Unhandled;
 }
@@ -73,6 +131,7 @@ pragma::ComponentHandle<pragma::BaseEntityComponent> BaseEntityComponentSystem::
 	if(m_components.size() == m_components.capacity())
 		m_components.reserve(m_components.size() +5u);
 	m_components.push_back(ptrComponent);
+	InvalidateEventSubscriptions();
 	auto it = m_componentLookupTable.find(componentId);
 	if(it == m_componentLookupTable.end())
 		m_componentLookupTable.insert(std::make_pair(componentId,ptrComponent));
@@ -135,7 +194,11 @@ void BaseEntityComponentSystem::RemoveComponent(pragma::BaseEntityComponent &com
 	}
 	component.OnRemove();
 	OnComponentRemoved(component);
+	// The component may still be referenced by the subscriber list of an ongoing broadcast
+	if(m_eventDispatchDepth > 0)
+		m_deferredComponentReleases.push_back(*it);
 	m_components.erase(it);
+	InvalidateEventSubscriptions();
 
 	auto itType = m_componentLookupTable.find(componentId);
 	if(itType != m_componentLookupTable.end())
@@ -0,0 +1,304 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright (c) 2021 Silverlan
+ */
+
+#include "stdafx_shared.h"
+#include "pragma/entities/entity_tick_scheduler.hpp"
+#include "pragma/entities/components/base_entity_component.hpp"
+#include "pragma/entities/baseentity.h"
+#include "pragma/util/job_system.hpp"
+#include <algorithm>
+#include <atomic>
+
+extern DLLNETWORK Engine *engine;
+
+using namespace pragma;
+
+EntityTickScheduler::EntityTickScheduler()
+{
+	m_groupComponents.resize(umath::to_integral(TickGroup::Count));
+}
+
+bool EntityTickScheduler::CompareSleepEntries(const SleepEntry &a,const SleepEntry &b) {return a.nextTick > b.nextTick;}
+bool EntityTickScheduler::IsSleepEntryValid(const SleepEntry &entry) const
+{
+	auto &slot = m_sleepSlots[entry.slot];
+	return slot.generation == entry.generation && slot.component != nullptr;
+}
+
+void EntityTickScheduler::Register(BaseEntityComponent &component)
+{
+	if(IsRegistered(component))
+		return;
+	PushActive(component);
+}
+void EntityTickScheduler::Unregister(BaseEntityComponent &component)
+{
+	auto &tickData = component.m_tickData;
+	switch(static_cast<SlotState>(tickData.schedulerState))
+	{
+	case SlotState::Active:
+		if(m_ticking)
+			m_active[tickData.schedulerIndex] = nullptr; // Will be erased by Tick
+		else
+			EraseActive(tickData.schedulerIndex);
+		break;
+	case SlotState::Sleeping:
+		ReleaseSleepSlot(tickData.schedulerIndex);
+		break;
+	default:
+		return;
+	}
+	tickData.schedulerState = static_cast<uint8_t>(SlotState::None);
+}
+void EntityTickScheduler::Wake(BaseEntityComponent &component)
+{
+	auto &tickData = component.m_tickData;
+	if(static_cast<SlotState>(tickData.schedulerState) != SlotState::Sleeping)
+		return;
+	ReleaseSleepSlot(tickData.schedulerIndex);
+	// If the component still isn't due, Tick will put it back to sleep with the new tick time
+	PushActive(component);
+}
+bool EntityTickScheduler::IsRegistered(const BaseEntityComponent &component) const {return static_cast<SlotState>(component.m_tickData.schedulerState) != SlotState::None;}
+
+void EntityTickScheduler::PushActive(BaseEntityComponent &component)
+{
+	auto &tickData = component.m_tickData;
+	tickData.schedulerState = static_cast<uint8_t>(SlotState::Active);
+	tickData.schedulerIndex = m_active.size();
+	m_active.push_back(&component);
+}
+void EntityTickScheduler::EraseActive(uint32_t idx)
+{
+	if(idx != m_active.size() -1)
+	{
+		auto *last = m_active.back();
+		m_active[idx] = last;
+		if(last)
+			last->m_tickData.schedulerIndex = idx;
+	}
+	m_active.pop_back();
+}
+void EntityTickScheduler::Sleep(uint32_t idx)
+{
+	auto &component = *m_active[idx];
+	EraseActive(idx);
+
+	uint32_t slotIdx;
+	if(m_freeSleepSlots.empty() == false)
+	{
+		slotIdx = m_freeSleepSlots.back();
+		m_freeSleepSlots.pop_back();
+	}
+	else
+	{
+		slotIdx = m_sleepSlots.size();
+		m_sleepSlots.push_back({});
+	}
+	auto &slot = m_sleepSlots[slotIdx];
+	slot.component = &component;
+
+	auto &tickData = component.m_tickData;
+	tickData.schedulerState = static_cast<uint8_t>(SlotState::Sleeping);
+	tickData.schedulerIndex = slotIdx;
+	m_sleepHeap.push_back({tickData.nextTick,slotIdx,slot.generation});
+	std::push_heap(m_sleepHeap.begin(),m_sleepHeap.end(),&CompareSleepEntries);
+	++m_sleepingCount;
+}
+void EntityTickScheduler::ReleaseSleepSlot(uint32_t slotIdx)
+{
+	auto &slot = m_sleepSlots[slotIdx];
+	slot.component = nullptr;
+	++slot.generation;
+	m_freeSleepSlots.push_back(slotIdx);
+	--m_sleepingCount;
+}
+void EntityTickScheduler::WakeDueComponents(double tCur)
+{
+	while(m_sleepHeap.empty() == false && m_sleepHeap.front().nextTick <= tCur)
+	{
+		std::pop_heap(m_sleepHeap.begin(),m_sleepHeap.end(),&CompareSleepEntries);
+		auto entry = m_sleepHeap.back();
+		m_sleepHeap.pop_back();
+		if(IsSleepEntryValid(entry) == false)
+			continue; // The component has been woken up or unregistered in the meantime
+		Wake(*m_sleepSlots[entry.slot].component);
+	}
+	CompactSleepHeap();
+}
+void EntityTickScheduler::CompactSleepHeap()
+{
+	// Stale entries are usually discarded once they're due, but if sleeping components are woken up
+	// or removed frequently, they may pile up
+	if(m_sleepHeap.size() <= m_sleepingCount *2 +64)
+		return;
+	m_sleepHeap.erase(std::remove_if(m_sleepHeap.begin(),m_sleepHeap.end(),[this](const SleepEntry &entry) {
+		return IsSleepEntryValid(entry) == false;
+	}),m_sleepHeap.end());
+	std::make_heap(m_sleepHeap.begin(),m_sleepHeap.end(),&CompareSleepEntries);
+}
+
+void EntityTickScheduler::SetMultithreaded(bool multithreaded) {m_multithreaded = multithreaded;}
+void EntityTickScheduler::SetDeterministic(bool deterministic) {m_deterministic = deterministic;}
+
+void EntityTickScheduler::TickParallelGroup(std::vector<BaseEntityComponent*> &components,double tDelta)
+{
+	// Components of the same entity have to be ticked sequentially, so they're grouped by entity.
+	// Sorting also ensures a stable order for the deterministic mode.
+	std::sort(components.begin(),components.end(),[](const BaseEntityComponent *a,const BaseEntityComponent *b) {
+		auto idxA = a->GetEntity().GetIndex();
+		auto idxB = b->GetEntity().GetIndex();
+		return (idxA != idxB) ? (idxA < idxB) : (a->GetComponentId() < b->GetComponentId());
+	});
+	m_groupEntityRanges.clear();
+	for(auto i=decltype(components.size()){0u};i<components.size();++i)
+	{
+		if(i == 0 || &components[i]->GetEntity() != &components[i -1]->GetEntity())
+			m_groupEntityRanges.push_back({static_cast<uint32_t>(i),0});
+		++m_groupEntityRanges.back().second;
+	}
+	m_groupResults.clear();
+	m_groupResults.resize(components.size(),1);
+
+	auto tickRange = [this,&components,tDelta](const std::pair<uint32_t,uint32_t> &range) {
+		for(auto i=range.first;i<range.first +range.second;++i)
+			m_groupResults[i] = components[i]->Tick(tDelta);
+	};
+	auto &jobSystem = engine->GetJobSystem();
+	if(m_deterministic || m_multithreaded == false || jobSystem.GetWorkerCount() == 0 || m_groupEntityRanges.size() < 2)
+	{
+		for(auto &range : m_groupEntityRanges)
+			tickRange(range);
+	}
+	else
+	{
+		// Workers (and the main thread) pull entities from a shared counter, so that threads that finish
+		// early pick up the remaining work
+		std::atomic<uint32_t> nextRange = 0;
+		auto numRanges = static_cast<uint32_t>(m_groupEntityRanges.size());
+		auto worker = [this,&nextRange,numRanges,&tickRange]() {
+			for(;;)
+			{
+				auto idx = nextRange.fetch_add(1);
+				if(idx >= numRanges)
+					break;
+				tickRange(m_groupEntityRanges[idx]);
+			}
+		};
+		auto numJobs = umath::min(jobSystem.GetWorkerCount(),numRanges -1);
+		pragma::JobCounter counter {};
+		for(auto i=decltype(numJobs){0u};i<numJobs;++i)
+			jobSystem.Schedule(worker,&counter);
+		worker();
+		jobSystem.Wait(counter);
+	}
+	m_stats.numTicked += components.size();
+
+	for(auto i=decltype(components.size()){0u};i<components.size();++i)
+	{
+		if(m_groupResults[i])
+			continue;
+		auto *c = components[i];
+		m_active[c->m_tickData.schedulerIndex] = nullptr; // Will be erased by Tick
+		c->m_tickData.schedulerState = static_cast<uint8_t>(SlotState::None);
+	}
+}
+
+void EntityTickScheduler::Tick(double tCur,double tDelta)
+{
+	m_stats = {};
+	WakeDueComponents(tCur);
+
+	// Note: During the loop, new components may be appended to m_active. Components that are
+	// unregistered during the loop are set to nullptr and erased here.
+	m_ticking = true;
+	auto hasParallelComponents = false;
+	for(auto i=decltype(m_active.size()){0u};i<m_active.size();)
+	{
+		auto *c = m_active[i];
+		if(c == nullptr)
+		{
+			EraseActive(i);
+			continue;
+		}
+		if(tCur < c->GetNextTick())
+		{
+			Sleep(i);
+			continue;
+		}
+		if(c->m_tickData.tickGroup != TickGroup::Main)
+		{
+			// Will be ticked after all main-thread components
+			hasParallelComponents = true;
+			++i;
+			continue;
+		}
+		++m_stats.numTicked;
+		auto keepTicking = c->Tick(tDelta);
+		if(m_active[i] != c)
+			continue; // Component has been unregistered during its tick
+		if(keepTicking == false)
+		{
+			c->m_tickData.schedulerState = static_cast<uint8_t>(SlotState::None);
+			EraseActive(i);
+			continue;
+		}
+		++i;
+	}
+
+	if(hasParallelComponents)
+	{
+		// Main-thread components may have removed or re-timed parallel components, so they have to be collected
+		// separately. Parallel components must not add or remove any components, so the pointers stay valid.
+		for(auto &components : m_groupComponents)
+			components.clear();
+		for(auto *c : m_active)
+		{
+			if(c == nullptr || c->m_tickData.tickGroup == TickGroup::Main || tCur < c->GetNextTick())
+				continue;
+			m_groupComponents[umath::to_integral(c->m_tickData.tickGroup)].push_back(c);
+		}
+		for(auto &components : m_groupComponents)
+		{
+			if(components.empty() == false)
+				TickParallelGroup(components,tDelta);
+		}
+		for(auto i=decltype(m_active.size()){0u};i<m_active.size();)
+		{
+			if(m_active[i] == nullptr)
+			{
+				EraseActive(i);
+				continue;
+			}
+			++i;
+		}
+	}
+	m_ticking = false;
+	m_stats.numSkipped = m_sleepingCount;
+}
+
+void EntityTickScheduler::Clear()
+{
+	for(auto *c : m_active)
+	{
+		if(c)
+			c->m_tickData.schedulerState = static_cast<uint8_t>(SlotState::None);
+	}
+	for(auto &slot : m_sleepSlots)
+	{
+		if(slot.component)
+			slot.component->m_tickData.schedulerState = static_cast<uint8_t>(SlotState::None);
+	}
+	m_active.clear();
+	m_sleepSlots.clear();
+	m_freeSleepSlots.clear();
+	m_sleepHeap.clear();
+	m_sleepingCount = 0;
+}
+
+uint32_t EntityTickScheduler::GetComponentCount() const {return m_active.size() +m_sleepingCount;}
+const EntityTickScheduler::Stats &EntityTickScheduler::GetStats() const {return m_stats;}
@@ -16,6 +16,7 @@
 #include "pragma/level/mapgeometry.h"
 #include <pragma/engine.h>
 #include "pragma/ai/navsystem.h"
+#include "pragma/ai/nav_path_service.hpp"
 #include "pragma/physics/environment.hpp"
 #include "pragma/physics/contact.hpp"
 #include "pragma/physics/constraint.hpp"
@@ -61,9 +62,16 @@
 #include <fsys/ifile.hpp>
 #include <luainterface.hpp>
 #include <udm.hpp>
+#include "pragma/util/job_system.hpp"
+#include <atomic>
 
 extern DLLNETWORK Engine *engine;
 
+static CVar cvEntityTickMultithreaded = GetEngineConVar("sh_entity_tick_multithreaded");
+static CVar cvEntityTickDeterministic = GetEngineConVar("debug_entity_tick_deterministic");
+static CVar cvAnimationMultithreaded = GetEngineConVar("sh_animation_multithreaded");
+static CVar cvNavPathIterationBudget = GetEngineConVar("sh_nav_path_iteration_budget");
+
 std::optional<std::string> Lua::VarToString(lua_State *lua,int n)
 {
 	auto t = GetType(lua,n);
@@ -246,7 +254,6 @@ Game::~Game() {}
 
 void Game::OnRemove()
 {
-	pragma::BaseAIComponent::ReleaseNavThread();
 	CallCallbacks<void>("OnLuaReleased",GetLuaState());
 	m_luaCallbacks.clear();
 	m_luaEnts = nullptr;
@@ -393,7 +400,6 @@ bool Game::LoadNavMesh(bool bReload)
 	m_navMesh = LoadNavMesh(path);
 	if(m_navMesh == nullptr)
 		Con::cwar<<"WARNING: Unable to load navigation mesh!"<<Con::endl;
-	pragma::BaseAIComponent::ReloadNavThread(*this);
 	return m_navMesh != nullptr;
 }
 
@@ -574,6 +580,9 @@ void Game::InitializeGame()
 			pragma::debug::ProfilingStage::Create(cpuProfiler,"Animations" +postFix,stageTick.get())
 		});
 		static_assert(umath::to_integral(CPUProfilingPhase::Count) == 6u,"Added new profiling phase, but did not create associated profiling stage!");
+		auto &stageLogic = m_profilingStageManager->GetProfilerStage(CPUProfilingPhase::GameObjectLogic);
+		m_counterComponentsTicked = stageLogic.AddCounter("Components ticked");
+		m_counterComponentsSkipped = stageLogic.AddCounter("Components skipped");
 	});
 }
 
@@ -643,8 +652,57 @@ void Game::ScheduleEntityForRemoval(BaseEntity &ent) {m_entsScheduledForRemoval.
 
 void Game::UpdateEntityAnimations(double dt)
 {
+	// The animation update is split into three stages. Everything that may invoke events (and therefore Lua) is
+	// executed serially on the main thread, only the pose evaluation of the entities is distributed among the worker threads.
+	// Note: UpdateEntityAnimations may be called recursively from Lua, so we'll work on a separate list
+	std::vector<pragma::ComponentHandle<pragma::BaseAnimatedComponent>> components {};
+	components.swap(m_animationUpdateComponents);
+	components.clear();
 	for(auto *ent : EntityIterator{*this,m_animatedComponentId})
-		ent->GetAnimatedComponent()->UpdateAnimations(dt);
+	{
+		auto animC = ent->GetAnimatedComponent();
+		if(animC->PrepareAnimationUpdate(dt))
+			components.push_back(animC->GetHandle<pragma::BaseAnimatedComponent>());
+	}
+
+	auto numComponents = static_cast<uint32_t>(components.size());
+	std::atomic<uint32_t> nextComponent = 0;
+	auto worker = [&components,&nextComponent,numComponents]() {
+		for(;;)
+		{
+			auto idx = nextComponent.fetch_add(1);
+			if(idx >= numComponents)
+				break;
+			auto &hComponent = components[idx];
+			if(hComponent.expired() == false)
+				hComponent->EvaluateAnimationPoses();
+		}
+	};
+	auto &jobSystem = engine->GetJobSystem();
+	if(cvAnimationMultithreaded->GetBool() == false || jobSystem.GetWorkerCount() == 0 || numComponents < 2)
+		worker();
+	else
+	{
+		// Workers (and the main thread) pull components from a shared counter, so that threads that finish early pick up the remaining work
+		auto numJobs = umath::min(jobSystem.GetWorkerCount(),numComponents -1);
+		pragma::JobCounter counter {};
+		for(auto i=decltype(numJobs){0u};i<numJobs;++i)
+			jobSystem.Schedule(worker,&counter);
+		worker();
+		jobSystem.Wait(counter);
+	}
+
+	for(auto &hComponent : components)
+	{
+		if(hComponent.expired())
+			continue;
+		hComponent->FinalizeAnimationUpdate();
+	}
+	components.clear();
+	if(m_animationUpdateComponents.empty())
+		components.swap(m_animationUpdateComponents); // Keep the capacity for the next update
+
+	// Panima components write their channel values directly to the animated component members (which may invoke change callbacks), so they're updated serially
 	EntityIterator entIt {*this};
 	entIt.AttachFilter<TEntityIteratorFilterComponent<pragma::PanimaComponent>>();
 	for(auto *ent : entIt)
@@ -741,29 +799,20 @@ void Game::Tick()
 	}
 
 	StartProfilingStage(CPUProfilingPhase::GameObjectLogic);
+
+	// Path requests are processed before the components are ticked, so AI components can pick up the results right away
+	if(m_navMesh)
+		m_navMesh->GetPathService().Update(static_cast<uint32_t>(umath::max(cvNavPathIterationBudget->GetInt(),0)));
 	
-	auto &logicComponents = GetEntityTickComponents();
-	// Note: During the loop, new items may be appended to the end of logicComponents, but no elements
-	// may be erased from outside sources. If an element is removed, it's set to nullptr.
-	for(auto i=decltype(logicComponents.size()){0u};i<logicComponents.size();)
+	m_entityTickScheduler.SetMultithreaded(cvEntityTickMultithreaded->GetBool());
+	m_entityTickScheduler.SetDeterministic(cvEntityTickDeterministic->GetBool());
+	m_entityTickScheduler.Tick(m_tCur,m_tDeltaTick);
+	if(m_profilingStageManager)
 	{
-		auto *c = logicComponents[i];
-		if(c == nullptr)
-		{
-			logicComponents.erase(logicComponents.begin() +i);
-			continue;
-		}
-		if(m_tCur < c->GetNextTick())
-		{
-			++i;
-			continue;
-		}
-		if(c->Tick(m_tDeltaTick) == false)
-		{
-			logicComponents.erase(logicComponents.begin() +i);
-			continue;
-		}
-		++i;
+		auto &stats = m_entityTickScheduler.GetStats();
+		auto &stage = m_profilingStageManager->GetProfilerStage(CPUProfilingPhase::GameObjectLogic);
+		stage.SetCounterValue(m_counterComponentsTicked,stats.numTicked);
+		stage.SetCounterValue(m_counterComponentsSkipped,stats.numSkipped);
 	}
 
 	StopProfilingStage(CPUProfilingPhase::GameObjectLogic);
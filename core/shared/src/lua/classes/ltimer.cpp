@@ -46,49 +46,49 @@ Timer::~Timer()
 	}
 }
 
-double Timer::GetCurTime(Game *game)
+float Timer::GetRemainingTime() const
 {
-	switch(m_timeType)
-	{
-	case TimerType::CurTime:
-		return game->CurTime();
-	case TimerType::RealTime:
-		return game->RealTime();
-	}
-	return game->ServerTime();
+	if(!m_bRunning || m_manager == nullptr)
+		return m_next;
+	return static_cast<float>(m_expiry -m_manager->GetTime(m_timeType));
 }
 
-double Timer::GetDeltaTime(Game *game)
+void Timer::ScheduleExpiry()
 {
-	switch(m_timeType)
-	{
-	case TimerType::CurTime:
-		return game->DeltaTickTime();
-	case TimerType::RealTime:
-		return game->DeltaRealTime();
-	}
-	return game->DeltaTickTime();
+	++m_scheduleId;
+	if(m_manager == nullptr)
+		return;
+	m_expiry = m_manager->GetTime(m_timeType) +m_next;
+	m_manager->Schedule(*this);
 }
 
+void Timer::CancelExpiry() {++m_scheduleId;}
+
 void Timer::Update(Game *game)
 {
 	if(!m_bRunning)
 		return;
-	m_next -= static_cast<float>(GetDeltaTime(game));
-	if(m_next <= 0)
+	m_next = GetRemainingTime();
+	if(m_next > 0)
 	{
-		Call(game);
-		if(m_reps > 0)
-		{
-			m_reps--;
-			if(m_reps == 0)
-				Remove(game);
-			else
-				Reset();
-		}
+		ScheduleExpiry();
+		return;
+	}
+	Call(game);
+	if(m_bRunning)
+		m_next = GetRemainingTime(); // The callback may have changed the interval
+	if(m_reps > 0)
+	{
+		m_reps--;
+		if(m_reps == 0)
+			Remove(game);
 		else
 			Reset();
 	}
+	else
+		Reset();
+	if(m_bRunning && m_bIsValid)
+		ScheduleExpiry();
 }
 
 void Timer::Call(Game *game)
@@ -123,28 +123,40 @@ void Timer::Reset()
 
 void Timer::Start(Game*)
 {
-	if(m_bRunning)
+	if(m_bRunning || !m_bIsValid)
 		return;
 	if(m_next == 0.f)
 		Reset();
 	m_bRunning = true;
+	ScheduleExpiry();
 }
 
 void Timer::Pause()
 {
+	if(!m_bRunning)
+		return;
+	m_next = GetRemainingTime();
 	m_bRunning = false;
+	CancelExpiry();
 }
 
 void Timer::Stop()
 {
 	m_bRunning = false;
 	m_next = 0.f;
+	CancelExpiry();
 }
 
 void Timer::Remove(Game *game)
 {
+	if(!m_bIsValid)
+		return;
 	m_bIsValid = false;
+	m_bRunning = false;
 	m_luaFunction = {};
+	CancelExpiry();
+	if(m_manager)
+		m_manager->ScheduleRemoval(*this);
 }
 
 bool Timer::IsValid() {return m_bIsValid;}
@@ -176,7 +188,7 @@ float Timer::GetTimeLeft()
 {
 	if(m_reps == 0)
 		return 0;
-	return std::max(m_next,0.f) +(m_reps -1) *m_delay;
+	return std::max(GetRemainingTime(),0.f) +(m_reps -1) *m_delay;
 }
 void Timer::SetTimeInterval(float time)
 {
@@ -185,7 +197,8 @@ void Timer::SetTimeInterval(float time)
 	if(!IsRunning())
 		return;
 	float tDelta = time -delayOld;
-	m_next += tDelta;
+	m_next = GetRemainingTime() +tDelta;
+	ScheduleExpiry();
 }
 float Timer::GetTimeInterval() {return m_delay;}
 unsigned int Timer::GetRepetitionsLeft() {return m_reps;}
@@ -205,38 +218,158 @@ void TimerRandom::Reset()
 */
 /////////////////////////////
 
-extern DLLNETWORK Engine *engine;
-Timer *Game::CreateTimer(float delay,int reps,LuaFunctionObject luaFunction,TimerType timeType)
+TimerManager::~TimerManager() {Clear();}
+
+bool TimerManager::CompareEntries(const ScheduleEntry &a,const ScheduleEntry &b) {return a.expiry > b.expiry;}
+
+Timer *TimerManager::CreateTimer(float delay,int reps,LuaFunctionObject luaFunction,TimerType timeType)
 {
-	m_timers.push_back(std::make_unique<Timer>(delay,reps,luaFunction,timeType));
-	return m_timers.back().get();
+	return AddTimer(std::make_unique<Timer>(delay,reps,luaFunction,timeType));
 }
 
-Timer *Game::CreateTimer(float delay,int reps,const CallbackHandle &hCallback,TimerType timeType)
+Timer *TimerManager::CreateTimer(float delay,int reps,const CallbackHandle &hCallback,TimerType timeType)
 {
-	m_timers.push_back(std::make_unique<Timer>(delay,reps,hCallback,timeType));
-	return m_timers.back().get();
+	return AddTimer(std::make_unique<Timer>(delay,reps,hCallback,timeType));
+}
+
+Timer *TimerManager::AddTimer(std::unique_ptr<Timer> timer)
+{
+	uint32_t slotIdx;
+	if(m_freeSlots.empty() == false)
+	{
+		slotIdx = m_freeSlots.back();
+		m_freeSlots.pop_back();
+	}
+	else
+	{
+		slotIdx = m_slots.size();
+		m_slots.push_back({});
+	}
+	timer->m_manager = this;
+	timer->m_slot = slotIdx;
+	auto &slot = m_slots[slotIdx];
+	slot.timer = std::move(timer);
+	++m_timerCount;
+	return slot.timer.get();
 }
 
-void Game::ClearTimers()
+void TimerManager::Schedule(Timer &timer)
 {
-	m_timers.clear();
+	auto &queue = m_queues[umath::to_integral(timer.m_timeType)];
+	queue.push_back({timer.m_expiry,timer.m_slot,m_slots[timer.m_slot].generation,timer.m_scheduleId});
+	std::push_heap(queue.begin(),queue.end(),&CompareEntries);
 }
 
-void Game::UpdateTimers()
+void TimerManager::ScheduleRemoval(Timer &timer) {m_pendingRemoval.push_back(timer.m_slot);}
+
+bool TimerManager::IsEntryValid(const ScheduleEntry &entry) const
 {
-	for(auto i=decltype(m_timers.size()){0u};i<m_timers.size();++i)
+	auto &slot = m_slots[entry.slot];
+	return slot.generation == entry.generation && slot.timer && slot.timer->m_bRunning && slot.timer->m_scheduleId == entry.scheduleId;
+}
+
+void TimerManager::Advance(TimerType type,double dt) {m_clocks[umath::to_integral(type)] += dt;}
+double TimerManager::GetTime(TimerType type) const {return m_clocks[umath::to_integral(type)];}
+uint32_t TimerManager::GetTimerCount() const {return m_timerCount;}
+
+void TimerManager::Update(Game *game)
+{
+	// Expired timers are collected first, so that timers which are re-scheduled with an expiry
+	// that has already passed won't be called again until the next update
+	m_dueTimers.clear();
+	for(auto i=decltype(m_queues.size()){0u};i<m_queues.size();++i)
 	{
-		auto &timer = *m_timers.at(i);
-		if(timer.IsValid() == false)
+		auto &queue = m_queues[i];
+		auto t = m_clocks[i];
+		while(queue.empty() == false && queue.front().expiry <= t)
 		{
-			m_timers.erase(m_timers.begin() +i);
+			std::pop_heap(queue.begin(),queue.end(),&CompareEntries);
+			auto entry = queue.back();
+			queue.pop_back();
+			if(IsEntryValid(entry))
+				m_dueTimers.push_back(entry);
+		}
+	}
+
+	m_updating = true;
+	for(auto &entry : m_dueTimers)
+	{
+		if(IsEntryValid(entry) == false)
+			continue; // Timer has been paused, stopped or removed by a previous callback
+		m_slots[entry.slot].timer->Update(game);
+	}
+	m_updating = false;
+
+	// Timers are only destroyed here, so that callbacks can safely remove any timer (including their own)
+	for(auto slotIdx : m_pendingRemoval)
+	{
+		auto &slot = m_slots[slotIdx];
+		if(slot.timer == nullptr)
 			continue;
+		slot.timer = nullptr;
+		++slot.generation;
+		m_freeSlots.push_back(slotIdx);
+		--m_timerCount;
+	}
+	m_pendingRemoval.clear();
+	CompactQueues();
+}
+
+void TimerManager::CompactQueues()
+{
+	// Invalidated entries are usually discarded once they expire, but if timers are paused, re-timed or removed
+	// frequently, they may pile up
+	for(auto &queue : m_queues)
+	{
+		if(queue.size() <= m_timerCount *2 +64)
+			continue;
+		queue.erase(std::remove_if(queue.begin(),queue.end(),[this](const ScheduleEntry &entry) {
+			return IsEntryValid(entry) == false;
+		}),queue.end());
+		std::make_heap(queue.begin(),queue.end(),&CompareEntries);
+	}
+}
+
+void TimerManager::Clear()
+{
+	if(m_updating)
+	{
+		// Timers mustn't be destroyed while they're being called
+		for(auto &slot : m_slots)
+		{
+			if(slot.timer)
+				slot.timer->Remove(nullptr);
 		}
-		timer.Update(this);
+		return;
 	}
+	m_slots.clear();
+	m_freeSlots.clear();
+	m_pendingRemoval.clear();
+	m_dueTimers.clear();
+	for(auto &queue : m_queues)
+		queue.clear();
+	m_timerCount = 0;
+}
+
+/////////////////////////////
+
+extern DLLNETWORK Engine *engine;
+Timer *Game::CreateTimer(float delay,int reps,LuaFunctionObject luaFunction,TimerType timeType) {return m_timerManager.CreateTimer(delay,reps,luaFunction,timeType);}
+
+Timer *Game::CreateTimer(float delay,int reps,const CallbackHandle &hCallback,TimerType timeType) {return m_timerManager.CreateTimer(delay,reps,hCallback,timeType);}
+
+void Game::ClearTimers() {m_timerManager.Clear();}
+
+void Game::UpdateTimers()
+{
+	m_timerManager.Advance(TimerType::CurTime,DeltaTickTime());
+	m_timerManager.Advance(TimerType::RealTime,DeltaRealTime());
+	m_timerManager.Advance(TimerType::ServerTime,DeltaTickTime());
+	m_timerManager.Update(this);
 }
 
+TimerManager &Game::GetTimerManager() {return m_timerManager;}
+
 /////////////////////////////
 
 DLLNETWORK void Lua_Timer_Start(lua_State *l,TimerHandle &timer)
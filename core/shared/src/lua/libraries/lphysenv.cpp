@@ -47,6 +47,8 @@ namespace Lua
 		static Lua::var<bool,luabind::tableT<TraceResult>,TraceResult> raycast(lua_State *l,Game &game,const ::TraceData &traceData);
 		static Lua::var<bool,luabind::tableT<TraceResult>,TraceResult> sweep(lua_State *l,Game &game,const ::TraceData &traceData);
 		static Lua::var<bool,luabind::tableT<TraceResult>,TraceResult> overlap(lua_State *l,Game &game,const ::TraceData &traceData);
+		static luabind::tableT<TraceResult> raycast_batch(lua_State *l,Game &game,const ::TraceData &traceData,luabind::tableT<Vector3> sources,luabind::tableT<Vector3> targets,bool resolveMeshes=false);
+		static luabind::tableT<TraceResult> sweep_batch(lua_State *l,Game &game,const ::TraceData &traceData,luabind::tableT<Vector3> sources,luabind::tableT<Vector3> targets,bool resolveMeshes=false);
 		static util::TSharedHandle<pragma::physics::IRigidBody> create_rigid_body(pragma::physics::IEnvironment *env,pragma::physics::IShape &shape,bool dynamic=true);
 		static std::shared_ptr<pragma::physics::IConvexHullShape> create_convex_hull_shape(pragma::physics::IEnvironment *env,pragma::physics::IMaterial &material);
 
@@ -157,6 +159,8 @@ void Lua::physenv::register_library(Lua::Interface &lua)
 		luabind::def("raycast",raycast),
 		luabind::def("sweep",sweep),
 		luabind::def("overlap",overlap),
+		luabind::def("raycast_batch",raycast_batch,luabind::default_parameter_policy<5,false>{}),
+		luabind::def("sweep_batch",sweep_batch,luabind::default_parameter_policy<5,false>{}),
 
 		luabind::def("calc_torque_from_angular_velocity",calc_torque_from_angular_velocity),
 		luabind::def("calc_angular_velocity_from_torque",calc_angular_velocity_from_torque),
@@ -895,6 +899,36 @@ Lua::var<bool,luabind::tableT<TraceResult>,TraceResult> Lua::physenv::overlap(lu
 		table[i +1] = res[i];
 	return table;
 }
+static luabind::tableT<TraceResult> batch_trace(lua_State *l,Game &game,TraceType type,const ::TraceData &traceData,luabind::tableT<Vector3> sources,luabind::tableT<Vector3> targets,bool resolveMeshes)
+{
+	auto numSources = Lua::GetObjectLength(l,sources);
+	auto numTargets = Lua::GetObjectLength(l,targets);
+	if(numSources != numTargets)
+		throw std::runtime_error{"Number of sources (" +std::to_string(numSources) +") doesn't match number of targets (" +std::to_string(numTargets) +")!"};
+	// The rotations of the trace data are used for all queries
+	std::vector<TraceQuery> queries;
+	queries.resize(numSources,TraceQuery{traceData.GetSource(),traceData.GetTarget()});
+	for(auto i=decltype(numSources){0u};i<numSources;++i)
+	{
+		queries[i].source.SetOrigin(luabind::object_cast<Vector3>(sources[i +1]));
+		queries[i].target.SetOrigin(luabind::object_cast<Vector3>(targets[i +1]));
+	}
+	std::vector<TraceResult> results;
+	results.resize(queries.size());
+	game.BatchTrace(type,traceData,queries.data(),static_cast<uint32_t>(queries.size()),results.data(),resolveMeshes);
+	auto t = luabind::newtable(l);
+	for(auto i=decltype(results.size()){0u};i<results.size();++i)
+		t[i +1] = std::move(results[i]);
+	return t;
+}
+luabind::tableT<TraceResult> Lua::physenv::raycast_batch(lua_State *l,Game &game,const ::TraceData &traceData,luabind::tableT<Vector3> sources,luabind::tableT<Vector3> targets,bool resolveMeshes)
+{
+	return batch_trace(l,game,TraceType::RayCast,traceData,sources,targets,resolveMeshes);
+}
+luabind::tableT<TraceResult> Lua::physenv::sweep_batch(lua_State *l,Game &game,const ::TraceData &traceData,luabind::tableT<Vector3> sources,luabind::tableT<Vector3> targets,bool resolveMeshes)
+{
+	return batch_trace(l,game,TraceType::Sweep,traceData,sources,targets,resolveMeshes);
+}
 std::shared_ptr<pragma::physics::IConvexHullShape> Lua::physenv::create_convex_hull_shape(pragma::physics::IEnvironment *env,pragma::physics::IMaterial &material)
 {
 	if(!env)
@@ -12,6 +12,9 @@
 #include <sharedutils/scope_guard.h>
 #include <sharedutils/util_file.h>
 #include <luainterface.hpp>
+#include <pragma/engine.h>
+
+extern DLLNETWORK Engine *engine;
 
 LuaDirectoryWatcherManager::LuaDirectoryWatcherManager(Game *game)
 	: m_game(game)
@@ -21,7 +24,13 @@ void LuaDirectoryWatcherManager::Poll()
 {
 	for(auto &watcher : m_watchers)
 		watcher->Poll();
+	if(m_reloadScheduler.HasPendingChanges() == false)
+		return;
+	// The budget is shared with the resource watchers
+	auto budget = engine->GetAssetReloadBudget();
+	engine->ConsumeAssetReloadBudget(budget -m_reloadScheduler.Process(budget));
 }
+const pragma::AssetReloadScheduler &LuaDirectoryWatcherManager::GetReloadScheduler() const {return m_reloadScheduler;}
 
 bool LuaDirectoryWatcherManager::IsLuaFile(const std::string &path,bool bAllowCompiled) const
 {
@@ -99,7 +108,8 @@ bool LuaDirectoryWatcherManager::MountDirectory(const std::string &path,bool bAb
 		if(bAbsolutePath)
 			watchFlags |= DirectoryWatcherCallback::WatchFlags::AbsolutePath;
 		m_watchers.push_back(std::make_shared<DirectoryWatcherCallback>(path,[this](const std::string &fName) {
-			OnLuaFileChanged(fName);
+			// Lua files are small, so they are not prefetched
+			m_reloadScheduler.AddChange(fName,[this,fName]() {OnLuaFileChanged(fName);});
 		},watchFlags));
 		return true;
 	}
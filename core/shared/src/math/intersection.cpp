@@ -11,6 +11,7 @@
 #include <algorithm>
 #include <pragma/model/modelmesh.h>
 #include <pragma/model/model.h>
+#include "pragma/model/triangle_bvh.hpp"
 
 bool Intersection::LineMesh(
 	const Vector3 &_start,const Vector3 &_dir,Model &mdl,LineMeshResult &r,bool precise,const std::vector<uint32_t> *bodyGroups,uint32_t lod,
@@ -95,17 +96,59 @@ bool Intersection::LineMesh(const Vector3 &_start,const Vector3 &_dir,ModelMesh
 	return hasFoundBetterCandidate;
 }
 
-static bool is_better_candidate(umath::intersection::Result oldResult,umath::intersection::Result newResult,float *tOld=nullptr,float *tNew=nullptr)
+static bool get_sub_mesh_bounds(const ModelSubMesh &subMesh,Vector3 &outMin,Vector3 &outMax)
 {
-	return newResult > oldResult || (tOld != nullptr && newResult == oldResult && tNew > tOld);
+	if(subMesh.GetGeometryType() != ModelSubMesh::GeometryType::Triangles || subMesh.GetTriangleCount() == 0)
+		return false;
+	subMesh.GetBounds(outMin,outMax);
+	if(uvec::distance_sqr(outMin,outMax) == 0.f)
+		return false;
+	for(uint8_t i=0;i<3;++i)
+	{
+		// If the mesh is flat on one plane, we'll inflate it slightly
+		if(outMax[i] -outMin[i] < 0.001)
+			outMax[i] = outMin[i] +0.001;
+	}
+	return true;
 }
-static bool is_better_candidate(umath::intersection::Result oldResult,umath::intersection::Result newResult,float tOld,float tNew)
+static bool is_line_in_bounds(const Vector3 &start,const Vector3 &dir,const Vector3 &min,const Vector3 &max)
 {
-	return is_better_candidate(oldResult,newResult,&tOld,&tNew);
+	auto tBounds = 0.f;
+	return umath::intersection::point_in_aabb(start,min,max) ||
+		umath::intersection::line_aabb(start,dir,min,max,&tBounds) != umath::intersection::Result::NoIntersection;
+}
+// Hits are looked for in two passes: Hits within the line first, and hits beyond the end of the line only if there are none.
+// Returns false if the pass cannot yield a better candidate than the current result.
+static bool get_trace_range(const Intersection::LineMeshResult &r,bool precise,bool withinLine,float &outTMin,float &outTMax)
+{
+	if(r.result == umath::intersection::Result::Intersect && (precise == false || withinLine == false))
+		return false;
+	if(withinLine)
+	{
+		outTMin = 0.f;
+		outTMax = (r.result == umath::intersection::Result::Intersect) ? umath::min(static_cast<float>(r.hitValue),1.f) : 1.f;
+		return true;
+	}
+	outTMin = 1.f;
+	outTMax = (r.result == umath::intersection::Result::OutOfRange) ? static_cast<float>(r.hitValue) : std::numeric_limits<float>::max();
+	return outTMax >= outTMin;
+}
+static void apply_hit(Intersection::LineMeshResult &r,ModelSubMesh &subMesh,const Vector3 &start,const Vector3 &dir,const pragma::TriangleBvh::Hit &hit,bool withinLine)
+{
+	r.result = withinLine ? umath::intersection::Result::Intersect : umath::intersection::Result::OutOfRange;
+	r.hitValue = hit.t;
+	r.hitPos = start +dir *hit.t;
+	r.precise = r.precise ? r.precise : std::make_shared<Intersection::LineMeshResult::Precise>();
+	r.precise->subMesh = subMesh.shared_from_this();
+	r.precise->triIdx = hit.triIdx;
+	r.precise->t = hit.t;
+	r.precise->u = hit.u;
+	r.precise->v = hit.v;
 }
 bool Intersection::LineMesh(const Vector3 &_start,const Vector3 &_dir,ModelSubMesh &subMesh,LineMeshResult &r,bool precise,const Vector3 *origin,const Quat *rot)
 {
-	if(subMesh.GetGeometryType() != ModelSubMesh::GeometryType::Triangles || subMesh.GetTriangleCount() == 0)
+	Vector3 min,max;
+	if(get_sub_mesh_bounds(subMesh,min,max) == false)
 		return false;
 	auto start = _start;
 	auto dir = _dir;
@@ -114,68 +157,124 @@ bool Intersection::LineMesh(const Vector3 &_start,const Vector3 &_dir,ModelSubMe
 		uvec::world_to_local(*origin,*rot,start);
 		uvec::rotate(&dir,uquat::get_inverse(*rot));
 	}
+	if(is_line_in_bounds(start,dir,min,max) == false)
+		return false;
+	auto bvh = subMesh.GetTriangleBvh();
+	if(bvh == nullptr)
+		return false;
+	r.precise = r.precise ? r.precise : std::make_shared<LineMeshResult::Precise>();
+	for(auto withinLine : {true,false})
+	{
+		pragma::TriangleBvh::Ray ray {start,dir};
+		if(get_trace_range(r,precise,withinLine,ray.tMin,ray.tMax) == false)
+			continue;
+		pragma::TriangleBvh::Hit hit;
+		if(bvh->Raycast(ray,hit,precise == false && withinLine) == false)
+			continue;
+		apply_hit(r,subMesh,start,dir,hit,withinLine);
+		return true;
+	}
+	return false;
+}
 
+static void transform_lines(const Intersection::Line *lines,uint32_t numLines,const Vector3 &origin,const Quat &rot,std::vector<Intersection::Line> &outLines)
+{
+	auto invRot = uquat::get_inverse(rot);
+	outLines.resize(numLines);
+	for(auto i=decltype(numLines){0u};i<numLines;++i)
+	{
+		auto &line = outLines[i];
+		line = lines[i];
+		uvec::world_to_local(origin,rot,line.start);
+		uvec::rotate(&line.dir,invRot);
+	}
+}
+static uint32_t line_mesh(const Intersection::Line *lines,uint32_t numLines,ModelSubMesh &subMesh,Intersection::LineMeshResult *outResults,bool precise,std::vector<bool> &outUpdated)
+{
+	outUpdated.assign(numLines,false);
 	Vector3 min,max;
-	subMesh.GetBounds(min,max);
-	if(uvec::distance_sqr(min,max) == 0.f)
-		return false;
-	for(uint8_t i=0;i<3;++i)
+	if(get_sub_mesh_bounds(subMesh,min,max) == false)
+		return 0;
+	std::vector<uint32_t> candidates;
+	candidates.reserve(numLines);
+	for(auto i=decltype(numLines){0u};i<numLines;++i)
 	{
-		// If the mesh is flat on one plane, we'll inflate it slightly
-		if(max[i] -min[i] < 0.001)
-			max[i] = min[i] +0.001;
+		if(is_line_in_bounds(lines[i].start,lines[i].dir,min,max))
+			candidates.push_back(i);
 	}
-	auto tBounds = 0.f;
-	if(
-		!umath::intersection::point_in_aabb(start,min,max) &&
-		umath::intersection::line_aabb(start,dir,min,max,&tBounds) == umath::intersection::Result::NoIntersection
-	)
-		return false;
-	
-	r.precise = r.precise ? r.precise : std::make_shared<LineMeshResult::Precise>();
-	auto &verts = subMesh.GetVertices();
-	auto bHit = false;
-	auto hasFoundBetterCandidate = false;
-	auto foundEarlyIntersection = false;
-	subMesh.VisitIndices([&verts,&start,&dir,&r,&hasFoundBetterCandidate,&foundEarlyIntersection,&bHit,&precise](auto *indexDataSrc,uint32_t numIndicesSrc) {
-		for(auto i=decltype(numIndicesSrc){0};i<numIndicesSrc;i+=3)
+	if(candidates.empty())
+		return 0;
+	auto bvh = subMesh.GetTriangleBvh();
+	if(bvh == nullptr)
+		return 0;
+	std::vector<pragma::TriangleBvh::Ray> rays;
+	std::vector<pragma::TriangleBvh::Hit> hits;
+	std::vector<uint32_t> rayLines;
+	rays.reserve(candidates.size());
+	rayLines.reserve(candidates.size());
+	uint32_t numUpdated = 0;
+	for(auto withinLine : {true,false})
+	{
+		rays.clear();
+		rayLines.clear();
+		for(auto lineIdx : candidates)
 		{
-			auto &va = verts[indexDataSrc[i]].position;
-			auto &vb = verts[indexDataSrc[i +1]].position;
-			auto &vc = verts[indexDataSrc[i +2]].position;
-
-			umath::Plane p {va,vb,vc};
-			float tl;
-			auto rCur = umath::intersection::line_plane(start,dir,p.GetNormal(),p.GetDistance(),&tl);
-			if(is_better_candidate(r.result,rCur,r.hitValue,tl) == false)
+			pragma::TriangleBvh::Ray ray {lines[lineIdx].start,lines[lineIdx].dir};
+			if(outUpdated[lineIdx] || get_trace_range(outResults[lineIdx],precise,withinLine,ray.tMin,ray.tMax) == false)
 				continue;
-			double t,u,v;
-			if(umath::intersection::line_triangle(start,dir,va,vb,vc,t,u,v,true) == false)
+			rays.push_back(ray);
+			rayLines.push_back(lineIdx);
+		}
+		if(rays.empty())
+			continue;
+		hits.resize(rays.size());
+		if(bvh->Raycast(rays.data(),hits.data(),static_cast<uint32_t>(rays.size()),precise == false && withinLine) == 0)
+			continue;
+		for(auto i=decltype(hits.size()){0u};i<hits.size();++i)
+		{
+			if(hits[i].IsValid() == false)
 				continue;
-			hasFoundBetterCandidate = true;
-			r.result = rCur;
-			bHit = true;
-			r.precise->triIdx = i /3;
-			r.hitValue = tl;
-			r.hitPos = start +dir *static_cast<float>(r.hitValue);
-
-			if(precise == false && r.result == umath::intersection::Result::Intersect)
-			{
-				foundEarlyIntersection = true;
-				break;
-			}
+			auto lineIdx = rayLines[i];
+			apply_hit(outResults[lineIdx],subMesh,rays[i].start,rays[i].dir,hits[i],withinLine);
+			outUpdated[lineIdx] = true;
+			++numUpdated;
 		}
-	});
-	if(foundEarlyIntersection)
-		return true;
-	if(bHit == true)
+	}
+	return numUpdated;
+}
+uint32_t Intersection::LineMesh(const Line *lines,uint32_t numLines,ModelSubMesh &subMesh,LineMeshResult *outResults,bool precise,const Vector3 *origin,const Quat *rot)
+{
+	std::vector<Line> localLines;
+	if(origin != nullptr && rot != nullptr)
 	{
-		if(r.precise)
-			r.precise->subMesh = subMesh.shared_from_this();
-		if(r.hitValue >= 0.f && r.hitValue <= 1.f)
-			r.result = umath::intersection::Result::Intersect;
-		else
-			r.result = umath::intersection::Result::OutOfRange;
+		transform_lines(lines,numLines,*origin,*rot,localLines);
+		lines = localLines.data();
 	}
-	return hasFoundBetterCandidate;
+	std::vector<bool> updated;
+	return line_mesh(lines,numLines,subMesh,outResults,precise,updated);
+}
+uint32_t Intersection::LineMesh(const Line *lines,uint32_t numLines,ModelMesh &mesh,LineMeshResult *outResults,bool precise,const Vector3 *origin,const Quat *rot)
+{
+	std::vector<Line> localLines;
+	if(origin != nullptr && rot != nullptr)
+	{
+		transform_lines(lines,numLines,*origin,*rot,localLines);
+		lines = localLines.data();
+	}
+	std::vector<bool> updatedByMesh(numLines,false);
+	std::vector<bool> updated;
+	auto &subMeshes = mesh.GetSubMeshes();
+	for(auto i=decltype(subMeshes.size()){0u};i<subMeshes.size();++i)
+	{
+		if(line_mesh(lines,numLines,*subMeshes[i],outResults,precise,updated) == 0)
+			continue;
+		for(auto j=decltype(numLines){0u};j<numLines;++j)
+		{
+			if(updated[j] == false)
+				continue;
+			updatedByMesh[j] = true;
+			outResults[j].precise->subMeshIdx = i;
+		}
+	}
+	return static_cast<uint32_t>(std::count(updatedByMesh.begin(),updatedByMesh.end(),true));
 }
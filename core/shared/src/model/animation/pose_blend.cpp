@@ -0,0 +1,217 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright (c) 2021 Silverlan
+ */
+
+#include "stdafx_shared.h"
+#include "pragma/model/animation/pose_blend.hpp"
+#include <mathutil/transform.hpp>
+#include <cmath>
+
+using namespace pragma::animation;
+
+void PoseBuffer::Resize(size_t numBones)
+{
+	for(auto &channel : m_channels)
+		channel.resize(numBones);
+	m_numBones = numBones;
+}
+
+void PoseBuffer::Load(const std::vector<umath::Transform> &poses,const std::vector<Vector3> *scales)
+{
+	auto n = poses.size();
+	Resize(n);
+	auto *px = GetChannel(Channel::PositionX);
+	auto *py = GetChannel(Channel::PositionY);
+	auto *pz = GetChannel(Channel::PositionZ);
+	auto *rw = GetChannel(Channel::RotationW);
+	auto *rx = GetChannel(Channel::RotationX);
+	auto *ry = GetChannel(Channel::RotationY);
+	auto *rz = GetChannel(Channel::RotationZ);
+	for(auto i=decltype(n){0u};i<n;++i)
+	{
+		auto &pos = poses[i].GetOrigin();
+		auto &rot = poses[i].GetRotation();
+		px[i] = pos.x;
+		py[i] = pos.y;
+		pz[i] = pos.z;
+		rw[i] = rot.w;
+		rx[i] = rot.x;
+		ry[i] = rot.y;
+		rz[i] = rot.z;
+	}
+
+	auto *sx = GetChannel(Channel::ScaleX);
+	auto *sy = GetChannel(Channel::ScaleY);
+	auto *sz = GetChannel(Channel::ScaleZ);
+	m_hasScales = (scales && scales->empty() == false);
+	auto numScales = m_hasScales ? umath::min(scales->size(),n) : size_t{0};
+	for(auto i=decltype(numScales){0u};i<numScales;++i)
+	{
+		auto &scale = (*scales)[i];
+		sx[i] = scale.x;
+		sy[i] = scale.y;
+		sz[i] = scale.z;
+	}
+	std::fill(sx +numScales,sx +n,1.f);
+	std::fill(sy +numScales,sy +n,1.f);
+	std::fill(sz +numScales,sz +n,1.f);
+}
+
+void PoseBuffer::Store(std::vector<umath::Transform> &outPoses,std::vector<Vector3> *outScales) const
+{
+	auto n = m_numBones;
+	outPoses.resize(n);
+	auto *px = GetChannel(Channel::PositionX);
+	auto *py = GetChannel(Channel::PositionY);
+	auto *pz = GetChannel(Channel::PositionZ);
+	auto *rw = GetChannel(Channel::RotationW);
+	auto *rx = GetChannel(Channel::RotationX);
+	auto *ry = GetChannel(Channel::RotationY);
+	auto *rz = GetChannel(Channel::RotationZ);
+	for(auto i=decltype(n){0u};i<n;++i)
+	{
+		auto &pose = outPoses[i];
+		pose.SetOrigin(Vector3{px[i],py[i],pz[i]});
+		pose.SetRotation(Quat{rw[i],rx[i],ry[i],rz[i]});
+	}
+	if(outScales == nullptr)
+		return;
+	if(m_hasScales == false)
+	{
+		outScales->clear();
+		return;
+	}
+	outScales->resize(n);
+	auto *sx = GetChannel(Channel::ScaleX);
+	auto *sy = GetChannel(Channel::ScaleY);
+	auto *sz = GetChannel(Channel::ScaleZ);
+	for(auto i=decltype(n){0u};i<n;++i)
+		(*outScales)[i] = {sx[i],sy[i],sz[i]};
+}
+
+void PoseBuffer::SetIdentity(size_t offset)
+{
+	if(offset >= m_numBones)
+		return;
+	for(auto c : {Channel::PositionX,Channel::PositionY,Channel::PositionZ,Channel::RotationX,Channel::RotationY,Channel::RotationZ})
+		std::fill(GetChannel(c) +offset,GetChannel(c) +m_numBones,0.f);
+	for(auto c : {Channel::RotationW,Channel::ScaleX,Channel::ScaleY,Channel::ScaleZ})
+		std::fill(GetChannel(c) +offset,GetChannel(c) +m_numBones,1.f);
+}
+
+// Branch-free kernels; The loops only contain arithmetic on contiguous float arrays, so they can be auto-vectorized.
+// Note: The pointers may alias (out may be the same as src or dst), but every element is read before it is written.
+static void blend_positions(
+	const float *srcX,const float *srcY,const float *srcZ,const float *dstX,const float *dstY,const float *dstZ,
+	float *outX,float *outY,float *outZ,const float *weights,float interpFactor,size_t offset,size_t count
+)
+{
+	for(auto i=offset;i<offset +count;++i)
+	{
+		auto t = interpFactor *(weights ? weights[i] : 1.f);
+		outX[i] = srcX[i] +(dstX[i] -srcX[i]) *t;
+		outY[i] = srcY[i] +(dstY[i] -srcY[i]) *t;
+		outZ[i] = srcZ[i] +(dstZ[i] -srcZ[i]) *t;
+	}
+}
+static void blend_rotations(
+	const float *srcW,const float *srcX,const float *srcY,const float *srcZ,const float *dstW,const float *dstX,const float *dstY,const float *dstZ,
+	float *outW,float *outX,float *outY,float *outZ,const float *weights,float interpFactor,size_t offset,size_t count
+)
+{
+	for(auto i=offset;i<offset +count;++i)
+	{
+		auto t = interpFactor *(weights ? weights[i] : 1.f);
+		auto aw = srcW[i];
+		auto ax = srcX[i];
+		auto ay = srcY[i];
+		auto az = srcZ[i];
+		auto bw = dstW[i];
+		auto bx = dstX[i];
+		auto by = dstY[i];
+		auto bz = dstZ[i];
+		// Shortest path
+		auto cosTheta = aw *bw +ax *bx +ay *by +az *bz;
+		auto d = std::abs(cosTheta);
+		auto sign = std::copysign(1.f,cosTheta);
+
+		// Polynomial correction of the interpolation factor, so that a normalized lerp closely matches slerp
+		// (max. error ~1e-4 radians). See "Approximating slerp" by A. Kapoulkine.
+		auto A = 1.0904f +d *(-3.2452f +d *(3.55645f -d *1.43519f));
+		auto B = 0.848013f +d *(-1.06021f +d *0.215638f);
+		auto k = A *(t -0.5f) *(t -0.5f) +B;
+		auto ot = t +t *(t -0.5f) *(t -1.f) *k;
+
+		auto wa = 1.f -ot;
+		auto wb = ot *sign;
+		auto rw = aw *wa +bw *wb;
+		auto rx = ax *wa +bx *wb;
+		auto ry = ay *wa +by *wb;
+		auto rz = az *wa +bz *wb;
+		auto invLen = 1.f /std::sqrt(rw *rw +rx *rx +ry *ry +rz *rz);
+		outW[i] = rw *invLen;
+		outX[i] = rx *invLen;
+		outY[i] = ry *invLen;
+		outZ[i] = rz *invLen;
+	}
+}
+static void blend_scales(
+	const float *srcX,const float *srcY,const float *srcZ,const float *dstX,const float *dstY,const float *dstZ,
+	float *outX,float *outY,float *outZ,const float *weights,float interpFactor,size_t offset,size_t count
+)
+{
+	for(auto i=offset;i<offset +count;++i)
+	{
+		auto w = weights ? weights[i] : 1.f;
+		outX[i] = srcX[i] +(dstX[i] *w -srcX[i]) *interpFactor;
+		outY[i] = srcY[i] +(dstY[i] *w -srcY[i]) *interpFactor;
+		outZ[i] = srcZ[i] +(dstZ[i] *w -srcZ[i]) *interpFactor;
+	}
+}
+
+void pragma::animation::blend_poses(const PoseBuffer &src,const PoseBuffer &dst,const std::vector<float> &boneWeights,float interpFactor,PoseBuffer &out)
+{
+	using Channel = PoseBuffer::Channel;
+	auto n = umath::min(src.GetBoneCount(),dst.GetBoneCount(),out.GetBoneCount());
+	auto hasScales = src.HasScales() && dst.HasScales();
+	auto numWeighted = umath::min(n,boneWeights.size());
+	auto blend = [&](const float *weights,size_t offset,size_t count) {
+		blend_positions(
+			src.GetChannel(Channel::PositionX),src.GetChannel(Channel::PositionY),src.GetChannel(Channel::PositionZ),
+			dst.GetChannel(Channel::PositionX),dst.GetChannel(Channel::PositionY),dst.GetChannel(Channel::PositionZ),
+			out.GetChannel(Channel::PositionX),out.GetChannel(Channel::PositionY),out.GetChannel(Channel::PositionZ),
+			weights,interpFactor,offset,count
+		);
+		blend_rotations(
+			src.GetChannel(Channel::RotationW),src.GetChannel(Channel::RotationX),src.GetChannel(Channel::RotationY),src.GetChannel(Channel::RotationZ),
+			dst.GetChannel(Channel::RotationW),dst.GetChannel(Channel::RotationX),dst.GetChannel(Channel::RotationY),dst.GetChannel(Channel::RotationZ),
+			out.GetChannel(Channel::RotationW),out.GetChannel(Channel::RotationX),out.GetChannel(Channel::RotationY),out.GetChannel(Channel::RotationZ),
+			weights,interpFactor,offset,count
+		);
+		if(hasScales == false)
+			return;
+		blend_scales(
+			src.GetChannel(Channel::ScaleX),src.GetChannel(Channel::ScaleY),src.GetChannel(Channel::ScaleZ),
+			dst.GetChannel(Channel::ScaleX),dst.GetChannel(Channel::ScaleY),dst.GetChannel(Channel::ScaleZ),
+			out.GetChannel(Channel::ScaleX),out.GetChannel(Channel::ScaleY),out.GetChannel(Channel::ScaleZ),
+			weights,interpFactor,offset,count
+		);
+	};
+	blend(boneWeights.data(),0,numWeighted);
+	blend(nullptr,numWeighted,n -numWeighted);
+
+	// Consistent with BlendBonePoses, scales are only blended if both inputs have them, otherwise
+	// the output scales are left untouched (or reset if the output is a separate buffer)
+	auto outIsInput = (&out == &src || &out == &dst);
+	if(hasScales == false && outIsInput == false)
+	{
+		for(auto c : {Channel::ScaleX,Channel::ScaleY,Channel::ScaleZ})
+			std::fill(out.GetChannel(c),out.GetChannel(c) +n,1.f);
+	}
+	if(outIsInput == false)
+		out.SetHasScales(true);
+	out.SetIdentity(n);
+}
@@ -8,6 +8,7 @@
 #include "stdafx_shared.h"
 #include <pragma/definitions.h>
 #include "pragma/model/model.h"
+#include "pragma/model/modelmanager.h"
 #include <pragma/engine.h>
 #include "materialmanager.h"
 #include "pragma/model/animation/activities.h"
@@ -592,6 +593,8 @@ uint32_t Model::AddTexture(const std::string &tex,Material *mat)
 	if(it != meta.textures.end())
 		return it -meta.textures.begin();
 	meta.textures.push_back(ntex);
+	if(m_networkState)
+		m_networkState->GetModelManager().RegisterMaterialUser(*this,ntex);
 	if(mat == nullptr)
 		m_materials.push_back(msys::MaterialHandle{});
 	else
@@ -606,6 +609,8 @@ bool Model::SetTexture(uint32_t texIdx,const std::string &tex,Material *mat)
 		auto ntex = tex;
 		ufile::remove_extension_from_filename(ntex,pragma::asset::get_supported_extensions(pragma::asset::Type::Material));
 		meta.textures.at(texIdx) = ntex;
+		if(m_networkState)
+			m_networkState->GetModelManager().RegisterMaterialUser(*this,ntex);
 	}
 	if(mat == nullptr)
 		m_materials.at(texIdx) = {};
@@ -271,8 +271,66 @@ void pragma::asset::ModelManager::InitializeProcessor(util::IAssetProcessor &pro
 util::AssetObject pragma::asset::ModelManager::InitializeAsset(const util::Asset &asset,const util::AssetLoadJob &job)
 {
 	auto &mdlProcessor = *static_cast<ModelProcessor*>(job.processor.get());
+	if(mdlProcessor.model)
+		RegisterMaterialUsers(*mdlProcessor.model);
 	return mdlProcessor.model;
 }
+std::string pragma::asset::ModelManager::GetMaterialIndexKey(const std::string &material)
+{
+	auto key = ufile::get_file_from_filename(material);
+	ufile::remove_extension_from_filename(key,pragma::asset::get_supported_extensions(pragma::asset::Type::Material));
+	ustring::to_lower(key);
+	return key;
+}
+void pragma::asset::ModelManager::RegisterMaterialUser(Model &mdl,const std::string &material)
+{
+	auto hMdl = mdl.weak_from_this();
+	if(hMdl.expired())
+		return;
+	auto key = GetMaterialIndexKey(material);
+	std::scoped_lock lock {m_materialUserMutex};
+	auto &hUser = m_materialUsers[key][&mdl];
+	// The entry may still belong to an expired model at the same address
+	if(hUser.owner_before(hMdl) || hMdl.owner_before(hUser))
+		hUser = hMdl;
+}
+void pragma::asset::ModelManager::RegisterMaterialUsers(Model &mdl)
+{
+	for(auto &tex : mdl.GetTextures())
+		RegisterMaterialUser(mdl,tex);
+}
+std::vector<std::shared_ptr<Model>> pragma::asset::ModelManager::FindMaterialUsers(const std::string &material)
+{
+	auto key = GetMaterialIndexKey(material);
+	std::scoped_lock lock {m_materialUserMutex};
+	auto it = m_materialUsers.find(key);
+	if(it == m_materialUsers.end())
+		return {};
+	std::vector<std::shared_ptr<Model>> models;
+	auto &users = it->second;
+	models.reserve(users.size());
+	for(auto itUser=users.begin();itUser!=users.end();)
+	{
+		auto mdl = itUser->second.lock();
+		// The texture list of a model can be changed at any time, so the entry has to be validated
+		auto isUser = false;
+		if(mdl)
+		{
+			auto &textures = mdl->GetTextures();
+			isUser = std::find_if(textures.begin(),textures.end(),[&key](const std::string &tex) {return GetMaterialIndexKey(tex) == key;}) != textures.end();
+		}
+		if(isUser == false)
+		{
+			itUser = users.erase(itUser);
+			continue;
+		}
+		models.push_back(mdl);
+		++itUser;
+	}
+	if(users.empty())
+		m_materialUsers.erase(it);
+	return models;
+}
 #if 0
 bool pragma::asset::ModelManager::PrecacheModel(const std::string &mdlName) const
 {
@@ -8,8 +8,10 @@
 #include "stdafx_shared.h"
 #include "pragma/model/modelmesh.h"
 #include <mathutil/uvec.h>
+#include "pragma/model/triangle_bvh.hpp"
 #include <pragma/math/intersection.h>
 #include <udm.hpp>
+#include <mutex>
 
 ModelMesh::ModelMesh()
 	: std::enable_shared_from_this<ModelMesh>(),m_numVerts(0),m_numIndices(0)
@@ -180,7 +182,7 @@ ModelSubMesh::ModelSubMesh(const ModelSubMesh &other)
 	m_extensions->Read(extStreamFileIn);
 	//
 
-	static_assert(sizeof(ModelSubMesh) == 232,"Update this function when making changes to this class!");
+	static_assert(sizeof(ModelSubMesh) == 248,"Update this function when making changes to this class!");
 }
 std::shared_ptr<ModelSubMesh> ModelSubMesh::Load(const udm::AssetData &data,std::string &outErr)
 {
@@ -193,7 +195,7 @@ bool ModelSubMesh::operator==(const ModelSubMesh &other) const {return this == &
 bool ModelSubMesh::operator!=(const ModelSubMesh &other) const {return !operator==(other);}
 bool ModelSubMesh::IsEqual(const ModelSubMesh &other) const
 {
-	static_assert(sizeof(ModelSubMesh) == 232,"Update this function when making changes to this class!");
+	static_assert(sizeof(ModelSubMesh) == 248,"Update this function when making changes to this class!");
 	if(!(m_skinTextureIndex == other.m_skinTextureIndex && uvec::cmp(m_center,other.m_center) && m_numAlphas == other.m_numAlphas && uvec::cmp(m_min,other.m_min) &&
 		uvec::cmp(m_max,other.m_max) && m_geometryType == other.m_geometryType && m_referenceId == other.m_referenceId &&
 		static_cast<bool>(m_vertices) == static_cast<bool>(other.m_vertices) && static_cast<bool>(m_alphas) == static_cast<bool>(other.m_alphas) &&
@@ -299,7 +301,7 @@ void ModelSubMesh::Copy(ModelSubMesh &cpy,bool fullCopy) const
 	ufile::InStreamFile extStreamFileIn {std::move(extStreamFileOut.MoveStream())};
 	m_extensions->Read(extStreamFileIn);
 	//
-	static_assert(sizeof(ModelSubMesh) == 232,"Update this function when making changes to this class!");
+	static_assert(sizeof(ModelSubMesh) == 248,"Update this function when making changes to this class!");
 }
 std::shared_ptr<ModelSubMesh> ModelSubMesh::Copy(bool fullCopy) const
 {
@@ -316,6 +318,7 @@ umath::ScaledTransform &ModelSubMesh::GetPose() {return m_pose;}
 void ModelSubMesh::SetPose(const umath::ScaledTransform &pose) {m_pose = pose;}
 void ModelSubMesh::Scale(const Vector3 &scale)
 {
+	ClearTriangleBvh();
 	m_pose.SetOrigin(m_pose.GetOrigin() *scale);
 	for(auto &v : *m_vertices)
 		v.position *= scale;
@@ -419,10 +422,12 @@ void ModelSubMesh::SetShared(const ModelSubMesh &other,ShareMode mode)
 }
 void ModelSubMesh::ClearTriangles()
 {
+	ClearTriangleBvh();
 	m_indexData = std::make_shared<std::vector<uint8_t>>();
 }
 void ModelSubMesh::Centralize(const Vector3 &origin)
 {
+	ClearTriangleBvh();
 	for(auto &v : *m_vertices)
 		v.position -= origin;
 	m_center -= origin;
@@ -499,6 +504,7 @@ void ModelSubMesh::GenerateNormals()
 }
 void ModelSubMesh::Rotate(const Quat &rot)
 {
+	ClearTriangleBvh();
 	for(auto &v : *m_vertices)
 	{
 		uvec::rotate(&v.position,rot);
@@ -513,6 +519,7 @@ void ModelSubMesh::Rotate(const Quat &rot)
 }
 void ModelSubMesh::Translate(const Vector3 &t)
 {
+	ClearTriangleBvh();
 	for(auto &v : *m_vertices)
 		v.position += t;
 	m_center += t;
@@ -696,8 +703,29 @@ void ModelSubMesh::SetIndexType(pragma::model::IndexType type)
 }
 ModelSubMesh::GeometryType ModelSubMesh::GetGeometryType() const {return m_geometryType;}
 void ModelSubMesh::SetGeometryType(GeometryType type) {m_geometryType = type;}
+static std::mutex g_triangleBvhMutex;
+std::shared_ptr<const pragma::TriangleBvh> ModelSubMesh::GetTriangleBvh() const
+{
+	{
+		std::scoped_lock lock {g_triangleBvhMutex};
+		if(m_triangleBvh)
+			return m_triangleBvh;
+	}
+	// The hierarchy is built without holding the lock; If multiple threads build it at the same time, the first one wins
+	std::shared_ptr<const pragma::TriangleBvh> bvh = pragma::TriangleBvh::Create(*this);
+	std::scoped_lock lock {g_triangleBvhMutex};
+	if(!m_triangleBvh)
+		m_triangleBvh = bvh;
+	return m_triangleBvh;
+}
+void ModelSubMesh::ClearTriangleBvh()
+{
+	std::scoped_lock lock {g_triangleBvhMutex};
+	m_triangleBvh = nullptr;
+}
 void ModelSubMesh::Update(ModelUpdateFlags flags)
 {
+	ClearTriangleBvh();
 	if((flags &ModelUpdateFlags::UpdateBounds) == ModelUpdateFlags::None)
 		return;
 	m_min = Vector3(std::numeric_limits<Vector3::value_type>::max(),std::numeric_limits<Vector3::value_type>::max(),std::numeric_limits<Vector3::value_type>::max());
@@ -0,0 +1,392 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright (c) 2021 Silverlan
+ */
+
+#include "stdafx_shared.h"
+#include "pragma/model/triangle_bvh.hpp"
+#include "pragma/model/modelmesh.h"
+#include <mathutil/umath_geometry.hpp>
+#include <algorithm>
+#include <array>
+#include <bit>
+
+// Beyond this depth nodes are split at the median instead, which limits the depth of the tree to MAX_DEPTH
+static constexpr uint32_t MAX_SAH_DEPTH = 32;
+static constexpr uint32_t MAX_DEPTH = 64;
+// Cost of traversing a node relative to the cost of intersecting a triangle
+static constexpr float TRAVERSAL_COST = 1.f;
+// Node bounds are enlarged slightly, so that flat meshes and rays grazing a node are not missed due to precision errors
+static constexpr float BOUNDS_EPSILON = 0.001f;
+
+struct pragma::TriangleBvh::BuildTriangle
+{
+	Vector3 min;
+	Vector3 max;
+	Vector3 centroid;
+	// Index into the unsorted triangle list
+	uint32_t index = 0;
+};
+
+static float get_half_area(const Vector3 &min,const Vector3 &max)
+{
+	auto d = max -min;
+	return d.x *d.y +d.y *d.z +d.z *d.x;
+}
+static Vector3 get_inverse_direction(const Vector3 &dir)
+{
+	Vector3 invDir;
+	for(uint8_t i=0;i<3;++i)
+		invDir[i] = (dir[i] != 0.f) ? (1.f /dir[i]) : std::numeric_limits<float>::max();
+	return invDir;
+}
+static bool intersect_bounds(const Vector3 &min,const Vector3 &max,const Vector3 &start,const Vector3 &invDir,float tMin,float tMax,float &outEntry)
+{
+	for(uint8_t i=0;i<3;++i)
+	{
+		auto t0 = (min[i] -start[i]) *invDir[i];
+		auto t1 = (max[i] -start[i]) *invDir[i];
+		if(t0 > t1)
+			std::swap(t0,t1);
+		tMin = umath::max(tMin,t0);
+		tMax = umath::min(tMax,t1);
+		if(tMin > tMax)
+			return false;
+	}
+	outEntry = tMin;
+	return true;
+}
+
+std::shared_ptr<pragma::TriangleBvh> pragma::TriangleBvh::Create(const ModelSubMesh &subMesh)
+{
+	if(subMesh.GetGeometryType() != ModelSubMesh::GeometryType::Triangles || subMesh.GetTriangleCount() == 0)
+		return nullptr;
+	auto &verts = subMesh.GetVertices();
+	std::vector<Triangle> triangles;
+	std::vector<uint32_t> triangleIndices;
+	std::vector<BuildTriangle> buildTris;
+	subMesh.VisitIndices([&verts,&triangles,&triangleIndices,&buildTris](auto *indexData,uint32_t numIndices) {
+		auto numTris = numIndices /3;
+		triangles.reserve(numTris);
+		triangleIndices.reserve(numTris);
+		buildTris.reserve(numTris);
+		for(auto i=decltype(numTris){0u};i<numTris;++i)
+		{
+			auto idx0 = indexData[i *3];
+			auto idx1 = indexData[i *3 +1];
+			auto idx2 = indexData[i *3 +2];
+			if(idx0 >= verts.size() || idx1 >= verts.size() || idx2 >= verts.size())
+				continue;
+			Triangle tri {verts[idx0].position,verts[idx1].position,verts[idx2].position};
+			BuildTriangle buildTri {};
+			buildTri.min = tri.v0;
+			buildTri.max = tri.v0;
+			for(auto *v : {&tri.v1,&tri.v2})
+			{
+				uvec::min(&buildTri.min,*v);
+				uvec::max(&buildTri.max,*v);
+			}
+			buildTri.centroid = (tri.v0 +tri.v1 +tri.v2) /3.f;
+			buildTri.index = static_cast<uint32_t>(triangles.size());
+			buildTris.push_back(buildTri);
+			triangles.push_back(tri);
+			triangleIndices.push_back(i);
+		}
+	});
+	if(triangles.empty())
+		return nullptr;
+	std::shared_ptr<TriangleBvh> bvh {new TriangleBvh{}};
+	// A binary tree with at most one triangle per leaf has 2n -1 nodes
+	bvh->m_nodes.reserve(triangles.size() *2 -1);
+	bvh->m_nodes.push_back({});
+	bvh->BuildNode(0,buildTris,0,static_cast<uint32_t>(buildTris.size()),0);
+	bvh->m_nodes.shrink_to_fit();
+
+	bvh->m_triangles.resize(triangles.size());
+	bvh->m_triangleIndices.resize(triangles.size());
+	for(auto i=decltype(buildTris.size()){0u};i<buildTris.size();++i)
+	{
+		bvh->m_triangles[i] = triangles[buildTris[i].index];
+		bvh->m_triangleIndices[i] = triangleIndices[buildTris[i].index];
+	}
+	return bvh;
+}
+
+void pragma::TriangleBvh::BuildNode(uint32_t nodeIdx,std::vector<BuildTriangle> &buildTris,uint32_t first,uint32_t count,uint32_t depth)
+{
+	auto itBegin = buildTris.begin() +first;
+	auto itEnd = itBegin +count;
+	Vector3 min {std::numeric_limits<float>::max()};
+	Vector3 max {std::numeric_limits<float>::lowest()};
+	auto cmin = min;
+	auto cmax = max;
+	for(auto it=itBegin;it!=itEnd;++it)
+	{
+		uvec::min(&min,it->min);
+		uvec::max(&max,it->max);
+		uvec::min(&cmin,it->centroid);
+		uvec::max(&cmax,it->centroid);
+	}
+	auto &node = m_nodes[nodeIdx];
+	node.min = min -Vector3{BOUNDS_EPSILON};
+	node.max = max +Vector3{BOUNDS_EPSILON};
+
+	auto makeLeaf = [this,nodeIdx,first,count]() {
+		auto &node = m_nodes[nodeIdx];
+		node.index = first;
+		node.triangleCount = count;
+	};
+	if(count <= 1)
+	{
+		makeLeaf();
+		return;
+	}
+
+	// Find the cheapest split with a binned surface area heuristic
+	auto parentArea = get_half_area(min,max);
+	auto bestAxis = -1;
+	uint32_t bestBin = 0;
+	auto bestCost = std::numeric_limits<float>::max();
+	if(depth < MAX_SAH_DEPTH && parentArea > 0.f)
+	{
+		struct Bin
+		{
+			Vector3 min {std::numeric_limits<float>::max()};
+			Vector3 max {std::numeric_limits<float>::lowest()};
+			uint32_t count = 0;
+		};
+		for(uint8_t axis=0;axis<3;++axis)
+		{
+			auto extent = cmax[axis] -cmin[axis];
+			if(extent <= 0.f)
+				continue;
+			std::array<Bin,SAH_BIN_COUNT> bins {};
+			auto scale = SAH_BIN_COUNT /extent;
+			for(auto it=itBegin;it!=itEnd;++it)
+			{
+				auto binIdx = umath::min(static_cast<uint32_t>((it->centroid[axis] -cmin[axis]) *scale),SAH_BIN_COUNT -1);
+				auto &bin = bins[binIdx];
+				uvec::min(&bin.min,it->min);
+				uvec::max(&bin.max,it->max);
+				++bin.count;
+			}
+			// Accumulate the bins from the right, then sweep from the left to evaluate every split plane
+			std::array<float,SAH_BIN_COUNT> rightAreas {};
+			std::array<uint32_t,SAH_BIN_COUNT> rightCounts {};
+			Bin accum {};
+			for(auto i=SAH_BIN_COUNT -1;i>0;--i)
+			{
+				uvec::min(&accum.min,bins[i].min);
+				uvec::max(&accum.max,bins[i].max);
+				accum.count += bins[i].count;
+				rightAreas[i] = (accum.count > 0) ? get_half_area(accum.min,accum.max) : 0.f;
+				rightCounts[i] = accum.count;
+			}
+			accum = {};
+			for(auto i=decltype(SAH_BIN_COUNT){0u};i<SAH_BIN_COUNT -1;++i)
+			{
+				uvec::min(&accum.min,bins[i].min);
+				uvec::max(&accum.max,bins[i].max);
+				accum.count += bins[i].count;
+				if(accum.count == 0 || rightCounts[i +1] == 0)
+					continue;
+				auto cost = TRAVERSAL_COST +(get_half_area(accum.min,accum.max) *accum.count +rightAreas[i +1] *rightCounts[i +1]) /parentArea;
+				if(cost >= bestCost)
+					continue;
+				bestCost = cost;
+				bestAxis = axis;
+				bestBin = i;
+			}
+		}
+	}
+
+	auto mid = first;
+	if(bestAxis != -1 && (bestCost < count || count > MAX_LEAF_TRIANGLES))
+	{
+		auto axis = bestAxis;
+		auto scale = SAH_BIN_COUNT /(cmax[axis] -cmin[axis]);
+		auto itMid = std::partition(itBegin,itEnd,[axis,scale,bestBin,&cmin](const BuildTriangle &tri) {
+			return umath::min(static_cast<uint32_t>((tri.centroid[axis] -cmin[axis]) *scale),SAH_BIN_COUNT -1) <= bestBin;
+		});
+		mid = first +static_cast<uint32_t>(itMid -itBegin);
+	}
+	else if(count <= MAX_LEAF_TRIANGLES)
+	{
+		makeLeaf();
+		return;
+	}
+	if(mid == first || mid == first +count)
+	{
+		// No usable split plane; Split at the median of the longest axis instead
+		auto extents = cmax -cmin;
+		auto axis = (extents.x > extents.y) ? ((extents.x > extents.z) ? 0 : 2) : ((extents.y > extents.z) ? 1 : 2);
+		mid = first +count /2;
+		std::nth_element(itBegin,buildTris.begin() +mid,itEnd,[axis](const BuildTriangle &a,const BuildTriangle &b) {
+			return a.centroid[axis] < b.centroid[axis];
+		});
+	}
+
+	auto leftIdx = static_cast<uint32_t>(m_nodes.size());
+	m_nodes.push_back({});
+	BuildNode(leftIdx,buildTris,first,mid -first,depth +1);
+	auto rightIdx = static_cast<uint32_t>(m_nodes.size());
+	m_nodes.push_back({});
+	m_nodes[nodeIdx].index = rightIdx;
+	BuildNode(rightIdx,buildTris,mid,first +count -mid,depth +1);
+}
+
+bool pragma::TriangleBvh::IntersectTriangles(const Node &node,const Ray &ray,float tMax,Hit &outHit) const
+{
+	auto found = false;
+	for(auto i=node.index;i<node.index +node.triangleCount;++i)
+	{
+		auto &tri = m_triangles[i];
+		double t,u,v;
+		if(umath::intersection::line_triangle(ray.start,ray.dir,tri.v0,tri.v1,tri.v2,t,u,v,true) == false || t < ray.tMin || t > tMax)
+			continue;
+		tMax = static_cast<float>(t);
+		outHit.triIdx = m_triangleIndices[i];
+		outHit.t = tMax;
+		outHit.u = static_cast<float>(u);
+		outHit.v = static_cast<float>(v);
+		found = true;
+	}
+	return found;
+}
+
+bool pragma::TriangleBvh::Raycast(const Ray &ray,Hit &outHit,bool anyHit) const
+{
+	outHit = {};
+	auto invDir = get_inverse_direction(ray.dir);
+	auto tMax = ray.tMax;
+	float tEntry;
+	if(intersect_bounds(m_nodes.front().min,m_nodes.front().max,ray.start,invDir,ray.tMin,tMax,tEntry) == false)
+		return false;
+	// Every inner node adds at most one entry to the stack
+	std::array<std::pair<uint32_t,float>,MAX_DEPTH +1> stack;
+	uint32_t stackSize = 0;
+	stack[stackSize++] = {0u,tEntry};
+	while(stackSize > 0)
+	{
+		auto [nodeIdx,tNode] = stack[--stackSize];
+		if(tNode > tMax)
+			continue;
+		auto &node = m_nodes[nodeIdx];
+		if(node.IsLeaf())
+		{
+			if(IntersectTriangles(node,ray,tMax,outHit) == false)
+				continue;
+			if(anyHit)
+				return true;
+			tMax = outHit.t;
+			continue;
+		}
+		// Visit the closer child first
+		auto leftIdx = nodeIdx +1;
+		auto rightIdx = node.index;
+		float tLeft,tRight;
+		auto hitLeft = intersect_bounds(m_nodes[leftIdx].min,m_nodes[leftIdx].max,ray.start,invDir,ray.tMin,tMax,tLeft);
+		auto hitRight = intersect_bounds(m_nodes[rightIdx].min,m_nodes[rightIdx].max,ray.start,invDir,ray.tMin,tMax,tRight);
+		if(hitLeft && hitRight)
+		{
+			if(tLeft <= tRight)
+			{
+				stack[stackSize++] = {rightIdx,tRight};
+				stack[stackSize++] = {leftIdx,tLeft};
+			}
+			else
+			{
+				stack[stackSize++] = {leftIdx,tLeft};
+				stack[stackSize++] = {rightIdx,tRight};
+			}
+		}
+		else if(hitLeft)
+			stack[stackSize++] = {leftIdx,tLeft};
+		else if(hitRight)
+			stack[stackSize++] = {rightIdx,tRight};
+	}
+	return outHit.IsValid();
+}
+
+uint32_t pragma::TriangleBvh::Raycast(const Ray *rays,Hit *outHits,uint32_t numRays,bool anyHit) const
+{
+	for(auto offset=decltype(numRays){0u};offset<numRays;offset+=PACKET_SIZE)
+	{
+		auto count = umath::min(numRays -offset,PACKET_SIZE);
+		if(count == 1)
+			Raycast(rays[offset],outHits[offset],anyHit);
+		else
+			RaycastPacket(rays +offset,outHits +offset,count,anyHit);
+	}
+	return static_cast<uint32_t>(std::count_if(outHits,outHits +numRays,[](const Hit &hit) {return hit.IsValid();}));
+}
+
+void pragma::TriangleBvh::RaycastPacket(const Ray *rays,Hit *outHits,uint32_t numRays,bool anyHit) const
+{
+	static_assert(PACKET_SIZE <= 32);
+	std::array<Vector3,PACKET_SIZE> invDirs;
+	std::array<float,PACKET_SIZE> tMax;
+	uint32_t activeMask = 0;
+	for(auto i=decltype(numRays){0u};i<numRays;++i)
+	{
+		outHits[i] = {};
+		invDirs[i] = get_inverse_direction(rays[i].dir);
+		tMax[i] = rays[i].tMax;
+		activeMask |= 1u<<i;
+	}
+	// The whole packet descends into a node if any of its active rays intersects the node's bounds
+	std::array<uint32_t,MAX_DEPTH +1> stack;
+	uint32_t stackSize = 0;
+	stack[stackSize++] = 0u;
+	while(stackSize > 0 && activeMask != 0)
+	{
+		auto nodeIdx = stack[--stackSize];
+		auto &node = m_nodes[nodeIdx];
+		uint32_t nodeMask = 0;
+		for(auto mask=activeMask;mask!=0;mask&=mask -1)
+		{
+			auto i = std::countr_zero(mask);
+			float tEntry;
+			if(intersect_bounds(node.min,node.max,rays[i].start,invDirs[i],rays[i].tMin,tMax[i],tEntry))
+				nodeMask |= 1u<<i;
+		}
+		if(nodeMask == 0)
+			continue;
+		if(node.IsLeaf())
+		{
+			for(auto mask=nodeMask;mask!=0;mask&=mask -1)
+			{
+				auto i = std::countr_zero(mask);
+				if(IntersectTriangles(node,rays[i],tMax[i],outHits[i]) == false)
+					continue;
+				tMax[i] = outHits[i].t;
+				if(anyHit)
+					activeMask &= ~(1u<<i);
+			}
+			continue;
+		}
+		// Visit the child that is closer along the direction of the first intersecting ray first
+		auto leftIdx = nodeIdx +1;
+		auto rightIdx = node.index;
+		auto &left = m_nodes[leftIdx];
+		auto &right = m_nodes[rightIdx];
+		auto &dir = rays[std::countr_zero(nodeMask)].dir;
+		if(uvec::dot((left.min +left.max) -(right.min +right.max),dir) <= 0.f)
+		{
+			stack[stackSize++] = rightIdx;
+			stack[stackSize++] = leftIdx;
+		}
+		else
+		{
+			stack[stackSize++] = leftIdx;
+			stack[stackSize++] = rightIdx;
+		}
+	}
+}
+
+uint32_t pragma::TriangleBvh::GetTriangleCount() const {return static_cast<uint32_t>(m_triangles.size());}
+uint32_t pragma::TriangleBvh::GetNodeCount() const {return static_cast<uint32_t>(m_nodes.size());}
+const Vector3 &pragma::TriangleBvh::GetMin() const {return m_nodes.front().min;}
+const Vector3 &pragma::TriangleBvh::GetMax() const {return m_nodes.front().max;}
@@ -112,6 +112,28 @@ BaseEntity *nwm::read_entity(NetPacket &packet)
 	return ::read_entity(packet);
 }
 
+void nwm::write_varint(NetPacket &packet,uint32_t value)
+{
+	while(value >= 0x80)
+	{
+		packet->Write<uint8_t>(static_cast<uint8_t>(value) | 0x80);
+		value >>= 7;
+	}
+	packet->Write<uint8_t>(static_cast<uint8_t>(value));
+}
+uint32_t nwm::read_varint(NetPacket &packet)
+{
+	uint32_t value = 0;
+	for(auto shift=0u;shift<32;shift+=7)
+	{
+		auto byte = packet->Read<uint8_t>();
+		value |= static_cast<uint32_t>(byte &0x7F)<<shift;
+		if((byte &0x80) == 0)
+			break;
+	}
+	return value;
+}
+
 void nwm::write_player(NetPacket &packet,const BaseEntity *pl)
 {
 	write_entity(packet,pl);
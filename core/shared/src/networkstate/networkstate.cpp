@@ -22,6 +22,7 @@
 #include "pragma/game/gamemode/gamemodemanager.h"
 #include "pragma/game/game_resources.hpp"
 #include "pragma/util/resource_watcher.h"
+#include "pragma/lua/lua_script_watcher.h"
 #include "pragma/entities/components/base_player_component.hpp"
 #include "pragma/model/modelmanager.h"
 #include "pragma/debug/intel_vtune.hpp"
@@ -75,9 +76,13 @@ NetworkState::NetworkState()
 		auto &cpuProfiler = engine->GetProfiler();
 		m_profilingStageManager = std::make_unique<pragma::debug::ProfilingStageManager<pragma::debug::ProfilingStage,CPUProfilingPhase>>();
 		m_profilingStageManager->InitializeProfilingStageManager(cpuProfiler,{
-			pragma::debug::ProfilingStage::Create(cpuProfiler,"UpdateSounds" +postFix,&engine->GetProfilingStageManager()->GetProfilerStage(Engine::CPUProfilingPhase::Think))
+			pragma::debug::ProfilingStage::Create(cpuProfiler,"UpdateSounds" +postFix,&engine->GetProfilingStageManager()->GetProfilerStage(Engine::CPUProfilingPhase::Think)),
+			pragma::debug::ProfilingStage::Create(cpuProfiler,"ReloadAssets" +postFix,&engine->GetProfilingStageManager()->GetProfilerStage(Engine::CPUProfilingPhase::Think))
 		});
-		static_assert(umath::to_integral(CPUProfilingPhase::Count) == 1u,"Added new profiling phase, but did not create associated profiling stage!");
+		static_assert(umath::to_integral(CPUProfilingPhase::Count) == 2u,"Added new profiling phase, but did not create associated profiling stage!");
+		auto &stageReload = m_profilingStageManager->GetProfilerStage(CPUProfilingPhase::ReloadAssets);
+		m_counterPendingReloads = stageReload.AddCounter("Pending reloads");
+		m_counterReloadLatency = stageReload.AddCounter("Max. reload latency (us)");
 	});
 }
 NetworkState::~NetworkState()
@@ -770,7 +775,24 @@ void NetworkState::Think()
 	Game *game = GetGameState();
 	if(game != NULL)
 		game->Think();
+	StartProfilingStage(CPUProfilingPhase::ReloadAssets);
 	m_resourceWatcher->Poll();
+	if(m_profilingStageManager)
+	{
+		// Lua scripts are reloaded by the game (see Game::Think)
+		auto numPending = m_resourceWatcher->GetPendingReloadCount();
+		auto latency = m_resourceWatcher->GetReloadScheduler().GetStats().maxApplyLatency;
+		if(game != nullptr)
+		{
+			auto &luaStats = game->GetLuaScriptWatcher().GetReloadScheduler().GetStats();
+			numPending += luaStats.queueDepth;
+			latency = std::max(latency,luaStats.maxApplyLatency);
+		}
+		auto &stage = m_profilingStageManager->GetProfilerStage(CPUProfilingPhase::ReloadAssets);
+		stage.SetCounterValue(m_counterPendingReloads,numPending);
+		stage.SetCounterValue(m_counterReloadLatency,latency.count());
+	}
+	StopProfilingStage(CPUProfilingPhase::ReloadAssets);
 	m_tLast = m_tReal;
 	for(unsigned int i=0;i<m_thinkCallbacks.size();i++)
 		m_thinkCallbacks[i]();
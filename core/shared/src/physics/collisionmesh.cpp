@@ -60,9 +60,10 @@ CollisionMesh::CollisionMesh(const CollisionMesh &other)
 	m_surfaceMaterialId = other.m_surfaceMaterialId;
 	m_centerOfMass = other.m_centerOfMass;
 	m_volume = other.m_volume;
+	m_buoyancyVolumeTable = other.m_buoyancyVolumeTable;
 	m_mass = other.m_mass;
 	m_softBodyInfo = (m_softBodyInfo != nullptr) ? std::make_shared<SoftBodyInfo>(*other.m_softBodyInfo) : nullptr;
-	static_assert(sizeof(CollisionMesh) == 200,"Update this function when making changes to this class!");
+	static_assert(sizeof(CollisionMesh) == 216,"Update this function when making changes to this class!");
 }
 bool CollisionMesh::operator==(const CollisionMesh &other) const
 {
@@ -90,7 +91,7 @@ bool CollisionMesh::operator==(const CollisionMesh &other) const
 		if(uvec::cmp(m_vertices[i],other.m_vertices[i]) == false)
 			return false;
 	}
-	static_assert(sizeof(CollisionMesh) == 200,"Update this function when making changes to this class!");
+	static_assert(sizeof(CollisionMesh) == 216,"Update this function when making changes to this class!");
 	return true;
 }
 void CollisionMesh::SetMass(float mass) {m_mass = mass;}
@@ -113,6 +114,7 @@ void CollisionMesh::AddVertex(const Vector3 &v)
 	if(m_vertices.size() == m_vertices.capacity())
 		m_vertices.reserve(static_cast<uint32_t>(m_vertices.size() *1.5));
 	m_vertices.push_back(v);
+	ClearBuoyancyVolumeTable();
 }
 void CollisionMesh::Rotate(const Quat &rot)
 {
@@ -121,6 +123,7 @@ void CollisionMesh::Rotate(const Quat &rot)
 	uvec::rotate(&m_origin,rot);
 	uvec::rotate(&m_min,rot);
 	uvec::rotate(&m_max,rot);
+	ClearBuoyancyVolumeTable();
 }
 void CollisionMesh::Translate(const Vector3 &t)
 {
@@ -129,6 +132,7 @@ void CollisionMesh::Translate(const Vector3 &t)
 	m_origin += t;
 	m_min += t;
 	m_max += t;
+	ClearBuoyancyVolumeTable();
 }
 void CollisionMesh::Scale(const Vector3 &scale)
 {
@@ -137,6 +141,7 @@ void CollisionMesh::Scale(const Vector3 &scale)
 	m_origin *= scale;
 	m_min *= scale;
 	m_max *= scale;
+	ClearBuoyancyVolumeTable();
 }
 std::shared_ptr<pragma::physics::IShape> CollisionMesh::CreateShape(const Vector3 &scale) const
 {
@@ -267,6 +272,7 @@ void CollisionMesh::CalculateBounds()
 }
 void CollisionMesh::Update(ModelUpdateFlags flags)
 {
+	ClearBuoyancyVolumeTable();
 	if((flags &ModelUpdateFlags::UpdateBounds) != ModelUpdateFlags::None)
 		CalculateBounds();
 	if((flags &ModelUpdateFlags::UpdateCollisionShapes) != ModelUpdateFlags::None)
@@ -282,6 +288,7 @@ void CollisionMesh::Centralize()
 	SetOrigin(GetOrigin() +-center);
 	for(auto &v : m_vertices)
 		v -= center;
+	ClearBuoyancyVolumeTable();
 }
 void CollisionMesh::GetAABB(Vector3 *min,Vector3 *max) const
 {
@@ -292,7 +299,11 @@ void CollisionMesh::SetAABB(Vector3 &min,Vector3 &max)
 {
 	m_min = min;
 	m_max = max;
+	ClearBuoyancyVolumeTable();
 }
+const std::shared_ptr<const pragma::physics::BuoyancyVolumeTable> &CollisionMesh::GetBuoyancyVolumeTable() const {return m_buoyancyVolumeTable;}
+void CollisionMesh::SetBuoyancyVolumeTable(const std::shared_ptr<const pragma::physics::BuoyancyVolumeTable> &table) {m_buoyancyVolumeTable = table;}
+void CollisionMesh::ClearBuoyancyVolumeTable() {m_buoyancyVolumeTable = nullptr;}
 std::shared_ptr<pragma::physics::IShape> CollisionMesh::GetShape() {return m_shape;}
 bool CollisionMesh::IntersectAABB(Vector3 *min,Vector3 *max)
 {
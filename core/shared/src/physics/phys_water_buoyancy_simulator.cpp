@@ -19,31 +19,165 @@
 #include "pragma/entities/components/base_transform_component.hpp"
 #include "pragma/entities/components/submergible_component.hpp"
 #include "pragma/entities/components/velocity_component.hpp"
+#include "pragma/util/job_system.hpp"
 #include <pragma/physics/movetypes.h>
+#include <pragma/console/convars.h>
+#include "pragma/console/engine_cvar.h"
+#include <pragma/engine.h>
 
 // See http://www.randygaul.net/wp-content/uploads/2014/02/RigidBodies_WaterSurface.pdf for algorithms
 
 #define ENABLE_DEBUG_DRAW 0
 
+extern DLLNETWORK Engine *engine;
+
+static CVar cvVolumeTables = GetEngineConVar("sh_water_buoyancy_volume_tables");
+
+// Generic mesh for physics meshes without triangles
+static const std::vector<uint16_t> g_aabbTriangles = {
+	0,6,7, // 1
+	0,7,5, // 1
+	3,0,5, // 2
+	3,1,0, // 2
+	2,0,1, // 3
+	2,6,0, // 3
+	7,6,2, // 4
+	4,7,2, // 4
+	4,1,3, // 5
+	1,4,2, // 5
+	4,3,5, // 6
+	4,5,7 // 6
+};
+static std::vector<Vector3> get_aabb_vertices(const Vector3 &min,const Vector3 &max)
+{
+	return {
+		min, // 0
+		Vector3(max.x,min.y,min.z), // 1
+		Vector3(max.x,min.y,max.z), // 2
+		Vector3(max.x,max.y,min.z), // 3
+		max, // 4
+		Vector3(min.x,max.y,min.z), // 5
+		Vector3(min.x,min.y,max.z), // 6
+		Vector3(min.x,max.y,max.z) // 7
+	};
+}
+
+Vector3 pragma::physics::BuoyancyVolumeTable::GetDirection(uint32_t face,uint32_t x,uint32_t y)
+{
+	auto axis = face /2;
+	Vector3 dir {};
+	dir[axis] = ((face %2) == 0) ? 1.f : -1.f;
+	dir[(axis +1) %3] = -1.f +2.f *static_cast<float>(x) /static_cast<float>(DIRECTION_RESOLUTION);
+	dir[(axis +2) %3] = -1.f +2.f *static_cast<float>(y) /static_cast<float>(DIRECTION_RESOLUTION);
+	return uvec::get_normal(dir);
+}
+const Vector3 &pragma::physics::BuoyancyVolumeTable::GetBodyCenter() const {return m_bodyCenter;}
+bool pragma::physics::BuoyancyVolumeTable::IsValid(std::size_t meshHash) const {return meshHash == m_meshHash;}
+std::size_t pragma::physics::BuoyancyVolumeTable::CalcMeshHash(CollisionMesh &colMesh)
+{
+	// FNV-1a
+	std::size_t hash = 14'695'981'039'346'656'037ull;
+	auto hashData = [&hash](const void *data,std::size_t size) {
+		auto *bytes = static_cast<const uint8_t*>(data);
+		for(auto i=decltype(size){0u};i<size;++i)
+		{
+			hash ^= bytes[i];
+			hash *= 1'099'511'628'211ull;
+		}
+	};
+	auto &verts = colMesh.GetVertices();
+	auto &triangles = colMesh.GetTriangles();
+	hashData(verts.data(),verts.size() *sizeof(verts.front()));
+	hashData(triangles.data(),triangles.size() *sizeof(triangles.front()));
+	if(triangles.empty())
+	{
+		// The table is built from the bounds
+		Vector3 min,max;
+		colMesh.GetAABB(&min,&max);
+		hashData(&min,sizeof(min));
+		hashData(&max,sizeof(max));
+	}
+	return hash;
+}
+pragma::physics::BuoyancyVolumeTable::Result pragma::physics::BuoyancyVolumeTable::Evaluate(const Vector3 &n,double d) const
+{
+	Result result {};
+	if(m_samples.empty())
+		return result;
+	// Find the cube face the plane normal points at
+	Vector3 absN {umath::abs(n.x),umath::abs(n.y),umath::abs(n.z)};
+	uint32_t axis = (absN.x >= absN.y && absN.x >= absN.z) ? 0 : ((absN.y >= absN.z) ? 1 : 2);
+	auto major = absN[axis];
+	if(major <= 0.f)
+		return result;
+	auto face = axis *2 +((n[axis] < 0.f) ? 1 : 0);
+	auto calcCell = [major](float v,uint32_t &outIdx,float &outFactor) {
+		auto f = (v /major +1.f) *0.5f *static_cast<float>(DIRECTION_RESOLUTION);
+		outIdx = static_cast<uint32_t>(umath::clamp(std::floor(f),0.f,static_cast<float>(DIRECTION_RESOLUTION -1)));
+		outFactor = umath::clamp(f -static_cast<float>(outIdx),0.f,1.f);
+	};
+	uint32_t x,y;
+	float tx,ty;
+	calcCell(n[(axis +1) %3],x,tx);
+	calcCell(n[(axis +2) %3],y,ty);
+
+	constexpr auto gridSize = DIRECTION_RESOLUTION +1;
+	auto baseIdx = (face *gridSize +x) *gridSize +y;
+	const std::array<std::pair<uint32_t,float>,4> directions = {
+		std::pair<uint32_t,float>{baseIdx,(1.f -tx) *(1.f -ty)},
+		std::pair<uint32_t,float>{baseIdx +gridSize,tx *(1.f -ty)},
+		std::pair<uint32_t,float>{baseIdx +1,(1.f -tx) *ty},
+		std::pair<uint32_t,float>{baseIdx +gridSize +1,tx *ty}
+	};
+
+	// The distance range differs between orientations, the plane distance is mapped to the interpolated range
+	Range range {};
+	for(auto &[dirIdx,weight] : directions)
+	{
+		range.min += m_ranges[dirIdx].min *weight;
+		range.max += m_ranges[dirIdx].max *weight;
+	}
+	auto extent = range.max -range.min;
+	auto t = (extent > 0.f) ? umath::clamp(static_cast<float>((d -range.min) /extent),0.f,1.f) : ((d >= range.max) ? 1.f : 0.f);
+	auto s = t *static_cast<float>(SAMPLE_COUNT -1);
+	auto sampleIdx = umath::min(static_cast<uint32_t>(s),SAMPLE_COUNT -2);
+	auto ts = s -static_cast<float>(sampleIdx);
+	for(auto &[dirIdx,weight] : directions)
+	{
+		auto &s0 = m_samples[dirIdx *SAMPLE_COUNT +sampleIdx];
+		auto &s1 = m_samples[dirIdx *SAMPLE_COUNT +sampleIdx +1];
+		result.volume += (s0.volume +(s1.volume -s0.volume) *ts) *weight;
+		result.center += (s0.center +(s1.center -s0.center) *ts) *weight;
+	}
+	return result;
+}
+
+struct pragma::physics::WaterBuoyancySimulator::PendingVolumeTable
+{
+	// Used to make sure the table is not assigned to a different mesh at the same address
+	std::weak_ptr<CollisionMesh> mesh;
+	// False if the mesh is not owned by a shared pointer, in which case its lifetime can't be tracked
+	bool tracked = false;
+	std::vector<Vector3> verts;
+	std::vector<uint16_t> triangles;
+	std::shared_ptr<BuoyancyVolumeTable> table = nullptr;
+	pragma::JobCounter counter {};
+};
+
 pragma::physics::WaterBuoyancySimulator::WaterBuoyancySimulator()
 {}
+pragma::physics::WaterBuoyancySimulator::~WaterBuoyancySimulator()
+{
+	for(auto &pair : m_pendingVolumeTables)
+		engine->GetJobSystem().Wait(pair.second->counter);
+}
 
 template<class InputItVert,class InputItIndex>
-	double pragma::physics::WaterBuoyancySimulator::CalcBuoyancy(
-	const Quat &rorigin,
-	const PhysLiquid &liquid,
-	const Vector3 &waterPlane,double waterPlaneDist,
+	double pragma::physics::WaterBuoyancySimulator::CalcSubmergedVolume(
 	const Vector3 &waterPlaneRelObj,double waterPlaneDistRelObj,
-	const Vector3 &waterVelocity,
-	double gravity,
 	InputItVert vertsBegin,
 	InputItIndex indicesBegin,InputItIndex indicesEnd,
-	double mass,
-	double volBody,
-	const Vector3 &bodyVelocity,
-	const Vector3 &bodyAngularVelocity,
-	Vector3 *force,Vector3 *torque,
-	Vector3 *optOutSubmergedCenter
+	Vector3 &outBodyCenter,Vector3 &outSubmergedCenter
 ) const
 {
 	auto C = waterPlaneRelObj *static_cast<float>(waterPlaneDistRelObj);
@@ -101,14 +235,27 @@ template<class InputItVert,class InputItIndex>
 		bodyCenter /= static_cast<float>(bodyVertCount);
 	if(submergedVertCount > 0)
 		submergedCenter /= static_cast<float>(submergedVertCount);
+	outBodyCenter = bodyCenter;
+	outSubmergedCenter = submergedCenter;
+	return submergedVolume;
+}
 
-	if(optOutSubmergedCenter)
-		*optOutSubmergedCenter = submergedCenter;
-
-	auto bSubmerged = (submergedVolume > 0.0) ? true : false;
-	if(bSubmerged == false)
-		return 0.0;
-
+void pragma::physics::WaterBuoyancySimulator::CalcForces(
+	const Quat &rorigin,
+	const PhysLiquid &liquid,
+	const Vector3 &waterPlane,
+	const Vector3 &waterVelocity,
+	double gravity,
+	double submergedVolume,
+	const Vector3 &bodyCenter,
+	const Vector3 &submergedCenter,
+	double mass,
+	double volBody,
+	const Vector3 &bodyVelocity,
+	const Vector3 &bodyAngularVelocity,
+	Vector3 *force,Vector3 *torque
+) const
+{
 	// These factors shouldn't be necessary, but without them
 	// the forces are excessive. Reason is currently unknown. FIXME?
 	constexpr auto forceFactor = 0.0700000301;
@@ -134,6 +281,37 @@ template<class InputItVert,class InputItIndex>
 			*torque += CalcCattoDragTorqueForceApproximation(liquid.torqueDragCoefficient,mass,submergedVolume,volBody,lenPolyhedron,bodyAngularVelocity);
 		}
 	}
+}
+
+template<class InputItVert,class InputItIndex>
+	double pragma::physics::WaterBuoyancySimulator::CalcBuoyancy(
+	const Quat &rorigin,
+	const PhysLiquid &liquid,
+	const Vector3 &waterPlane,double waterPlaneDist,
+	const Vector3 &waterPlaneRelObj,double waterPlaneDistRelObj,
+	const Vector3 &waterVelocity,
+	double gravity,
+	InputItVert vertsBegin,
+	InputItIndex indicesBegin,InputItIndex indicesEnd,
+	double mass,
+	double volBody,
+	const Vector3 &bodyVelocity,
+	const Vector3 &bodyAngularVelocity,
+	Vector3 *force,Vector3 *torque,
+	Vector3 *optOutSubmergedCenter
+) const
+{
+	Vector3 bodyCenter;
+	Vector3 submergedCenter;
+	auto submergedVolume = CalcSubmergedVolume(waterPlaneRelObj,waterPlaneDistRelObj,vertsBegin,indicesBegin,indicesEnd,bodyCenter,submergedCenter);
+
+	if(optOutSubmergedCenter)
+		*optOutSubmergedCenter = submergedCenter;
+
+	auto bSubmerged = (submergedVolume > 0.0) ? true : false;
+	if(bSubmerged == false)
+		return 0.0;
+	CalcForces(rorigin,liquid,waterPlane,waterVelocity,gravity,submergedVolume,bodyCenter,submergedCenter,mass,volBody,bodyVelocity,bodyAngularVelocity,force,torque);
 	return submergedVolume;
 }
 
@@ -242,7 +420,331 @@ template<class TIterator>
 	}
 }
 
+std::shared_ptr<pragma::physics::BuoyancyVolumeTable> pragma::physics::WaterBuoyancySimulator::InitializeVolumeTable(const std::vector<Vector3> &verts,const std::vector<uint16_t> &triangles) const
+{
+	auto table = std::shared_ptr<BuoyancyVolumeTable>{new BuoyancyVolumeTable{}};
+	if(verts.empty() || triangles.size() < 3)
+		return table;
+	constexpr auto gridSize = BuoyancyVolumeTable::DIRECTION_RESOLUTION +1;
+	constexpr auto numDirections = gridSize *gridSize *6;
+	table->m_ranges.resize(numDirections);
+	table->m_samples.resize(numDirections *BuoyancyVolumeTable::SAMPLE_COUNT);
+
+	Vector3 bodyCenter;
+	Vector3 submergedCenter;
+	CalcSubmergedVolume(Vector3{0.f,1.f,0.f},0.0,verts.begin(),triangles.begin(),triangles.end(),bodyCenter,submergedCenter);
+	table->m_bodyCenter = bodyCenter;
+	return table;
+}
+
+void pragma::physics::WaterBuoyancySimulator::BuildVolumeTableDirections(BuoyancyVolumeTable &table,const std::vector<Vector3> &verts,const std::vector<uint16_t> &triangles,uint32_t firstDir,uint32_t numDirs) const
+{
+	constexpr auto gridSize = BuoyancyVolumeTable::DIRECTION_RESOLUTION +1;
+	constexpr auto sampleCount = BuoyancyVolumeTable::SAMPLE_COUNT;
+	for(auto dirIdx=firstDir;dirIdx<(firstDir +numDirs);++dirIdx)
+	{
+		auto dir = BuoyancyVolumeTable::GetDirection(dirIdx /(gridSize *gridSize),(dirIdx /gridSize) %gridSize,dirIdx %gridSize);
+		auto &range = table.m_ranges[dirIdx];
+		range.min = std::numeric_limits<float>::max();
+		range.max = std::numeric_limits<float>::lowest();
+		for(auto &v : verts)
+		{
+			auto d = uvec::dot(v,dir);
+			range.min = umath::min(range.min,d);
+			range.max = umath::max(range.max,d);
+		}
+		auto *samples = table.m_samples.data() +dirIdx *sampleCount;
+		for(uint32_t i=0;i<sampleCount;++i)
+		{
+			auto d = range.min +(range.max -range.min) *(static_cast<float>(i) /static_cast<float>(sampleCount -1));
+			Vector3 bodyCenter;
+			auto &sample = samples[i];
+			sample.volume = CalcSubmergedVolume(dir,d,verts.begin(),triangles.begin(),triangles.end(),bodyCenter,sample.center);
+		}
+		// Nothing is submerged at the lowest distance, use the closest center instead so interpolated centers remain plausible
+		samples[0].center = samples[1].center;
+	}
+}
+
+std::shared_ptr<pragma::physics::BuoyancyVolumeTable> pragma::physics::WaterBuoyancySimulator::CreateVolumeTable(const std::vector<Vector3> &verts,const std::vector<uint16_t> &triangles) const
+{
+	auto table = InitializeVolumeTable(verts,triangles);
+	if(table->m_samples.empty())
+		return table;
+	// Every orientation clips all triangles once per sample, so the orientations are distributed across the job system
+	constexpr auto gridSize = BuoyancyVolumeTable::DIRECTION_RESOLUTION +1;
+	auto numDirections = static_cast<uint32_t>(table->m_ranges.size());
+	auto &jobSystem = engine->GetJobSystem();
+	pragma::JobCounter counter {};
+	for(uint32_t dirIdx=0;dirIdx<numDirections;dirIdx += gridSize)
+		jobSystem.Schedule([this,&table,&verts,&triangles,dirIdx]() {BuildVolumeTableDirections(*table,verts,triangles,dirIdx,gridSize);},&counter);
+	jobSystem.Wait(counter);
+	return table;
+}
+
+std::shared_ptr<const pragma::physics::BuoyancyVolumeTable> pragma::physics::WaterBuoyancySimulator::GetVolumeTable(CollisionMesh &colMesh) const
+{
+	auto meshHash = BuoyancyVolumeTable::CalcMeshHash(colMesh);
+	auto &table = colMesh.GetBuoyancyVolumeTable();
+	if(table != nullptr && table->IsValid(meshHash))
+		return table;
+	auto &jobSystem = engine->GetJobSystem();
+	auto hMesh = colMesh.weak_from_this();
+	auto it = m_pendingVolumeTables.find(&colMesh);
+	if(it != m_pendingVolumeTables.end())
+	{
+		auto &pending = *it->second;
+		if(pending.counter.IsComplete() == false)
+			return nullptr;
+		jobSystem.Wait(pending.counter); // The job which has completed the counter may still be using it
+		auto newTable = std::move(pending.table);
+		auto isSameMesh = !hMesh.owner_before(pending.mesh) && !pending.mesh.owner_before(hMesh);
+		m_pendingVolumeTables.erase(it);
+		// The mesh may have been changed while the table was being built, in which case a new one is required
+		if(isSameMesh && newTable->IsValid(meshHash))
+		{
+			colMesh.SetBuoyancyVolumeTable(newTable);
+			return newTable;
+		}
+	}
+
+	auto pending = std::make_unique<PendingVolumeTable>();
+	pending->mesh = hMesh;
+	pending->tracked = !hMesh.expired();
+	// The job operates on a copy, since the mesh may be changed or removed while the table is being built
+	auto &triangles = colMesh.GetTriangles();
+	if(triangles.empty())
+	{
+		Vector3 min,max;
+		colMesh.GetAABB(&min,&max);
+		pending->verts = get_aabb_vertices(min,max);
+		pending->triangles = g_aabbTriangles;
+	}
+	else
+	{
+		pending->verts = colMesh.GetVertices();
+		pending->triangles = triangles;
+	}
+	pending->table = InitializeVolumeTable(pending->verts,pending->triangles);
+	pending->table->m_meshHash = meshHash;
+	if(pending->table->m_samples.empty())
+	{
+		colMesh.SetBuoyancyVolumeTable(pending->table);
+		return pending->table;
+	}
+	constexpr auto gridSize = BuoyancyVolumeTable::DIRECTION_RESOLUTION +1;
+	auto numDirections = static_cast<uint32_t>(pending->table->m_ranges.size());
+	auto *ptrPending = pending.get();
+	for(uint32_t dirIdx=0;dirIdx<numDirections;dirIdx += gridSize)
+	{
+		jobSystem.Schedule([this,ptrPending,dirIdx]() {
+			BuildVolumeTableDirections(*ptrPending->table,ptrPending->verts,ptrPending->triangles,dirIdx,gridSize);
+		},&ptrPending->counter);
+	}
+	m_pendingVolumeTables[&colMesh] = std::move(pending);
+	return nullptr;
+}
+
+void pragma::physics::WaterBuoyancySimulator::ClearExpiredVolumeTables() const
+{
+	for(auto it=m_pendingVolumeTables.begin();it!=m_pendingVolumeTables.end();)
+	{
+		auto &pending = *it->second;
+		if(pending.tracked == false || pending.mesh.expired() == false || pending.counter.IsComplete() == false)
+		{
+			++it;
+			continue;
+		}
+		engine->GetJobSystem().Wait(pending.counter);
+		it = m_pendingVolumeTables.erase(it);
+	}
+}
+
 void pragma::physics::WaterBuoyancySimulator::Simulate(BaseEntity &entWater,const PhysLiquid &liquid,BaseEntity &ent,Vector3 waterPlane,double waterPlaneDist,const Vector3 &waterVelocity,const PhysWaterSurfaceSimulator *surfaceSim) const
+{
+	if(cvVolumeTables->GetBool() == false)
+	{
+		SimulateExact(entWater,liquid,ent,waterPlane,waterPlaneDist,waterVelocity,surfaceSim);
+		return;
+	}
+	std::vector<BaseEntity*> ents {&ent};
+	Simulate(entWater,liquid,ents,waterPlane,waterPlaneDist,waterVelocity,surfaceSim);
+}
+
+void pragma::physics::WaterBuoyancySimulator::Simulate(BaseEntity &entWater,const PhysLiquid &liquid,const std::vector<BaseEntity*> &ents,const Vector3 &waterPlane,double waterPlaneDist,const Vector3 &waterVelocity,const PhysWaterSurfaceSimulator *surfaceSim) const
+{
+	if(cvVolumeTables->GetBool() == false)
+	{
+		for(auto *ent : ents)
+			SimulateExact(entWater,liquid,*ent,waterPlane,waterPlaneDist,waterVelocity,surfaceSim);
+		return;
+	}
+	struct Body
+	{
+		IRigidBody *rigidBody = nullptr;
+		std::shared_ptr<const BuoyancyVolumeTable> volumeTable = nullptr;
+		Quat rotation = uquat::identity();
+		Vector3 waterPlane {};
+		Vector3 waterPlaneRelObj {};
+		double waterPlaneDistRelObj = 0.0;
+		double gravity = 0.0;
+		double mass = 0.0;
+		double volume = 0.0;
+		Vector3 linearVelocity {};
+		Vector3 angularVelocity {};
+		uint32_t entityIndex = 0;
+
+		Vector3 force {};
+		Vector3 torque {};
+		double submergedVolume = 0.0;
+	};
+	struct EntityVolume
+	{
+		double total = 0.0;
+		double submerged = 0.0;
+		bool simulated = false;
+	};
+	std::vector<Body> bodies;
+	std::vector<EntityVolume> entityVolumes(ents.size());
+	ClearExpiredVolumeTables();
+
+	// Collect the bodies on the calling thread, since volume tables are cached on the collision meshes
+	for(auto entIdx=decltype(ents.size()){0u};entIdx<ents.size();++entIdx)
+	{
+		auto &ent = *ents[entIdx];
+		auto pPhysComponent = ent.GetPhysicsComponent();
+		auto physType = pPhysComponent != nullptr ? pPhysComponent->GetPhysicsType() : PHYSICSTYPE::NONE;
+		auto *physObj = pPhysComponent != nullptr ? pPhysComponent->GetPhysicsObject() : nullptr;
+		if(physObj == nullptr)
+			continue;
+		// Controllers are approximated by a box, which is cheap enough to clip
+		if(physType == PHYSICSTYPE::BOXCONTROLLER || physType == PHYSICSTYPE::CAPSULECONTROLLER)
+		{
+			SimulateExact(entWater,liquid,ent,waterPlane,waterPlaneDist,waterVelocity,surfaceSim);
+			continue;
+		}
+		entityVolumes[entIdx].simulated = true;
+		auto pGravityComponent = ent.GetComponent<pragma::GravityComponent>();
+		auto gravity = pGravityComponent.valid() ? pGravityComponent->GetGravityForce() : Vector3{};
+		auto firstBody = bodies.size();
+		auto tablesPending = false;
+		for(auto &hColObj : physObj->GetCollisionObjects())
+		{
+			if(hColObj.IsValid() == false || hColObj->IsRigid() == false)
+				continue;
+			auto *colObj = hColObj->GetRigidBody();
+			auto mass = colObj->GetMass();
+			auto shape = colObj->GetCollisionShape();
+			if(mass == 0.f || shape == nullptr || shape->IsConvex() == false)
+				continue;
+			auto *colMesh = shape->GetConvexShape()->GetCollisionMesh();
+			if(colMesh == nullptr)
+				continue;
+			Body body {};
+			body.rigidBody = colObj;
+			body.volumeTable = GetVolumeTable(*colMesh);
+			if(body.volumeTable == nullptr)
+			{
+				// Keep going, so the tables of the remaining meshes are built as well
+				tablesPending = true;
+				continue;
+			}
+			body.volume = colMesh->GetVolume();
+			if(colMesh->GetTriangles().empty())
+			{
+				Vector3 min,max;
+				colMesh->GetAABB(&min,&max);
+				body.volume = (max.x -min.x) *(max.y -min.y) *(max.z -min.z);
+			}
+			entityVolumes[entIdx].total += body.volume;
+
+			auto pose = colObj->GetBaseTransform(); // Pose without local pose of physics object
+			auto relPlane = pose.GetInverse() *umath::Plane{waterPlane,waterPlaneDist};
+			body.waterPlane = waterPlane;
+			body.waterPlaneRelObj = relPlane.GetNormal();
+			body.waterPlaneDistRelObj = relPlane.GetDistance();
+			if(surfaceSim != nullptr)
+			{
+				// The corners of the bounds are sufficient to determine the area of the surface below the body
+				Vector3 min,max;
+				colMesh->GetAABB(&min,&max);
+				auto corners = get_aabb_vertices(min,max);
+				auto bodyWaterPlaneDist = waterPlaneDist;
+				calc_surface_plane(
+					surfaceSim,pose.GetOrigin(),pose.GetRotation(),corners.begin(),corners.end(),body.waterPlane,bodyWaterPlaneDist,body.waterPlaneRelObj,body.waterPlaneDistRelObj
+				);
+			}
+			body.rotation = pose.GetRotation();
+			body.gravity = -gravity.y;
+			body.mass = mass;
+			body.linearVelocity = colObj->GetLinearVelocity();
+			body.angularVelocity = colObj->GetAngularVelocity();
+			body.entityIndex = entIdx;
+			bodies.push_back(std::move(body));
+		}
+		if(tablesPending)
+		{
+			// Until all tables of the entity are ready, the exact volumes are used
+			bodies.erase(bodies.begin() +firstBody,bodies.end());
+			entityVolumes[entIdx] = {};
+			SimulateExact(entWater,liquid,ent,waterPlane,waterPlaneDist,waterVelocity,surfaceSim);
+		}
+	}
+
+	auto calcForces = [this,&bodies,&liquid,&waterVelocity](uint32_t first,uint32_t count) {
+		for(auto i=first;i<(first +count);++i)
+		{
+			auto &body = bodies[i];
+			auto result = body.volumeTable->Evaluate(body.waterPlaneRelObj,body.waterPlaneDistRelObj);
+			if(result.volume <= 0.0)
+				continue;
+			body.submergedVolume = result.volume;
+			CalcForces(
+				body.rotation,liquid,body.waterPlane,waterVelocity,body.gravity,result.volume,body.volumeTable->GetBodyCenter(),result.center,
+				body.mass,body.volume,body.linearVelocity,body.angularVelocity,&body.force,&body.torque
+			);
+		}
+	};
+	constexpr uint32_t MIN_BODIES_PER_JOB = 16;
+	auto numBodies = static_cast<uint32_t>(bodies.size());
+	auto &jobSystem = engine->GetJobSystem();
+	auto numJobs = umath::min(jobSystem.GetWorkerCount() +1,(numBodies +MIN_BODIES_PER_JOB -1) /MIN_BODIES_PER_JOB);
+	if(numJobs <= 1)
+		calcForces(0,numBodies);
+	else
+	{
+		pragma::JobCounter counter {};
+		auto bodiesPerJob = (numBodies +numJobs -1) /numJobs;
+		for(auto first=decltype(numBodies){0u};first<numBodies;first += bodiesPerJob)
+		{
+			auto count = umath::min(bodiesPerJob,numBodies -first);
+			jobSystem.Schedule([&calcForces,first,count]() {calcForces(first,count);},&counter);
+		}
+		jobSystem.Wait(counter);
+	}
+
+	// Forces have to be applied on the calling thread
+	for(auto &body : bodies)
+	{
+		if(body.submergedVolume <= 0.0)
+			continue;
+		body.rigidBody->ApplyForce(body.force);
+		body.rigidBody->ApplyTorque(body.torque);
+		entityVolumes[body.entityIndex].submerged += body.submergedVolume;
+	}
+	for(auto entIdx=decltype(ents.size()){0u};entIdx<ents.size();++entIdx)
+	{
+		auto &volume = entityVolumes[entIdx];
+		if(volume.simulated == false)
+			continue;
+		auto pSubmergedComponent = ents[entIdx]->GetComponent<pragma::SubmergibleComponent>();
+		if(pSubmergedComponent.expired())
+			continue;
+		pSubmergedComponent->SetSubmergedFraction(entWater,(volume.total > 0.0) ? (volume.submerged /volume.total) : 0.0);
+	}
+}
+
+void pragma::physics::WaterBuoyancySimulator::SimulateExact(BaseEntity &entWater,const PhysLiquid &liquid,BaseEntity &ent,Vector3 waterPlane,double waterPlaneDist,const Vector3 &waterVelocity,const PhysWaterSurfaceSimulator *surfaceSim) const
 {
 	auto pPhysComponent = ent.GetPhysicsComponent();
 	auto physType = pPhysComponent != nullptr ? pPhysComponent->GetPhysicsType() : PHYSICSTYPE::NONE;
@@ -355,20 +857,6 @@ void pragma::physics::WaterBuoyancySimulator::Simulate(BaseEntity &entWater,cons
 					const auto *triangles = &colMesh->GetTriangles();
 
 					std::vector<Vector3> aabbVerts;
-					const std::vector<uint16_t> aabbTris = {
-						0,6,7, // 1
-						0,7,5, // 1
-						3,0,5, // 2
-						3,1,0, // 2
-						2,0,1, // 3
-						2,6,0, // 3
-						7,6,2, // 4
-						4,7,2, // 4
-						4,1,3, // 5
-						1,4,2, // 5
-						4,3,5, // 6
-						4,5,7 // 6
-					};
 					if(triangles->empty())
 					{
 						// If physics mesh has no triangles, build generic mesh from AABB
@@ -377,19 +865,10 @@ void pragma::physics::WaterBuoyancySimulator::Simulate(BaseEntity &entWater,cons
 #if ENABLE_DEBUG_DRAW == 1
 						pragma::get_engine()->GetClientState()->GetGameState()->DrawBox(min,max,EulerAngles{},Color::Aqua,0.1f);
 #endif
-						aabbVerts = {
-							min, // 0
-							Vector3(max.x,min.y,min.z), // 1
-							Vector3(max.x,min.y,max.z), // 2
-							Vector3(max.x,max.y,min.z), // 3
-							max, // 4
-							Vector3(min.x,max.y,min.z), // 5
-							Vector3(min.x,min.y,max.z), // 6
-							Vector3(min.x,max.y,max.z) // 7
-						};
+						aabbVerts = get_aabb_vertices(min,max);
 
 						verts = &aabbVerts;
-						triangles = &aabbTris;
+						triangles = &g_aabbTriangles;
 						volume = (max.x -min.x) *(max.y -min.y) *(max.z -min.z);
 					}
 
@@ -70,8 +70,9 @@ void PhysWaterSurfaceSimulator::InitializeSurface()
 	if(numParticles > std::numeric_limits<uint32_t>::max())
 		return;
 	m_particleField.resize(numParticles);
-	m_particleHeights.resize(numParticles);
-	m_threadParticleHeights.resize(numParticles);
+	m_particleState.Resize(numParticles);
+	for(auto &buf : m_heightBuffers)
+		buf.heights.resize(numParticles,0.f);
 
 	m_particleEdges.reserve(
 		4 *2 + // Corner particles
@@ -120,8 +121,19 @@ void PhysWaterSurfaceSimulator::Initialize()
 	if(m_bUseThread == false)
 		return;
 	m_simThread = std::thread([this]() {
+		// Waves are simulated in fixed steps in real time, if the simulation can't keep up it will slow down instead of catching up
+		constexpr auto stepDuration = std::chrono::milliseconds{10};
+		auto tNext = std::chrono::steady_clock::now();
 		while(m_bRunThread == true)
+		{
 			SimulateWaves(0.01); // TODO: Delta?
+			tNext += stepDuration;
+			auto t = std::chrono::steady_clock::now();
+			if(tNext < t)
+				tNext = t;
+			else
+				std::this_thread::sleep_until(tNext);
+		}
 	});
 }
 uint32_t PhysWaterSurfaceSimulator::GetSpacing() const {return m_surfaceInfo.spacing;}
@@ -166,27 +178,10 @@ void PhysWaterSurfaceSimulator::SimulateWaves(double dt)
 	m_settingsMutex.unlock();
 
 	// Apply splashes
-	auto width = GetWidth();
-	auto length = GetLength();
 	m_splashMutex.lock();
 		while(m_splashQueue.empty() == false)
 		{
-			auto &info = m_splashQueue.front();
-			auto r2 = info.radiusSqr;
-			auto &particleField = GetParticleField();
-			for(auto i=decltype(particleField.size()){0};i<particleField.size();++i)
-			{
-				auto pos = CalcParticlePosition(surfInfo,m_threadParticleHeights,i);
-				auto l = uvec::length_sqr(pos -info.origin);
-				if(l < r2)
-				{
-					l = umath::sqrt(l);
-					auto factor = (info.radius -l) /info.radius;
-					auto &pt = particleField.at(i);
-					pt.SetOldHeight(pt.GetHeight());
-					SetParticleHeight(surfInfo,i,pt.GetHeight() +info.force *factor);
-				}
-			}
+			ApplySplash(surfInfo,m_splashQueue.front());
 			m_splashQueue.pop();
 		}
 	m_splashMutex.unlock();
@@ -196,12 +191,52 @@ void PhysWaterSurfaceSimulator::SimulateWaves(double dt)
 	auto sovleEdgeCount = GetEdgeIterationCount();
 	for(auto i=decltype(sovleEdgeCount){0};i<sovleEdgeCount;++i)
 		SolveEdges(surfInfo);
-	SolveDepths(surfInfo);
-	VelocityFixup(surfInfo,1.0 /dt);
 
-	m_heightMutex.lock();
-		std::copy(m_threadParticleHeights.begin(),m_threadParticleHeights.end(),m_particleHeights.begin());
-	m_heightMutex.unlock();
+	auto backBufferIdx = 1u -m_frontHeightBuffer.load();
+	auto &backBuffer = m_heightBuffers[backBufferIdx];
+	// Views that were created before the last swap may still reference the back buffer
+	while(backBuffer.readers.load() > 0)
+		std::this_thread::yield();
+	SolveDepths(surfInfo,1.0 /dt,backBuffer.heights);
+	m_frontHeightBuffer = backBufferIdx;
+}
+void PhysWaterSurfaceSimulator::ApplySplash(const SurfaceInfo &surfInfo,const SplashInfo &splash)
+{
+	if(surfInfo.spacing == 0 || surfInfo.width == 0 || surfInfo.length == 0)
+		return;
+	// Only particles within the bounds of the splash have to be checked. Rows are placed along the x-axis, columns along the z-axis.
+	auto calcRange = [&surfInfo,&splash](float origin,float splashOrigin,uint32_t count,uint32_t &outMin,uint32_t &outMax) -> bool {
+		auto fMin = std::ceil((splashOrigin -splash.radius -origin) /static_cast<float>(surfInfo.spacing));
+		auto fMax = std::floor((splashOrigin +splash.radius -origin) /static_cast<float>(surfInfo.spacing));
+		if(fMax < 0.f || fMin > static_cast<float>(count -1))
+			return false;
+		outMin = static_cast<uint32_t>(umath::max(fMin,0.f));
+		outMax = static_cast<uint32_t>(umath::min(fMax,static_cast<float>(count -1)));
+		return true;
+	};
+	uint32_t rowMin,rowMax,colMin,colMax;
+	if(
+		calcRange(surfInfo.origin.x,splash.origin.x,surfInfo.length,rowMin,rowMax) == false ||
+		calcRange(surfInfo.origin.z,splash.origin.z,surfInfo.width,colMin,colMax) == false
+	)
+		return;
+	auto &heights = m_particleState.heights;
+	auto &oldHeights = m_particleState.oldHeights;
+	for(auto y=rowMin;y<=rowMax;++y)
+	{
+		for(auto x=colMin;x<=colMax;++x)
+		{
+			auto ptIdx = GetParticleIndex(surfInfo,x,y);
+			auto pos = CalcParticlePosition(surfInfo,heights,ptIdx);
+			auto l = uvec::length_sqr(pos -splash.origin);
+			if(l >= splash.radiusSqr)
+				continue;
+			l = umath::sqrt(l);
+			auto factor = (splash.radius -l) /splash.radius;
+			oldHeights[ptIdx] = heights[ptIdx];
+			heights[ptIdx] = umath::min(heights[ptIdx] +splash.force *factor,surfInfo.maxHeight);
+		}
+	}
 }
 uint8_t PhysWaterSurfaceSimulator::GetEdgeIterationCount() const
 {
@@ -210,15 +245,21 @@ uint8_t PhysWaterSurfaceSimulator::GetEdgeIterationCount() const
 Vector3 PhysWaterSurfaceSimulator::CalcParticlePosition(const SurfaceInfo &surfInfo,const std::vector<float> &heights,std::size_t ptIdx) const
 {
 	auto c = GetParticleCoordinates(surfInfo,ptIdx);
-	return Vector3{surfInfo.origin.x +c.first *surfInfo.spacing,surfInfo.origin.y +heights.at(ptIdx),surfInfo.origin.z +c.second *surfInfo.spacing};
+	return Vector3{surfInfo.origin.x +c.first *surfInfo.spacing,surfInfo.origin.y +heights[ptIdx],surfInfo.origin.z +c.second *surfInfo.spacing};
+}
+Vector3 PhysWaterSurfaceSimulator::CalcParticlePosition(const HeightView &heights,std::size_t ptIdx) const {return CalcParticlePosition(m_surfaceInfo,heights.GetHeights(),ptIdx);}
+Vector3 PhysWaterSurfaceSimulator::CalcParticlePosition(std::size_t ptIdx) const
+{
+	HeightView heights {*this};
+	return CalcParticlePosition(heights,ptIdx);
 }
-Vector3 PhysWaterSurfaceSimulator::CalcParticlePosition(std::size_t ptIdx) const {return CalcParticlePosition(m_surfaceInfo,m_particleHeights,ptIdx);}
-void PhysWaterSurfaceSimulator::LockParticleHeights() {m_heightMutex.lock();}
-void PhysWaterSurfaceSimulator::UnlockParticleHeights() {m_heightMutex.unlock();}
 bool PhysWaterSurfaceSimulator::CalcPointSurfaceIntersection(const Vector3 &origin,Vector3 &intersection) const
 {
-	auto posFirst = CalcParticlePosition(0);
-	auto posLast = CalcParticlePosition(m_particleField.size() -1);
+	if(m_particleField.empty())
+		return false;
+	HeightView heights {*this};
+	auto posFirst = CalcParticlePosition(heights,0);
+	auto posLast = CalcParticlePosition(heights,m_particleField.size() -1);
 	posFirst.y = 0.f; // TODO: Relative to plane!
 	posLast.y = 0.f;
 	auto bounds = posLast -posFirst;
@@ -242,10 +283,10 @@ bool PhysWaterSurfaceSimulator::CalcPointSurfaceIntersection(const Vector3 &orig
 	if(ptIdx0 >= numParticles || ptIdx1 >= numParticles || ptIdx2 >= numParticles || ptIdx3 >= numParticles)
 		return false;
 	std::array<Vector3,4> particlePositions = {
-		CalcParticlePosition(ptIdx0),
-		CalcParticlePosition(ptIdx1),
-		CalcParticlePosition(ptIdx2),
-		CalcParticlePosition(ptIdx3)
+		CalcParticlePosition(heights,ptIdx0),
+		CalcParticlePosition(heights,ptIdx1),
+		CalcParticlePosition(heights,ptIdx2),
+		CalcParticlePosition(heights,ptIdx3)
 	};
 	const auto n = Vector3(0,1,0); // TODO
 	double t,u,v;
@@ -7,62 +7,224 @@
 
 #include "stdafx_shared.h"
 #include "pragma/physics/phys_water_surface_simulator.hpp"
+#include "pragma/util/job_system.hpp"
+#include <pragma/engine.h>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+	#define PRAGMA_WATER_SURFACE_SSE
+	#include <xmmintrin.h>
+#endif
+
+extern DLLNETWORK Engine *engine;
+
+// Relaxes the edges between a[i] and b[i]. The height difference of each edge is reduced by the factor k on both sides.
+static void solve_edges(float *a,float *b,uint32_t count,float k,float maxHeight)
+{
+	uint32_t i = 0;
+#ifdef PRAGMA_WATER_SURFACE_SSE
+	auto vK = _mm_set1_ps(k);
+	auto vMaxHeight = _mm_set1_ps(maxHeight);
+	for(;i +4 <= count;i += 4)
+	{
+		auto va = _mm_loadu_ps(a +i);
+		auto vb = _mm_loadu_ps(b +i);
+		auto d = _mm_mul_ps(_mm_sub_ps(vb,va),vK);
+		_mm_storeu_ps(a +i,_mm_min_ps(_mm_add_ps(va,d),vMaxHeight));
+		_mm_storeu_ps(b +i,_mm_min_ps(_mm_sub_ps(vb,d),vMaxHeight));
+	}
+#endif
+	for(;i<count;++i)
+	{
+		auto d = (b[i] -a[i]) *k;
+		a[i] = umath::min(a[i] +d,maxHeight);
+		b[i] = umath::min(b[i] -d,maxHeight);
+	}
+}
+// Relaxes the edges between h[i *2] and h[i *2 +1]
+static void solve_edge_pairs(float *h,uint32_t count,float k,float maxHeight)
+{
+	uint32_t i = 0;
+#ifdef PRAGMA_WATER_SURFACE_SSE
+	auto vK = _mm_set1_ps(k);
+	auto vMaxHeight = _mm_set1_ps(maxHeight);
+	for(;i +4 <= count;i += 4)
+	{
+		auto *p = h +i *2;
+		auto v0 = _mm_loadu_ps(p);
+		auto v1 = _mm_loadu_ps(p +4);
+		// Deinterleave into the first and second particle of each edge
+		auto va = _mm_shuffle_ps(v0,v1,_MM_SHUFFLE(2,0,2,0));
+		auto vb = _mm_shuffle_ps(v0,v1,_MM_SHUFFLE(3,1,3,1));
+		auto d = _mm_mul_ps(_mm_sub_ps(vb,va),vK);
+		va = _mm_min_ps(_mm_add_ps(va,d),vMaxHeight);
+		vb = _mm_min_ps(_mm_sub_ps(vb,d),vMaxHeight);
+		_mm_storeu_ps(p,_mm_unpacklo_ps(va,vb));
+		_mm_storeu_ps(p +4,_mm_unpackhi_ps(va,vb));
+	}
+#endif
+	for(;i<count;++i)
+	{
+		auto &a = h[i *2];
+		auto &b = h[i *2 +1];
+		auto d = (b -a) *k;
+		a = umath::min(a +d,maxHeight);
+		b = umath::min(b -d,maxHeight);
+	}
+}
+
+void PhysWaterSurfaceSimulator::ParticleState::Resize(std::size_t count)
+{
+	heights.resize(count,0.f);
+	oldHeights.resize(count,0.f);
+	targetHeights.resize(count,0.f);
+	velocities.resize(count,0.f);
+}
+
+PhysWaterSurfaceSimulator::HeightView::HeightView(const PhysWaterSurfaceSimulator &sim)
+{
+	for(;;)
+	{
+		auto idx = sim.m_frontHeightBuffer.load();
+		auto &buf = sim.m_heightBuffers[idx];
+		++buf.readers;
+		// If the buffers were swapped in the meantime, the simulation may already be writing to this one
+		if(sim.m_frontHeightBuffer.load() == idx)
+		{
+			m_heights = &buf.heights;
+			m_readers = &buf.readers;
+			break;
+		}
+		--buf.readers;
+	}
+}
+PhysWaterSurfaceSimulator::HeightView::~HeightView() {--(*m_readers);}
+const std::vector<float> &PhysWaterSurfaceSimulator::HeightView::GetHeights() const {return *m_heights;}
 
 void PhysWaterSurfaceSimulator::JoinThread()
 {
 	m_bRunThread = false;
-	m_simThread.join();
+	if(m_simThread.joinable())
+		m_simThread.join();
 }
 std::size_t PhysWaterSurfaceSimulator::GetParticleIndex(uint32_t x,uint32_t y) const {return GetParticleIndex(m_surfaceInfo,x,y);}
 std::pair<uint32_t,uint32_t> PhysWaterSurfaceSimulator::GetParticleCoordinates(std::size_t idx) const {return GetParticleCoordinates(m_surfaceInfo,idx);}
 std::size_t PhysWaterSurfaceSimulator::GetParticleIndex(const SurfaceInfo &surfInfo,uint32_t x,uint32_t y) const {return y *surfInfo.width +x;}
 std::pair<uint32_t,uint32_t> PhysWaterSurfaceSimulator::GetParticleCoordinates(const SurfaceInfo &surfInfo,std::size_t idx) const {return std::pair<uint32_t,uint32_t>(idx /surfInfo.width,idx %surfInfo.width);}
-void PhysWaterSurfaceSimulator::SolveDepths(const SurfaceInfo &surfInfo)
+void PhysWaterSurfaceSimulator::ParallelFor(uint32_t count,uint32_t itemSize,const std::function<void(uint32_t,uint32_t)> &fn) const
 {
-	std::size_t ptIdx = 0;
-	for(auto &pt : GetParticleField())
+	if(count == 0)
+		return;
+	auto &jobSystem = engine->GetJobSystem();
+	auto minItemsPerJob = umath::max(MIN_PARTICLES_PER_JOB /umath::max(itemSize,1u),1u);
+	auto numJobs = umath::min(jobSystem.GetWorkerCount() +1,(count +minItemsPerJob -1) /minItemsPerJob);
+	if(numJobs <= 1)
 	{
-		auto x = pt.GetTargetHeight() -pt.GetHeight();
-		SetParticleHeight(surfInfo,ptIdx++,pt.GetHeight() +x *surfInfo.stiffness);
+		fn(0,count);
+		return;
 	}
-}
-void PhysWaterSurfaceSimulator::SolveEdges(const SurfaceInfo &surfInfo)
-{
-	auto &particleField = GetParticleField();
-	for(auto &edge : GetParticleEdges())
+	auto itemsPerJob = (count +numJobs -1) /numJobs;
+	pragma::JobCounter counter {};
+	for(auto first=decltype(count){0u};first<count;first += itemsPerJob)
 	{
-		auto &pt0 = particleField.at(edge.index0);
-		auto &pt1 = particleField.at(edge.index1);
-
-		auto d = pt1.GetHeight() -pt0.GetHeight();
-		d *= surfInfo.propagation;
-
-		SetParticleHeight(surfInfo,edge.index0,pt0.GetHeight() +d);
-		SetParticleHeight(surfInfo,edge.index1,pt1.GetHeight() -d);
+		auto end = umath::min(first +itemsPerJob,count);
+		jobSystem.Schedule([&fn,first,end]() {fn(first,end);},&counter);
 	}
+	jobSystem.Wait(counter);
 }
-void PhysWaterSurfaceSimulator::SetParticleHeight(const SurfaceInfo &surfInfo,std::size_t ptIdx,float height)
+void PhysWaterSurfaceSimulator::SolveDepths(const SurfaceInfo &surfInfo,double invDt,std::vector<float> &outHeights)
 {
-	auto &pt = m_particleField.at(ptIdx);
-	pt.SetHeight(umath::min(height,surfInfo.maxHeight));
-	m_threadParticleHeights.at(ptIdx) = height;
+	auto *heights = m_particleState.heights.data();
+	auto *oldHeights = m_particleState.oldHeights.data();
+	auto *targetHeights = m_particleState.targetHeights.data();
+	auto *velocities = m_particleState.velocities.data();
+	auto *out = outHeights.data();
+	auto stiffness = surfInfo.stiffness;
+	auto maxHeight = surfInfo.maxHeight;
+	auto fInvDt = static_cast<float>(invDt);
+	auto width = surfInfo.width;
+	ParallelFor(surfInfo.length,width,[=](uint32_t rowStart,uint32_t rowEnd) {
+		auto i = rowStart *width;
+		auto end = rowEnd *width;
+#ifdef PRAGMA_WATER_SURFACE_SSE
+		auto vStiffness = _mm_set1_ps(stiffness);
+		auto vMaxHeight = _mm_set1_ps(maxHeight);
+		auto vInvDt = _mm_set1_ps(fInvDt);
+		for(;i +4 <= end;i += 4)
+		{
+			auto h = _mm_loadu_ps(heights +i);
+			h = _mm_add_ps(h,_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(targetHeights +i),h),vStiffness));
+			h = _mm_min_ps(h,vMaxHeight);
+			_mm_storeu_ps(velocities +i,_mm_mul_ps(_mm_sub_ps(h,_mm_loadu_ps(oldHeights +i)),vInvDt));
+			_mm_storeu_ps(heights +i,h);
+			_mm_storeu_ps(oldHeights +i,h);
+			_mm_storeu_ps(out +i,h);
+		}
+#endif
+		for(;i<end;++i)
+		{
+			auto h = umath::min(heights[i] +(targetHeights[i] -heights[i]) *stiffness,maxHeight);
+			velocities[i] = (h -oldHeights[i]) *fInvDt;
+			heights[i] = h;
+			oldHeights[i] = h;
+			out[i] = h;
+		}
+	});
 }
-void PhysWaterSurfaceSimulator::Integrate(const SurfaceInfo &surfInfo,double dt)
-{
-	std::size_t ptIdx = 0;
-	for(auto &pt : GetParticleField())
-		SetParticleHeight(surfInfo,ptIdx++,pt.GetHeight() +dt *pt.GetVelocity());
-}
-void PhysWaterSurfaceSimulator::VelocityFixup(const SurfaceInfo &surfInfo,double invDt)
+void PhysWaterSurfaceSimulator::SolveEdges(const SurfaceInfo &surfInfo)
 {
-	auto &particleField = GetParticleField();
-	for(auto i=decltype(particleField.size()){0};i<particleField.size();++i)
-	{
-		auto &pt = particleField.at(i);
-		auto delta = pt.GetHeight() -pt.GetOldHeight();
-		pt.SetVelocity(invDt *delta);
-		pt.SetOldHeight(pt.GetHeight());
+	// Solving an edge in both directions (as the edge list does) is equivalent to moving
+	// both heights towards each other by the factor 2p(1 -p) of their difference.
+	auto p = surfInfo.propagation;
+	auto k = 2.f *p *(1.f -p);
+	auto maxHeight = surfInfo.maxHeight;
+	auto width = surfInfo.width;
+	auto length = surfInfo.length;
+	auto *heights = m_particleState.heights.data();
 
-		//UpdateParticlePosition(surfInfo,i);
+	ParallelFor(length,width,[=](uint32_t rowStart,uint32_t rowEnd) {
+		for(auto y=rowStart;y<rowEnd;++y)
+		{
+			auto *row = heights +static_cast<std::size_t>(y) *width;
+			solve_edge_pairs(row,width /2,k,maxHeight);
+			if(width > 0)
+				solve_edge_pairs(row +1,(width -1) /2,k,maxHeight);
+		}
+	});
+	if(length < 2)
+		return;
+	for(uint32_t startRow=0;startRow<2;++startRow)
+	{
+		// Edges between row startRow +i *2 and the row after it
+		auto numRowPairs = (length -startRow) /2;
+		ParallelFor(numRowPairs,width *2,[=](uint32_t pairStart,uint32_t pairEnd) {
+			for(auto i=pairStart;i<pairEnd;++i)
+			{
+				auto *row = heights +static_cast<std::size_t>(startRow +i *2) *width;
+				solve_edges(row,row +width,width,k,maxHeight);
+			}
+		});
 	}
 }
+void PhysWaterSurfaceSimulator::Integrate(const SurfaceInfo &surfInfo,double dt)
+{
+	auto *heights = m_particleState.heights.data();
+	auto *velocities = m_particleState.velocities.data();
+	auto maxHeight = surfInfo.maxHeight;
+	auto fDt = static_cast<float>(dt);
+	auto width = surfInfo.width;
+	ParallelFor(surfInfo.length,width,[=](uint32_t rowStart,uint32_t rowEnd) {
+		auto i = rowStart *width;
+		auto end = rowEnd *width;
+#ifdef PRAGMA_WATER_SURFACE_SSE
+		auto vDt = _mm_set1_ps(fDt);
+		auto vMaxHeight = _mm_set1_ps(maxHeight);
+		for(;i +4 <= end;i += 4)
+		{
+			auto h = _mm_add_ps(_mm_loadu_ps(heights +i),_mm_mul_ps(_mm_loadu_ps(velocities +i),vDt));
+			_mm_storeu_ps(heights +i,_mm_min_ps(h,vMaxHeight));
+		}
+#endif
+		for(;i<end;++i)
+			heights[i] = umath::min(heights[i] +velocities[i] *fDt,maxHeight);
+	});
+}
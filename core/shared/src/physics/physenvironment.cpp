@@ -25,6 +25,15 @@
 #include "pragma/physics/physsoftbodyinfo.hpp"
 #include "pragma/entities/components/base_physics_component.hpp"
 #include "pragma/entities/trigger/base_trigger_touch.hpp"
+#include "pragma/physics/raycast_filter.hpp"
+#include "pragma/util/job_system.hpp"
+#include <pragma/console/convars.h>
+#include "pragma/console/engine_cvar.h"
+#include <pragma/engine.h>
+
+extern DLLNETWORK Engine *engine;
+
+static CVar cvTraceBatchMultithreaded = GetEngineConVar("sh_trace_batch_multithreaded");
 
 std::vector<std::string> pragma::physics::IEnvironment::GetAvailablePhysicsEngines()
 {
@@ -126,6 +135,103 @@ void pragma::physics::IEnvironment::ClearVehicles()
 }
 
 const pragma::physics::WaterBuoyancySimulator &pragma::physics::IEnvironment::GetWaterBuoyancySimulator() const {return *m_buoyancySim;}
+bool pragma::physics::IEnvironment::SupportsConcurrentQueries() const {return false;}
+uint32_t pragma::physics::IEnvironment::BatchTrace(TraceType type,const TraceData &data,const TraceQuery *queries,uint32_t numQueries,TraceResult *outResults,bool resolveMeshes) const
+{
+	if(numQueries == 0)
+		return 0;
+	// Each job traces a contiguous range of queries with its own copy of the trace data and its own result buffer,
+	// so nothing has to be allocated or set up per query
+	struct Scratch
+	{
+		TraceData data;
+		std::vector<TraceResult> results;
+		uint32_t numHits = 0;
+	};
+	constexpr uint32_t MIN_QUERIES_PER_JOB = 16;
+	auto &jobSystem = engine->GetJobSystem();
+	auto &filter = data.GetFilter();
+	auto multithreaded = cvTraceBatchMultithreaded->GetBool() && SupportsConcurrentQueries() && (filter == nullptr || filter->IsThreadSafe());
+	auto numJobs = multithreaded ? umath::min(jobSystem.GetWorkerCount() +1,(numQueries +MIN_QUERIES_PER_JOB -1) /MIN_QUERIES_PER_JOB) : 1u;
+	std::vector<Scratch> scratch;
+	scratch.reserve(numJobs);
+	for(auto i=decltype(numJobs){0u};i<numJobs;++i)
+	{
+		scratch.push_back({data});
+		auto &jobScratch = scratch.back();
+		auto flags = jobScratch.data.GetFlags();
+		umath::set_flag(flags,RayCastFlags::ReportAllResults,false);
+		jobScratch.data.SetFlags(flags);
+		jobScratch.results.reserve(4);
+	}
+
+	auto traceRange = [this,type,queries,outResults](Scratch &scratch,uint32_t first,uint32_t count) {
+		for(auto i=first;i<first +count;++i)
+		{
+			auto &query = queries[i];
+			scratch.data.SetSource(query.source);
+			scratch.data.SetTarget(query.target);
+			scratch.results.clear();
+			auto hit = false;
+			switch(type)
+			{
+			case TraceType::RayCast:
+				hit = RayCast(scratch.data,&scratch.results);
+				break;
+			case TraceType::Sweep:
+				hit = Sweep(scratch.data,&scratch.results);
+				break;
+			case TraceType::Overlap:
+				hit = Overlap(scratch.data,&scratch.results);
+				break;
+			}
+			auto &result = outResults[i];
+			if(hit == false || scratch.results.empty())
+			{
+				result = TraceResult{scratch.data};
+				continue;
+			}
+			result = std::move(scratch.results.front());
+			++scratch.numHits;
+		}
+	};
+	// Resolving the meshes accesses the entity's model, which is not thread-safe
+	auto resolveResultMeshes = [numQueries,outResults]() {
+		for(auto i=decltype(numQueries){0u};i<numQueries;++i)
+		{
+			auto &result = outResults[i];
+			if(result.hitType == RayCastHitType::None)
+				continue;
+			ModelMesh *mesh;
+			ModelSubMesh *subMesh;
+			result.GetMeshes(&mesh,&subMesh);
+		}
+	};
+	if(numJobs == 1)
+	{
+		traceRange(scratch.front(),0,numQueries);
+		if(resolveMeshes)
+			resolveResultMeshes();
+		return scratch.front().numHits;
+	}
+	pragma::JobCounter counter {};
+	auto queriesPerJob = (numQueries +numJobs -1) /numJobs;
+	for(auto i=decltype(numJobs){0u};i<numJobs;++i)
+	{
+		auto first = i *queriesPerJob;
+		if(first >= numQueries)
+			break;
+		auto count = umath::min(queriesPerJob,numQueries -first);
+		jobSystem.Schedule([&traceRange,&jobScratch=scratch[i],first,count]() {traceRange(jobScratch,first,count);},&counter);
+	}
+	jobSystem.Wait(counter);
+	if(resolveMeshes)
+		resolveResultMeshes();
+	uint32_t numHits = 0;
+	for(auto &jobScratch : scratch)
+		numHits += jobScratch.numHits;
+	return numHits;
+}
 void pragma::physics::IEnvironment::AddConstraint(IConstraint &constraint)
 {
 	auto hConstraint = constraint.ClaimOwnership();
@@ -23,6 +23,7 @@ RayCastHitType pragma::physics::EntityRayCastFilterCallback::PostFilter(pragma::
 }
 bool pragma::physics::EntityRayCastFilterCallback::HasPreFilter() const {return true;}
 bool pragma::physics::EntityRayCastFilterCallback::HasPostFilter() const {return false;}
+bool pragma::physics::EntityRayCastFilterCallback::IsThreadSafe() const {return true;}
 
 //////////////////
 
@@ -41,6 +42,7 @@ RayCastHitType pragma::physics::MultiEntityRayCastFilterCallback::PostFilter(pra
 }
 bool pragma::physics::MultiEntityRayCastFilterCallback::HasPreFilter() const {return true;}
 bool pragma::physics::MultiEntityRayCastFilterCallback::HasPostFilter() const {return false;}
+bool pragma::physics::MultiEntityRayCastFilterCallback::IsThreadSafe() const {return true;}
 
 //////////////////
 
@@ -58,6 +60,7 @@ RayCastHitType pragma::physics::PhysObjRayCastFilterCallback::PostFilter(pragma:
 }
 bool pragma::physics::PhysObjRayCastFilterCallback::HasPreFilter() const {return true;}
 bool pragma::physics::PhysObjRayCastFilterCallback::HasPostFilter() const {return false;}
+bool pragma::physics::PhysObjRayCastFilterCallback::IsThreadSafe() const {return true;}
 
 //////////////////
 
@@ -74,6 +77,7 @@ RayCastHitType pragma::physics::CollisionObjRayCastFilterCallback::PostFilter(pr
 }
 bool pragma::physics::CollisionObjRayCastFilterCallback::HasPreFilter() const {return true;}
 bool pragma::physics::CollisionObjRayCastFilterCallback::HasPostFilter() const {return false;}
+bool pragma::physics::CollisionObjRayCastFilterCallback::IsThreadSafe() const {return true;}
 
 //////////////////
 
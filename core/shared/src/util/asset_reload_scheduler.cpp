@@ -0,0 +1,108 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright (c) 2021 Silverlan
+ */
+
+#include "stdafx_shared.h"
+#include "pragma/util/asset_reload_scheduler.hpp"
+#include "pragma/util/job_system.hpp"
+#include <fsys/filesystem.h>
+#include <algorithm>
+
+using namespace pragma;
+
+AssetReloadScheduler::AssetReloadScheduler(JobSystem *jobSystem)
+	: m_jobSystem{jobSystem}
+{}
+
+void AssetReloadScheduler::AddChange(const std::string &key,const std::function<void()> &apply,const std::optional<std::string> &prefetchPath)
+{
+	auto t = Clock::now();
+	m_tLastChange = t;
+	auto it = m_keyToChange.find(key);
+	if(it != m_keyToChange.end())
+	{
+		// The file may still be in the process of being written, so it has to be read again
+		auto &change = *it->second;
+		change.apply = apply;
+		change.prefetchPath = prefetchPath;
+		change.prefetched = nullptr;
+		m_stats.queueDepth = static_cast<uint32_t>(m_changes.size());
+		return;
+	}
+	m_changes.push_back({key,apply,prefetchPath,t});
+	m_keyToChange[key] = std::prev(m_changes.end());
+	m_stats.queueDepth = static_cast<uint32_t>(m_changes.size());
+}
+
+void AssetReloadScheduler::Prefetch(Change &change)
+{
+	auto prefetched = std::make_shared<std::atomic<bool>>(false);
+	change.prefetched = prefetched;
+	auto job = [path=*change.prefetchPath,prefetched]() {
+		// The data is discarded; The asset is loaded from the file system cache afterwards
+		auto f = filemanager::open_file(path,filemanager::FileMode::Read | filemanager::FileMode::Binary);
+		if(f)
+		{
+			std::vector<uint8_t> data(f->GetSize());
+			f->Read(data.data(),data.size());
+		}
+		*prefetched = true;
+	};
+	if(m_jobSystem)
+		m_jobSystem->Schedule(job);
+	else
+		job();
+}
+
+bool AssetReloadScheduler::IsReady(Change &change,Clock::time_point t,bool settled)
+{
+	if(settled == false && t -change.tFirstChange < MAX_DELAY)
+		return false;
+	if(change.prefetchPath.has_value() == false)
+		return true;
+	if(change.prefetched == nullptr)
+		Prefetch(change);
+	return *change.prefetched;
+}
+
+std::chrono::microseconds AssetReloadScheduler::Process(std::chrono::microseconds budget)
+{
+	m_stats.numApplied = 0;
+	m_stats.maxApplyLatency = std::chrono::microseconds{0};
+	if(m_changes.empty())
+		return budget;
+	auto tStart = Clock::now();
+	auto settled = (tStart -m_tLastChange) >= DEBOUNCE_TIME;
+	// Single pass over the queue; Changes which aren't ready yet are skipped instead of being tested again for every applied change.
+	// The apply functions may only append new changes (or update existing ones), which doesn't invalidate the iterator.
+	for(auto it=m_changes.begin();it!=m_changes.end();)
+	{
+		auto t = Clock::now();
+		if(m_stats.numApplied > 0 && t -tStart >= budget)
+			break;
+		if(IsReady(*it,t,settled) == false)
+		{
+			++it;
+			continue;
+		}
+		// The apply function may add new changes, so the change has to be removed from the queue before it is called
+		auto apply = std::move(it->apply);
+		auto tFirstChange = it->tFirstChange;
+		m_keyToChange.erase(it->key);
+		it = m_changes.erase(it);
+
+		apply();
+		++m_stats.numApplied;
+		auto latency = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() -tFirstChange);
+		m_stats.maxApplyLatency = std::max(m_stats.maxApplyLatency,latency);
+	}
+	m_stats.queueDepth = static_cast<uint32_t>(m_changes.size());
+	auto tElapsed = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() -tStart);
+	return (tElapsed < budget) ? (budget -tElapsed) : std::chrono::microseconds{0};
+}
+
+bool AssetReloadScheduler::HasPendingChanges() const {return !m_changes.empty();}
+const AssetReloadScheduler::Stats &AssetReloadScheduler::GetStats() const {return m_stats;}
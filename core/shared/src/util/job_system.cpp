@@ -0,0 +1,257 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright (c) 2021 Silverlan
+ */
+
+#include "stdafx_shared.h"
+#include "pragma/util/job_system.hpp"
+#include <sharedutils/util.h>
+#include <mathutil/umath.h>
+
+using namespace pragma;
+
+bool JobCounter::IsComplete() const {return m_value == 0;}
+uint32_t JobCounter::GetValue() const {return m_value;}
+
+//////////////////
+
+static thread_local const JobSystem *g_curJobSystem = nullptr;
+static thread_local uint32_t g_curWorkerIndex = JobSystem::INVALID_WORKER_INDEX;
+uint32_t JobSystem::GetCurrentWorkerIndex() {return g_curWorkerIndex;}
+
+JobSystem::JobSystem(std::string name,uint32_t numWorkers,const WorkerCallback &onWorkerStarted)
+	: m_name{std::move(name)},m_onWorkerStarted{onWorkerStarted}
+{
+	StartWorkers(numWorkers);
+}
+
+JobSystem::~JobSystem()
+{
+	WaitForAll();
+	StopWorkers();
+}
+
+const std::string &JobSystem::GetName() const {return m_name;}
+bool JobSystem::IsWorkerThread() const {return g_curJobSystem == this;}
+uint32_t JobSystem::GetWorkerCount() const {return static_cast<uint32_t>(m_workers.size());}
+uint32_t JobSystem::GetPendingJobCount() const {return m_numPendingJobs;}
+
+void JobSystem::SetWorkerCount(uint32_t numWorkers)
+{
+	if(numWorkers == m_workers.size())
+		return;
+	WaitForAll();
+	StopWorkers();
+	StartWorkers(numWorkers);
+}
+
+void JobSystem::StartWorkers(uint32_t numWorkers)
+{
+	m_queues.clear();
+	auto numQueues = umath::max(numWorkers,1u);
+	m_queues.reserve(numQueues);
+	for(auto i=decltype(numQueues){0u};i<numQueues;++i)
+		m_queues.push_back(std::make_unique<WorkerQueue>());
+	m_running = true;
+	m_workers.reserve(numWorkers);
+	for(auto i=decltype(numWorkers){0u};i<numWorkers;++i)
+	{
+		m_workers.push_back(std::thread{[this,i]() {WorkerMain(i);}});
+		util::set_thread_name(m_workers.back(),m_name);
+	}
+}
+
+void JobSystem::StopWorkers()
+{
+	m_workAvailableMutex.lock();
+		m_running = false;
+		m_workAvailableCondition.notify_all();
+	m_workAvailableMutex.unlock();
+	for(auto &worker : m_workers)
+	{
+		if(worker.joinable())
+			worker.join();
+	}
+	m_workers.clear();
+}
+
+void JobSystem::WorkerMain(uint32_t workerIndex)
+{
+	g_curJobSystem = this;
+	g_curWorkerIndex = workerIndex;
+	if(m_onWorkerStarted)
+		m_onWorkerStarted(workerIndex);
+	for(;;)
+	{
+		JobInfo info;
+		if(AcquireJob(info))
+		{
+			RunJob(info);
+			continue;
+		}
+		std::unique_lock<std::mutex> mlock {m_workAvailableMutex};
+		m_workAvailableCondition.wait(mlock,[this]() -> bool {return m_numQueuedJobs > 0 || !m_running;});
+		if(m_running == false)
+			break;
+	}
+	g_curJobSystem = nullptr;
+	g_curWorkerIndex = INVALID_WORKER_INDEX;
+}
+
+void JobSystem::Schedule(const Job &job,JobCounter *counter,JobCounter *dependency)
+{
+	++m_numPendingJobs;
+	if(counter)
+		++counter->m_value;
+	if(dependency)
+	{
+		std::unique_lock<std::mutex> lock {dependency->m_mutex};
+		if(dependency->m_value > 0)
+		{
+			// The job will be pushed once the last job of the dependency has been completed
+			dependency->m_continuations.push_back({job,counter});
+			return;
+		}
+	}
+	Push({job,counter});
+}
+
+void JobSystem::Push(JobInfo &&info)
+{
+	// Jobs scheduled by one of our own workers are kept on that worker's deque, since they're likely to
+	// operate on data that is still in its cache. Everything else is distributed evenly.
+	auto queueIndex = (g_curJobSystem == this) ? g_curWorkerIndex : (m_nextQueue.fetch_add(1) %static_cast<uint32_t>(m_queues.size()));
+	auto &queue = *m_queues[queueIndex];
+	queue.mutex.lock();
+		queue.jobs.push_back(std::move(info));
+		++m_numQueuedJobs;
+	queue.mutex.unlock();
+
+	m_workAvailableMutex.lock();
+	m_workAvailableMutex.unlock();
+	m_workAvailableCondition.notify_one();
+	if(m_numWaiters > 0)
+		NotifyWaiters();
+}
+
+bool JobSystem::PopJob(uint32_t queueIndex,JobInfo &outInfo)
+{
+	auto &queue = *m_queues[queueIndex];
+	std::scoped_lock lock {queue.mutex};
+	if(queue.jobs.empty())
+		return false;
+	outInfo = std::move(queue.jobs.back());
+	queue.jobs.pop_back();
+	--m_numQueuedJobs;
+	return true;
+}
+
+bool JobSystem::StealJob(uint32_t thiefIndex,JobInfo &outInfo)
+{
+	auto numQueues = static_cast<uint32_t>(m_queues.size());
+	auto startIndex = (thiefIndex != INVALID_WORKER_INDEX) ? (thiefIndex +1) : 0u;
+	for(auto i=decltype(numQueues){0u};i<numQueues;++i)
+	{
+		auto queueIndex = (startIndex +i) %numQueues;
+		if(queueIndex == thiefIndex)
+			continue;
+		auto &queue = *m_queues[queueIndex];
+		std::scoped_lock lock {queue.mutex};
+		if(queue.jobs.empty())
+			continue;
+		// Steal from the opposite end of the owner to reduce contention
+		outInfo = std::move(queue.jobs.front());
+		queue.jobs.pop_front();
+		--m_numQueuedJobs;
+		return true;
+	}
+	return false;
+}
+
+bool JobSystem::AcquireJob(JobInfo &outInfo)
+{
+	if(m_numQueuedJobs == 0)
+		return false;
+	if(g_curJobSystem == this)
+		return PopJob(g_curWorkerIndex,outInfo) || StealJob(g_curWorkerIndex,outInfo);
+	return StealJob(INVALID_WORKER_INDEX,outInfo);
+}
+
+bool JobSystem::ExecuteJob()
+{
+	JobInfo info;
+	if(AcquireJob(info) == false)
+		return false;
+	RunJob(info);
+	return true;
+}
+
+void JobSystem::RunJob(JobInfo &info)
+{
+	info.job();
+	info.job = nullptr; // Release captured resources before the job is marked as complete
+
+	auto notify = false;
+	if(info.counter)
+	{
+		auto &counter = *info.counter;
+		std::vector<JobCounter::Continuation> continuations;
+		counter.m_mutex.lock();
+			auto completed = (--counter.m_value == 0);
+			if(completed)
+			{
+				continuations = std::move(counter.m_continuations);
+				counter.m_continuations.clear();
+			}
+		counter.m_mutex.unlock();
+		// Note: The counter may have already been destroyed at this point and must not be accessed anymore
+		for(auto &continuation : continuations)
+			Push({std::move(continuation.job),continuation.counter});
+		notify = completed;
+	}
+	if(--m_numPendingJobs == 0)
+		notify = true;
+	if(notify && m_numWaiters > 0)
+		NotifyWaiters();
+}
+
+void JobSystem::NotifyWaiters()
+{
+	m_waitMutex.lock();
+		m_waitCondition.notify_all();
+	m_waitMutex.unlock();
+}
+
+void JobSystem::HelpUntil(const std::function<bool()> &isDone)
+{
+	if(isDone())
+		return;
+	++m_numWaiters;
+	while(isDone() == false)
+	{
+		JobInfo info;
+		if(AcquireJob(info))
+		{
+			RunJob(info);
+			continue;
+		}
+		std::unique_lock<std::mutex> mlock {m_waitMutex};
+		m_waitCondition.wait(mlock,[this,&isDone]() -> bool {return isDone() || m_numQueuedJobs > 0;});
+	}
+	--m_numWaiters;
+}
+
+void JobSystem::Wait(JobCounter &counter)
+{
+	HelpUntil([&counter]() -> bool {return counter.m_value == 0;});
+	// The job that completed the counter may still be holding the lock, in which case we have
+	// to wait for it to be released, otherwise the counter may be destroyed while it's still in use
+	std::scoped_lock lock {counter.m_mutex};
+}
+
+void JobSystem::WaitForAll()
+{
+	HelpUntil([this]() -> bool {return m_numPendingJobs == 0;});
+}
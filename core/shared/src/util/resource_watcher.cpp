@@ -16,6 +16,9 @@
 #include <material_manager2.hpp>
 #include <sharedutils/util_file.h>
 #include <pragma/asset/util_asset.hpp>
+#include <pragma/engine.h>
+
+extern DLLNETWORK Engine *engine;
 
 decltype(EResourceWatcherCallbackType::Model) EResourceWatcherCallbackType::Model = EResourceWatcherCallbackType{umath::to_integral(E::Model)};
 decltype(EResourceWatcherCallbackType::Material) EResourceWatcherCallbackType::Material = EResourceWatcherCallbackType{umath::to_integral(E::Material)};
@@ -25,7 +28,7 @@ decltype(EResourceWatcherCallbackType::SoundScript) EResourceWatcherCallbackType
 decltype(EResourceWatcherCallbackType::Sound) EResourceWatcherCallbackType::Sound = EResourceWatcherCallbackType{umath::to_integral(E::Sound)};
 decltype(EResourceWatcherCallbackType::Count) EResourceWatcherCallbackType::Count = EResourceWatcherCallbackType{umath::to_integral(E::Count)};
 ResourceWatcherManager::ResourceWatcherManager(NetworkState *nw)
-	: m_networkState(nw)
+	: m_networkState(nw),m_reloadScheduler{&engine->GetJobSystem()}
 {}
 
 void ResourceWatcherManager::Poll()
@@ -33,8 +36,35 @@ void ResourceWatcherManager::Poll()
 	std::scoped_lock lock {m_watcherMutex};
 	for(auto &watcher : m_watchers)
 		watcher->Poll();
+	if(m_reloadScheduler.HasPendingChanges() == false && m_pendingMaterialReloads.empty() && m_deferredCallbacks.empty())
+		return;
+	// The budget is shared with the other watchers
+	auto budget = engine->GetAssetReloadBudget();
+	auto tStart = std::chrono::steady_clock::now();
+	util::ScopeGuard sgBudget {[tStart]() {
+		engine->ConsumeAssetReloadBudget(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() -tStart));
+	}};
+
+	// Material reloads and change callbacks are deferred until the changes of this frame have been processed, so that
+	// materials which are affected by multiple changed files are only reloaded once
+	m_processingChanges = true;
+	budget = m_reloadScheduler.Process(budget);
+	ReloadTextureUsers();
+	m_processingChanges = false;
+	if(m_pendingMaterialReloads.empty() == false)
+		ReloadPendingMaterials(budget);
+	if(m_pendingMaterialReloads.empty() == false)
+		return; // Callbacks are deferred until all affected materials have been reloaded
+
+	auto callbacks = std::move(m_deferredCallbacks);
+	m_deferredCallbacks.clear();
+	for(auto &cb : callbacks)
+		CallChangeCallbacks(cb.type,cb.path,cb.ext);
 }
 
+const pragma::AssetReloadScheduler &ResourceWatcherManager::GetReloadScheduler() const {return m_reloadScheduler;}
+uint32_t ResourceWatcherManager::GetPendingReloadCount() const {return m_reloadScheduler.GetStats().queueDepth +static_cast<uint32_t>(m_pendingMaterialReloads.size());}
+
 void ResourceWatcherManager::Lock()
 {
 	std::scoped_lock lock {m_watcherMutex};
@@ -65,49 +95,185 @@ util::ScopeGuard ResourceWatcherManager::ScopeLock()
 bool ResourceWatcherManager::IsLocked() const {return m_lockedCount > 0;}
 
 void ResourceWatcherManager::ReloadMaterial(const std::string &path)
+{
+	if(m_pendingMaterialReloadKeys.insert(GetTextureIndexKey(path)).second)
+		m_pendingMaterialReloads.push_back(path);
+}
+
+void ResourceWatcherManager::ReloadPendingMaterials(std::chrono::microseconds budget)
 {
 	auto *nw = m_networkState;
 	auto *game = m_networkState->GetGameState();
-	auto &matManager = nw->GetMaterialManager();
-	//if(matManager.FindMaterial(path) == nullptr)
-	//	return; // Don't reload the material if it was never requested in the first place
-	std::string internalPath;
-	if(nw->LoadMaterial(path,true) != nullptr)
+	auto &mdlManager = nw->GetModelManager();
+	std::vector<std::string> reloadedPaths;
+	// Keeps the affected models alive until the callback has been called
+	std::vector<std::shared_ptr<Model>> models;
+	std::unordered_set<Model*> modelMap;
+	auto tStart = std::chrono::steady_clock::now();
+	uint32_t numProcessed = 0;
+	while(numProcessed < m_pendingMaterialReloads.size() && (numProcessed == 0 || std::chrono::steady_clock::now() -tStart < budget))
 	{
+		auto &path = m_pendingMaterialReloads[numProcessed++];
+		//if(matManager.FindMaterial(path) == nullptr)
+		//	continue; // Don't reload the material if it was never requested in the first place
+		auto *mat = nw->LoadMaterial(path,true);
+		if(mat == nullptr)
+			continue;
 #if RESOURCE_WATCHER_VERBOSE > 0
 		Con::cout<<"[ResourceWatcher] Material 'materials\\"<<path<<"' has been reloaded!"<<Con::endl;
 #endif
-		if(game != nullptr)
+		reloadedPaths.push_back(path);
+		IndexMaterial(*mat); // Only the reloaded material has to be re-indexed
+		if(game == nullptr)
+			continue;
+		auto key = pragma::asset::ModelManager::GetMaterialIndexKey(path);
+		for(auto &mdl : mdlManager.FindMaterialUsers(path))
 		{
-			auto fname = ufile::get_file_from_filename(path);
-			ufile::remove_extension_from_filename(fname);
-			auto &mdlManager = m_networkState->GetModelManager();
-			auto &models = mdlManager.GetCache();
-			std::unordered_set<Model*> modelMap;
-			for(auto &pair : models)
+			auto &textures = mdl->GetTextures();
+			for(auto i=decltype(textures.size()){0};i<textures.size();++i)
 			{
-				auto asset = mdlManager.GetAsset(pair.second);
-				if(!asset)
-					continue;
-				auto mdl = pragma::asset::ModelManager::GetAssetObject(*asset);
-				auto &textures = mdl->GetTextures();
-				for(auto it=textures.begin();it!=textures.end();++it)
-				{
-					auto tex = *it;
-					ustring::to_lower(tex);
-					if(tex == fname)
-					{
-						modelMap.insert(mdl.get());
-						mdl->PrecacheTexture(it -textures.begin());
-						goto loopDone;
-					}
-				}
+				if(pragma::asset::ModelManager::GetMaterialIndexKey(textures[i]) == key)
+					mdl->PrecacheTexture(i);
 			}
-		loopDone:;
+			if(modelMap.insert(mdl.get()).second)
+				models.push_back(mdl);
+		}
+	}
+	for(auto i=decltype(numProcessed){0u};i<numProcessed;++i)
+		m_pendingMaterialReloadKeys.erase(GetTextureIndexKey(m_pendingMaterialReloads[i]));
+	m_pendingMaterialReloads.erase(m_pendingMaterialReloads.begin(),m_pendingMaterialReloads.begin() +numProcessed);
+	if(game == nullptr || reloadedPaths.empty())
+		return;
+	OnMaterialsReloaded(reloadedPaths,modelMap);
+}
+
+std::string ResourceWatcherManager::GetTextureIndexKey(const std::string &texture)
+{
+	auto key = FileManager::GetCanonicalizedPath(texture);
+	ustring::to_lower(key);
+	ufile::remove_extension_from_filename(key);
+	return key;
+}
+
+void ResourceWatcherManager::RemoveFromTextureIndex(const std::string &matName,const IndexedMaterial &indexed)
+{
+	for(auto &tex : indexed.textures)
+	{
+		auto it = m_textureUsers.find(tex);
+		if(it == m_textureUsers.end())
+			continue;
+		it->second.erase(matName);
+		if(it->second.empty())
+			m_textureUsers.erase(it);
+	}
+}
+
+void ResourceWatcherManager::IndexMaterial(Material &mat)
+{
+	std::function<void(const std::shared_ptr<ds::Block>&,std::vector<std::string>&)> fCollectTextures = nullptr;
+	fCollectTextures = [&fCollectTextures](const std::shared_ptr<ds::Block> &block,std::vector<std::string> &outTextures) {
+		auto *data = block->GetData();
+		if(data == nullptr)
+			return;
+		for(auto &pair : *data)
+		{
+			auto v = pair.second;
+			if(v->IsBlock() == true)
+			{
+				fCollectTextures(std::static_pointer_cast<ds::Block>(v),outTextures);
+				continue;
+			}
+			auto dataTex = std::dynamic_pointer_cast<ds::Texture>(v);
+			if(dataTex == nullptr)
+				continue;
+			auto texName = GetTextureIndexKey(dataTex->GetString());
+			if(std::find(outTextures.begin(),outTextures.end(),texName) == outTextures.end())
+				outTextures.push_back(texName);
+		}
+	};
+
+	auto matName = mat.GetName();
+	auto it = m_indexedMaterials.find(matName);
+	if(it != m_indexedMaterials.end())
+	{
+		if(it->second.material == &mat)
+			return;
+		// The material has been reloaded, its textures may have changed
+		RemoveFromTextureIndex(matName,it->second);
+	}
+	else
+		it = m_indexedMaterials.insert(std::make_pair(matName,IndexedMaterial{})).first;
+	auto &indexed = it->second;
+	indexed.material = &mat;
+	indexed.textures.clear();
+	auto &block = mat.GetDataBlock();
+	if(block != nullptr)
+		fCollectTextures(block,indexed.textures);
+	for(auto &tex : indexed.textures)
+		m_textureUsers[tex].insert(matName);
+}
 
-			OnMaterialReloaded(path,modelMap);
+void ResourceWatcherManager::UpdateTextureIndex()
+{
+	// Only materials which are new or have been reloaded since the last update have their data blocks walked
+	auto &matManager = m_networkState->GetMaterialManager();
+	auto &cache = matManager.GetCache();
+	std::unordered_set<std::string> cachedMaterials;
+	cachedMaterials.reserve(cache.size());
+	for(auto &pair : cache)
+	{
+		auto asset = matManager.GetAsset(pair.second);
+		if(!asset)
+			continue;
+		auto hMat = msys::MaterialManager::GetAssetObject(*asset);
+		if(!hMat)
+			continue;
+		cachedMaterials.insert(hMat->GetName());
+		IndexMaterial(*hMat);
+	}
+
+	for(auto it=m_indexedMaterials.begin();it!=m_indexedMaterials.end();)
+	{
+		if(cachedMaterials.find(it->first) != cachedMaterials.end())
+		{
+			++it;
+			continue;
+		}
+		RemoveFromTextureIndex(it->first,it->second);
+		it = m_indexedMaterials.erase(it);
+	}
+}
+
+void ResourceWatcherManager::ReloadTextureUsers()
+{
+	if(m_changedTextures.empty())
+		return;
+	UpdateTextureIndex();
+	for(auto &tex : m_changedTextures)
+	{
+		auto it = m_textureUsers.find(GetTextureIndexKey(tex));
+		if(it == m_textureUsers.end())
+			continue;
+		for(auto matName : it->second) // Reload all materials which use this texture
+		{
+			// A new material with a different extension may have just been
+			// moved into the game files. Remove the extension and let the material
+			// system decide which one to load.
+			ufile::remove_extension_from_filename(matName);
+			ReloadMaterial(matName);
 		}
 	}
+	m_changedTextures.clear();
+}
+
+std::vector<std::string> ResourceWatcherManager::FindTextureUsers(const std::string &texture)
+{
+	std::scoped_lock lock {m_watcherMutex};
+	UpdateTextureIndex();
+	auto it = m_textureUsers.find(GetTextureIndexKey(texture));
+	if(it == m_textureUsers.end())
+		return {};
+	return {it->second.begin(),it->second.end()};
 }
 
 void ResourceWatcherManager::ReloadTexture(const std::string &path) {}
@@ -123,6 +289,12 @@ CallbackHandle ResourceWatcherManager::AddChangeCallback(EResourceWatcherCallbac
 
 void ResourceWatcherManager::CallChangeCallbacks(EResourceWatcherCallbackType type,const std::string &path,const std::string &ext)
 {
+	if(m_processingChanges)
+	{
+		// Callbacks are deferred until all pending changes have been processed
+		m_deferredCallbacks.push_back({type,path,ext});
+		return;
+	}
 	auto it = m_callbacks.find(type);
 	if(it == m_callbacks.end())
 		return;
@@ -135,7 +307,7 @@ void ResourceWatcherManager::CallChangeCallbacks(EResourceWatcherCallbackType ty
 			++itCb;
 		}
 		else
-			it->second.erase(itCb);
+			itCb = it->second.erase(itCb);
 	}
 	if(it->second.empty())
 		m_callbacks.erase(it);
@@ -209,62 +381,7 @@ void ResourceWatcherManager::OnResourceChanged(const util::Path &rootPath,const
 			Con::cout<<"[ResourceWatcher] Texture has changed: "<<texPath<<". Attempting to reload..."<<Con::endl;
 #endif
 			ReloadTexture(strPath);
-			auto &matManager = nw->GetMaterialManager();
-			for(auto &pair : matManager.GetCache()) // Find all materials which use this texture
-			{
-				auto asset = matManager.GetAsset(pair.second);
-				if(!asset)
-					continue;
-				auto hMat = msys::MaterialManager::GetAssetObject(*asset);
-				if(!hMat)
-					continue;
-				auto *mat = hMat.get();
-				auto &block = mat->GetDataBlock();
-				if(block == nullptr)
-					continue;
-				auto canonName = FileManager::GetCanonicalizedPath(strPath);
-				ustring::to_lower(canonName);
-				ufile::remove_extension_from_filename(canonName);
-			
-				std::function<bool(const std::shared_ptr<ds::Block>&)> fHasTexture = nullptr;
-				fHasTexture = [&fHasTexture,&canonName](const std::shared_ptr<ds::Block> &block) -> bool {
-					auto *data = block->GetData();
-					if(data != nullptr)
-					{
-						for(auto &pair : *data)
-						{
-							auto v = pair.second;
-							if(v->IsBlock() == true)
-							{
-								if(fHasTexture(std::static_pointer_cast<ds::Block>(v)) == true)
-									return true;
-							}
-							else
-							{
-								auto dataTex = std::dynamic_pointer_cast<ds::Texture>(v);
-								if(dataTex != nullptr)
-								{
-									auto texName = FileManager::GetCanonicalizedPath(dataTex->GetString());
-									ustring::to_lower(texName);
-									ufile::remove_extension_from_filename(texName);
-									if(canonName == texName)
-										return true;
-								}
-							}
-						}
-					}
-					return false;
-				};
-				if(fHasTexture(block) == true) // Material has texture, reload it
-				{
-					auto matName = mat->GetName();
-					// A new material with a different extension may have just been
-					// moved into the game files. Remove the extension and let the material
-					// system decide which one to load.
-					ufile::remove_extension_from_filename(matName);
-					ReloadMaterial(matName);
-				}
-			}
+			m_changedTextures.push_back(strPath); // The materials which use the texture are reloaded once all changes of this poll have been applied
 			CallChangeCallbacks(EResourceWatcherCallbackType::Texture,strPath,ext);
 		}
 		else if(*assetType == pragma::asset::Type::Sound)
@@ -318,7 +435,15 @@ void ResourceWatcherManager::OnResourceChanged(const util::Path &rootPath,const
 #if RESOURCE_WATCHER_VERBOSE > 0
 	Con::cout<<"[ResourceWatcher] File changed: "<<path<<" ("<<ext<<")"<<Con::endl;
 #endif
-	OnResourceChanged(rootPath,path,*ext);
+	// The change is applied by the reload scheduler once no further changes have occurred for a while (see Poll).
+	// Assets which are reloaded directly are read on a worker thread beforehand.
+	std::scoped_lock lock {m_watcherMutex};
+	auto filePath = (rootPath +path).GetString();
+	auto assetType = pragma::asset::determine_type_from_extension(*ext);
+	auto prefetch = assetType.has_value() && (*assetType == pragma::asset::Type::Model || *assetType == pragma::asset::Type::Material || *assetType == pragma::asset::Type::Texture);
+	m_reloadScheduler.AddChange(filePath,[this,rootPath,path,ext=*ext]() {
+		OnResourceChanged(rootPath,path,ext);
+	},prefetch ? filePath : std::optional<std::string>{});
 }
 
 void ResourceWatcherManager::GetWatchPaths(std::vector<std::string> &paths)
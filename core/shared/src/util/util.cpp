@@ -183,6 +183,20 @@ Bool Game::Sweep(const TraceData &data,std::vector<TraceResult> *optOutResults)
 		return false;
 	return physEnv->Sweep(data,optOutResults);
 }
+uint32_t Game::BatchTrace(TraceType type,const TraceData &data,const TraceQuery *queries,uint32_t numQueries,TraceResult *outResults,bool resolveMeshes) const
+{
+	auto *physEnv = GetPhysicsEnvironment();
+	if(physEnv == nullptr)
+	{
+		for(auto i=decltype(numQueries){0u};i<numQueries;++i)
+		{
+			outResults[i] = TraceResult{};
+			outResults[i].hitType = RayCastHitType::None;
+		}
+		return 0;
+	}
+	return physEnv->BatchTrace(type,data,queries,numQueries,outResults,resolveMeshes);
+}
 TraceResult Game::Overlap(const TraceData &data) const
 {
 	std::vector<TraceResult> results {};
@@ -32,44 +32,6 @@ const BSPTree::Node *BSPTree::Node::GetChild(BSPTree &tree,uint8_t idx)
 	return &tree.m_nodes[children[idx]];
 }
 
-static void preprocess_bsp_data(util::BSPTree &bspTree,std::vector<std::vector<size_t>> &outClusterNodes,std::vector<std::vector<uint16_t>> &outClusterToClusterVisibility)
-{
-	auto numClusters = bspTree.GetClusterCount();
-	auto &bspNodes = bspTree.GetNodes();
-
-	// Pre-processing to speed up some calculations
-	{
-		// Nodes per cluster
-		outClusterNodes.resize(numClusters);
-		for(auto i=decltype(bspNodes.size()){0u};i<bspNodes.size();++i)
-		{
-			auto &bspNode = bspNodes.at(i);
-			if(bspNode.cluster >= outClusterNodes.size())
-				continue;
-			auto &nodeList = outClusterNodes.at(bspNode.cluster);
-			if(nodeList.size() == nodeList.capacity())
-				nodeList.reserve(nodeList.size() *1.5f +100);
-			nodeList.push_back(i);
-		}
-
-		// List of clusters visible from every other cluster
-		outClusterToClusterVisibility.resize(numClusters);
-		for(auto cluster0=decltype(numClusters){0u};cluster0<numClusters;++cluster0)
-		{
-			auto &visibleClusters = outClusterToClusterVisibility.at(cluster0);
-			for(auto cluster1=decltype(numClusters){0u};cluster1<numClusters;++cluster1)
-			{
-				if(bspTree.IsClusterVisible(cluster0,cluster1) == false)
-					continue;
-				if(visibleClusters.size() == visibleClusters.capacity())
-					visibleClusters.reserve(visibleClusters.size() *1.5f +50);
-				visibleClusters.push_back(cluster1);
-			}
-		}
-	}
-	//
-}
-
 std::shared_ptr<BSPTree> BSPTree::Load(const udm::AssetData &data,std::string &outErr)
 {
 	if(data.GetAssetType() != PBSP_IDENTIFIER)
@@ -91,10 +53,28 @@ std::shared_ptr<BSPTree> BSPTree::Load(const udm::AssetData &data,std::string &o
 	udm["rootNode"](bspTree->m_rootNode);
 	udm["numClusters"](bspTree->m_clusterCount);
 	
-	auto &clusterVisibility = bspTree->GetClusterVisibility();
-	udm["clusterVisibility"].GetBlobData(clusterVisibility);
+	if(version < 2)
+	{
+		auto &clusterVisibility = bspTree->GetClusterVisibility();
+		udm["clusterVisibility"].GetBlobData(clusterVisibility);
+		bspTree->CompressClusterVisibility();
+		return bspTree;
+	}
+	std::vector<ClusterVisibilityRow> visibilityRows;
+	std::vector<uint16_t> visibilityData;
+	udm["clusterVisibilityRows"].GetBlobData(visibilityRows);
+	udm["clusterVisibilityData"].GetBlobData(visibilityData);
+	if(visibilityRows.size() != bspTree->m_clusterCount)
+	{
+		outErr = "Number of cluster visibility rows mismatches number of clusters!";
+		return nullptr;
+	}
+	if(bspTree->SetCompressedClusterVisibility(std::move(visibilityRows),std::move(visibilityData)) == false)
+	{
+		outErr = "Invalid cluster visibility data!";
+		return nullptr;
+	}
 	return bspTree;
-
 }
 bool BSPTree::Save(udm::AssetDataArg outData,std::string &outErr)
 {
@@ -113,44 +93,186 @@ bool BSPTree::Save(udm::AssetDataArg outData,std::string &outErr)
 	udm["rootNode"] = static_cast<uint32_t>(it -m_nodes.begin());
 	udm["nodes"] = udm::compress_lz4_blob(m_nodes);
 
-	auto &clusterVisibility = GetClusterVisibility();
-	udm["clusterVisibility"] = udm::compress_lz4_blob(clusterVisibility);
+	if(IsClusterVisibilityCompressed() == false)
+		CompressClusterVisibility();
+	udm["clusterVisibilityRows"] = udm::compress_lz4_blob(m_clusterVisibilityRows);
+	udm["clusterVisibilityData"] = udm::compress_lz4_blob(m_clusterVisibilityData);
 	return true;
 }
 
 bool BSPTree::IsValid() const {return m_rootNode < m_nodes.size();}
 bool BSPTree::IsClusterVisible(uint16_t clusterSrc,uint16_t clusterDst) const
 {
+	if(IsClusterVisibilityCompressed())
+	{
+		if(clusterSrc >= m_clusterVisibilityRows.size() || clusterDst >= m_clusterCount)
+			return false;
+		auto &row = m_clusterVisibilityRows[clusterSrc];
+		auto *data = m_clusterVisibilityData.data() +row.offset;
+		if(IsDenseClusterVisibilityRow(row))
+			return (data[clusterDst /16u] &(1u<<(clusterDst %16u))) != 0u;
+		return std::binary_search(data,data +row.count,clusterDst);
+	}
 	auto bit = static_cast<uint64_t>(clusterSrc) *m_clusterCount +static_cast<uint64_t>(clusterDst);
 	auto offset = bit /8u;
 	bit %= 8u;
 	return offset < m_clusterVisibility.size() && (m_clusterVisibility.at(offset) &(1<<bit)) > 0u;
 }
-void BSPTree::UpdateVisibilityBounds()
+uint32_t BSPTree::GetVisibleClusterCount(ClusterIndex clusterSrc) const
 {
-	for(auto &node : m_nodes)
+	if(IsClusterVisibilityCompressed())
+		return (clusterSrc < m_clusterVisibilityRows.size()) ? m_clusterVisibilityRows[clusterSrc].count : 0u;
+	uint32_t count = 0;
+	IterateVisibleClusters(clusterSrc,[&count](ClusterIndex) {++count;});
+	return count;
+}
+uint32_t BSPTree::GetDenseClusterVisibilityRowSize() const {return (m_clusterCount +15u) /16u;}
+bool BSPTree::IsDenseClusterVisibilityRow(const ClusterVisibilityRow &row) const {return row.count > GetDenseClusterVisibilityRowSize();}
+bool BSPTree::IsClusterVisibilityCompressed() const {return m_clusterVisibilityRows.empty() == false;}
+void BSPTree::CompressClusterVisibility()
+{
+	m_clusterVisibilityRows.clear();
+	m_clusterVisibilityData.clear();
+	auto numDenseWords = GetDenseClusterVisibilityRowSize();
+	std::vector<uint16_t> visibleClusters;
+	m_clusterVisibilityRows.reserve(m_clusterCount);
+	for(auto clusterSrc=decltype(m_clusterCount){0u};clusterSrc<m_clusterCount;++clusterSrc)
 	{
-		if(node.leaf == false)
+		visibleClusters.clear();
+		auto bitStart = clusterSrc *m_clusterCount;
+		auto bitEnd = bitStart +m_clusterCount;
+		for(auto bit=bitStart;bit<bitEnd;)
+		{
+			auto offset = bit /8u;
+			if(offset >= m_clusterVisibility.size())
+				break;
+			// Most of the matrix is usually empty, so we can skip entire bytes
+			if((bit %8u) == 0u && m_clusterVisibility[offset] == 0u)
+			{
+				bit += 8u;
+				continue;
+			}
+			if((m_clusterVisibility[offset] &(1<<(bit %8u))) != 0u)
+				visibleClusters.push_back(static_cast<uint16_t>(bit -bitStart));
+			++bit;
+		}
+		ClusterVisibilityRow row {};
+		row.offset = m_clusterVisibilityData.size();
+		row.count = visibleClusters.size();
+		if(IsDenseClusterVisibilityRow(row))
+		{
+			m_clusterVisibilityData.resize(m_clusterVisibilityData.size() +numDenseWords,0u);
+			auto *data = m_clusterVisibilityData.data() +row.offset;
+			for(auto clusterDst : visibleClusters)
+				data[clusterDst /16u] |= 1u<<(clusterDst %16u);
+		}
+		else
+			m_clusterVisibilityData.insert(m_clusterVisibilityData.end(),visibleClusters.begin(),visibleClusters.end());
+		m_clusterVisibilityRows.push_back(row);
+	}
+	m_clusterVisibilityData.shrink_to_fit();
+	m_clusterVisibility = {};
+}
+std::vector<uint8_t> BSPTree::DecompressClusterVisibility() const
+{
+	if(IsClusterVisibilityCompressed() == false)
+		return m_clusterVisibility;
+	auto numBits = m_clusterCount *m_clusterCount;
+	std::vector<uint8_t> clusterVisibility {};
+	clusterVisibility.resize(numBits /8u +((numBits %8u) > 0u ? 1u : 0u),0u);
+	for(auto clusterSrc=decltype(m_clusterCount){0u};clusterSrc<m_clusterCount;++clusterSrc)
+	{
+		IterateVisibleClusters(clusterSrc,[this,&clusterVisibility,clusterSrc](ClusterIndex clusterDst) {
+			auto bit = clusterSrc *m_clusterCount +clusterDst;
+			clusterVisibility[bit /8u] |= 1u<<(bit %8u);
+		});
+	}
+	return clusterVisibility;
+}
+bool BSPTree::IsClusterVisibilityValid(const std::vector<ClusterVisibilityRow> &rows,const std::vector<uint16_t> &data) const
+{
+	if(rows.size() != m_clusterCount)
+		return false;
+	auto numDenseWords = GetDenseClusterVisibilityRowSize();
+	for(auto &row : rows)
+	{
+		if(row.count > m_clusterCount)
+			return false;
+		auto dense = IsDenseClusterVisibilityRow(row);
+		auto size = dense ? numDenseWords : row.count;
+		if(static_cast<uint64_t>(row.offset) +size > data.size())
+			return false;
+		auto *rowData = data.data() +row.offset;
+		if(dense)
+		{
+			// Padding bits past the last cluster must not be set, otherwise IterateVisibleClusters would yield invalid clusters
+			auto numPaddingBits = numDenseWords *16u -m_clusterCount;
+			if(numPaddingBits > 0u && (rowData[numDenseWords -1] >>(16u -numPaddingBits)) != 0u)
+				return false;
 			continue;
-		UpdateVisibilityBounds(node);
+		}
+		// Sparse rows must be sorted for the binary search in IsClusterVisible
+		for(auto i=decltype(row.count){0u};i<row.count;++i)
+		{
+			if(rowData[i] >= m_clusterCount || (i > 0u && rowData[i] <= rowData[i -1]))
+				return false;
+		}
 	}
+	return true;
 }
-void BSPTree::UpdateVisibilityBounds(BSPTree::Node &node)
+bool BSPTree::SetCompressedClusterVisibility(std::vector<ClusterVisibilityRow> &&rows,std::vector<uint16_t> &&data)
+{
+	if(IsClusterVisibilityValid(rows,data) == false)
+		return false;
+	m_clusterVisibilityRows = std::move(rows);
+	m_clusterVisibilityData = std::move(data);
+	m_clusterVisibility = {};
+	return true;
+}
+const std::vector<BSPTree::ClusterVisibilityRow> &BSPTree::GetClusterVisibilityRows() const {return m_clusterVisibilityRows;}
+const std::vector<uint16_t> &BSPTree::GetClusterVisibilityData() const {return m_clusterVisibilityData;}
+void BSPTree::UpdateVisibilityBounds()
 {
+	// Bounds of all leaves of each cluster
 	auto minInit = Vector3{std::numeric_limits<float>::max(),std::numeric_limits<float>::max(),std::numeric_limits<float>::max()};
 	auto maxInit = Vector3{std::numeric_limits<float>::lowest(),std::numeric_limits<float>::lowest(),std::numeric_limits<float>::lowest()};
-	node.minVisible = minInit;
-	node.maxVisible = maxInit;
-	for(auto &nodeOther : m_nodes)
+	std::vector<std::pair<Vector3,Vector3>> clusterBounds {};
+	clusterBounds.resize(m_clusterCount,{minInit,maxInit});
+	for(auto &node : m_nodes)
+	{
+		if(node.leaf == false || node.cluster >= m_clusterCount)
+			continue;
+		auto &bounds = clusterBounds[node.cluster];
+		uvec::to_min_max(bounds.first,bounds.second,node.min,node.max);
+	}
+
+	// Bounds of all clusters visible from each cluster
+	std::vector<std::pair<Vector3,Vector3>> clusterVisibleBounds {};
+	clusterVisibleBounds.resize(m_clusterCount,{minInit,maxInit});
+	for(auto clusterSrc=decltype(m_clusterCount){0u};clusterSrc<m_clusterCount;++clusterSrc)
+	{
+		auto &visibleBounds = clusterVisibleBounds[clusterSrc];
+		IterateVisibleClusters(static_cast<ClusterIndex>(clusterSrc),[&visibleBounds,&clusterBounds,&minInit](ClusterIndex clusterDst) {
+			auto &bounds = clusterBounds[clusterDst];
+			if(bounds.first == minInit)
+				return;
+			uvec::to_min_max(visibleBounds.first,visibleBounds.second,bounds.first,bounds.second);
+		});
+	}
+
+	for(auto &node : m_nodes)
 	{
-		if(!nodeOther.leaf || &nodeOther == &node || !IsClusterVisible(node.cluster,nodeOther.cluster))
+		if(node.leaf == false)
+			continue;
+		node.minVisible = node.min;
+		node.maxVisible = node.max;
+		if(node.cluster >= m_clusterCount)
+			continue;
+		auto &visibleBounds = clusterVisibleBounds[node.cluster];
+		if(visibleBounds.first == minInit)
 			continue;
-		uvec::to_min_max(node.minVisible,node.maxVisible,nodeOther.min,nodeOther.max);
+		uvec::to_min_max(node.minVisible,node.maxVisible,visibleBounds.first,visibleBounds.second);
 	}
-	if(node.minVisible == minInit)
-		node.minVisible = {};
-	if(node.maxVisible == maxInit)
-		node.maxVisible = {};
 }
 const BSPTree::Node &BSPTree::GetRootNode() const {return const_cast<BSPTree*>(this)->GetRootNode();}
 BSPTree::Node &BSPTree::GetRootNode() {return m_nodes[m_rootNode];}
@@ -208,6 +330,12 @@ void BSPTree::FindLeafNodesInAabb(BSPTree::Node &node,const std::array<Vector3,8
 		FindLeafNodesInAabb(m_nodes[node.children.at(1)],aabbPoints,outNodes);
 }
 std::vector<BSPTree::Node*> BSPTree::FindLeafNodesInAabb(const Vector3 &min,const Vector3 &max)
+{
+	std::vector<BSPTree::Node*> nodes {};
+	FindLeafNodesInAabb(min,max,nodes);
+	return nodes;
+}
+void BSPTree::FindLeafNodesInAabb(const Vector3 &min,const Vector3 &max,std::vector<Node*> &outNodes)
 {
 	std::array<Vector3,8> aabbPoints = {
 		min,
@@ -219,9 +347,7 @@ std::vector<BSPTree::Node*> BSPTree::FindLeafNodesInAabb(const Vector3 &min,cons
 		Vector3{max.x,max.y,min.z},
 		max
 	};
-	std::vector<BSPTree::Node*> nodes {};
-	FindLeafNodesInAabb(GetRootNode(),aabbPoints,nodes);
-	return nodes;
+	FindLeafNodesInAabb(GetRootNode(),aabbPoints,outNodes);
 }
 
 bool BSPTree::IsAabbVisibleInCluster(const BSPTree::Node &node,const std::array<Vector3,8> &aabbPoints,BSPTree::ClusterIndex clusterIdx) const